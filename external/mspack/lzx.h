@@ -156,6 +156,25 @@ extern struct lzxd_stream *lzxd_init(struct mspack_system *system,
 extern void lzxd_set_output_length(struct lzxd_stream *lzx,
                                    off_t output_length);
 
+/**
+ * Resets an LZX decompression state, to decode a new LZX stream with the
+ * same window size, reset interval and input buffer size. This reuses the
+ * memory allocated by lzxd_init().
+ *
+ * @param lzx           LZX decompression state, as allocated by lzxd_init().
+ * @param input         an input file handle to read LZX data using
+ *                      system->read().
+ * @param output        an output file handle to write LZX data using
+ *                      system->write().
+ * @param output_length the length in bytes of the entirely decompressed
+ *                      output stream. See lzxd_init().
+ * @return an error code, or MSPACK_ERR_OK if successful
+ */
+extern int lzxd_reset(struct lzxd_stream *lzx,
+                      struct mspack_file *input,
+                      struct mspack_file *output,
+                      off_t output_length);
+
 /**
  * Reads LZX DELTA reference data into the window and allows
  * lzxd_decompress() to reference it.
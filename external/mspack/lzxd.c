@@ -390,6 +390,32 @@ void lzxd_set_output_length(struct lzxd_stream *lzx, off_t out_bytes) {
   if (lzx && out_bytes > 0) lzx->length = out_bytes;
 }
 
+int lzxd_reset(struct lzxd_stream *lzx,
+               struct mspack_file *input,
+               struct mspack_file *output,
+               off_t output_length)
+{
+  if (!lzx || output_length < 0) return MSPACK_ERR_ARGS;
+
+  lzx->input           = input;
+  lzx->output          = output;
+  lzx->offset          = 0;
+  lzx->length          = output_length;
+
+  lzx->ref_data_size   = 0;
+  lzx->window_posn     = 0;
+  lzx->frame_posn      = 0;
+  lzx->frame           = 0;
+  lzx->intel_filesize  = 0;
+  lzx->intel_started   = 0;
+  lzx->error           = MSPACK_ERR_OK;
+
+  lzx->o_ptr = lzx->o_end = &lzx->e8_buf[0];
+  lzxd_reset_state(lzx);
+  INIT_BITS;
+  return MSPACK_ERR_OK;
+}
+
 int lzxd_decompress(struct lzxd_stream *lzx, off_t out_bytes) {
   /* bitstream and huffman reading variables */
   register unsigned int bit_buffer;
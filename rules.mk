@@ -73,3 +73,4 @@ include external/rules.mk
 include src/rules.mk
 
 include tests/rules.mk
+include tests/benchmark/rules.mk
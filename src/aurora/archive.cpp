@@ -22,13 +22,164 @@
  *  Handling various archive files.
  */
 
+#include <cstring>
+#include <algorithm>
+
 #include "src/common/system.h"
 
 #include "src/aurora/archive.h"
 
 namespace Aurora {
 
-Archive::Resource::Resource() : hash(0), type(kFileTypeNone), index(0xFFFFFFFF) {
+/** The minimum size of a block in the name table of a resource list. */
+static const size_t kNameBlockSize = 16384;
+
+/** Hash a zero-terminated string, using djb2. */
+static size_t hashNameString(const char *str) {
+	size_t hash = 5381;
+
+	while (*str)
+		hash = ((hash << 5) + hash) + (byte) *str++;
+
+	return hash;
+}
+
+
+Archive::Resource::Resource() : name(""), hash(0), type(kFileTypeNone), index(0xFFFFFFFF) {
+}
+
+
+size_t Archive::ResourceList::hashName::operator()(const char *str) const {
+	return hashNameString(str);
+}
+
+bool Archive::ResourceList::equalName::operator()(const char *str1, const char *str2) const {
+	return std::strcmp(str1, str2) == 0;
+}
+
+Archive::ResourceList::ResourceList() : _nameBlockSize(0), _nameBlockFill(0), _nameTableSize(0) {
+}
+
+Archive::ResourceList::~ResourceList() {
+}
+
+bool Archive::ResourceList::empty() const {
+	return _resources.empty();
+}
+
+size_t Archive::ResourceList::size() const {
+	return _resources.size();
+}
+
+Archive::ResourceList::iterator Archive::ResourceList::begin() {
+	return _resources.begin();
+}
+
+Archive::ResourceList::iterator Archive::ResourceList::end() {
+	return _resources.end();
+}
+
+Archive::ResourceList::const_iterator Archive::ResourceList::begin() const {
+	return _resources.begin();
+}
+
+Archive::ResourceList::const_iterator Archive::ResourceList::end() const {
+	return _resources.end();
+}
+
+Archive::Resource &Archive::ResourceList::operator[](size_t i) {
+	return _resources[i];
+}
+
+const Archive::Resource &Archive::ResourceList::operator[](size_t i) const {
+	return _resources[i];
+}
+
+const Archive::Resource *Archive::ResourceList::data() const {
+	return _resources.data();
+}
+
+void Archive::ResourceList::resize(size_t size) {
+	_resources.resize(size);
+}
+
+void Archive::ResourceList::reserve(size_t size) {
+	_resources.reserve(size);
+}
+
+Archive::Resource &Archive::ResourceList::add(const Common::UString &name, FileType type,
+                                              uint32_t index, uint64_t hash) {
+	return add(name.c_str(), type, index, hash);
+}
+
+Archive::Resource &Archive::ResourceList::add(const char *name, FileType type,
+                                              uint32_t index, uint64_t hash) {
+	_resources.emplace_back();
+
+	Resource &resource = _resources.back();
+
+	resource.name  = internName(name);
+	resource.hash  = hash;
+	resource.type  = type;
+	resource.index = index;
+
+	return resource;
+}
+
+void Archive::ResourceList::setName(Resource &resource, const Common::UString &name) {
+	resource.name = internName(name);
+}
+
+void Archive::ResourceList::finish() {
+	NameSet().swap(_names);
+
+	_resources.shrink_to_fit();
+}
+
+size_t Archive::ResourceList::getMemoryUsage() const {
+	return _resources.capacity() * sizeof(Resource) + _nameTableSize;
+}
+
+const char *Archive::ResourceList::internName(const Common::UString &name) {
+	return internName(name.c_str());
+}
+
+const char *Archive::ResourceList::internName(const char *name) {
+	if (!name || (*name == '\0'))
+		return "";
+
+	NameSet::const_iterator interned = _names.find(name);
+	if (interned != _names.end())
+		return *interned;
+
+	const size_t length = std::strlen(name) + 1;
+
+	// Start a new block if the name doesn't fit into the current one anymore
+	if ((_nameBlocks.empty()) || ((_nameBlockFill + length) > _nameBlockSize)) {
+		_nameBlockSize = std::max(kNameBlockSize, length);
+		_nameBlockFill = 0;
+
+		_nameBlocks.emplace_back(std::make_unique<char[]>(_nameBlockSize));
+		_nameTableSize += _nameBlockSize;
+	}
+
+	char *str = _nameBlocks.back().get() + _nameBlockFill;
+	std::memcpy(str, name, length);
+
+	_nameBlockFill += length;
+
+	_names.insert(str);
+
+	return str;
+}
+
+
+bool Archive::NameKey::operator==(const NameKey &key) const {
+	return (type == key.type) && (std::strcmp(name, key.name) == 0);
+}
+
+size_t Archive::hashNameKey::operator()(const NameKey &key) const {
+	return hashNameString(key.name) * 31 + (size_t) key.type;
 }
 
 Archive::Archive() {
@@ -45,23 +196,79 @@ Common::HashAlgo Archive::getNameHashAlgo() const {
 	return Common::kHashNone;
 }
 
+void Archive::buildHashIndex() const {
+	const ResourceList &resources = getResources();
+
+	_hashIndex.reserve(resources.size());
+
+	// emplace() doesn't overwrite, so the first resource with a certain hash wins
+	for (ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+		_hashIndex.emplace(r->hash, r->index);
+}
+
+void Archive::buildNameIndex() const {
+	const ResourceList &resources = getResources();
+
+	_nameIndex.reserve(resources.size());
+
+	// The keys reference the names inside the resource list, which never changes after loading
+	for (ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+		_nameIndex.emplace(NameKey(r->name, r->type), r->index);
+}
+
+uint32_t Archive::findInHashIndex(uint64_t hash) const {
+	HashIndex::const_iterator r = _hashIndex.find(hash);
+	if (r == _hashIndex.end())
+		return 0xFFFFFFFF;
+
+	return r->second;
+}
+
+uint32_t Archive::findInNameIndex(const Common::UString &name, FileType type) const {
+	NameIndex::const_iterator r = _nameIndex.find(NameKey(name.c_str(), type));
+	if (r == _nameIndex.end())
+		return 0xFFFFFFFF;
+
+	return r->second;
+}
+
 uint32_t Archive::findResource(uint64_t hash) const {
 	if (getNameHashAlgo() == Common::kHashNone)
 		return 0xFFFFFFFF;
 
-	for (ResourceList::const_iterator r = getResources().begin(); r != getResources().end(); ++r)
-		if (r->hash == hash)
-			return r->index;
+	std::call_once(_hashIndexBuilt, &Archive::buildHashIndex, this);
 
-	return 0xFFFFFFFF;
+	return findInHashIndex(hash);
 }
 
 uint32_t Archive::findResource(const Common::UString &name, FileType type) const {
-	for (ResourceList::const_iterator r = getResources().begin(); r != getResources().end(); ++r)
-		if ((r->type == type) && (r->name == name))
-			return r->index;
+	std::call_once(_nameIndexBuilt, &Archive::buildNameIndex, this);
 
-	return 0xFFFFFFFF;
+	return findInNameIndex(name, type);
+}
+
+std::vector<uint32_t> Archive::findResources(const std::vector<uint64_t> &hashes) const {
+	std::vector<uint32_t> indices(hashes.size(), 0xFFFFFFFF);
+	if (getNameHashAlgo() == Common::kHashNone)
+		return indices;
+
+	std::call_once(_hashIndexBuilt, &Archive::buildHashIndex, this);
+
+	for (size_t i = 0; i < hashes.size(); i++)
+		indices[i] = findInHashIndex(hashes[i]);
+
+	return indices;
+}
+
+std::vector<uint32_t> Archive::findResources(const std::vector<ResourceName> &names) const {
+	std::vector<uint32_t> indices(names.size(), 0xFFFFFFFF);
+
+	std::call_once(_nameIndexBuilt, &Archive::buildNameIndex, this);
+
+	for (size_t i = 0; i < names.size(); i++)
+		indices[i] = findInNameIndex(names[i].first, names[i].second);
+
+	return indices;
 }
 
 } // End of namespace Aurora
@@ -25,13 +25,18 @@
 #ifndef AURORA_ARCHIVE_H
 #define AURORA_ARCHIVE_H
 
-#include <list>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
 #include "src/common/hash.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
 
@@ -46,15 +51,104 @@ class Archive : boost::noncopyable {
 public:
 	/** A resource within the archive. */
 	struct Resource {
-		Common::UString name;  ///< The resource's name.
-		uint64_t        hash;  ///< The resource's hashed name.
-		FileType        type;  ///< The resource's type.
-		uint32_t        index; ///< The resource's local index within the archive.
+		const char *name;  ///< The resource's name, UTF-8, stored in the list's name table.
+		uint64_t    hash;  ///< The resource's hashed name.
+		FileType    type;  ///< The resource's type.
+		uint32_t    index; ///< The resource's local index within the archive.
 
 		Resource();
 	};
 
-	typedef std::list<Resource> ResourceList;
+	/** A contiguous list of resources.
+	 *
+	 *  All resource names are interned into one name table shared by the
+	 *  whole list, so that each resource is a small, fixed-size record and
+	 *  identical names are only stored once.
+	 *
+	 *  The names stay valid for the lifetime of the list. They are not
+	 *  affected by adding further resources.
+	 */
+	class ResourceList {
+	public:
+		typedef std::vector<Resource>::iterator       iterator;
+		typedef std::vector<Resource>::const_iterator const_iterator;
+
+		ResourceList();
+		ResourceList(const ResourceList &) = delete;
+		ResourceList(ResourceList &&) = default;
+		~ResourceList();
+
+		ResourceList &operator=(const ResourceList &) = delete;
+		ResourceList &operator=(ResourceList &&) = default;
+
+		bool   empty() const;
+		size_t size() const;
+
+		iterator begin();
+		iterator end();
+
+		const_iterator begin() const;
+		const_iterator end() const;
+
+		Resource &operator[](size_t i);
+		const Resource &operator[](size_t i) const;
+
+		/** Return the contiguous resource array. */
+		const Resource *data() const;
+
+		/** Resize the list. New resources are empty. */
+		void resize(size_t size);
+		/** Reserve space for this many resources. */
+		void reserve(size_t size);
+
+		/** Add a resource to the end of the list. */
+		Resource &add(const Common::UString &name, FileType type, uint32_t index, uint64_t hash = 0);
+		/** Add a resource with a zero-terminated UTF-8 name to the end of the list. */
+		Resource &add(const char *name, FileType type, uint32_t index, uint64_t hash = 0);
+
+		/** Set the name of a resource in this list. */
+		void setName(Resource &resource, const Common::UString &name);
+
+		/** Release all memory only needed while adding resources.
+		 *
+		 *  Names set afterwards are still stored, but not deduplicated
+		 *  against the existing ones anymore.
+		 */
+		void finish();
+
+		/** Return the number of bytes used by the resources and their names. */
+		size_t getMemoryUsage() const;
+
+	private:
+		struct hashName {
+			size_t operator()(const char *str) const;
+		};
+
+		struct equalName {
+			bool operator()(const char *str1, const char *str2) const;
+		};
+
+		typedef std::unordered_set<const char *, hashName, equalName> NameSet;
+
+		/** The resources themselves. */
+		std::vector<Resource> _resources;
+
+		/** Blocks of memory holding the resource names. */
+		std::vector<std::unique_ptr<char[]> > _nameBlocks;
+
+		size_t _nameBlockSize; ///< The size of the current name block.
+		size_t _nameBlockFill; ///< The number of bytes used in the current name block.
+		size_t _nameTableSize; ///< The total size of all name blocks.
+
+		/** All names stored so far, for deduplication. */
+		NameSet _names;
+
+		const char *internName(const Common::UString &name);
+		const char *internName(const char *name);
+	};
+
+	/** A resource name together with its type, as used for lookups. */
+	typedef std::pair<Common::UString, FileType> ResourceName;
 
 	Archive();
 	virtual ~Archive();
@@ -80,6 +174,51 @@ public:
 	uint32_t findResource(uint64_t hash) const;
 	/** Return the index of the resource matching the name and type, or 0xFFFFFFFF if not found. */
 	uint32_t findResource(const Common::UString &name, FileType type) const;
+
+	/** Look up several resources by hash at once.
+	 *
+	 *  For each hash, the returned list contains the index of the matching
+	 *  resource, or 0xFFFFFFFF if not found.
+	 */
+	std::vector<uint32_t> findResources(const std::vector<uint64_t> &hashes) const;
+	/** Look up several resources by name and type at once.
+	 *
+	 *  For each name, the returned list contains the index of the matching
+	 *  resource, or 0xFFFFFFFF if not found.
+	 */
+	std::vector<uint32_t> findResources(const std::vector<ResourceName> &names) const;
+
+private:
+	/** Key into the name lookup index, referencing the name of a resource. */
+	struct NameKey {
+		const char *name;
+		FileType type;
+
+		NameKey(const char *n, FileType t) : name(n), type(t) { }
+
+		bool operator==(const NameKey &key) const;
+	};
+
+	struct hashNameKey {
+		size_t operator()(const NameKey &key) const;
+	};
+
+	typedef std::unordered_map<uint64_t, uint32_t> HashIndex;
+	typedef std::unordered_map<NameKey, uint32_t, hashNameKey> NameIndex;
+
+	/** Index of resource hashes to resource indices, built on first use. */
+	mutable HashIndex _hashIndex;
+	/** Index of resource names and types to resource indices, built on first use. */
+	mutable NameIndex _nameIndex;
+
+	mutable std::once_flag _hashIndexBuilt;
+	mutable std::once_flag _nameIndexBuilt;
+
+	void buildHashIndex() const;
+	void buildNameIndex() const;
+
+	uint32_t findInHashIndex(uint64_t hash) const;
+	uint32_t findInNameIndex(const Common::UString &name, FileType type) const;
 };
 
 } // End of namespace Aurora
@@ -0,0 +1,336 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A persistent cache of archive indices.
+ */
+
+#include <cstring>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
+#include "src/common/writefile.h"
+#include "src/common/filepath.h"
+
+#include "src/aurora/archivecache.h"
+
+static const uint32_t kCacheID      = MKTAG('A', 'R', 'C', 'C');
+static const uint32_t kCacheVersion = 1;
+
+/** The size of a serialized resource, not counting its name's characters. */
+static const size_t kResourceSize = 4 + 8 + 4 + 4;
+
+namespace Aurora {
+
+ArchiveCache::ArchiveCache() : _modified(false), _mapFiles(true) {
+}
+
+ArchiveCache::~ArchiveCache() {
+}
+
+void ArchiveCache::setMapFiles(bool mapFiles) {
+	_mapFiles = mapFiles;
+}
+
+Common::SeekableReadStream *ArchiveCache::openFile(const Common::UString &path) const {
+	if (_mapFiles)
+		return new Common::MappedReadFile(path);
+
+	return new Common::ReadFile(path);
+}
+
+void ArchiveCache::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_modified = _modified || !_entries.empty();
+
+	_entries.clear();
+}
+
+size_t ArchiveCache::size() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _entries.size();
+}
+
+bool ArchiveCache::isModified() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _modified;
+}
+
+bool ArchiveCache::load(const Common::UString &cacheFile) {
+	EntryMap entries;
+
+	if (!Common::FilePath::isRegularFile(cacheFile))
+		return false;
+
+	try {
+		/* Read the whole file at once. It's small, and another instance of
+		 * us might replace it any time, which would crash us if it was mapped. */
+		Common::ReadFile file(cacheFile);
+		std::unique_ptr<Common::SeekableReadStream> stream(file.readStream(file.size()));
+
+		Common::SeekableReadStream &cache = *stream;
+
+		if (cache.readUint32BE() != kCacheID)
+			throw Common::Exception("Not an archive cache file");
+		if (cache.readUint32LE() != kCacheVersion)
+			throw Common::Exception("Unsupported archive cache version");
+
+		const uint32_t entryCount = readCount(cache, 4 + 8 + 8 + 4);
+		for (uint32_t i = 0; i < entryCount; i++) {
+			const Common::UString path = readString(cache);
+
+			Entry &entry = entries[path];
+
+			entry.size = cache.readUint64LE();
+			entry.time = (std::time_t) cache.readSint64LE();
+
+			const size_t indexSize = readCount(cache, 1);
+
+			entry.index.resize(indexSize);
+			if ((indexSize > 0) && (cache.read(entry.index.data(), indexSize) != indexSize))
+				throw Common::Exception(Common::kReadError);
+		}
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to load archive cache \"%s\"", cacheFile.c_str());
+		Common::printException(e, "WARNING: ");
+
+		clear();
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_entries.swap(entries);
+	_modified = false;
+
+	return true;
+}
+
+void ArchiveCache::save(const Common::UString &cacheFile) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Don't keep the indices of archives that are gone
+	removeMissingEntries();
+
+	if (!_modified)
+		return;
+
+	const Common::UString directory = Common::FilePath::getDirectory(cacheFile);
+	if (!directory.empty() && !Common::FilePath::isDirectory(directory))
+		Common::FilePath::createDirectories(directory);
+
+	/* Write into a new file first, and then replace the old one with it. That
+	 * way, a crash or another instance of us never leaves a truncated file. */
+	const Common::UString tempFile = Common::FilePath::getUniquePath(cacheFile + ".%%%%%%%%.tmp");
+
+	try {
+		Common::WriteFile cache(tempFile);
+
+		cache.writeUint32BE(kCacheID);
+		cache.writeUint32LE(kCacheVersion);
+
+		cache.writeUint32LE(_entries.size());
+		for (EntryMap::const_iterator e = _entries.begin(); e != _entries.end(); ++e) {
+			writeString(cache, e->first);
+
+			cache.writeUint64LE(e->second.size);
+			cache.writeSint64LE(e->second.time);
+
+			cache.writeUint32LE(e->second.index.size());
+			if (!e->second.index.empty())
+				cache.write(e->second.index.data(), e->second.index.size());
+		}
+
+		cache.flush();
+		cache.close();
+
+		Common::FilePath::renameFile(tempFile, cacheFile);
+
+	} catch (...) {
+		try {
+			Common::FilePath::removeFile(tempFile);
+		} catch (...) {
+		}
+
+		throw;
+	}
+
+	_modified = false;
+}
+
+void ArchiveCache::prune() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	removeMissingEntries();
+}
+
+void ArchiveCache::removeMissingEntries() {
+	for (EntryMap::iterator e = _entries.begin(); e != _entries.end(); ) {
+		if (Common::FilePath::isRegularFile(e->first)) {
+			++e;
+			continue;
+		}
+
+		e = _entries.erase(e);
+		_modified = true;
+	}
+}
+
+Common::SeekableReadStream *ArchiveCache::getIndex(const Common::UString &path) const {
+	const Common::UString key = getKey(path);
+
+	uint64_t size;
+	std::time_t time;
+	if (!getFileState(key, size, time))
+		return 0;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	EntryMap::const_iterator entry = _entries.find(key);
+	if ((entry == _entries.end()) || (entry->second.size != size) || (entry->second.time != time))
+		return 0;
+
+	// Copy the index, so that it stays valid even if the entry is replaced
+	byte *data = new byte[entry->second.index.size()];
+	std::memcpy(data, entry->second.index.data(), entry->second.index.size());
+
+	return new Common::MemoryReadStream(data, entry->second.index.size(), true);
+}
+
+void ArchiveCache::setIndex(const Common::UString &path, const byte *data, size_t size) {
+	const Common::UString key = getKey(path);
+
+	Entry entry;
+	if (!getFileState(key, entry.size, entry.time))
+		return;
+
+	entry.index.assign(data, data + size);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::swap(_entries[key], entry);
+	_modified = true;
+}
+
+void ArchiveCache::removeIndex(const Common::UString &path) {
+	const Common::UString key = getKey(path);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_entries.erase(key) > 0)
+		_modified = true;
+}
+
+Common::UString ArchiveCache::getDefaultCacheFile() {
+	return Common::FilePath::getUserDataFile("phaethon-archives.cache");
+}
+
+bool ArchiveCache::getFileState(const Common::UString &path, uint64_t &size, std::time_t &time) {
+	time = Common::FilePath::getModificationTime(path);
+	if (time == -1)
+		return false;
+
+	const size_t fileSize = Common::FilePath::getFileSize(path);
+	if (fileSize == Common::kFileInvalid)
+		return false;
+
+	size = fileSize;
+	return true;
+}
+
+Common::UString ArchiveCache::getKey(const Common::UString &path) {
+	return Common::FilePath::normalize(path);
+}
+
+void ArchiveCache::writeString(Common::WriteStream &index, const Common::UString &str) {
+	const std::string &data = str.toString();
+
+	index.writeUint32LE(data.size());
+	index.write(data.c_str(), data.size());
+}
+
+Common::UString ArchiveCache::readString(Common::SeekableReadStream &index) {
+	const uint32_t length = readCount(index, 1);
+	if (length == 0)
+		return "";
+
+	std::unique_ptr<char[]> data = std::make_unique<char[]>(length);
+	if (index.read(data.get(), length) != length)
+		throw Common::Exception(Common::kReadError);
+
+	return Common::UString(data.get(), length);
+}
+
+void ArchiveCache::writeResources(Common::WriteStream &index, const Archive::ResourceList &resources) {
+	index.writeUint32LE(resources.size());
+
+	for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+		writeString(index, r->name);
+
+		index.writeUint64LE(r->hash);
+		index.writeUint32LE((uint32_t) r->type);
+		index.writeUint32LE(r->index);
+	}
+}
+
+void ArchiveCache::readResources(Common::SeekableReadStream &index, Archive::ResourceList &resources) {
+	const uint32_t count = readCount(index, kResourceSize);
+
+	resources = Archive::ResourceList();
+	resources.reserve(count);
+
+	// Read the names into a reused buffer, to avoid a string allocation per resource
+	std::vector<char> name;
+
+	for (uint32_t i = 0; i < count; i++) {
+		const uint32_t length = readCount(index, 1);
+
+		name.resize(length + 1);
+		if ((length > 0) && (index.read(name.data(), length) != length))
+			throw Common::Exception(Common::kReadError);
+
+		name[length] = '\0';
+
+		const uint64_t hash  = index.readUint64LE();
+		const FileType type  = (FileType) index.readUint32LE();
+		const uint32_t resID = index.readUint32LE();
+
+		resources.add(name.data(), type, resID, hash);
+	}
+
+	resources.finish();
+}
+
+uint32_t ArchiveCache::readCount(Common::SeekableReadStream &index, size_t elementSize) {
+	const uint32_t count = index.readUint32LE();
+
+	if (((uint64_t) count * elementSize) > (uint64_t) (index.size() - index.pos()))
+		throw Common::Exception("Archive index too short for %u elements", count);
+
+	return count;
+}
+
+} // End of namespace Aurora
@@ -0,0 +1,209 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A persistent cache of archive indices.
+ */
+
+#ifndef AURORA_ARCHIVECACHE_H
+#define AURORA_ARCHIVECACHE_H
+
+#include <ctime>
+#include <vector>
+#include <memory>
+#include <map>
+#include <atomic>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/error.h"
+#include "src/common/mutex.h"
+#include "src/common/readfile.h"
+#include "src/common/memwritestream.h"
+
+#include "src/aurora/archive.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class WriteStream;
+}
+
+namespace Aurora {
+
+/** A persistent, on-disk cache of archive indices.
+ *
+ *  Opening an archive normally means parsing its headers and resource
+ *  tables. For a whole game installation, with dozens of big KEY and BIF
+ *  files, that adds up. The ArchiveCache stores a compact serialization of
+ *  each archive's resource table (an index), keyed by the archive's path,
+ *  size and modification time.
+ *
+ *  The cacheable archive classes (KEYFile, BIFFile, BZFFile, ERFFile,
+ *  RIMFile and HERFFile) provide writeIndex() to create such an index, and
+ *  a constructor that rehydrates the archive from one, without reading any
+ *  of the archive's headers.
+ *
+ *  Entries whose archive changed size or modification time are stale. They
+ *  are not used, and replaced individually the next time the archive is
+ *  opened through open().
+ *
+ *  Archive files are memory-mapped by default. A mapped file that's
+ *  truncated or rewritten while still open crashes the process on the next
+ *  access, though. So when the files might change underneath us, like in
+ *  the GUI, they should be read normally instead, see setMapFiles().
+ *
+ *  All methods are thread-safe.
+ */
+class ArchiveCache : boost::noncopyable {
+public:
+	ArchiveCache();
+	~ArchiveCache();
+
+	/** Should archive files opened through open() be memory-mapped? */
+	void setMapFiles(bool mapFiles);
+
+	/** Remove all entries. */
+	void clear();
+
+	/** Return the number of entries in the cache. */
+	size_t size() const;
+
+	/** Was the cache changed since it was last loaded or saved? */
+	bool isModified() const;
+
+	/** Load the cache from a file.
+	 *
+	 *  A missing, broken or outdated cache file results in an empty cache.
+	 *
+	 *  @return true if the cache file was loaded.
+	 */
+	bool load(const Common::UString &cacheFile);
+
+	/** Write the cache into a file, if it was changed.
+	 *
+	 *  The entries of archives that don't exist anymore are removed first.
+	 *  The file is replaced atomically, so that it's never left half-written.
+	 */
+	void save(const Common::UString &cacheFile);
+
+	/** Remove the entries of all archives that don't exist anymore. */
+	void prune();
+
+	/** Return the cached index of this archive file.
+	 *
+	 *  @return A stream of the index, or 0 if the archive has no entry, or a stale one.
+	 */
+	Common::SeekableReadStream *getIndex(const Common::UString &path) const;
+
+	/** Set the index of this archive file.
+	 *
+	 *  The archive's current size and modification time are stored alongside.
+	 */
+	void setIndex(const Common::UString &path, const byte *data, size_t size);
+
+	/** Remove the index of this archive file. */
+	void removeIndex(const Common::UString &path);
+
+	/** Open an archive file, using the cached index if possible.
+	 *
+	 *  If no index for this archive is cached, or the cached index is stale,
+	 *  the archive is fully read and its fresh index added to the cache.
+	 *
+	 *  @param path The path to the archive file.
+	 *  @param args Additional parameters for the archive's constructor.
+	 */
+	template<class T, typename... Args>
+	T *open(const Common::UString &path, Args &&... args);
+
+	/** Open an archive file, mapped or not, see setMapFiles(). */
+	Common::SeekableReadStream *openFile(const Common::UString &path) const;
+
+	/** Return the path of the cache file used by default. */
+	static Common::UString getDefaultCacheFile();
+
+	// .--- Helpers for reading and writing archive indices
+	/** Write a string into an index. */
+	static void writeString(Common::WriteStream &index, const Common::UString &str);
+	/** Read a string out of an index. */
+	static Common::UString readString(Common::SeekableReadStream &index);
+
+	/** Write a list of resources into an index. */
+	static void writeResources(Common::WriteStream &index, const Archive::ResourceList &resources);
+	/** Read a list of resources out of an index. */
+	static void readResources(Common::SeekableReadStream &index, Archive::ResourceList &resources);
+
+	/** Read the number of elements in an index list, making sure the index is large enough to hold them. */
+	static uint32_t readCount(Common::SeekableReadStream &index, size_t elementSize);
+	// '---
+
+private:
+	/** A cached archive index. */
+	struct Entry {
+		uint64_t    size; ///< The size of the archive file.
+		std::time_t time; ///< The modification time of the archive file.
+
+		std::vector<byte> index; ///< The archive index.
+	};
+
+	typedef std::map<Common::UString, Entry> EntryMap;
+
+	EntryMap _entries;
+
+	bool _modified;
+
+	std::atomic<bool> _mapFiles;
+
+	mutable std::mutex _mutex;
+
+	/** Remove the entries of all archives that don't exist anymore. The mutex must be held. */
+	void removeMissingEntries();
+
+	/** Return the size and modification time of a file. */
+	static bool getFileState(const Common::UString &path, uint64_t &size, std::time_t &time);
+
+	static Common::UString getKey(const Common::UString &path);
+};
+
+template<class T, typename... Args>
+T *ArchiveCache::open(const Common::UString &path, Args &&... args) {
+	std::unique_ptr<Common::SeekableReadStream> index(getIndex(path));
+	if (index) {
+		try {
+			return new T(openFile(path), *index, args...);
+		} catch (Common::Exception &) {
+			// A broken index. Read the whole archive and replace it
+		}
+	}
+
+	std::unique_ptr<T> archive = std::make_unique<T>(openFile(path), args...);
+
+	Common::MemoryWriteStreamDynamic newIndex(true);
+	archive->writeIndex(newIndex);
+
+	setIndex(path, newIndex.getData(), newIndex.size());
+
+	return archive.release();
+}
+
+} // End of namespace Aurora
+
+#endif // AURORA_ARCHIVECACHE_H
@@ -32,6 +32,7 @@
 #include "src/common/strutil.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/writestream.h"
 
 #include "src/aurora/biffile.h"
 
@@ -47,6 +48,12 @@ BIFFile::BIFFile(Common::SeekableReadStream *bif) : _bif(bif) {
 	load(*_bif);
 }
 
+BIFFile::BIFFile(Common::SeekableReadStream *bif, Common::SeekableReadStream &index) : _bif(bif) {
+	assert(_bif);
+
+	readIndex(index);
+}
+
 BIFFile::~BIFFile() {
 }
 
@@ -96,14 +103,33 @@ void BIFFile::readVarResTable(Common::SeekableReadStream &bif, uint32_t offset)
 	}
 }
 
-Common::SeekableReadStream *BIFFile::getResource(uint32_t index) const {
+void BIFFile::writeIndex(Common::WriteStream &index) const {
+	index.writeUint32BE(_id);
+	index.writeUint32BE(_version);
+
+	writeResourceIndex(index);
+}
+
+void BIFFile::readIndex(Common::SeekableReadStream &index) {
+	_id      = index.readUint32BE();
+	_version = index.readUint32BE();
+
+	if ((_id != kBIFID) || ((_version != kVersion1) && (_version != kVersion11)))
+		throw Common::Exception("Not a BIF index (%s, %s)", Common::debugTag(_id).c_str(),
+		                        Common::debugTag(_version).c_str());
+
+	readResourceIndex(index);
+}
+
+Common::SeekableReadStream *BIFFile::getResource(uint32_t index, bool tryNoCopy) const {
 	const Resource &res = getRes(index);
 	if (res.size == 0)
 		return new Common::MemoryReadStream(static_cast<const byte *>(0), 0);
 
-	_bif->seek(res.offset);
+	if (tryNoCopy)
+		return _bif->createSubStream(res.offset, res.offset + res.size);
 
-	std::unique_ptr<Common::SeekableReadStream> resStream(_bif->readStream(res.size));
+	std::unique_ptr<Common::SeekableReadStream> resStream(_bif->readStreamAt(res.offset, res.size));
 
 	if (!resStream || (((uint32_t) resStream->size()) != res.size))
 		throw Common::Exception(Common::kReadError);
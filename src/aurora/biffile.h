@@ -65,10 +65,15 @@ class BIFFile : public AuroraFile, public KEYDataFile {
 public:
 	/** Take over this stream and read a BIF file out of it. */
 	BIFFile(Common::SeekableReadStream *bif);
+	/** Take over this stream and read the BIF's resource table out of an index, as written by writeIndex(). */
+	BIFFile(Common::SeekableReadStream *bif, Common::SeekableReadStream &index);
 	~BIFFile();
 
+	/** Write an index of this BIF, for use with ArchiveCache. */
+	void writeIndex(Common::WriteStream &index) const;
+
 	/** Return a stream of the resource's contents. */
-	Common::SeekableReadStream *getResource(uint32_t index) const;
+	Common::SeekableReadStream *getResource(uint32_t index, bool tryNoCopy = false) const;
 
 private:
 	std::unique_ptr<Common::SeekableReadStream> _bif;
@@ -76,6 +81,8 @@ private:
 	void load(Common::SeekableReadStream &bif);
 
 	void readVarResTable(Common::SeekableReadStream &bif, uint32_t offset);
+
+	void readIndex(Common::SeekableReadStream &index);
 };
 
 } // End of namespace Aurora
@@ -26,11 +26,13 @@
  */
 
 #include <cassert>
+#include <memory>
 
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/writestream.h"
 #include "src/common/lzma.h"
 
 #include "src/aurora/bzffile.h"
@@ -46,6 +48,12 @@ BZFFile::BZFFile(Common::SeekableReadStream *bzf) : _bzf(bzf) {
 	load(*_bzf);
 }
 
+BZFFile::BZFFile(Common::SeekableReadStream *bzf, Common::SeekableReadStream &index) : _bzf(bzf) {
+	assert(_bzf);
+
+	readIndex(index);
+}
+
 BZFFile::~BZFFile() {
 }
 
@@ -96,14 +104,42 @@ void BZFFile::readVarResTable(Common::SeekableReadStream &bzf, uint32_t offset)
 		_resources.back().packedSize = bzf.size() - _resources.back().offset;
 }
 
-Common::SeekableReadStream *BZFFile::getResource(uint32_t index) const {
+void BZFFile::writeIndex(Common::WriteStream &index) const {
+	index.writeUint32BE(_id);
+	index.writeUint32BE(_version);
+
+	writeResourceIndex(index);
+}
+
+void BZFFile::readIndex(Common::SeekableReadStream &index) {
+	_id      = index.readUint32BE();
+	_version = index.readUint32BE();
+
+	if ((_id != kBZFID) || (_version != kVersion1))
+		throw Common::Exception("Not a BZF index (%s, %s)", Common::debugTag(_id).c_str(),
+		                        Common::debugTag(_version).c_str());
+
+	readResourceIndex(index);
+}
+
+Common::SeekableReadStream *BZFFile::getResource(uint32_t index, bool UNUSED(tryNoCopy)) const {
 	const Resource &res = getRes(index);
 	if ((res.packedSize == 0) || (res.size == 0))
 		return new Common::MemoryReadStream(static_cast<const byte *>(0), 0);
 
-	_bzf->seek(res.offset);
+	std::unique_ptr<Common::SeekableReadStream>
+		packedStream(_bzf->createSubStream(res.offset, res.offset + res.packedSize));
+
+	/* decompressLZMA1() reuses the LZMA1 decoder of the calling thread.
+	 * If the BZF is mapped into memory, decompress straight from it. */
+	const byte *packedData = packedStream->getData();
+	if (packedData) {
+		const byte *data = Common::decompressLZMA1(packedData, res.packedSize, res.size);
+
+		return new Common::MemoryReadStream(data, res.size, true);
+	}
 
-	return Common::decompressLZMA1(*_bzf, res.packedSize, res.size);
+	return Common::decompressLZMA1(*packedStream, res.packedSize, res.size);
 }
 
 } // End of namespace Aurora
@@ -49,10 +49,15 @@ class BZFFile : public AuroraFile, public KEYDataFile {
 public:
 	/** Take over this stream and read a BZF file out of it. */
 	BZFFile(Common::SeekableReadStream *bzf);
+	/** Take over this stream and read the BZF's resource table out of an index, as written by writeIndex(). */
+	BZFFile(Common::SeekableReadStream *bzf, Common::SeekableReadStream &index);
 	~BZFFile();
 
+	/** Write an index of this BZF, for use with ArchiveCache. */
+	void writeIndex(Common::WriteStream &index) const;
+
 	/** Return a stream of the resource's contents. */
-	Common::SeekableReadStream *getResource(uint32_t index) const;
+	Common::SeekableReadStream *getResource(uint32_t index, bool tryNoCopy = false) const;
 
 private:
 	std::unique_ptr<Common::SeekableReadStream> _bzf;
@@ -60,6 +65,8 @@ private:
 	void load(Common::SeekableReadStream &bzf);
 
 	void readVarResTable(Common::SeekableReadStream &bzf, uint32_t offset);
+
+	void readIndex(Common::SeekableReadStream &index);
 };
 
 } // End of namespace Aurora
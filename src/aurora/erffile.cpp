@@ -36,12 +36,16 @@
 #include "src/common/encoding.h"
 #include "src/common/md5.h"
 #include "src/common/blowfish.h"
+#include "src/common/blowfishreadstream.h"
 #include "src/common/deflate.h"
+#include "src/common/inflatereadstream.h"
 #include "src/common/lzma.h"
 #include "src/common/lzx.h"
+#include "src/common/writestream.h"
 
 #include "src/aurora/erffile.h"
 #include "src/aurora/util.h"
+#include "src/aurora/archivecache.h"
 
 static const uint32_t kERFID     = MKTAG('E', 'R', 'F', ' ');
 static const uint32_t kMODID     = MKTAG('M', 'O', 'D', ' ');
@@ -54,6 +58,9 @@ static const uint32_t kVersion21 = MKTAG('V', '2', '.', '1');
 static const uint32_t kVersion22 = MKTAG('V', '2', '.', '2');
 static const uint32_t kVersion30 = MKTAG('V', '3', '.', '0');
 
+/** Zlib-compressed resources of at least this size are decompressed on demand. */
+static const uint32_t kMinInflateOnDemandSize = 256 * 1024;
+
 namespace Aurora {
 
 static const size_t kNWNPremiumKeyLength = 56;
@@ -115,7 +122,8 @@ void ERFFile::ERFHeader::clear() {
 	buildYear = 0;
 	buildDay  = 0;
 
-	isNWNPremium = false;
+	isNWNPremium  = false;
+	nwnPremiumKey = 0;
 
 	moduleID = 0;
 
@@ -157,6 +165,14 @@ ERFFile::ERFFile(Common::SeekableReadStream *erf, const std::vector<byte> &passw
 	load();
 }
 
+ERFFile::ERFFile(Common::SeekableReadStream *erf, Common::SeekableReadStream &index,
+                 const std::vector<byte> &password) : _erf(erf), _password(password) {
+
+	assert(_erf);
+
+	loadIndex(index);
+}
+
 ERFFile::~ERFFile() {
 }
 
@@ -235,22 +251,30 @@ bool ERFFile::decryptNWNPremiumHeader(Common::SeekableReadStream &erf, ERFHeader
 	return header.isSensible(erf.size());
 }
 
-bool ERFFile::findNWNPremiumKey(Common::SeekableReadStream &erf, ERFHeader &header,
-                                const std::vector<byte> &md5, std::vector<byte> &password) {
-
+void ERFFile::getNWNPremiumKey(size_t key, const std::vector<byte> &md5, std::vector<byte> &password) {
+	assert(key < ARRAYSIZE(kNWNPremiumKeys));
 	assert(md5.empty() || (md5.size() == Common::kMD5Length));
 
 	password.resize(kNWNPremiumKeyLength);
+
+	std::memcpy(&password[0], kNWNPremiumKeys[key], kNWNPremiumKeyLength);
+	if (!md5.empty())
+		std::memcpy(&password[0] + kNWNPremiumKeyLength - Common::kMD5Length, &md5[0], Common::kMD5Length);
+}
+
+bool ERFFile::findNWNPremiumKey(Common::SeekableReadStream &erf, ERFHeader &header,
+                                const std::vector<byte> &md5, std::vector<byte> &password) {
+
 	const size_t headerPos = erf.pos();
 
 	for (size_t i = 0; i < ARRAYSIZE(kNWNPremiumKeys); i++) {
-		std::memcpy(&password[0], kNWNPremiumKeys[i], kNWNPremiumKeyLength);
-		if (!md5.empty())
-			std::memcpy(&password[0] + kNWNPremiumKeyLength - Common::kMD5Length, &md5[0], Common::kMD5Length);
+		getNWNPremiumKey(i, md5, password);
 
 		erf.seek(headerPos);
-		if (decryptNWNPremiumHeader(erf, header, password))
+		if (decryptNWNPremiumHeader(erf, header, password)) {
+			header.nwnPremiumKey = i;
 			return true;
+		}
 	}
 
 	return false;
@@ -301,12 +325,141 @@ void ERFFile::load() {
 
 }
 
+void ERFFile::loadIndex(Common::SeekableReadStream &index) {
+	try {
+
+		readIndex(index);
+
+		verifyPasswordDigest();
+
+		if (_header.isNWNPremium) {
+			/* The index only remembers which of the premium module keys is in use,
+			 * together with a digest of the final key, to check the MD5 we were given. */
+
+			if (!_password.empty() && (_password.size() != Common::kMD5Length))
+				throw Common::Exception("Invalid Neverwinter Nights premium module MD5 length (%u)",
+				                        (uint)_password.size());
+
+			if (_header.nwnPremiumKey >= ARRAYSIZE(kNWNPremiumKeys))
+				throw Common::Exception("Invalid Neverwinter Nights premium module key %u", _header.nwnPremiumKey);
+
+			const std::vector<byte> md5 = _password;
+			getNWNPremiumKey(_header.nwnPremiumKey, md5, _password);
+
+			if (!Common::compareMD5Digest(_password, _header.passwordDigest))
+				throw Common::Exception("Wrong Neverwinter Nights premium module key");
+
+			decryptNWNPremium();
+		}
+
+	} catch (Common::Exception &e) {
+		e.add("Failed reading ERF index");
+		throw;
+	}
+}
+
+void ERFFile::writeIndex(Common::WriteStream &index) const {
+	index.writeUint32BE(_id);
+	index.writeUint32BE(_version);
+	index.writeByte(_utf16le ? 1 : 0);
+
+	index.writeUint32LE(_header.buildYear);
+	index.writeUint32LE(_header.buildDay);
+	index.writeUint32LE(_header.moduleID);
+
+	// The encryption of premium modules is handled by the archive stream, after loading
+	const Encryption encryption = _header.isNWNPremium ? kEncryptionBlowfishNWN : _header.encryption;
+
+	index.writeUint32LE((uint32_t) encryption);
+	index.writeUint32LE((uint32_t) _header.compression);
+
+	index.writeByte(_header.isNWNPremium ? 1 : 0);
+	index.writeUint32LE(_header.nwnPremiumKey);
+
+	std::vector<byte> passwordDigest = _header.passwordDigest;
+	if (_header.isNWNPremium)
+		Common::hashMD5(_password, passwordDigest);
+
+	index.writeUint32LE(passwordDigest.size());
+	if (!passwordDigest.empty())
+		index.write(passwordDigest.data(), passwordDigest.size());
+
+	std::vector<LocString::SubLocString> description;
+	_description.getStrings(description);
+
+	index.writeUint32LE(_description.getID());
+	index.writeUint32LE(description.size());
+	for (std::vector<LocString::SubLocString>::const_iterator d = description.begin(); d != description.end(); ++d) {
+		index.writeUint32LE(d->language);
+		ArchiveCache::writeString(index, d->str);
+	}
+
+	ArchiveCache::writeResources(index, _resources);
+
+	index.writeUint32LE(_iResources.size());
+	for (IResourceList::const_iterator iRes = _iResources.begin(); iRes != _iResources.end(); ++iRes) {
+		index.writeUint32LE(iRes->offset);
+		index.writeUint32LE(iRes->packedSize);
+		index.writeUint32LE(iRes->unpackedSize);
+	}
+}
+
+void ERFFile::readIndex(Common::SeekableReadStream &index) {
+	_id      = index.readUint32BE();
+	_version = index.readUint32BE();
+	_utf16le = index.readByte() != 0;
+
+	verifyVersion(_id, _version, _utf16le);
+
+	_header.clear();
+
+	_header.buildYear = index.readUint32LE();
+	_header.buildDay  = index.readUint32LE();
+	_header.moduleID  = index.readUint32LE();
+
+	_header.encryption  = (Encryption)  index.readUint32LE();
+	_header.compression = (Compression) index.readUint32LE();
+
+	_header.isNWNPremium  = index.readByte() != 0;
+	_header.nwnPremiumKey = index.readUint32LE();
+
+	_header.passwordDigest.resize(ArchiveCache::readCount(index, 1));
+	const size_t digestSize = _header.passwordDigest.size();
+	if ((digestSize > 0) && (index.read(_header.passwordDigest.data(), digestSize) != digestSize))
+		throw Common::Exception(Common::kReadError);
+
+	_description.clear();
+	_description.setID(index.readUint32LE());
+
+	std::vector<LocString::SubLocString> description(ArchiveCache::readCount(index, 8));
+	for (std::vector<LocString::SubLocString>::iterator d = description.begin(); d != description.end(); ++d) {
+		d->language = index.readUint32LE();
+		d->str      = ArchiveCache::readString(index);
+	}
+
+	_description.setStrings(description);
+
+	ArchiveCache::readResources(index, _resources);
+
+	_iResources.resize(ArchiveCache::readCount(index, 12));
+	if (_iResources.size() != _resources.size())
+		throw Common::Exception("ERF index resource count mismatch");
+
+	for (IResourceList::iterator iRes = _iResources.begin(); iRes != _iResources.end(); ++iRes) {
+		iRes->offset       = index.readUint32LE();
+		iRes->packedSize   = index.readUint32LE();
+		iRes->unpackedSize = index.readUint32LE();
+	}
+
+	_header.resCount = _resources.size();
+}
+
 void ERFFile::decryptNWNPremium() {
 	assert(_header.encryption == kEncryptionBlowfishNWN);
 
-	_erf->seek(0);
-
-	_erf.reset(decrypt(*_erf, kEncryptionBlowfishNWN, _password));
+	/* Decrypt the whole archive on demand, so that opening a premium module
+	 * only needs to decrypt its header and resource lists. */
+	_erf.reset(new Common::BlowfishReadStream(_erf.release(), _password));
 
 	_header.encryption = kEncryptionNone;
 }
@@ -553,6 +706,7 @@ void ERFFile::readResources(Common::SeekableReadStream &erf, const ERFHeader &he
 
 	}
 
+	_resources.finish();
 }
 
 void ERFFile::readV10KeyList(Common::SeekableReadStream &erf, const ERFHeader &header) {
@@ -560,7 +714,7 @@ void ERFFile::readV10KeyList(Common::SeekableReadStream &erf, const ERFHeader &h
 
 	uint32_t index = 0;
 	for (ResourceList::iterator res = _resources.begin(); res != _resources.end(); ++index, ++res) {
-		res->name = Common::readStringFixed(erf, Common::kEncodingASCII, 16);
+		_resources.setName(*res, Common::readStringFixed(erf, Common::kEncodingASCII, 16));
 		erf.skip(4); // Resource ID
 		res->type = (FileType) erf.readUint16LE();
 		erf.skip(2); // Reserved
@@ -573,7 +727,7 @@ void ERFFile::readV11KeyList(Common::SeekableReadStream &erf, const ERFHeader &h
 
 	uint32_t index = 0;
 	for (ResourceList::iterator res = _resources.begin(); res != _resources.end(); ++index, ++res) {
-		res->name = Common::readStringFixed(erf, Common::kEncodingASCII, 32);
+		_resources.setName(*res, Common::readStringFixed(erf, Common::kEncodingASCII, 32));
 		erf.skip(4); // Resource ID
 		res->type = (FileType) erf.readUint16LE();
 		erf.skip(2); // Reserved
@@ -599,7 +753,7 @@ void ERFFile::readV20ResList(Common::SeekableReadStream &erf, const ERFHeader &h
 	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++index, ++res, ++iRes) {
 		Common::UString name = Common::readStringFixed(erf, Common::kEncodingUTF16LE, 64);
 
-		res->name  = TypeMan.setFileType(name, kFileTypeNone);
+		_resources.setName(*res, TypeMan.setFileType(name, kFileTypeNone));
 		res->type  = TypeMan.getFileType(name);
 		res->index = index;
 
@@ -618,7 +772,7 @@ void ERFFile::readV21ResList(Common::SeekableReadStream &erf, const ERFHeader &h
 	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++index, ++res, ++iRes) {
 		Common::UString name = Common::readStringFixed(erf, Common::kEncodingASCII, 32);
 
-		res->name  = TypeMan.setFileType(name, kFileTypeNone);
+		_resources.setName(*res, TypeMan.setFileType(name, kFileTypeNone));
 		res->type  = TypeMan.getFileType(name);
 		res->index = index;
 
@@ -638,7 +792,7 @@ void ERFFile::readV22ResList(Common::SeekableReadStream &erf, const ERFHeader &h
 	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++index, ++res, ++iRes) {
 		Common::UString name = Common::readStringFixed(erf, Common::kEncodingUTF16LE, 64);
 
-		res->name  = TypeMan.setFileType(name, kFileTypeNone);
+		_resources.setName(*res, TypeMan.setFileType(name, kFileTypeNone));
 		res->type  = TypeMan.getFileType(name);
 		res->index = index;
 
@@ -663,7 +817,7 @@ void ERFFile::readV30ResList(Common::SeekableReadStream &erf, const ERFHeader &h
 				throw Common::Exception("Invalid ERF string table offset");
 
 			Common::UString name = header.stringTable.get() + nameOffset;
-			res->name = TypeMan.setFileType(name, kFileTypeNone);
+			_resources.setName(*res, TypeMan.setFileType(name, kFileTypeNone));
 			res->type = TypeMan.getFileType(name);
 		}
 
@@ -715,12 +869,26 @@ Common::SeekableReadStream *ERFFile::getResource(uint32_t index, bool tryNoCopy)
 	const IResource &res = getIResource(index);
 
 	if (tryNoCopy && (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone))
-		return new Common::SeekableSubReadStream(_erf.get(), res.offset, res.offset + res.packedSize);
+		return _erf->createSubStream(res.offset, res.offset + res.packedSize);
+
+	/* Read. If the archive is mapped into memory, decrypt/decompress straight from it.
+	 * Unless the resource is decompressed on demand, since the resulting stream
+	 * would then keep referencing the archive's data. */
+	Common::MemoryReadStream *stream = 0;
+	if ((_header.encryption != kEncryptionNone) || (_header.compression != kCompressionNone)) {
+		const bool keepsPackedData = (_header.encryption == kEncryptionNone) && isInflatedOnDemand(res.unpackedSize);
+
+		const byte *erfData = _erf->getData();
+		if (erfData && (tryNoCopy || !keepsPackedData)) {
+			if (((size_t)res.offset + res.packedSize) > _erf->size())
+				throw Common::Exception(Common::kReadError);
 
-	_erf->seek(res.offset);
+			stream = new Common::MemoryReadStream(erfData + res.offset, res.packedSize);
+		}
+	}
 
-	// Read
-	Common::MemoryReadStream *stream = _erf->readStream(res.packedSize);
+	if (!stream)
+		stream = _erf->readStreamAt(res.offset, res.packedSize);
 
 	// Decrypt
 	if (_header.encryption != kEncryptionNone)
@@ -806,12 +974,14 @@ Common::SeekableReadStream *ERFFile::decompressBiowareZlib(Common::MemoryReadStr
 
 	assert(packedStream);
 
-	std::unique_ptr<Common::MemoryReadStream> stream(packedStream);
+	if (packedStream->size() < 1) {
+		delete packedStream;
+		throw Common::Exception(Common::kReadError);
+	}
 
-	const byte * const compressedData = stream->getData();
-	const uint32_t packedSize = stream->size();
+	const int windowBits = *packedStream->getData() >> 4;
 
-	return decompressZlib(compressedData + 1, packedSize - 1, unpackedSize, *compressedData >> 4);
+	return decompressZlib(packedStream, 1, unpackedSize, windowBits);
 }
 
 Common::SeekableReadStream *ERFFile::decompressHeaderlessZlib(Common::MemoryReadStream *packedStream,
@@ -821,12 +991,7 @@ Common::SeekableReadStream *ERFFile::decompressHeaderlessZlib(Common::MemoryRead
 
 	assert(packedStream);
 
-	std::unique_ptr<Common::MemoryReadStream> stream(packedStream);
-
-	const byte * const compressedData = stream->getData();
-	const uint32_t packedSize = stream->size();
-
-	return decompressZlib(compressedData, packedSize, unpackedSize, Common::kWindowBitsMax);
+	return decompressZlib(packedStream, 0, unpackedSize, Common::kWindowBitsMax);
 }
 
 Common::SeekableReadStream *ERFFile::decompressStandardZlib(Common::MemoryReadStream *packedStream,
@@ -836,21 +1001,43 @@ Common::SeekableReadStream *ERFFile::decompressStandardZlib(Common::MemoryReadSt
 
 	assert(packedStream);
 
-	std::unique_ptr<Common::MemoryReadStream> stream(packedStream);
-
-	const byte * const compressedData = stream->getData();
-	const uint32_t packedSize = stream->size();
-
-	return decompressZlib(compressedData, packedSize, unpackedSize, -Common::kWindowBitsMax);
+	return decompressZlib(packedStream, 0, unpackedSize, -Common::kWindowBitsMax);
 }
 
-Common::SeekableReadStream *ERFFile::decompressZlib(const byte *compressedData, uint32_t packedSize,
+Common::SeekableReadStream *ERFFile::decompressZlib(Common::MemoryReadStream *packedStream, size_t offset,
                                                     uint32_t unpackedSize, int windowBits) const {
 
+	std::unique_ptr<Common::MemoryReadStream> stream(packedStream);
+	if (offset > stream->size())
+		throw Common::Exception(Common::kReadError);
+
 	// Decompress. Negative window size to signal not to look for a gzip header.
-	const byte *data = Common::decompressDeflate(compressedData, packedSize, unpackedSize, -windowBits);
 
-	return new Common::MemoryReadStream(data, unpackedSize, true);
+	if (isInflatedOnDemand(unpackedSize)) {
+		Common::SeekableReadStream *compressedStream = stream.release();
+		if (offset > 0)
+			compressedStream = new Common::SeekableSubReadStream(compressedStream, offset, compressedStream->size(), true);
+
+		return new Common::InflateReadStream(compressedStream, unpackedSize, -windowBits);
+	}
+
+	// Decompress in one go, reusing the inflate context of this thread
+	std::unique_ptr<byte[]> data = std::make_unique<byte[]>(unpackedSize);
+
+	Common::InflateContext::getThreadContext().decompress(stream->getData() + offset, stream->size() - offset,
+	                                                      data.get(), unpackedSize, -windowBits);
+
+	return new Common::MemoryReadStream(data.release(), unpackedSize, true);
+}
+
+bool ERFFile::isInflatedOnDemand(uint32_t unpackedSize) const {
+	if ((_header.compression != kCompressionBioWareZlib) &&
+	    (_header.compression != kCompressionHeaderlessZlib) &&
+	    (_header.compression != kCompressionStandardZlib))
+		return false;
+
+	// Small resources are cheaper to decompress in one go
+	return unpackedSize >= kMinInflateOnDemandSize;
 }
 
 std::unique_ptr<Common::SeekableReadStream> ERFFile::decompressLZMA(std::unique_ptr<Common::SeekableReadStream> packedStream,
@@ -38,6 +38,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class WriteStream;
 }
 
 namespace Aurora {
@@ -118,8 +119,18 @@ public:
 	 *  to calculate the key to decrypt the .hak file.
 	 */
 	ERFFile(Common::SeekableReadStream *erf, const std::vector<byte> &password = std::vector<byte>());
+	/** Take over this stream and read the ERF's header information and resource
+	 *  list out of an index, as written by writeIndex().
+	 *
+	 *  The same password as when reading the ERF file itself is needed.
+	 */
+	ERFFile(Common::SeekableReadStream *erf, Common::SeekableReadStream &index,
+	        const std::vector<byte> &password = std::vector<byte>());
 	~ERFFile();
 
+	/** Write an index of this ERF, for use with ArchiveCache. */
+	void writeIndex(Common::WriteStream &index) const;
+
 	/** Return the list of resources. */
 	const ResourceList &getResources() const;
 
@@ -181,6 +192,7 @@ private:
 		uint32_t buildDay;         ///< The day of year the ERF was built.
 
 		bool     isNWNPremium;     ///< Is this a Neverwinter Nights premium module?
+		uint32_t nwnPremiumKey;    ///< The Neverwinter Nights premium module key in use.
 
 		std::unique_ptr<char[]> stringTable; ///< String table used for hashed ERFs.
 		uint32_t stringTableSize;            ///< Size of the string table.
@@ -228,6 +240,9 @@ private:
 	std::vector<byte> _password;
 
 	void load();
+	void loadIndex(Common::SeekableReadStream &index);
+
+	void readIndex(Common::SeekableReadStream &index);
 
 	// .--- Header
 	static void verifyVersion(uint32_t id, uint32_t version, bool utf16le);
@@ -284,6 +299,8 @@ private:
 	static Common::SeekableReadStream *decrypt(Common::SeekableReadStream &erf, size_t size,
 	                                           Encryption encryption, const std::vector<byte> &password);
 
+	static void getNWNPremiumKey(size_t key, const std::vector<byte> &md5, std::vector<byte> &password);
+
 	static bool decryptNWNPremiumHeader(Common::SeekableReadStream &erf, ERFHeader &header,
 	                                    const std::vector<byte> &password);
 	static bool findNWNPremiumKey      (Common::SeekableReadStream &erf, ERFHeader &header,
@@ -305,9 +322,12 @@ private:
 	Common::SeekableReadStream *decompressStandardZlib  (Common::MemoryReadStream *packedStream,
 	                                                     uint32_t unpackedSize) const;
 
-	Common::SeekableReadStream *decompressZlib(const byte *compressedData, uint32_t packedSize,
+	Common::SeekableReadStream *decompressZlib(Common::MemoryReadStream *packedStream, size_t offset,
 	                                           uint32_t unpackedSize, int windowBits) const;
 
+	/** Will a resource of this size be decompressed on demand, while it is read? */
+	bool isInflatedOnDemand(uint32_t unpackedSize) const;
+
 	std::unique_ptr<Common::SeekableReadStream> decompressLZMA(std::unique_ptr<Common::SeekableReadStream> packedStream,
 	                                                           uint32_t unpackedSize) const;
 
@@ -30,9 +30,13 @@
 #include "src/common/memreadstream.h"
 #include "src/common/encoding.h"
 #include "src/common/hash.h"
+#include "src/common/writestream.h"
 
 #include "src/aurora/herffile.h"
 #include "src/aurora/util.h"
+#include "src/aurora/archivecache.h"
+
+static const uint32_t kHERFID = 0x00F1A5C0;
 
 namespace Aurora {
 
@@ -42,12 +46,20 @@ HERFFile::HERFFile(Common::SeekableReadStream *herf) : _herf(herf), _dictOffset(
 	load(*_herf);
 }
 
+HERFFile::HERFFile(Common::SeekableReadStream *herf, Common::SeekableReadStream &index) :
+	_herf(herf), _dictOffset(0xFFFFFFFF), _dictSize(0) {
+
+	assert(_herf);
+
+	readIndex(index);
+}
+
 HERFFile::~HERFFile() {
 }
 
 void HERFFile::load(Common::SeekableReadStream &herf) {
 	uint32_t magic = herf.readUint32LE();
-	if (magic != 0x00F1A5C0)
+	if (magic != kHERFID)
 		throw Common::Exception("Invalid HERF file (0x%08X)", magic);
 
 	uint32_t resCount = herf.readUint32LE();
@@ -94,7 +106,7 @@ void HERFFile::readDictionary(Common::SeekableReadStream &herf, std::map<uint32_
 	herf.seek(_dictOffset);
 
 	uint32_t magic = herf.readUint32LE();
-	if (magic != 0x00F1A5C0)
+	if (magic != kHERFID)
 		throw Common::Exception("Invalid HERF dictionary (0x%08X)", magic);
 
 	uint32_t hashCount = herf.readUint32LE();
@@ -130,15 +142,52 @@ void HERFFile::readResList(Common::SeekableReadStream &herf) {
 
 		std::map<uint32_t, Common::UString>::const_iterator name = dict.find(res->hash);
 		if (name != dict.end()) {
-			res->name = Common::FilePath::getStem(name->second);
+			_resources.setName(*res, Common::FilePath::getStem(name->second));
 			res->type = TypeMan.getFileType(name->second);
 		}
 
 		if ((iRes->offset == _dictOffset) && (iRes->size == _dictSize)) {
-			res->name = "erf";
+			_resources.setName(*res, "erf");
 			res->type = kFileTypeDICT;
 		}
 	}
+
+	_resources.finish();
+}
+
+void HERFFile::writeIndex(Common::WriteStream &index) const {
+	index.writeUint32LE(kHERFID);
+
+	index.writeUint32LE(_dictOffset);
+	index.writeUint32LE(_dictSize);
+
+	ArchiveCache::writeResources(index, _resources);
+
+	index.writeUint32LE(_iResources.size());
+	for (IResourceList::const_iterator iRes = _iResources.begin(); iRes != _iResources.end(); ++iRes) {
+		index.writeUint32LE(iRes->offset);
+		index.writeUint32LE(iRes->size);
+	}
+}
+
+void HERFFile::readIndex(Common::SeekableReadStream &index) {
+	uint32_t magic = index.readUint32LE();
+	if (magic != kHERFID)
+		throw Common::Exception("Invalid HERF index (0x%08X)", magic);
+
+	_dictOffset = index.readUint32LE();
+	_dictSize   = index.readUint32LE();
+
+	ArchiveCache::readResources(index, _resources);
+
+	_iResources.resize(ArchiveCache::readCount(index, 8));
+	if (_iResources.size() != _resources.size())
+		throw Common::Exception("HERF index resource count mismatch");
+
+	for (IResourceList::iterator iRes = _iResources.begin(); iRes != _iResources.end(); ++iRes) {
+		iRes->offset = index.readUint32LE();
+		iRes->size   = index.readUint32LE();
+	}
 }
 
 const Archive::ResourceList &HERFFile::getResources() const {
@@ -160,11 +209,9 @@ Common::SeekableReadStream *HERFFile::getResource(uint32_t index, bool tryNoCopy
 	const IResource &res = getIResource(index);
 
 	if (tryNoCopy)
-		return new Common::SeekableSubReadStream(_herf.get(), res.offset, res.offset + res.size);
-
-	_herf->seek(res.offset);
+		return _herf->createSubStream(res.offset, res.offset + res.size);
 
-	return _herf->readStream(res.size);
+	return _herf->readStreamAt(res.offset, res.size);
 }
 
 Common::HashAlgo HERFFile::getNameHashAlgo() const {
@@ -37,6 +37,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class WriteStream;
 }
 
 namespace Aurora {
@@ -54,8 +55,13 @@ class HERFFile : public Archive {
 public:
 	/** Take over this stream and read an HERF file out of it. */
 	HERFFile(Common::SeekableReadStream *herf);
+	/** Take over this stream and read the HERF's resource list out of an index, as written by writeIndex(). */
+	HERFFile(Common::SeekableReadStream *herf, Common::SeekableReadStream &index);
 	~HERFFile();
 
+	/** Write an index of this HERF, for use with ArchiveCache. */
+	void writeIndex(Common::WriteStream &index) const;
+
 	/** Return the list of resources. */
 	const ResourceList &getResources() const;
 
@@ -95,6 +101,8 @@ private:
 
 	void readNames();
 
+	void readIndex(Common::SeekableReadStream &index);
+
 	const IResource &getIResource(uint32_t index) const;
 };
 
@@ -23,8 +23,11 @@
  */
 
 #include "src/common/error.h"
+#include "src/common/readstream.h"
+#include "src/common/writestream.h"
 
 #include "src/aurora/keydatafile.h"
+#include "src/aurora/archivecache.h"
 
 namespace Aurora {
 
@@ -49,4 +52,26 @@ const KEYDataFile::Resource &KEYDataFile::getRes(uint32_t index) const {
 	return _resources[index];
 }
 
+void KEYDataFile::writeResourceIndex(Common::WriteStream &index) const {
+	index.writeUint32LE(_resources.size());
+
+	for (ResourceList::const_iterator res = _resources.begin(); res != _resources.end(); ++res) {
+		index.writeUint32LE((uint32_t) res->type);
+		index.writeUint32LE(res->offset);
+		index.writeUint32LE(res->size);
+		index.writeUint32LE(res->packedSize);
+	}
+}
+
+void KEYDataFile::readResourceIndex(Common::SeekableReadStream &index) {
+	_resources.resize(ArchiveCache::readCount(index, 16));
+
+	for (ResourceList::iterator res = _resources.begin(); res != _resources.end(); ++res) {
+		res->type       = (FileType) index.readUint32LE();
+		res->offset     = index.readUint32LE();
+		res->size       = index.readUint32LE();
+		res->packedSize = index.readUint32LE();
+	}
+}
+
 } // End of namespace Aurora
@@ -35,6 +35,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class WriteStream;
 }
 
 namespace Aurora {
@@ -51,8 +52,13 @@ public:
 	/** Return the size of a resource. */
 	uint32_t getResourceSize(uint32_t index) const;
 
-	/** Return a stream of the resource's contents. */
-	virtual Common::SeekableReadStream *getResource(uint32_t index) const = 0;
+	/** Return a stream of the resource's contents.
+	 *
+	 *  @param  index The index of the resource we want.
+	 *  @param  tryNoCopy Try to return a stream referencing the data file instead of copying.
+	 *  @return A (possibly non-copying) SeekableReadStream of the resource data.
+	 */
+	virtual Common::SeekableReadStream *getResource(uint32_t index, bool tryNoCopy = false) const = 0;
 
 protected:
 	/** Resource information. */
@@ -71,6 +77,11 @@ protected:
 	ResourceList _resources;
 
 	const Resource &getRes(uint32_t index) const;
+
+	/** Write the resource list into an archive index. */
+	void writeResourceIndex(Common::WriteStream &index) const;
+	/** Read the resource list out of an archive index. */
+	void readResourceIndex(Common::SeekableReadStream &index);
 };
 
 } // End of namespace Aurora
@@ -27,6 +27,7 @@
  */
 
 #include <memory>
+#include <vector>
 #include <cstddef>
 
 #include "src/common/util.h"
@@ -34,9 +35,11 @@
 #include "src/common/error.h"
 #include "src/common/readstream.h"
 #include "src/common/encoding.h"
+#include "src/common/writestream.h"
 
 #include "src/aurora/keyfile.h"
 #include "src/aurora/keydatafile.h"
+#include "src/aurora/archivecache.h"
 
 static const uint32_t kKEYID     = MKTAG('K', 'E', 'Y', ' ');
 static const uint32_t kVersion1  = MKTAG('V', '1', ' ', ' ');
@@ -44,39 +47,176 @@ static const uint32_t kVersion11 = MKTAG('V', '1', '.', '1');
 
 namespace Aurora {
 
-KEYFile::KEYFile(Common::SeekableReadStream *key) {
+KEYFile::DataFile::DataFile() : dataFile(0), failed(false) {
+}
+
+
+KEYFile::KEYFile(Common::SeekableReadStream *key) : _prewarmPool(0) {
 	std::unique_ptr<Common::SeekableReadStream> keyStream(key);
 
 	load(*keyStream);
 }
 
+KEYFile::KEYFile(Common::SeekableReadStream *key, Common::SeekableReadStream &index) : _prewarmPool(0) {
+	std::unique_ptr<Common::SeekableReadStream> keyStream(key);
+
+	readIndex(index);
+}
+
 KEYFile::~KEYFile() {
+	/* Pre-warm tasks still reference us, so cancel and wait for them. Those
+	 * that haven't started are just dropped, and only data files that are
+	 * being opened right now hold us up. No unrelated tasks are run here. */
+	_prewarmToken.cancel();
+
+	for (const Common::TaskFuture<void> &task : _prewarmTasks)
+		_prewarmPool->wait(task);
 }
 
 bool KEYFile::haveDataFile(uint32_t index) const {
-	return getIResource(index).dataFile != 0;
+	const IResource &iRes = getIResource(index);
+	if (iRes.dataFileIndex >= _dataFileSlots.size())
+		return false;
+
+	const DataFile &dataFile = *_dataFileSlots[iRes.dataFileIndex];
+
+	return (dataFile.dataFile.load() != 0) || dataFile.opener;
 }
 
 void KEYFile::addDataFile(uint32_t dataFileIndex, KEYDataFile *dataFile) {
 	if (!dataFile)
 		throw Common::Exception("KEYFile::addDataFile(): dataFile == 0");
 
-	ResourceList::iterator   res = _resources.begin();
-	IResourceList::iterator iRes = _iResources.begin();
-	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++res, ++iRes) {
-		// Merge information for all resources where the data file index matches
-		if (iRes->dataFileIndex != dataFileIndex)
+	// Pre-warm tasks might be opening the data files right now
+	if (_prewarmPool)
+		throw Common::Exception("KEYFile::addDataFile(): Can't add data files while pre-warming");
+
+	if (dataFileIndex >= _dataFileSlots.size())
+		throw Common::Exception("KEYFile::addDataFile(): Data file index %u out of range (%u data files)",
+		                        (uint)dataFileIndex, (uint)_dataFileSlots.size());
+
+	verifyDataFile(dataFileIndex, *dataFile);
+
+	_dataFileSlots[dataFileIndex]->dataFile = dataFile;
+}
+
+void KEYFile::addDataFile(uint32_t dataFileIndex, DataFileOpener opener) {
+	if (!opener)
+		throw Common::Exception("KEYFile::addDataFile(): opener == 0");
+
+	// Pre-warm tasks might be opening the data files right now
+	if (_prewarmPool)
+		throw Common::Exception("KEYFile::addDataFile(): Can't add data files while pre-warming");
+
+	if (dataFileIndex >= _dataFileSlots.size())
+		throw Common::Exception("KEYFile::addDataFile(): Data file index %u out of range (%u data files)",
+		                        (uint)dataFileIndex, (uint)_dataFileSlots.size());
+
+	// The once_flag can't be reset, so start over with a fresh slot
+	_dataFileSlots[dataFileIndex] = std::make_unique<DataFile>();
+	_dataFileSlots[dataFileIndex]->opener = opener;
+}
+
+bool KEYFile::isDataFileOpen(uint32_t dataFileIndex) const {
+	if (dataFileIndex >= _dataFileSlots.size())
+		return false;
+
+	return _dataFileSlots[dataFileIndex]->dataFile.load() != 0;
+}
+
+void KEYFile::prewarmDataFiles(Common::ThreadPool &pool) {
+	if (_prewarmPool && (_prewarmPool != &pool))
+		throw Common::Exception("KEYFile::prewarmDataFiles(): Already pre-warming on a different pool");
+
+	_prewarmPool = &pool;
+
+	for (uint32_t i = 0; i < _dataFileSlots.size(); i++) {
+		DataFile &dataFile = *_dataFileSlots[i];
+		if (!dataFile.opener || (dataFile.dataFile.load() != 0))
 			continue;
 
-		if (res->type != dataFile->getResourceType(iRes->resIndex))
+		_prewarmTasks.push_back(pool.submit([this, &dataFile, i]() {
+			openDataFile(dataFile, i, &_prewarmToken);
+		}, _prewarmToken));
+	}
+}
+
+void KEYFile::createDataFileSlots() {
+	_dataFileSlots.clear();
+	_dataFileSlots.reserve(_dataFiles.size());
+
+	for (size_t i = 0; i < _dataFiles.size(); i++)
+		_dataFileSlots.push_back(std::make_unique<DataFile>());
+}
+
+void KEYFile::verifyDataFile(uint32_t dataFileIndex, const KEYDataFile &dataFile) const {
+	// Check all resources where the data file index matches
+	for (uint32_t index : getDataFileResources(dataFileIndex)) {
+		const Resource  &res = _resources[index];
+		const IResource &iRes = _iResources[index];
+
+		if (res.type != dataFile.getResourceType(iRes.resIndex))
 			throw Common::Exception("Resource type doesn't match in data file (%d, %d, %d, %d, %d)",
-			                        res->index, iRes->dataFileIndex, iRes->resIndex,
-			                        res->type, dataFile->getResourceType(iRes->resIndex));
+			                        res.index, iRes.dataFileIndex, iRes.resIndex,
+			                        res.type, dataFile.getResourceType(iRes.resIndex));
+	}
+}
+
+/** Thrown to leave a data file unopened when its pre-warm was cancelled. */
+struct OpenCancelled {
+};
+
+void KEYFile::openDataFile(DataFile &dataFile, uint32_t dataFileIndex, const Common::CancelToken *token) const {
+	if (token && token->isCancelled())
+		return;
+
+	try {
+		std::call_once(dataFile.opened, [this, &dataFile, dataFileIndex, token]() {
+			// Throwing out of call_once leaves the data file unopened, for whoever needs it next
+			if (token && token->isCancelled())
+				throw OpenCancelled();
+
+			try {
+				std::unique_ptr<KEYDataFile> opened(dataFile.opener());
+				if (!opened)
+					throw Common::Exception("No data file");
 
-		iRes->dataFile = dataFile;
+				verifyDataFile(dataFileIndex, *opened);
+
+				dataFile.owned = std::move(opened);
+				dataFile.dataFile = dataFile.owned.get();
+
+			} catch (Common::Exception &e) {
+				e.add("Failed to open KEY data file \"%s\"", _dataFiles[dataFileIndex].c_str());
+
+				dataFile.error  = e;
+				dataFile.failed = true;
+			}
+		});
+	} catch (OpenCancelled &) {
 	}
 }
 
+KEYDataFile &KEYFile::getDataFile(const IResource &iRes) const {
+	if (iRes.dataFileIndex >= _dataFileSlots.size())
+		throw Common::Exception("Data file %u for resource missing", iRes.dataFileIndex);
+
+	DataFile &dataFile = *_dataFileSlots[iRes.dataFileIndex];
+
+	KEYDataFile *file = dataFile.dataFile.load();
+	if (file)
+		return *file;
+
+	if (!dataFile.opener)
+		throw Common::Exception("Data file \"%s\" for resource missing", _dataFiles[iRes.dataFileIndex].c_str());
+
+	openDataFile(dataFile, iRes.dataFileIndex);
+	if (dataFile.failed)
+		throw dataFile.error;
+
+	return *dataFile.dataFile.load();
+}
+
 const std::vector<Common::UString> &KEYFile::getDataFileList() const {
 	return _dataFiles;
 }
@@ -112,6 +252,8 @@ void KEYFile::load(Common::SeekableReadStream &key) {
 		_iResources.resize(resCount);
 		readResList(key, offResTable);
 
+		createDataFileSlots();
+
 	} catch (Common::Exception &e) {
 		e.add("Failed reading KEY file");
 		throw;
@@ -155,9 +297,7 @@ void KEYFile::readResList(Common::SeekableReadStream &key, uint32_t offset) {
 	ResourceList::iterator   res = _resources.begin();
 	IResourceList::iterator iRes = _iResources.begin();
 	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++index, ++res, ++iRes) {
-		iRes->dataFile = 0;
-
-		res->name  = Common::readStringFixed(key, Common::kEncodingASCII, 16);
+		_resources.setName(*res, Common::readStringFixed(key, Common::kEncodingASCII, 16));
 		res->type  = (FileType) key.readUint16LE();
 		res->index = index;
 
@@ -174,6 +314,75 @@ void KEYFile::readResList(Common::SeekableReadStream &key, uint32_t offset) {
 		// TODO: Fixed resources?
 		iRes->resIndex = id & 0xFFFFF;
 	}
+
+	_resources.finish();
+
+	indexDataFileResources();
+}
+
+void KEYFile::indexDataFileResources() {
+	/* Counting sort of the resource indices by data file index. Resources
+	 * referencing data files the KEY doesn't list are left out. */
+
+	_dataFileResourceStart.assign(_dataFiles.size() + 1, 0);
+
+	for (const IResource &iRes : _iResources)
+		if (iRes.dataFileIndex < _dataFiles.size())
+			_dataFileResourceStart[iRes.dataFileIndex + 1]++;
+
+	for (size_t i = 1; i < _dataFileResourceStart.size(); i++)
+		_dataFileResourceStart[i] += _dataFileResourceStart[i - 1];
+
+	_dataFileResources.resize(_dataFileResourceStart.back());
+
+	std::vector<uint32_t> next(_dataFileResourceStart.begin(), _dataFileResourceStart.end() - 1);
+	for (size_t i = 0; i < _iResources.size(); i++)
+		if (_iResources[i].dataFileIndex < _dataFiles.size())
+			_dataFileResources[next[_iResources[i].dataFileIndex]++] = i;
+}
+
+void KEYFile::writeIndex(Common::WriteStream &index) const {
+	index.writeUint32BE(_id);
+	index.writeUint32BE(_version);
+
+	index.writeUint32LE(_dataFiles.size());
+	for (std::vector<Common::UString>::const_iterator d = _dataFiles.begin(); d != _dataFiles.end(); ++d)
+		ArchiveCache::writeString(index, *d);
+
+	ArchiveCache::writeResources(index, _resources);
+
+	index.writeUint32LE(_iResources.size());
+	for (IResourceList::const_iterator iRes = _iResources.begin(); iRes != _iResources.end(); ++iRes) {
+		index.writeUint32LE(iRes->dataFileIndex);
+		index.writeUint32LE(iRes->resIndex);
+	}
+}
+
+void KEYFile::readIndex(Common::SeekableReadStream &index) {
+	_id      = index.readUint32BE();
+	_version = index.readUint32BE();
+
+	if ((_id != kKEYID) || ((_version != kVersion1) && (_version != kVersion11)))
+		throw Common::Exception("Not a KEY index (%s, %s)", Common::debugTag(_id).c_str(),
+		                        Common::debugTag(_version).c_str());
+
+	_dataFiles.resize(ArchiveCache::readCount(index, 4));
+	for (std::vector<Common::UString>::iterator d = _dataFiles.begin(); d != _dataFiles.end(); ++d)
+		*d = ArchiveCache::readString(index);
+
+	ArchiveCache::readResources(index, _resources);
+
+	_iResources.resize(ArchiveCache::readCount(index, 8));
+	if (_iResources.size() != _resources.size())
+		throw Common::Exception("KEY index resource count mismatch");
+
+	for (IResourceList::iterator iRes = _iResources.begin(); iRes != _iResources.end(); ++iRes) {
+		iRes->dataFileIndex = index.readUint32LE();
+		iRes->resIndex      = index.readUint32LE();
+	}
+
+	indexDataFileResources();
+	createDataFileSlots();
 }
 
 const Archive::ResourceList &KEYFile::getResources() const {
@@ -188,31 +397,79 @@ const KEYFile::IResource &KEYFile::getIResource(uint32_t index) const {
 }
 
 uint32_t KEYFile::getResourceSize(uint32_t index) const {
-	const IResource &iRes = getIResource(index);
-	if (!iRes.dataFile)
+	if (!haveDataFile(index))
 		return 0xFFFFFFFF;
 
-	return iRes.dataFile->getResourceSize(iRes.resIndex);
+	const IResource &iRes = getIResource(index);
+
+	try {
+		return getDataFile(iRes).getResourceSize(iRes.resIndex);
+	} catch (Common::Exception &) {
+		return 0xFFFFFFFF;
+	}
 }
 
-Common::SeekableReadStream *KEYFile::getResource(uint32_t index, bool UNUSED(tryNoCopy)) const {
+Common::SeekableReadStream *KEYFile::getResource(uint32_t index, bool tryNoCopy) const {
 	const IResource &iRes = getIResource(index);
-	if (!iRes.dataFile)
-		throw Common::Exception("Data files for resource %d (\"%s\") missing", index,
-		                        _dataFiles[iRes.dataFileIndex].c_str());
 
-	return iRes.dataFile->getResource(iRes.resIndex);
+	try {
+		return getDataFile(iRes).getResource(iRes.resIndex, tryNoCopy);
+	} catch (Common::Exception &e) {
+		e.add("Failed to read KEY resource %u", index);
+		throw;
+	}
+}
+
+KEYFile::DataFileResources::DataFileResources(const_iterator b, const_iterator e) : _begin(b), _end(e) {
+}
+
+bool KEYFile::DataFileResources::empty() const {
+	return _begin == _end;
+}
+
+size_t KEYFile::DataFileResources::size() const {
+	return _end - _begin;
+}
+
+KEYFile::DataFileResources::const_iterator KEYFile::DataFileResources::begin() const {
+	return _begin;
+}
+
+KEYFile::DataFileResources::const_iterator KEYFile::DataFileResources::end() const {
+	return _end;
+}
+
+KEYFile::DataFileResources KEYFile::getDataFileResources(uint32_t dataFileIndex) const {
+	if (dataFileIndex >= _dataFiles.size())
+		return DataFileResources(0, 0);
+
+	const uint32_t *resources = _dataFileResources.data();
+
+	return DataFileResources(resources + _dataFileResourceStart[dataFileIndex],
+	                         resources + _dataFileResourceStart[dataFileIndex + 1]);
+}
+
+std::vector<const Archive::Resource *> KEYFile::getResourceListForDataFile(uint32_t dataFileIndex) const {
+	const DataFileResources indices = getDataFileResources(dataFileIndex);
+
+	std::vector<const Archive::Resource *> list;
+	list.reserve(indices.size());
+
+	for (uint32_t index : indices)
+		list.push_back(&_resources[index]);
+
+	return list;
 }
 
 std::vector<const Archive::Resource *> KEYFile::getResourceListForDataFile(const Common::UString &dataFile) const {
 	std::vector<const Archive::Resource *> list;
 
-	uint32_t i = 0;
-	for (auto it = _resources.begin(); it != _resources.end(); ++it, i++) {
-		if (_dataFiles[getIResource(i).dataFileIndex] != dataFile)
+	for (size_t i = 0; i < _dataFiles.size(); i++) {
+		if (_dataFiles[i] != dataFile)
 			continue;
 
-		list.push_back(&(*it));
+		std::vector<const Archive::Resource *> dataFileList = getResourceListForDataFile(i);
+		list.insert(list.end(), dataFileList.begin(), dataFileList.end());
 	}
 
 	return list;
@@ -26,9 +26,16 @@
 #define AURORA_KEYFILE_H
 
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <future>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
+#include "src/common/error.h"
+#include "src/common/mutex.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/types.h"
 #include "src/aurora/aurorafile.h"
@@ -36,6 +43,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class WriteStream;
 }
 
 namespace Aurora {
@@ -70,9 +78,23 @@ class KEYDataFile;
  */
 class KEYFile : public Archive, public AuroraFile {
 public:
+	/** A function opening a data file, called when the data file is first needed.
+	 *
+	 *  The KEYFile takes over ownership of the data file returned.
+	 */
+	typedef std::function<KEYDataFile *()> DataFileOpener;
+
 	KEYFile(Common::SeekableReadStream *key);
+	/** Read the KEY's data file and resource lists out of an index, as written by writeIndex().
+	 *
+	 *  The KEY file stream itself isn't needed then, but it is taken over nevertheless.
+	 */
+	KEYFile(Common::SeekableReadStream *key, Common::SeekableReadStream &index);
 	~KEYFile();
 
+	/** Write an index of this KEY, for use with ArchiveCache. */
+	void writeIndex(Common::WriteStream &index) const;
+
 	/** Add a data file that's managed by this KEY file.
 	 *
 	 *  The data file needs to be kept around as long as the KEYFile object
@@ -80,10 +102,34 @@ public:
 	 */
 	void addDataFile(uint32_t dataFileIndex, KEYDataFile *dataFile);
 
+	/** Add a data file that's managed by this KEY file, to be opened when first needed.
+	 *
+	 *  The opener is called, at most once, by the first getResource() or
+	 *  getResourceSize() on a resource in this data file, or by a pre-warm.
+	 *  If opening fails, all resources in this data file fail to be read.
+	 */
+	void addDataFile(uint32_t dataFileIndex, DataFileOpener opener);
+
+	/** Has this data file been opened already? */
+	bool isDataFileOpen(uint32_t dataFileIndex) const;
+
+	/** Open all data files still waiting to be opened, in the background.
+	 *
+	 *  Each data file is opened in its own task on this pool. Failures are
+	 *  remembered and reported when reading from the data file, as usual.
+	 *  Tasks not started yet when the KEYFile is destroyed are cancelled.
+	 *
+	 *  No further data files can be added after calling this method.
+	 */
+	void prewarmDataFiles(Common::ThreadPool &pool);
+
 	/** Return the list of data files (BIF/BZF) this KEY file indexes. */
 	const std::vector<Common::UString> &getDataFileList() const;
 
-	/** Do we have a data file associated for this resource? */
+	/** Do we have a data file associated for this resource?
+	 *
+	 *  This is also true for a data file that was added, but not yet opened.
+	 */
 	bool haveDataFile(uint32_t index) const;
 
 	/** Return the list of resources. */
@@ -93,8 +139,8 @@ public:
 	 *
 	 *  Note: The size of the resource is stored in data file.
 	 *        If the data files containing this resource's data
-	 *        was not added first with addDataFile(), this method
-	 *        will return 0xFFFFFFFF.
+	 *        was not added first with addDataFile(), or can't be
+	 *        opened, this method will return 0xFFFFFFFF.
 	 */
 	uint32_t getResourceSize(uint32_t index) const;
 
@@ -106,6 +152,33 @@ public:
 	 */
 	Common::SeekableReadStream *getResource(uint32_t index, bool tryNoCopy = false) const;
 
+	/** The indices of all resources found in one data file, in KEY order. */
+	class DataFileResources {
+	public:
+		typedef const uint32_t *const_iterator;
+
+		DataFileResources(const_iterator b, const_iterator e);
+
+		bool   empty() const;
+		size_t size() const;
+
+		const_iterator begin() const;
+		const_iterator end() const;
+
+	private:
+		const_iterator _begin;
+		const_iterator _end;
+	};
+
+	/** Return the indices of all resources found in this data file.
+	 *
+	 *  This is a constant-time lookup into an index built when loading the KEY.
+	 */
+	DataFileResources getDataFileResources(uint32_t dataFileIndex) const;
+
+	/** Return all resources found in this data file. */
+	std::vector<const Archive::Resource *> getResourceListForDataFile(uint32_t dataFileIndex) const;
+	/** Return all resources found in the data file with this name. */
 	std::vector<const Archive::Resource *> getResourceListForDataFile(const Common::UString &dataFile) const;
 
 private:
@@ -113,8 +186,25 @@ private:
 	struct IResource {
 		uint32_t dataFileIndex; ///< Index into the data file list.
 		uint32_t resIndex;      ///< Index into the data file's resource table.
+	};
+
+	/** A data file added to this KEY, possibly not yet opened. */
+	struct DataFile {
+		/** The actual data file, once added or opened. */
+		std::atomic<KEYDataFile *> dataFile;
+		/** The data file, if we opened it ourselves. */
+		std::unique_ptr<KEYDataFile> owned;
+
+		/** The function opening the data file, if it's opened on demand. */
+		DataFileOpener opener;
+		std::once_flag opened;
 
-		KEYDataFile *dataFile; ///< The actual data file containing this resource.
+		/** Did opening the data file fail? */
+		bool failed;
+		/** Why opening the data file failed. */
+		Common::Exception error;
+
+		DataFile();
 	};
 
 	typedef std::vector<IResource> IResourceList;
@@ -128,12 +218,42 @@ private:
 	/** All managed data files (BIF/BZF). */
 	std::vector<Common::UString> _dataFiles;
 
+	/** The data files added to this KEY, indexed like _dataFiles. */
+	std::vector<std::unique_ptr<DataFile>> _dataFileSlots;
+
+	/** Cancels the pre-warm tasks that haven't started yet. */
+	Common::CancelToken _prewarmToken;
+	/** The pool running our pre-warm tasks. */
+	Common::ThreadPool *_prewarmPool;
+	/** The pre-warm tasks, to wait for them when we're destroyed. */
+	std::vector<Common::TaskFuture<void>> _prewarmTasks;
+
+	/** Indices of all resources, grouped by data file. */
+	std::vector<uint32_t> _dataFileResources;
+	/** Where each data file's resources start within _dataFileResources. */
+	std::vector<uint32_t> _dataFileResourceStart;
+
 	void load(Common::SeekableReadStream &key);
 
 	void readDataFileList(Common::SeekableReadStream &key, uint32_t offset);
 	void readResList(Common::SeekableReadStream &key, uint32_t offset);
 
+	/** Group the resource indices by data file. */
+	void indexDataFileResources();
+
+	void readIndex(Common::SeekableReadStream &index);
+
 	const IResource &getIResource(uint32_t index) const;
+
+	void createDataFileSlots();
+
+	/** Check that the data file matches the resources we expect in it. */
+	void verifyDataFile(uint32_t dataFileIndex, const KEYDataFile &dataFile) const;
+
+	/** Return the data file containing this resource, opening it if necessary. */
+	KEYDataFile &getDataFile(const IResource &iRes) const;
+	/** Open this data file, unless it's already open, or the token was cancelled. */
+	void openDataFile(DataFile &dataFile, uint32_t dataFileIndex, const Common::CancelToken *token = 0) const;
 };
 
 } // End of namespace Aurora
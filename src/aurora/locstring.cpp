@@ -135,6 +135,11 @@ void LocString::getStrings(std::vector<SubLocString> &str) const {
 		str.push_back(SubLocString(s->first, s->second));
 }
 
+void LocString::setStrings(const std::vector<SubLocString> &str) {
+	for (std::vector<SubLocString>::const_iterator s = str.begin(); s != str.end(); ++s)
+		setString(s->language, s->str);
+}
+
 void LocString::readString(uint32_t languageID, Common::SeekableReadStream &stream) {
 	uint32_t length = stream.readUint32LE();
 
@@ -90,6 +90,8 @@ public:
 
 	/** Return all strings. */
 	void getStrings(std::vector<SubLocString> &str) const;
+	/** Set these strings, as returned by getStrings(). */
+	void setStrings(const std::vector<SubLocString> &str);
 
 	/** Read a string out of a stream. */
 	void readString(uint32_t languageID, Common::SeekableReadStream &stream);
@@ -81,20 +81,16 @@ void NDSFile::readNames(Common::SeekableReadStream &nds, uint32_t offset, uint32
 
 	uint32_t index = 0;
 	while (((size_t)nds.pos()) < (size_t)(offset + length)) {
-		Resource res;
-
 		byte nameLength = nds.readByte();
 		if ((nameLength == 0) || ((size_t)nds.pos() >= (size_t)(offset + length)))
 			break;
 
 		Common::UString name = Common::readStringFixed(nds, Common::kEncodingASCII, nameLength).toLower();
 
-		res.name  = TypeMan.setFileType(name, kFileTypeNone);
-		res.type  = TypeMan.getFileType(name);
-		res.index = index++;
-
-		_resources.push_back(res);
+		_resources.add(TypeMan.setFileType(name, kFileTypeNone), TypeMan.getFileType(name), index++);
 	}
+
+	_resources.finish();
 }
 
 void NDSFile::readFAT(Common::SeekableReadStream &nds, uint32_t offset) {
@@ -166,14 +162,10 @@ uint32_t NDSFile::getResourceSize(uint32_t index) const {
 Common::SeekableReadStream *NDSFile::getResource(uint32_t index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	_nds->seek(res.offset);
-
 	if (tryNoCopy)
-		return new Common::SeekableSubReadStream(_nds.get(), res.offset, res.offset + res.size);
-
-	_nds->seek(res.offset);
+		return _nds->createSubStream(res.offset, res.offset + res.size);
 
-	return _nds->readStream(res.size);
+	return _nds->readStreamAt(res.offset, res.size);
 }
 
 } // End of namespace Aurora
@@ -0,0 +1,206 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Opening archives of any supported type.
+ */
+
+#include <memory>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+#include "src/common/readfile.h"
+#include "src/common/filepath.h"
+#include "src/common/threadpool.h"
+
+#include "src/aurora/openarchive.h"
+#include "src/aurora/util.h"
+#include "src/aurora/archivecache.h"
+#include "src/aurora/zipfile.h"
+#include "src/aurora/erffile.h"
+#include "src/aurora/rimfile.h"
+#include "src/aurora/keyfile.h"
+#include "src/aurora/keydatafile.h"
+#include "src/aurora/biffile.h"
+#include "src/aurora/bzffile.h"
+#include "src/aurora/herffile.h"
+#include "src/aurora/ndsrom.h"
+
+namespace Aurora {
+
+/** Open an archive file through the cache, if we have one. */
+template<class T>
+static T *openCached(ArchiveCache *cache, const Common::UString &path) {
+	if (cache)
+		return cache->open<T>(path);
+
+	return new T(new Common::MappedReadFile(path));
+}
+
+/** Open a file that isn't cached, but mapped like the cache would. */
+static Common::SeekableReadStream *openFile(ArchiveCache *cache, const Common::UString &path) {
+	if (cache)
+		return cache->openFile(path);
+
+	return new Common::MappedReadFile(path);
+}
+
+static bool isCancelled(const Common::CancelToken *cancel) {
+	return cancel && cancel->isCancelled();
+}
+
+/** Register the data files of a freshly opened KEY, and return it, unless we were cancelled. */
+static KEYFile *finishKEY(KEYFile *keyFile, const Common::UString &dataDir, ArchiveCache *cache,
+                          const Common::CancelToken *cancel) {
+
+	std::unique_ptr<KEYFile> key(keyFile);
+	if (!loadKEYDataFiles(*key, dataDir, cache, cancel))
+		return 0;
+
+	return key.release();
+}
+
+Archive *openArchive(const Common::UString &path, ArchiveCache *cache, const Common::UString &dataDir,
+                     const Common::CancelToken *cancel) {
+
+	if (isCancelled(cancel))
+		return 0;
+
+	switch (TypeMan.getFileType(path)) {
+		case kFileTypeZIP:
+			return new ZIPFile(openFile(cache, path));
+
+		case kFileTypeERF:
+		case kFileTypeMOD:
+		case kFileTypeNWM:
+		case kFileTypeSAV:
+		case kFileTypeHAK:
+			return openCached<ERFFile>(cache, path);
+
+		case kFileTypeRIM: {
+			// Some RIM files are actually ERFs
+			Common::ReadFile stream(path);
+			if (ERFFile::isERFID(stream.readUint32BE()))
+				return openCached<ERFFile>(cache, path);
+
+			return openCached<RIMFile>(cache, path);
+		}
+
+		case kFileTypeKEY:
+			return finishKEY(openCached<KEYFile>(cache, path),
+			                 dataDir.empty() ? Common::FilePath::getDirectory(path) : dataDir, cache, cancel);
+
+		case kFileTypeHERF:
+			return openCached<HERFFile>(cache, path);
+
+		case kFileTypeNDS:
+			return new NDSFile(openFile(cache, path));
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Invalid archive file \"%s\"", path.c_str());
+}
+
+Archive *openArchive(Common::SeekableReadStream *stream, FileType type, ArchiveCache *cache,
+                     const Common::UString &dataDir, const Common::CancelToken *cancel) {
+
+	std::unique_ptr<Common::SeekableReadStream> archiveStream(stream);
+	if (!archiveStream)
+		throw Common::Exception("No archive stream");
+
+	if (isCancelled(cancel))
+		return 0;
+
+	switch (type) {
+		case kFileTypeZIP:
+			return new ZIPFile(archiveStream.release());
+
+		case kFileTypeERF:
+		case kFileTypeMOD:
+		case kFileTypeNWM:
+		case kFileTypeSAV:
+		case kFileTypeHAK:
+			return new ERFFile(archiveStream.release());
+
+		case kFileTypeRIM: {
+			// Some RIM files are actually ERFs
+			const bool isERF = ERFFile::isERFID(archiveStream->readUint32BE());
+			archiveStream->seek(0);
+
+			if (isERF)
+				return new ERFFile(archiveStream.release());
+
+			return new RIMFile(archiveStream.release());
+		}
+
+		case kFileTypeKEY:
+			return finishKEY(new KEYFile(archiveStream.release()), dataDir, cache, cancel);
+
+		case kFileTypeHERF:
+			return new HERFFile(archiveStream.release());
+
+		case kFileTypeNDS:
+			return new NDSFile(archiveStream.release());
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Invalid archive type %d", type);
+}
+
+bool loadKEYDataFiles(KEYFile &key, const Common::UString &dataDir, ArchiveCache *cache,
+                      const Common::CancelToken *cancel) {
+
+	const std::vector<Common::UString> &dataFileList = key.getDataFileList();
+	for (size_t i = 0; i < dataFileList.size(); i++) {
+		if (isCancelled(cancel))
+			return false;
+
+		try {
+			const Common::UString path = Common::FilePath::normalize(dataDir + "/" + dataFileList[i]);
+			if (!Common::FilePath::isRegularFile(path))
+				throw Common::Exception("No such file \"%s\"", path.c_str());
+
+			const FileType type = TypeMan.getFileType(path);
+			if ((type != kFileTypeBIF) && (type != kFileTypeBZF))
+				throw Common::Exception("Unknown KEY data file type \"%s\"", path.c_str());
+
+			// Only open the data file once we actually need a resource out of it
+			key.addDataFile(i, [cache, path, type]() -> KEYDataFile * {
+				if (type == kFileTypeBIF)
+					return openCached<BIFFile>(cache, path);
+
+				return openCached<BZFFile>(cache, path);
+			});
+
+		} catch (Common::Exception &e) {
+			e.add("Failed to load KEY data file \"%s\"", dataFileList[i].c_str());
+			Common::printException(e, "WARNING: ");
+		}
+	}
+
+	return true;
+}
+
+} // End of namespace Aurora
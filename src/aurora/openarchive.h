@@ -0,0 +1,77 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Opening archives of any supported type.
+ */
+
+#ifndef AURORA_OPENARCHIVE_H
+#define AURORA_OPENARCHIVE_H
+
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class CancelToken;
+}
+
+namespace Aurora {
+
+class Archive;
+class ArchiveCache;
+class KEYFile;
+
+/** Open the archive file at this path, detecting its type by the extension.
+ *
+ *  If a cache is given, the archive's index is taken from the cache, or
+ *  added to it, and the file is mapped or not as configured in the cache.
+ *  Without a cache, the file is mapped.
+ *
+ *  The data files of a KEY are registered with loadKEYDataFiles(), relative
+ *  to dataDir, or to the KEY's own directory if dataDir is empty.
+ *
+ *  @return The archive, or 0 if the cancel token was cancelled in the meantime.
+ */
+Archive *openArchive(const Common::UString &path, ArchiveCache *cache = 0,
+                     const Common::UString &dataDir = "", const Common::CancelToken *cancel = 0);
+
+/** Open an archive of this type out of a stream, for example an archive within another archive.
+ *
+ *  The archive takes over the stream. Only the data files of a KEY are opened
+ *  through the cache, if given, relative to dataDir.
+ */
+Archive *openArchive(Common::SeekableReadStream *stream, FileType type, ArchiveCache *cache = 0,
+                     const Common::UString &dataDir = "", const Common::CancelToken *cancel = 0);
+
+/** Register all existing data files of this KEY, to be opened once they're needed.
+ *
+ *  The data files are looked for relative to dataDir, and are opened through
+ *  the cache, if given. Missing data files only produce a warning.
+ *
+ *  @return false if the cancel token was cancelled before all data files were registered.
+ */
+bool loadKEYDataFiles(KEYFile &key, const Common::UString &dataDir, ArchiveCache *cache = 0,
+                      const Common::CancelToken *cancel = 0);
+
+} // End of namespace Aurora
+
+#endif // AURORA_OPENARCHIVE_H
@@ -0,0 +1,400 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Resolving resources across a whole game installation.
+ */
+
+#include <cassert>
+#include <algorithm>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+#include "src/common/readstream.h"
+#include "src/common/readfile.h"
+#include "src/common/filepath.h"
+#include "src/common/filetree.h"
+
+#include "src/aurora/resourceresolver.h"
+#include "src/aurora/openarchive.h"
+#include "src/aurora/util.h"
+#include "src/aurora/keyfile.h"
+
+namespace Aurora {
+
+/** Is this an archive that can be added on its own, not just a KEY data file? */
+static bool isStandaloneArchive(FileType type) {
+	if ((type == kFileTypeBIF) || (type == kFileTypeBZF))
+		return false;
+
+	return TypeMan.getResourceType(type) == kResourceArchive;
+}
+
+ResourceResolver::Layer::Layer(const Common::UString &p, uint32_t prio) : path(p), priority(prio) {
+}
+
+ResourceResolver::Layer::~Layer() {
+}
+
+
+ResourceResolver::Location::Location() : layer(SIZE_MAX), index(0xFFFFFFFF) {
+}
+
+ResourceResolver::Location::Location(size_t l, uint32_t i) : layer(l), index(i) {
+}
+
+bool ResourceResolver::Location::isValid() const {
+	return layer != SIZE_MAX;
+}
+
+
+bool ResourceResolver::Key::operator==(const Key &key) const {
+	return (type == key.type) && (name == key.name);
+}
+
+size_t ResourceResolver::hashKey::operator()(const Key &key) const {
+	return std::hash<std::string>()(key.name) * 31 + (size_t) key.type;
+}
+
+bool ResourceResolver::HashKey::operator==(const HashKey &key) const {
+	return (algo == key.algo) && (hash == key.hash);
+}
+
+size_t ResourceResolver::hashHashKey::operator()(const HashKey &key) const {
+	return (size_t) (key.hash ^ (key.hash >> 32)) * 31 + (size_t) key.algo;
+}
+
+
+ResourceResolver::ResourceResolver(ArchiveCache *cache) : _cache(cache) {
+}
+
+ResourceResolver::~ResourceResolver() {
+}
+
+void ResourceResolver::clear() {
+	_names.clear();
+	_hashes.clear();
+	_hashAlgos.clear();
+
+	_layers.clear();
+}
+
+size_t ResourceResolver::addArchive(const Common::UString &path, uint32_t priority) {
+	std::unique_ptr<Layer> layer = std::make_unique<Layer>(Common::FilePath::normalize(path), priority);
+
+	try {
+		layer->archive.reset(openArchive(layer->path, _cache));
+	} catch (Common::Exception &e) {
+		e.add("Failed to add archive \"%s\" to the resource resolver", path.c_str());
+		throw;
+	}
+
+	return addLayer(std::move(layer));
+}
+
+size_t ResourceResolver::addArchive(Archive *archive, const Common::UString &path, uint32_t priority) {
+	if (!archive)
+		throw Common::Exception("ResourceResolver::addArchive(): archive == 0");
+
+	std::unique_ptr<Layer> layer = std::make_unique<Layer>(path, priority);
+	layer->archive.reset(archive);
+
+	return addLayer(std::move(layer));
+}
+
+size_t ResourceResolver::addArchives(const Common::UString &path, uint32_t priority, int recurseDepth) {
+	if (!Common::FilePath::isDirectory(path))
+		throw Common::Exception("\"%s\" is not a directory", path.c_str());
+
+	Common::FileTree tree;
+	tree.readPath(path, (recurseDepth == -1) ? -1 : (recurseDepth + 1));
+
+	std::vector<Common::UString> archives;
+
+	std::vector<const Common::FileTree::Entry *> entries(1, &tree.getRoot());
+	while (!entries.empty()) {
+		const Common::FileTree::Entry &entry = *entries.back();
+		entries.pop_back();
+
+		for (const Common::FileTree::Entry &child : entry.children) {
+			if (!child.children.empty()) {
+				entries.push_back(&child);
+				continue;
+			}
+
+			const Common::UString childPath = child.path.generic_string();
+			if (isStandaloneArchive(TypeMan.getFileType(childPath)) && child.isRegularFile())
+				archives.push_back(childPath);
+		}
+	}
+
+	std::sort(archives.begin(), archives.end());
+
+	size_t count = 0;
+	for (const Common::UString &archive : archives) {
+		try {
+			addArchive(archive, priority);
+			count++;
+		} catch (Common::Exception &e) {
+			Common::printException(e, "WARNING: ");
+		}
+	}
+
+	return count;
+}
+
+size_t ResourceResolver::addDirectory(const Common::UString &path, uint32_t priority, int recurseDepth) {
+	if (!Common::FilePath::isDirectory(path))
+		throw Common::Exception("\"%s\" is not a directory", path.c_str());
+
+	Common::FileTree tree;
+	tree.readPath(path, (recurseDepth == -1) ? -1 : (recurseDepth + 1));
+
+	std::unique_ptr<Layer> layer = std::make_unique<Layer>(tree.getRoot().path.generic_string(), priority);
+
+	std::vector<const Common::FileTree::Entry *> entries(1, &tree.getRoot());
+	while (!entries.empty()) {
+		const Common::FileTree::Entry &entry = *entries.back();
+		entries.pop_back();
+
+		for (const Common::FileTree::Entry &child : entry.children) {
+			if (!child.children.empty()) {
+				entries.push_back(&child);
+				continue;
+			}
+
+			if (child.isRegularFile())
+				layer->files.push_back(child.path.generic_string());
+		}
+	}
+
+	// Make the order, and with it which of two equally named files wins, independent of the file system
+	std::sort(layer->files.begin(), layer->files.end());
+
+	return addLayer(std::move(layer));
+}
+
+size_t ResourceResolver::getLayerCount() const {
+	return _layers.size();
+}
+
+const ResourceResolver::Layer &ResourceResolver::getLayer(size_t layer) const {
+	if (layer >= _layers.size())
+		throw Common::Exception("Resource resolver layer index out of range (%s >= %s)",
+		                        Common::composeString(layer).c_str(), Common::composeString(_layers.size()).c_str());
+
+	return *_layers[layer];
+}
+
+size_t ResourceResolver::size() const {
+	return _names.size() + _hashes.size();
+}
+
+size_t ResourceResolver::addLayer(std::unique_ptr<Layer> layer) {
+	_layers.push_back(std::move(layer));
+
+	const size_t index = _layers.size() - 1;
+
+	if (_layers.back()->archive)
+		indexArchive(index);
+	else
+		indexDirectory(index);
+
+	return index;
+}
+
+void ResourceResolver::indexArchive(size_t layer) {
+	const Archive &archive = *_layers[layer]->archive;
+
+	const KEYFile *key = dynamic_cast<const KEYFile *>(&archive);
+
+	const Archive::ResourceList &resources = archive.getResources();
+	const Common::HashAlgo algo = archive.getNameHashAlgo();
+
+	_names.reserve(_names.size() + resources.size());
+
+	Key nameKey;
+	for (const Archive::Resource &resource : resources) {
+		// KEY resources in data files we don't have can't be read anyway
+		if (key && !key->haveDataFile(resource.index))
+			continue;
+
+		const Location location(layer, resource.index);
+
+		if (resource.name[0] != '\0') {
+			makeKey(nameKey, resource.name, resource.type);
+			addResource(_names, nameKey, location);
+
+		} else if (algo != Common::kHashNone) {
+			addResource(_hashes, HashKey{algo, resource.hash}, location);
+
+			if (std::find(_hashAlgos.begin(), _hashAlgos.end(), algo) == _hashAlgos.end())
+				_hashAlgos.push_back(algo);
+		}
+	}
+}
+
+void ResourceResolver::indexDirectory(size_t layer) {
+	const std::vector<Common::UString> &files = _layers[layer]->files;
+
+	_names.reserve(_names.size() + files.size());
+
+	Key nameKey;
+	for (size_t i = 0; i < files.size(); i++) {
+		const Common::UString stem = Common::FilePath::getStem(files[i]);
+
+		makeKey(nameKey, stem.c_str(), TypeMan.getFileType(files[i]));
+		addResource(_names, nameKey, Location(layer, i));
+	}
+}
+
+template<typename K, typename M>
+void ResourceResolver::addResource(M &map, K &&key, const Location &location) {
+	std::pair<typename M::iterator, bool> result = map.emplace(std::forward<K>(key), location);
+	if (!result.second && overrides(location, result.first->second))
+		result.first->second = location;
+}
+
+bool ResourceResolver::overrides(const Location &location1, const Location &location2) const {
+	const uint32_t priority1 = _layers[location1.layer]->priority;
+	const uint32_t priority2 = _layers[location2.layer]->priority;
+
+	if (priority1 != priority2)
+		return priority1 > priority2;
+
+	if (location1.layer != location2.layer)
+		return location1.layer > location2.layer;
+
+	// Within the same layer, the first resource wins, like for Archive::findResource()
+	return false;
+}
+
+ResourceResolver::Location ResourceResolver::resolve(const Common::UString &name, FileType type) const {
+	Key key;
+	makeKey(key, name.c_str(), type);
+
+	Location location;
+
+	NameMap::const_iterator byName = _names.find(key);
+	if (byName != _names.end())
+		location = byName->second;
+
+	if (_hashAlgos.empty())
+		return location;
+
+	// Check the archives that only know the hashes of their resource names
+	const Common::UString fileName = TypeMan.setFileType(key.name, type);
+
+	for (Common::HashAlgo algo : _hashAlgos) {
+		HashMap::const_iterator byHash = _hashes.find(HashKey{algo, Common::hashString(fileName, algo)});
+		if (byHash == _hashes.end())
+			continue;
+
+		if (!location.isValid() || overrides(byHash->second, location))
+			location = byHash->second;
+	}
+
+	return location;
+}
+
+std::vector<ResourceResolver::Location> ResourceResolver::resolve(const std::vector<Archive::ResourceName> &names) const {
+	std::vector<Location> locations;
+	locations.reserve(names.size());
+
+	for (const Archive::ResourceName &name : names)
+		locations.push_back(resolve(name.first, name.second));
+
+	return locations;
+}
+
+bool ResourceResolver::hasResource(const Common::UString &name, FileType type) const {
+	return resolve(name, type).isValid();
+}
+
+uint32_t ResourceResolver::getResourceSize(const Location &location) const {
+	const Layer &layer = getLayer(location.layer);
+
+	if (layer.archive)
+		return layer.archive->getResourceSize(location.index);
+
+	assert(location.index < layer.files.size());
+
+	const size_t size = Common::FilePath::getFileSize(layer.files[location.index]);
+	if ((size == Common::kFileInvalid) || (size > 0xFFFFFFFF))
+		return 0xFFFFFFFF;
+
+	return size;
+}
+
+Common::SeekableReadStream *ResourceResolver::getResource(const Location &location, bool tryNoCopy) const {
+	const Layer &layer = getLayer(location.layer);
+
+	if (layer.archive)
+		return layer.archive->getResource(location.index, tryNoCopy);
+
+	assert(location.index < layer.files.size());
+
+	return new Common::ReadFile(layer.files[location.index]);
+}
+
+Common::SeekableReadStream *ResourceResolver::getResource(const Common::UString &name, FileType type,
+                                                          bool tryNoCopy) const {
+
+	const Location location = resolve(name, type);
+	if (!location.isValid())
+		return 0;
+
+	return getResource(location, tryNoCopy);
+}
+
+Common::UString ResourceResolver::getPath(const Location &location) const {
+	const Layer &layer = getLayer(location.layer);
+
+	if (!layer.archive) {
+		assert(location.index < layer.files.size());
+
+		return layer.files[location.index];
+	}
+
+	const Archive::ResourceList &resources = layer.archive->getResources();
+	if (location.index >= resources.size())
+		return layer.path;
+
+	const Archive::Resource &resource = resources[location.index];
+
+	Common::UString name = resource.name;
+	if (name.empty())
+		name = Common::composeString(resource.hash);
+
+	return layer.path + ":" + TypeMan.setFileType(name, resource.type);
+}
+
+void ResourceResolver::makeKey(Key &key, const char *name, FileType type) {
+	key.name.assign(name);
+	key.type = type;
+
+	// Only ASCII letters are folded, which covers all the names the games use
+	for (std::string::iterator c = key.name.begin(); c != key.name.end(); ++c)
+		if ((*c >= 'A') && (*c <= 'Z'))
+			*c += 'a' - 'A';
+}
+
+} // End of namespace Aurora
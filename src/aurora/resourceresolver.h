@@ -0,0 +1,249 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Resolving resources across a whole game installation.
+ */
+
+#ifndef AURORA_RESOURCERESOLVER_H
+#define AURORA_RESOURCERESOLVER_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/hash.h"
+
+#include "src/aurora/types.h"
+#include "src/aurora/archive.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+class ArchiveCache;
+
+/** Priorities of the usual resource sources, mirroring the order the engines load them in.
+ *
+ *  Resources from a source with a higher priority override those of a lower
+ *  priority. Any other value can be used as well, for finer control.
+ */
+enum ResolverPriority {
+	kPriorityBase     = 100, ///< The game's base data, usually a KEY with its BIFs.
+	kPriorityPatch    = 200, ///< Patches and expansions to the base data.
+	kPriorityDLC      = 300, ///< Downloadable content.
+	kPriorityModule   = 400, ///< The current module (MOD, RIM, ERF).
+	kPriorityHAK      = 500, ///< HAK paks used by the current module.
+	kPriorityOverride = 600  ///< The override directory.
+};
+
+/** Resolves resource names against a whole game installation.
+ *
+ *  The resolver merges the resources of any number of sources, called
+ *  layers, into one namespace: KEY files together with their BIF/BZF data
+ *  files, ERF, HAK, MOD, RIM and similar archives, and directories of loose
+ *  files, like the override directory.
+ *
+ *  Every layer has a priority. When several layers contain a resource of the
+ *  same name and type, the one from the layer with the highest priority is
+ *  used. Between layers of equal priority, the layer added last wins.
+ *
+ *  The merged namespace is built once, while adding the layers. Afterwards,
+ *  each lookup is a single hash table access (plus one for each kind of name
+ *  hashing found in archives without resource names). Like in the games
+ *  themselves, resource names are case-insensitive.
+ *
+ *  Adding layers is not thread-safe, but once all layers are added, resources
+ *  can be resolved from several threads concurrently.
+ */
+class ResourceResolver : boost::noncopyable {
+public:
+	/** A source of resources. */
+	struct Layer {
+		Common::UString path; ///< The path of the archive or directory.
+		uint32_t priority;    ///< The priority of this layer.
+
+		/** The archive, or 0 for a directory of loose files. */
+		std::unique_ptr<Archive> archive;
+
+		/** The paths of the files in a directory. */
+		std::vector<Common::UString> files;
+
+		Layer(const Common::UString &p, uint32_t prio);
+		~Layer();
+	};
+
+	/** The location of a resolved resource. */
+	struct Location {
+		size_t   layer; ///< The index of the layer holding the resource.
+		uint32_t index; ///< The index of the resource within the layer.
+
+		Location();
+		Location(size_t l, uint32_t i);
+
+		/** Was the resource found? */
+		bool isValid() const;
+	};
+
+	/** Create a resolver, optionally opening archives through an archive cache.
+	 *
+	 *  The cache, if given, needs to outlive the resolver.
+	 */
+	ResourceResolver(ArchiveCache *cache = 0);
+	~ResourceResolver();
+
+	/** Remove all layers. */
+	void clear();
+
+	/** Add an archive file as a layer.
+	 *
+	 *  The type of archive is detected by the file's extension. For a KEY
+	 *  file, the BIF/BZF data files are looked for relative to the KEY's
+	 *  directory. Data files that can't be found are skipped with a warning.
+	 *  The data files themselves are only opened when a resource is read
+	 *  out of them.
+	 *
+	 *  @return The index of the new layer.
+	 */
+	size_t addArchive(const Common::UString &path, uint32_t priority);
+
+	/** Add an already opened archive as a layer, taking over its ownership.
+	 *
+	 *  @return The index of the new layer.
+	 */
+	size_t addArchive(Archive *archive, const Common::UString &path, uint32_t priority);
+
+	/** Add every archive found in this directory as its own layer.
+	 *
+	 *  The archives are added in alphabetical order of their paths. Archives
+	 *  that fail to open are skipped with a warning.
+	 *
+	 *  @param  path The directory to look through.
+	 *  @param  priority The priority of all new layers.
+	 *  @param  recurseDepth The number of levels to recurse into subdirectories, -1 for unlimited.
+	 *  @return The number of layers added.
+	 */
+	size_t addArchives(const Common::UString &path, uint32_t priority, int recurseDepth = 0);
+
+	/** Add a directory of loose files, like the override directory, as a layer.
+	 *
+	 *  @param  path The directory to add.
+	 *  @param  priority The priority of the new layer.
+	 *  @param  recurseDepth The number of levels to recurse into subdirectories, -1 for unlimited.
+	 *  @return The index of the new layer.
+	 */
+	size_t addDirectory(const Common::UString &path, uint32_t priority, int recurseDepth = -1);
+
+	/** Return the number of layers. */
+	size_t getLayerCount() const;
+	/** Return a layer. */
+	const Layer &getLayer(size_t layer) const;
+
+	/** Return the number of distinct resources in the merged namespace. */
+	size_t size() const;
+
+	/** Find a resource, returning an invalid location if it doesn't exist. */
+	Location resolve(const Common::UString &name, FileType type) const;
+	/** Find several resources at once. */
+	std::vector<Location> resolve(const std::vector<Archive::ResourceName> &names) const;
+
+	/** Does a resource exist? */
+	bool hasResource(const Common::UString &name, FileType type) const;
+
+	/** Return the size of a resolved resource, or 0xFFFFFFFF if unknown. */
+	uint32_t getResourceSize(const Location &location) const;
+
+	/** Return a stream of a resolved resource's contents. */
+	Common::SeekableReadStream *getResource(const Location &location, bool tryNoCopy = false) const;
+	/** Return a stream of a resource's contents, or 0 if it doesn't exist. */
+	Common::SeekableReadStream *getResource(const Common::UString &name, FileType type, bool tryNoCopy = false) const;
+
+	/** Return the path of a resolved resource, for describing where it comes from.
+	 *
+	 *  For a loose file, this is the path of the file. For a resource inside an
+	 *  archive, this is the path of the archive, followed by the resource's name.
+	 */
+	Common::UString getPath(const Location &location) const;
+
+private:
+	/** Key into the merged namespace: the lowercased name and the type of a resource. */
+	struct Key {
+		std::string name;
+		FileType    type;
+
+		bool operator==(const Key &key) const;
+	};
+
+	struct hashKey {
+		size_t operator()(const Key &key) const;
+	};
+
+	/** Key for resources only known by the hash of their name. */
+	struct HashKey {
+		Common::HashAlgo algo;
+		uint64_t         hash;
+
+		bool operator==(const HashKey &key) const;
+	};
+
+	struct hashHashKey {
+		size_t operator()(const HashKey &key) const;
+	};
+
+	typedef std::unordered_map<Key, Location, hashKey> NameMap;
+	typedef std::unordered_map<HashKey, Location, hashHashKey> HashMap;
+
+	ArchiveCache *_cache;
+
+	std::vector<std::unique_ptr<Layer>> _layers;
+
+	/** All resources known by name. */
+	NameMap _names;
+	/** All resources only known by the hash of their name. */
+	HashMap _hashes;
+
+	/** The name hashing algorithms used by the resources in _hashes. */
+	std::vector<Common::HashAlgo> _hashAlgos;
+
+	size_t addLayer(std::unique_ptr<Layer> layer);
+
+	void indexArchive(size_t layer);
+	void indexDirectory(size_t layer);
+
+	/** Add a resource to the merged namespace, if it overrides the current one. */
+	template<typename K, typename M>
+	void addResource(M &map, K &&key, const Location &location);
+
+	/** Does this location override that one? */
+	bool overrides(const Location &location1, const Location &location2) const;
+
+	static void makeKey(Key &key, const char *name, FileType type);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_RESOURCERESOLVER_H
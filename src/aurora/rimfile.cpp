@@ -29,8 +29,10 @@
 #include "src/common/memreadstream.h"
 #include "src/common/error.h"
 #include "src/common/encoding.h"
+#include "src/common/writestream.h"
 
 #include "src/aurora/rimfile.h"
+#include "src/aurora/archivecache.h"
 
 static const uint32_t kRIMID     = MKTAG('R', 'I', 'M', ' ');
 static const uint32_t kVersion1  = MKTAG('V', '1', '.', '0');
@@ -43,6 +45,12 @@ RIMFile::RIMFile(Common::SeekableReadStream *rim) : _rim(rim) {
 	load(*_rim);
 }
 
+RIMFile::RIMFile(Common::SeekableReadStream *rim, Common::SeekableReadStream &index) : _rim(rim) {
+	assert(_rim);
+
+	readIndex(index);
+}
+
 RIMFile::~RIMFile() {
 }
 
@@ -81,13 +89,48 @@ void RIMFile::readResList(Common::SeekableReadStream &rim, uint32_t offset) {
 	ResourceList::iterator   res = _resources.begin();
 	IResourceList::iterator iRes = _iResources.begin();
 	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++index, ++res, ++iRes) {
-		res->name    = Common::readStringFixed(rim, Common::kEncodingASCII, 16);
+		_resources.setName(*res, Common::readStringFixed(rim, Common::kEncodingASCII, 16));
 		res->type    = (FileType) rim.readUint16LE();
 		res->index   = index;
 		rim.skip(4 + 2); // Resource ID + Reserved
 		iRes->offset = rim.readUint32LE();
 		iRes->size   = rim.readUint32LE();
 	}
+
+	_resources.finish();
+}
+
+void RIMFile::writeIndex(Common::WriteStream &index) const {
+	index.writeUint32BE(_id);
+	index.writeUint32BE(_version);
+
+	ArchiveCache::writeResources(index, _resources);
+
+	index.writeUint32LE(_iResources.size());
+	for (IResourceList::const_iterator iRes = _iResources.begin(); iRes != _iResources.end(); ++iRes) {
+		index.writeUint32LE(iRes->offset);
+		index.writeUint32LE(iRes->size);
+	}
+}
+
+void RIMFile::readIndex(Common::SeekableReadStream &index) {
+	_id      = index.readUint32BE();
+	_version = index.readUint32BE();
+
+	if ((_id != kRIMID) || (_version != kVersion1))
+		throw Common::Exception("Not a RIM index (%s, %s)", Common::debugTag(_id).c_str(),
+		                        Common::debugTag(_version).c_str());
+
+	ArchiveCache::readResources(index, _resources);
+
+	_iResources.resize(ArchiveCache::readCount(index, 8));
+	if (_iResources.size() != _resources.size())
+		throw Common::Exception("RIM index resource count mismatch");
+
+	for (IResourceList::iterator iRes = _iResources.begin(); iRes != _iResources.end(); ++iRes) {
+		iRes->offset = index.readUint32LE();
+		iRes->size   = index.readUint32LE();
+	}
 }
 
 const Archive::ResourceList &RIMFile::getResources() const {
@@ -109,11 +152,9 @@ Common::SeekableReadStream *RIMFile::getResource(uint32_t index, bool tryNoCopy)
 	const IResource &res = getIResource(index);
 
 	if (tryNoCopy)
-		return new Common::SeekableSubReadStream(_rim.get(), res.offset, res.offset + res.size);
-
-	_rim->seek(res.offset);
+		return _rim->createSubStream(res.offset, res.offset + res.size);
 
-	return _rim->readStream(res.size);
+	return _rim->readStreamAt(res.offset, res.size);
 }
 
 } // End of namespace Aurora
@@ -36,6 +36,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class WriteStream;
 }
 
 namespace Aurora {
@@ -62,8 +63,13 @@ class RIMFile : public Archive, public AuroraFile {
 public:
 	/** Take over this stream and read a RIM file out of it. */
 	RIMFile(Common::SeekableReadStream *rim);
+	/** Take over this stream and read the RIM's resource list out of an index, as written by writeIndex(). */
+	RIMFile(Common::SeekableReadStream *rim, Common::SeekableReadStream &index);
 	~RIMFile();
 
+	/** Write an index of this RIM, for use with ArchiveCache. */
+	void writeIndex(Common::WriteStream &index) const;
+
 	/** Return the list of resources. */
 	const ResourceList &getResources() const;
 
@@ -93,6 +99,8 @@ private:
 	void load(Common::SeekableReadStream &rim);
 	void readResList(Common::SeekableReadStream &rim, uint32_t offset);
 
+	void readIndex(Common::SeekableReadStream &index);
+
 	const IResource &getIResource(uint32_t index) const;
 };
 
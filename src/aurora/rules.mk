@@ -30,6 +30,9 @@ src_aurora_libaurora_la_SOURCES += \
     src/aurora/locstring.h \
     src/aurora/aurorafile.h \
     src/aurora/archive.h \
+    src/aurora/archivecache.h \
+    src/aurora/openarchive.h \
+    src/aurora/resourceresolver.h \
     src/aurora/zipfile.h \
     src/aurora/erffile.h \
     src/aurora/rimfile.h \
@@ -52,6 +55,9 @@ src_aurora_libaurora_la_SOURCES += \
     src/aurora/locstring.cpp \
     src/aurora/aurorafile.cpp \
     src/aurora/archive.cpp \
+    src/aurora/archivecache.cpp \
+    src/aurora/openarchive.cpp \
+    src/aurora/resourceresolver.cpp \
     src/aurora/zipfile.cpp \
     src/aurora/erffile.cpp \
     src/aurora/rimfile.cpp \
@@ -398,14 +398,19 @@ FileTypeManager::FileTypeManager() {
 
 	_resourceTypes[kResourceTable].push_back(kFileType2DA);
 	_resourceTypes[kResourceTable].push_back(kFileTypeGDA);
+
+	// Build all lookups right away. Afterwards, they're only ever read, from any thread
+	buildExtensionLookup();
+	buildTypeLookup();
+
+	for (int i = 0; i < Common::kHashMAX; i++)
+		buildHashLookup((Common::HashAlgo) i);
 }
 
 FileTypeManager::~FileTypeManager() {
 }
 
-FileType FileTypeManager::getFileType(const Common::UString &path) {
-	buildExtensionLookup();
-
+FileType FileTypeManager::getFileType(const Common::UString &path) const {
 	Common::UString ext = Common::FilePath::getExtension(path).toLower();
 
 	ExtensionLookup::const_iterator t = _extensionLookup.find(ext);
@@ -415,13 +420,11 @@ FileType FileTypeManager::getFileType(const Common::UString &path) {
 	return kFileTypeNone;
 }
 
-Common::UString FileTypeManager::addFileType(const Common::UString &path, FileType type) {
+Common::UString FileTypeManager::addFileType(const Common::UString &path, FileType type) const {
 	return setFileType(path + ".", type);
 }
 
-Common::UString FileTypeManager::setFileType(const Common::UString &path, FileType type) {
-	buildTypeLookup();
-
+Common::UString FileTypeManager::setFileType(const Common::UString &path, FileType type) const {
 	Common::UString ext;
 	TypeLookup::const_iterator t = _typeLookup.find(type);
 	if (t != _typeLookup.end())
@@ -430,12 +433,10 @@ Common::UString FileTypeManager::setFileType(const Common::UString &path, FileTy
 	return Common::FilePath::changeExtension(path, ext);
 }
 
-FileType FileTypeManager::getFileType(Common::HashAlgo algo, uint64_t hashedExtension) {
+FileType FileTypeManager::getFileType(Common::HashAlgo algo, uint64_t hashedExtension) const {
 	if ((algo < 0) || (algo >= Common::kHashMAX))
 		return kFileTypeNone;
 
-	buildHashLookup(algo);
-
 	HashLookup::const_iterator t = _hashLookup[algo].find(hashedExtension);
 	if (t != _hashLookup[algo].end())
 		return t->second->type;
@@ -444,25 +445,16 @@ FileType FileTypeManager::getFileType(Common::HashAlgo algo, uint64_t hashedExte
 }
 
 void FileTypeManager::buildExtensionLookup() {
-	if (!_extensionLookup.empty())
-		return;
-
 	for (size_t i = 0; i < ARRAYSIZE(types); i++)
 		_extensionLookup.insert(std::make_pair(Common::UString(types[i].extension), &types[i]));
 }
 
 void FileTypeManager::buildTypeLookup() {
-	if (!_typeLookup.empty())
-		return;
-
 	for (size_t i = 0; i < ARRAYSIZE(types); i++)
 		_typeLookup.insert(std::make_pair(types[i].type, &types[i]));
 }
 
 void FileTypeManager::buildHashLookup(Common::HashAlgo algo) {
-	if (!_hashLookup[algo].empty())
-		return;
-
 	for (size_t i = 0; i < ARRAYSIZE(types); i++) {
 		const char *ext = types[i].extension;
 		if (ext[0] == '.')
@@ -472,9 +464,7 @@ void FileTypeManager::buildHashLookup(Common::HashAlgo algo) {
 	}
 }
 
-Common::UString FileTypeManager::getExtension(FileType type) {
-	buildTypeLookup();
-
+Common::UString FileTypeManager::getExtension(FileType type) const {
 	Common::UString ext;
 	TypeLookup::const_iterator t = _typeLookup.find(type);
 	if (t != _typeLookup.end())
@@ -486,9 +476,9 @@ Common::UString FileTypeManager::getExtension(FileType type) {
 	return ext;
 }
 
-ResourceType FileTypeManager::getResourceType(FileType type) {
+ResourceType FileTypeManager::getResourceType(FileType type) const {
 	for (int i = 0; i < kResourceMAX; i++) {
-		ResourceTypes::iterator t = std::find(_resourceTypes[i].begin(), _resourceTypes[i].end(), type);
+		ResourceTypes::const_iterator t = std::find(_resourceTypes[i].begin(), _resourceTypes[i].end(), type);
 
 		if (t != _resourceTypes[i].end())
 			return (ResourceType) i;
@@ -497,11 +487,11 @@ ResourceType FileTypeManager::getResourceType(FileType type) {
 	return kResourceNone;
 }
 
-ResourceType FileTypeManager::getResourceType(const Common::UString &path) {
+ResourceType FileTypeManager::getResourceType(const Common::UString &path) const {
 	return getResourceType(getFileType(path));
 }
 
-ResourceType FileTypeManager::getResourceType(Common::HashAlgo algo, uint64_t hashedExtension) {
+ResourceType FileTypeManager::getResourceType(Common::HashAlgo algo, uint64_t hashedExtension) const {
 	return getResourceType(getFileType(algo, hashedExtension));
 }
 
@@ -43,31 +43,37 @@ Common::UString getPlatformDescription(Platform platform);
 Common::UString getResourceTypeDescription(ResourceType type);
 
 
+/** Looks up file types by their extensions, and vice versa.
+ *
+ *  All lookups are built when the manager is created. After that, the manager
+ *  is only ever read, so its methods can be called from several threads at once.
+ *  Only the creation itself, on the first use of TypeMan, is not thread-safe.
+ */
 class FileTypeManager : public Common::Singleton<FileTypeManager> {
 public:
 	FileTypeManager();
 	~FileTypeManager();
 
 	/** Return the file type of a file name, detected by its extension. */
-	FileType getFileType(const Common::UString &path);
+	FileType getFileType(const Common::UString &path) const;
 
 	/** Return the file type of a file name, detected by its hashed extension. */
-	FileType getFileType(Common::HashAlgo algo, uint64_t hashedExtension);
+	FileType getFileType(Common::HashAlgo algo, uint64_t hashedExtension) const;
 
 	/** Return the file name with an added extensions according to the specified file type. */
-	Common::UString addFileType(const Common::UString &path, FileType type);
+	Common::UString addFileType(const Common::UString &path, FileType type) const;
 	/** Return the file name with a swapped extensions according to the specified file type. */
-	Common::UString setFileType(const Common::UString &path, FileType type);
+	Common::UString setFileType(const Common::UString &path, FileType type) const;
 
 	/** Return the raw extension of a file type. */
-	Common::UString getExtension(FileType type);
+	Common::UString getExtension(FileType type) const;
 
 	/** Return the resource type of a file type. */
-	ResourceType getResourceType(FileType type);
+	ResourceType getResourceType(FileType type) const;
 	/** Return the resource type of a file name, detected by its extension. */
-	ResourceType getResourceType(const Common::UString &path);
+	ResourceType getResourceType(const Common::UString &path) const;
 	/** Return the resource type of a file name, detected by its hashed extension. */
-	ResourceType getResourceType(Common::HashAlgo algo, uint64_t hashedExtension);
+	ResourceType getResourceType(Common::HashAlgo algo, uint64_t hashedExtension) const;
 
 
 private:
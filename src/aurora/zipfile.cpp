@@ -57,15 +57,11 @@ Common::SeekableReadStream *ZIPFile::getResource(uint32_t index, bool tryNoCopy)
 
 void ZIPFile::load() {
 	const Common::ZipFile::FileList &files = _zipFile->getFiles();
-	for (Common::ZipFile::FileList::const_iterator file = files.begin(); file != files.end(); ++file) {
-		Resource res;
+	_resources.reserve(files.size());
+	for (Common::ZipFile::FileList::const_iterator file = files.begin(); file != files.end(); ++file)
+		_resources.add(Common::FilePath::getStem(file->name), TypeMan.getFileType(file->name), file->index);
 
-		res.name  = Common::FilePath::getStem(file->name);
-		res.type  = TypeMan.getFileType(file->name);
-		res.index = file->index;
-
-		_resources.push_back(res);
-	}
+	_resources.finish();
 }
 
 } // End of namespace Aurora
@@ -23,6 +23,8 @@
  */
 
 #include "src/common/string.h"
+#include "src/common/strutil.h"
+#include "src/common/error.h"
 
 #include "src/version/version.h"
 
@@ -45,6 +47,34 @@ Job parseCommandLine(const std::vector<Common::UString> &argv) {
 			break;
 		}
 
+		// --extract needs the archive and the output directory
+		if ((argv[i] == Common::UString("-x")) || (argv[i] == Common::UString("--extract"))) {
+			if (((i + 2) >= argv.size()) || !job.path.empty() || (job.operation == kOperationExtract)) {
+				job.operation = kOperationInvalid;
+				break;
+			}
+
+			job.operation = kOperationExtract;
+			job.path      = argv[++i];
+			job.outPath   = argv[++i];
+			continue;
+		}
+
+		// --jobs needs the number of parallel jobs
+		if ((argv[i] == Common::UString("-j")) || (argv[i] == Common::UString("--jobs"))) {
+			try {
+				if ((i + 1) >= argv.size())
+					throw Common::Exception("Missing number of jobs");
+
+				Common::parseString(argv[++i], job.jobs);
+			} catch (...) {
+				job.operation = kOperationInvalid;
+				break;
+			}
+
+			continue;
+		}
+
 		// We only allow one path, so a second one makes the command line invalid
 		if (!job.path.empty()) {
 			job.operation = kOperationInvalid;
@@ -74,8 +104,11 @@ Common::UString createHelpText(const Common::UString &name) {
 	text += Common::String::format("%s - A FLOSS resource explorer for BioWare's Aurora engine games\n",
 	                                Version::getProjectName());
 	text += Common::String::format("Usage: %s [options] [<path>]\n", name.c_str());
+	text += Common::String::format("       %s [options] --extract <archive> <directory>\n", name.c_str());
 	text += Common::String::format("  -h      --help              Display this text and exit.\n");
-	text += Common::String::format("  -v      --version           Display version information and exit.");
+	text += Common::String::format("  -v      --version           Display version information and exit.\n");
+	text += Common::String::format("  -x      --extract           Extract all resources of an archive into a directory.\n");
+	text += Common::String::format("  -j <n>  --jobs <n>          Use <n> worker threads (default: one per CPU core).");
 
 	return text;
 }
@@ -25,6 +25,8 @@
 #ifndef CLINE_H
 #define CLINE_H
 
+#include <cstddef>
+
 #include <vector>
 
 #include "src/common/ustring.h"
@@ -34,15 +36,19 @@ enum Operation {
 	kOperationInvalid = 0, ///< Invalid command line.
 	kOperationHelp       , ///< Show the help text.
 	kOperationVersion    , ///< Show version information.
-	kOperationPath         ///< Crawl through a game directory.
+	kOperationPath       , ///< Crawl through a game directory.
+	kOperationExtract      ///< Extract all resources of an archive.
 };
 
 /** Full description of the job this tool will be doing. */
 struct Job {
 	Operation operation;  ///< The operation to perform.
-	Common::UString path; ///< The game directory to look through.
+	Common::UString path; ///< The game directory to look through, or the archive to extract.
+
+	Common::UString outPath; ///< The directory to extract into.
+	size_t jobs;             ///< Number of worker threads, 0 for one per CPU core.
 
-	Job() : operation(kOperationInvalid) {
+	Job() : operation(kOperationInvalid), jobs(0) {
 	}
 };
 
@@ -30,6 +30,8 @@
 #include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
+#include "src/common/endianness.h"
+#include "src/common/util.h"
 #include "src/common/disposableptr.h"
 #include "src/common/error.h"
 #include "src/common/readstream.h"
@@ -63,6 +65,15 @@ public:
 	/** Read a multi-bit value from the bit stream. */
 	virtual uint32_t getBits(size_t n) = 0;
 
+	/** Read a multi-bit value from the bit stream, without advancing the position.
+	 *
+	 *  Bits past the end of the stream are read as 0.
+	 */
+	virtual uint32_t peekBits(size_t n) = 0;
+
+	/** Are the bits of a value handed out in the order of MSB to LSB? */
+	virtual bool isMSBFirst() const = 0;
+
 	/** Add a bit to the n-bit value x, making it an (n+1)-bit value. */
 	virtual void addBit(uint32_t &x, size_t n) = 0;
 
@@ -198,6 +209,49 @@ public:
 		return v;
 	}
 
+	/** Read a multi-bit value from the bit stream, without advancing the position. */
+	uint32_t peekBits(size_t n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			throw Exception("Too many bits requested to be read");
+
+		/* Collect the bits left in the current value, and as many following
+		 * values as needed, in an accumulator. Values past the end of the
+		 * stream are never read, so their bits stay 0. */
+
+		uint64_t bits = (_inValue == 0) ? 0 : _value;
+		size_t   have = (_inValue == 0) ? 0 : (valueBits - _inValue);
+
+		const size_t streamPos = _stream->pos();
+		const size_t valueSize = valueBits / 8;
+
+		while ((have < n) && ((_stream->size() - _stream->pos()) >= valueSize)) {
+			const uint64_t value = readData();
+
+			// Bits that don't fit into the accumulator anymore aren't needed anyway
+			if (isMSB2LSB)
+				bits |= (value << (64 - valueBits)) >> have;
+			else
+				bits |= value << have;
+
+			have += valueBits;
+		}
+
+		_stream->seek(streamPos);
+
+		if (isMSB2LSB)
+			return (uint32_t) (bits >> (64 - n));
+
+		return (uint32_t) (bits & (0xFFFFFFFFFFFFFFFFULL >> (64 - n)));
+	}
+
+	/** Are the bits of a value handed out in the order of MSB to LSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
 	/** Add a bit to the n-bit value x, making it an (n+1)-bit value. */
 	void addBit(uint32_t &x, size_t n) {
 		if (n >= 32)
@@ -219,8 +273,23 @@ public:
 
 	/** Skip the specified amount of bits. */
 	void skip(size_t n) {
-		while (n-- > 0)
-			getBit();
+		// Skip as many bits as possible out of the current value at once
+		while (n > 0) {
+			if (_inValue == 0)
+				readValue();
+
+			const size_t count = MIN<size_t>(n, valueBits - _inValue);
+
+			if (count >= 64)
+				_value = 0;
+			else if (isMSB2LSB)
+				_value <<= count;
+			else
+				_value >>= count;
+
+			_inValue = (_inValue + count) % valueBits;
+			n -= count;
+		}
 	}
 
 	/** Return the stream position in bits. */
@@ -276,6 +345,338 @@ typedef BitStreamImpl<64, false, true > BitStream64BEMSB;
 /** 64-bit big-endian data, LSB to MSB. */
 typedef BitStreamImpl<64, false, false> BitStream64BELSB;
 
+/**
+ * A template implementing a bit stream over a contiguous memory buffer.
+ *
+ * It has the same memory layout parameters as BitStreamImpl, but instead
+ * of reading the bits from a data stream one at a time, it keeps up to 64
+ * bits of the buffer in an accumulator, refilled with as many whole values
+ * as fit in one go. getBits(), peekBits() and skipBits() then only need a
+ * shift and a mask most of the time.
+ *
+ * The buffer is not copied and needs to stay valid for the lifetime of the
+ * bit stream. Use BitStreamImpl for data that is not available in memory.
+ */
+template<int valueBits, bool isLE, bool isMSB2LSB>
+class MemoryBitStreamImpl final : boost::noncopyable, public BitStream {
+private:
+	static const size_t kValueSize = valueBits / 8;
+
+	const byte *_data; ///< The input data.
+	size_t      _size; ///< The size of the input data in bytes, in whole values.
+
+	size_t _dataPos; ///< Offset of the first value not yet in the accumulator.
+
+	/** The accumulator.
+	 *
+	 *  For MSB to LSB streams, the next bit is the MSB of the accumulator,
+	 *  otherwise it's the LSB. Bits past the valid ones are either 0 or
+	 *  already the correct following bits of the buffer.
+	 */
+	uint64_t _cache;
+	size_t   _cacheBits; ///< Number of valid bits in the accumulator.
+
+	/** Read the value at this offset in the buffer. */
+	inline uint64_t readValue(size_t offset) const {
+		const byte *data = _data + offset;
+
+		if (valueBits ==  8)
+			return *data;
+
+		if (isLE) {
+			if (valueBits == 16)
+				return READ_LE_UINT16(data);
+			if (valueBits == 32)
+				return READ_LE_UINT32(data);
+			if (valueBits == 64)
+				return READ_LE_UINT64(data);
+		} else {
+			if (valueBits == 16)
+				return READ_BE_UINT16(data);
+			if (valueBits == 32)
+				return READ_BE_UINT32(data);
+			if (valueBits == 64)
+				return READ_BE_UINT64(data);
+		}
+
+		assert(false);
+		return 0;
+	}
+
+	/** Put as many whole values into the accumulator as will fit. */
+	inline void refill() {
+		if ((valueBits == 8) && ((_size - _dataPos) >= 8)) {
+			/* For bytes, the next 8 bytes in bit order are just one 64-bit
+			 * read. Bits that don't fit are dropped, and bits of a partial
+			 * byte are already the correct following bits. */
+
+			const uint64_t value = isMSB2LSB ? READ_BE_UINT64(_data + _dataPos) : READ_LE_UINT64(_data + _dataPos);
+			const size_t   count = (64 - _cacheBits) >> 3;
+
+			if (isMSB2LSB)
+				_cache |= value >> _cacheBits;
+			else
+				_cache |= value << _cacheBits;
+
+			_dataPos   += count;
+			_cacheBits += count * 8;
+			return;
+		}
+
+		while ((_cacheBits <= (64 - valueBits)) && (_dataPos < _size)) {
+			const uint64_t value = readValue(_dataPos);
+
+			if (isMSB2LSB)
+				_cache |= (value << (64 - valueBits)) >> _cacheBits;
+			else
+				_cache |= value << _cacheBits;
+
+			_dataPos   += kValueSize;
+			_cacheBits += valueBits;
+		}
+	}
+
+	/** Return the next n bits (0 < n <= 32) in the accumulator. */
+	inline uint32_t peekCache(size_t n) const {
+		if (isMSB2LSB)
+			return (uint32_t) (_cache >> (64 - n));
+
+		return (uint32_t) (_cache & (0xFFFFFFFFFFFFFFFFULL >> (64 - n)));
+	}
+
+	/** Drop the next n bits (0 < n <= _cacheBits) from the accumulator. */
+	inline void consumeCache(size_t n) {
+		if (n >= 64)
+			_cache = 0;
+		else if (isMSB2LSB)
+			_cache <<= n;
+		else
+			_cache >>= n;
+
+		_cacheBits -= n;
+	}
+
+	/** Read bits that straddle the end of the accumulator.
+	 *
+	 *  Only happens for 64-bit values, or at the end of the buffer.
+	 */
+	uint32_t getBitsSlow(size_t n) {
+		if ((size() - pos()) < n)
+			throw Exception("BitStream::getBits(): End of bit stream reached");
+
+		const size_t first = _cacheBits;
+
+		const uint32_t v1 = (first > 0) ? peekCache(first) : 0;
+		if (first > 0)
+			consumeCache(first);
+
+		refill();
+
+		const size_t   second = n - first;
+		const uint32_t v2     = peekCache(second);
+		consumeCache(second);
+
+		if (isMSB2LSB)
+			return (v1 << second) | v2;
+
+		return v1 | (v2 << first);
+	}
+
+	/** Peek at bits that straddle the end of the accumulator, 0 past the end of the buffer. */
+	uint32_t peekBitsSlow(size_t n) const {
+		uint64_t bits = _cache;
+		size_t   have = _cacheBits;
+
+		if (_dataPos < _size) {
+			const uint64_t value = readValue(_dataPos);
+
+			// Bits that don't fit into the accumulator anymore aren't needed anyway
+			if (isMSB2LSB)
+				bits |= (value << (64 - valueBits)) >> have;
+			else if (have < 64)
+				bits |= value << have;
+		}
+
+		if (isMSB2LSB)
+			return (uint32_t) (bits >> (64 - n));
+
+		return (uint32_t) (bits & (0xFFFFFFFFFFFFFFFFULL >> (64 - n)));
+	}
+
+public:
+	/** Create a bit stream over this memory buffer of this size in bytes. */
+	MemoryBitStreamImpl(const byte *data, size_t size) : _data(data),
+		_size(size & ~((size_t) (kValueSize - 1))), _dataPos(0), _cache(0), _cacheBits(0) {
+
+		assert(_data || (_size == 0));
+
+		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32) && (valueBits != 64))
+			throw Exception("BitStream: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+	}
+
+	/** Create a bit stream over this memory buffer. */
+	template<size_t N>
+	MemoryBitStreamImpl(const byte (&array)[N]) : MemoryBitStreamImpl(array, N) {
+	}
+
+	~MemoryBitStreamImpl() {
+	}
+
+	/** Read a bit from the bit stream. */
+	inline uint32_t getBit() {
+		return getBits(1);
+	}
+
+	/** Read a multi-bit value from the bit stream. */
+	inline uint32_t getBits(size_t n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			throw Exception("Too many bits requested to be read");
+
+		if (_cacheBits < n) {
+			refill();
+
+			if (_cacheBits < n)
+				return getBitsSlow(n);
+		}
+
+		const uint32_t v = peekCache(n);
+		consumeCache(n);
+
+		return v;
+	}
+
+	/** Read a multi-bit value from the bit stream, without advancing the position. */
+	inline uint32_t peekBits(size_t n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			throw Exception("Too many bits requested to be read");
+
+		if (_cacheBits < n) {
+			refill();
+
+			if (_cacheBits < n)
+				return peekBitsSlow(n);
+		}
+
+		return peekCache(n);
+	}
+
+	/** Skip up to 32 bits, usually after looking at them with peekBits(). */
+	inline void skipBits(size_t n) {
+		if (n <= _cacheBits) {
+			if (n > 0)
+				consumeCache(n);
+
+			return;
+		}
+
+		skip(n);
+	}
+
+	/** Are the bits of a value handed out in the order of MSB to LSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
+	/** Add a bit to the n-bit value x, making it an (n+1)-bit value. */
+	void addBit(uint32_t &x, size_t n) {
+		if (n >= 32)
+			throw Exception("Too many bits requested to be read");
+
+		if (isMSB2LSB)
+			x = (x << 1) | getBit();
+		else
+			x = (x & ~(1 << n)) | (getBit() << n);
+	}
+
+	/** Rewind the bit stream back to the start. */
+	void rewind() {
+		_dataPos   = 0;
+		_cache     = 0;
+		_cacheBits = 0;
+	}
+
+	/** Skip the specified amount of bits. */
+	void skip(size_t n) {
+		if (n <= _cacheBits) {
+			if (n > 0)
+				consumeCache(n);
+
+			return;
+		}
+
+		if ((size() - pos()) < n)
+			throw Exception("BitStream::skip(): End of bit stream reached");
+
+		// Throw away the accumulator and jump over whole values directly
+		n -= _cacheBits;
+
+		_cache     = 0;
+		_cacheBits = 0;
+
+		_dataPos += (n / valueBits) * kValueSize;
+		n        %= valueBits;
+
+		if (n > 0) {
+			refill();
+			consumeCache(n);
+		}
+	}
+
+	/** Return the stream position in bits. */
+	size_t pos() const {
+		return _dataPos * 8 - _cacheBits;
+	}
+
+	/** Return the stream size in bits. */
+	size_t size() const {
+		return _size * 8;
+	}
+
+	bool eos() const {
+		return pos() >= size();
+	}
+};
+
+// typedefs for various memory layouts.
+
+/** 8-bit data in memory, MSB to LSB. */
+typedef MemoryBitStreamImpl<8, false, true > MemoryBitStream8MSB;
+/** 8-bit data in memory, LSB to MSB. */
+typedef MemoryBitStreamImpl<8, false, false> MemoryBitStream8LSB;
+
+/** 16-bit little-endian data in memory, MSB to LSB. */
+typedef MemoryBitStreamImpl<16, true , true > MemoryBitStream16LEMSB;
+/** 16-bit little-endian data in memory, LSB to MSB. */
+typedef MemoryBitStreamImpl<16, true , false> MemoryBitStream16LELSB;
+/** 16-bit big-endian data in memory, MSB to LSB. */
+typedef MemoryBitStreamImpl<16, false, true > MemoryBitStream16BEMSB;
+/** 16-bit big-endian data in memory, LSB to MSB. */
+typedef MemoryBitStreamImpl<16, false, false> MemoryBitStream16BELSB;
+
+/** 32-bit little-endian data in memory, MSB to LSB. */
+typedef MemoryBitStreamImpl<32, true , true > MemoryBitStream32LEMSB;
+/** 32-bit little-endian data in memory, LSB to MSB. */
+typedef MemoryBitStreamImpl<32, true , false> MemoryBitStream32LELSB;
+/** 32-bit big-endian data in memory, MSB to LSB. */
+typedef MemoryBitStreamImpl<32, false, true > MemoryBitStream32BEMSB;
+/** 32-bit big-endian data in memory, LSB to MSB. */
+typedef MemoryBitStreamImpl<32, false, false> MemoryBitStream32BELSB;
+
+/** 64-bit little-endian data in memory, MSB to LSB. */
+typedef MemoryBitStreamImpl<64, true , true > MemoryBitStream64LEMSB;
+/** 64-bit little-endian data in memory, LSB to MSB. */
+typedef MemoryBitStreamImpl<64, true , false> MemoryBitStream64LELSB;
+/** 64-bit big-endian data in memory, MSB to LSB. */
+typedef MemoryBitStreamImpl<64, false, true > MemoryBitStream64BEMSB;
+/** 64-bit big-endian data in memory, LSB to MSB. */
+typedef MemoryBitStreamImpl<64, false, false> MemoryBitStream64BELSB;
+
 } // End of namespace Common
 
 #endif // COMMON_BITSTREAM_H
@@ -25,10 +25,14 @@
 #include <cassert>
 
 #include <memory>
+#include <list>
+#include <mutex>
 
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/md5.h"
+#include "src/common/threadpool.h"
 #include "src/common/blowfish.h"
 
 namespace Common {
@@ -73,16 +77,16 @@ static const size_t kMaxKeyLength = 56;
 static const size_t kRoundCount   = 16;
 static const size_t kBlockSize    =  8;
 
-struct BlowfishContext {
+struct BlowfishState {
 	uint32_t P[kRoundCount + 2]; ///< Blowfish round keys.
 	uint32_t S[4][256];          ///< Key-dependant S-boxes.
 
-	BlowfishContext() {
+	BlowfishState() {
 		std::memset(P, 0, sizeof(P));
 		std::memset(S, 0, sizeof(S));
 	}
 
-	~BlowfishContext() {
+	~BlowfishState() {
 		/* We don't care about security here, so we do *not* zeroize the buffers.
 		 * Residuals of the encryption/decryption *will* be left in memory!
 		 *
@@ -233,7 +237,7 @@ static const uint32_t S[4][256] = {
 	}
 };
 
-static uint32_t F(const BlowfishContext &ctx, uint32_t x) {
+static uint32_t F(const BlowfishState &ctx, uint32_t x) {
 	const uint16_t d = (uint16_t)(x & 0xFF);
 	x >>= 8;
 	const uint16_t c = (uint16_t)(x & 0xFF);
@@ -245,7 +249,7 @@ static uint32_t F(const BlowfishContext &ctx, uint32_t x) {
 	return ((ctx.S[0][a] + ctx.S[1][b]) ^ ctx.S[2][c]) + ctx.S[3][d];
 }
 
-static void blowfishEnc(BlowfishContext &ctx, uint32_t &xl, uint32_t &xr) {
+static void blowfishEnc(const BlowfishState &ctx, uint32_t &xl, uint32_t &xr) {
 	for (size_t i = 0; i < kRoundCount; i++) {
 		xl = xl ^ ctx.P[i];
 		xr = F(ctx, xl) ^ xr;
@@ -259,7 +263,7 @@ static void blowfishEnc(BlowfishContext &ctx, uint32_t &xl, uint32_t &xr) {
 	xl = xl ^ ctx.P[kRoundCount + 1];
 }
 
-static void blowfishDec(BlowfishContext &ctx, uint32_t &xl, uint32_t &xr) {
+static void blowfishDec(const BlowfishState &ctx, uint32_t &xl, uint32_t &xr) {
 	for (size_t i = kRoundCount + 1; i > 1; i--) {
 		xl = xl ^ ctx.P[i];
 		xr = F(ctx, xl) ^ xr;
@@ -273,7 +277,7 @@ static void blowfishDec(BlowfishContext &ctx, uint32_t &xl, uint32_t &xr) {
 	xl = xl ^ ctx.P[0];
 }
 
-static void blowfishSetKey(BlowfishContext &ctx, const byte *key, size_t keyLength) {
+static void blowfishSetKey(BlowfishState &ctx, const byte *key, size_t keyLength) {
 	if ((keyLength < kMinKeyLength) || (keyLength > kMaxKeyLength))
 		throw Exception("Invalid Blowfish key length %u", (uint) keyLength);
 
@@ -315,7 +319,7 @@ static void blowfishSetKey(BlowfishContext &ctx, const byte *key, size_t keyLeng
 	}
 }
 
-static void blowfishECB(BlowfishContext &ctx, Mode mode, const byte *input, byte *output) {
+static void blowfishECB(const BlowfishState &ctx, Mode mode, const byte *input, byte *output) {
 	uint32_t X0 = READ_BE_UINT32(input);
 	uint32_t X1 = READ_BE_UINT32(input + 4);
 
@@ -336,34 +340,119 @@ static void blowfishECB(BlowfishContext &ctx, Mode mode, const byte *input, byte
 }
 // '--- Blowfish, based on the implementation from mbed TLS ---'
 
-MemoryReadStream *blowfishEBC(SeekableReadStream &input, const std::vector<byte> &key, Mode mode) {
-	BlowfishContext ctx;
+/** Buffers of at least this size are split across the threads of a pool. */
+static const size_t kParallelSize  = 256 * 1024;
+/** The size of the pieces a buffer is split into for the threads of a pool. */
+static const size_t kParallelChunk =  64 * 1024;
 
-	blowfishSetKey(ctx, &key[0], key.size());
+/** The number of expanded keys kept around in the context cache. */
+static const size_t kContextCacheSize = 8;
 
-	size_t inputSize = input.size() - input.pos();
+BlowfishContext::BlowfishContext(const std::vector<byte> &key) : _state(std::make_unique<BlowfishState>()) {
+	if (key.empty())
+		throw Exception("Invalid Blowfish key length 0");
+
+	blowfishSetKey(*_state, &key[0], key.size());
+}
+
+BlowfishContext::~BlowfishContext() {
+}
+
+void BlowfishContext::encryptECB(byte *data, size_t size, ThreadPool *pool) const {
+	processECB(data, size, true, pool);
+}
+
+void BlowfishContext::decryptECB(byte *data, size_t size, ThreadPool *pool) const {
+	processECB(data, size, false, pool);
+}
+
+void BlowfishContext::processECB(byte *data, size_t size, bool encrypt, ThreadPool *pool) const {
+	if ((size % kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) size);
+
+	const Mode mode = encrypt ? kModeEncrypt : kModeDecrypt;
+	const BlowfishState &state = *_state;
+
+	if (!pool || (size < kParallelSize)) {
+		for (byte *end = data + size; data < end; data += kBlockSize)
+			blowfishECB(state, mode, data, data);
+
+		return;
+	}
+
+	// ECB blocks are independent of each other, so we can process several chunks at once
+
+	const size_t chunkCount = (size + kParallelChunk - 1) / kParallelChunk;
+
+	pool->parallelFor(0, chunkCount, [&](size_t i) {
+		byte *chunk = data + i * kParallelChunk;
+		byte *end   = chunk + MIN(kParallelChunk, size - i * kParallelChunk);
+
+		for (; chunk < end; chunk += kBlockSize)
+			blowfishECB(state, mode, chunk, chunk);
+	}, CancelToken(), 1);
+}
+
+std::shared_ptr<const BlowfishContext> BlowfishContext::getContext(const std::vector<byte> &key) {
+	struct CachedContext {
+		std::vector<byte> digest;
+		std::shared_ptr<const BlowfishContext> context;
+	};
+
+	static std::mutex cacheMutex;
+	static std::list<CachedContext> cache;
+
+	std::vector<byte> digest;
+	hashMD5(key, digest);
+
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		for (std::list<CachedContext>::iterator c = cache.begin(); c != cache.end(); ++c) {
+			if (c->digest != digest)
+				continue;
+
+			// Move the most recently used context to the front
+			cache.splice(cache.begin(), cache, c);
+
+			return c->context;
+		}
+	}
+
+	// Expand the key outside the lock, so we don't block other threads
+	std::shared_ptr<const BlowfishContext> context = std::make_shared<const BlowfishContext>(key);
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	cache.push_front(CachedContext { digest, context });
+	if (cache.size() > kContextCacheSize)
+		cache.pop_back();
+
+	return context;
+}
+
+static MemoryReadStream *blowfishEBC(SeekableReadStream &input, const std::vector<byte> &key, Mode mode) {
+	std::shared_ptr<const BlowfishContext> context = BlowfishContext::getContext(key);
+
+	const size_t inputSize = input.size() - input.pos();
 
 	// Round up to the next multiple of the block size
 	const size_t outputSize = ((inputSize + kBlockSize - 1) / kBlockSize) * kBlockSize;
 
 	std::unique_ptr<byte[]> output = std::make_unique<byte[]>(outputSize);
 
-	byte buffer[kBlockSize];
-	byte *data = output.get();
-	while (inputSize > 0) {
-		const size_t toRead = MIN<size_t>(inputSize, kBlockSize);
+	// Read everything in one go, and en/decrypt in place
+	if (input.read(output.get(), inputSize) != inputSize)
+		throw Exception(kReadError);
 
-		if (input.read(buffer, toRead) != toRead)
-			throw Exception(kReadError);
+	std::memset(output.get() + inputSize, 0, outputSize - inputSize);
 
-		if (toRead < kBlockSize)
-			std::memset(buffer + toRead, 0, kBlockSize - toRead);
+	ThreadPool *pool = (outputSize >= kParallelSize) ? &ThreadPoolMan.getPool() : 0;
 
-		blowfishECB(ctx, mode, buffer, data);
-
-		data      += toRead;
-		inputSize -= toRead;
-	}
+	if (mode == kModeEncrypt)
+		context->encryptECB(output.get(), outputSize, pool);
+	else
+		context->decryptECB(output.get(), outputSize, pool);
 
 	return new MemoryReadStream(output.release(), outputSize, true);
 }
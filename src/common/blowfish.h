@@ -26,6 +26,9 @@
 #define COMMON_BLOWFISH_H
 
 #include <vector>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
 
@@ -33,6 +36,57 @@ namespace Common {
 
 class SeekableReadStream;
 class MemoryReadStream;
+class ThreadPool;
+
+struct BlowfishState;
+
+/** A Blowfish cipher with an expanded key, operating in ECB mode.
+ *
+ *  Expanding a key into the Blowfish round keys and S-boxes is expensive:
+ *  it takes 521 block encryptions. Since archives usually encrypt all their
+ *  resources with the same key, getContext() keeps a small cache of expanded
+ *  keys, indexed by the MD5 digest of the key.
+ *
+ *  A BlowfishContext is immutable once created, and can be used by several
+ *  threads at the same time.
+ */
+class BlowfishContext : boost::noncopyable {
+public:
+	static const size_t kBlockSize = 8;
+
+	/** Expand this key. */
+	BlowfishContext(const std::vector<byte> &key);
+	~BlowfishContext();
+
+	/** Encrypt a buffer in place.
+	 *
+	 *  Since ECB blocks are independent, large buffers can be split across
+	 *  the threads of a thread pool.
+	 *
+	 *  @param data The data to encrypt. Its size has to be a multiple of kBlockSize.
+	 *  @param size The size of the data in bytes.
+	 *  @param pool If not 0, encrypt large buffers on the threads of this pool.
+	 */
+	void encryptECB(byte *data, size_t size, ThreadPool *pool = 0) const;
+	/** Decrypt a buffer in place.
+	 *
+	 *  Since ECB blocks are independent, large buffers can be split across
+	 *  the threads of a thread pool.
+	 *
+	 *  @param data The data to decrypt. Its size has to be a multiple of kBlockSize.
+	 *  @param size The size of the data in bytes.
+	 *  @param pool If not 0, decrypt large buffers on the threads of this pool.
+	 */
+	void decryptECB(byte *data, size_t size, ThreadPool *pool = 0) const;
+
+	/** Return the context for this key, from the cache if possible. */
+	static std::shared_ptr<const BlowfishContext> getContext(const std::vector<byte> &key);
+
+private:
+	std::unique_ptr<BlowfishState> _state;
+
+	void processECB(byte *data, size_t size, bool encrypt, ThreadPool *pool) const;
+};
 
 /** Encrypt the stream with the Blowfish algorithm in EBC mode. */
 MemoryReadStream *encryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key);
@@ -0,0 +1,176 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A stream that decrypts Blowfish ECB encrypted data on demand.
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include "src/common/blowfishreadstream.h"
+#include "src/common/blowfish.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+namespace Common {
+
+/** Size of the pages of decrypted data we cache. */
+static const size_t kPageSize  = 4096;
+/** Number of pages we cache. */
+static const size_t kPageCount = 8;
+
+BlowfishReadStream::Page::Page() : offset(SIZE_MAX), size(0), lastUse(0) {
+}
+
+BlowfishReadStream::BlowfishReadStream(SeekableReadStream *input, const std::vector<byte> &key,
+                                       bool disposeInput) :
+	_input(input, disposeInput), _size(input ? input->size() : 0), _pos(0), _eos(false), _useCounter(0) {
+
+	assert(input);
+
+	if ((_size % BlowfishContext::kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) _size);
+
+	_context = BlowfishContext::getContext(key);
+
+	_pages.resize(kPageCount);
+}
+
+BlowfishReadStream::~BlowfishReadStream() {
+}
+
+bool BlowfishReadStream::eos() const {
+	return _eos;
+}
+
+size_t BlowfishReadStream::pos() const {
+	return _pos;
+}
+
+size_t BlowfishReadStream::size() const {
+	return _size;
+}
+
+size_t BlowfishReadStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t BlowfishReadStream::read(void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	if (dataSize > (_size - _pos)) {
+		dataSize = _size - _pos;
+		_eos     = true;
+	}
+
+	const size_t readSize = readAt(_pos, dataPtr, dataSize);
+
+	_pos += readSize;
+
+	return readSize;
+}
+
+size_t BlowfishReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	if (offset >= _size)
+		return 0;
+
+	dataSize = MIN(dataSize, _size - offset);
+
+	byte *data = static_cast<byte *>(dataPtr);
+
+	size_t readSize = 0;
+	while (readSize < dataSize) {
+		const size_t position  = offset + readSize;
+		const size_t remaining = dataSize - readSize;
+
+		// Big block-aligned reads are decrypted straight into the caller's buffer
+		if (((position % BlowfishContext::kBlockSize) == 0) && (remaining >= kPageSize)) {
+			const size_t directSize = remaining - (remaining % BlowfishContext::kBlockSize);
+
+			if (_input->readAt(position, data + readSize, directSize) != directSize)
+				throw Exception(kReadError);
+
+			_context->decryptECB(data + readSize, directSize);
+
+			readSize += directSize;
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		const Page &page = getPage(position / kPageSize);
+
+		const size_t pageOffset = position - page.offset;
+		const size_t copySize   = MIN(remaining, page.size - pageOffset);
+
+		std::memcpy(data + readSize, page.data.get() + pageOffset, copySize);
+
+		readSize += copySize;
+	}
+
+	return readSize;
+}
+
+const BlowfishReadStream::Page &BlowfishReadStream::getPage(size_t index) {
+	const size_t offset = index * kPageSize;
+
+	// Look for the page in the cache, and for the least recently used page while we're at it
+	Page *oldest = &_pages.front();
+	for (std::vector<Page>::iterator p = _pages.begin(); p != _pages.end(); ++p) {
+		if (p->offset == offset) {
+			p->lastUse = ++_useCounter;
+			return *p;
+		}
+
+		if (p->lastUse < oldest->lastUse)
+			oldest = &*p;
+	}
+
+	Page &page = *oldest;
+
+	if (!page.data)
+		page.data = std::make_unique<byte[]>(kPageSize);
+
+	page.offset = SIZE_MAX;
+	page.size   = MIN(kPageSize, _size - offset);
+
+	if (_input->readAt(offset, page.data.get(), page.size) != page.size)
+		throw Exception(kReadError);
+
+	_context->decryptECB(page.data.get(), page.size);
+
+	page.offset  = offset;
+	page.lastUse = ++_useCounter;
+
+	return page;
+}
+
+} // End of namespace Common
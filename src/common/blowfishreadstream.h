@@ -0,0 +1,108 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A stream that decrypts Blowfish ECB encrypted data on demand.
+ */
+
+#ifndef COMMON_BLOWFISHREADSTREAM_H
+#define COMMON_BLOWFISHREADSTREAM_H
+
+#include <cstddef>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/readstream.h"
+#include "src/common/disposableptr.h"
+
+namespace Common {
+
+class BlowfishContext;
+
+/** A stream of Blowfish ECB encrypted data, decrypted on demand.
+ *
+ *  Instead of decrypting everything up front, only the 8-byte blocks that
+ *  are actually read are decrypted. Small reads go through a small cache
+ *  of decrypted pages, while large reads are decrypted directly into the
+ *  caller's buffer.
+ *
+ *  The encrypted data is read from the input stream with readAt(), and
+ *  reads through readAt() are thread-safe.
+ */
+class BlowfishReadStream : boost::noncopyable, public SeekableReadStream {
+public:
+	/** Create an on-demand decrypting stream.
+	 *
+	 *  @param input        The encrypted input data. Its size has to be a
+	 *                      multiple of the Blowfish block size.
+	 *  @param key          The key to decrypt with.
+	 *  @param disposeInput Should the input stream be deleted together with this stream?
+	 */
+	BlowfishReadStream(SeekableReadStream *input, const std::vector<byte> &key, bool disposeInput = true);
+	~BlowfishReadStream();
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+private:
+	/** A page of decrypted data. */
+	struct Page {
+		size_t offset;   ///< Offset of the page within the stream, SIZE_MAX if unused.
+		size_t size;     ///< Size of the page's data.
+		uint64_t lastUse;
+
+		std::unique_ptr<byte[]> data;
+
+		Page();
+	};
+
+	DisposablePtr<SeekableReadStream> _input;
+
+	std::shared_ptr<const BlowfishContext> _context;
+
+	const size_t _size;
+
+	size_t _pos;
+	bool _eos;
+
+	std::mutex _mutex; ///< Protects the page cache.
+
+	std::vector<Page> _pages;
+	uint64_t _useCounter;
+
+	/** Return the cached page with this index, decrypting it if necessary. */
+	const Page &getPage(size_t index);
+};
+
+} // End of namespace Common
+
+#endif // COMMON_BLOWFISHREADSTREAM_H
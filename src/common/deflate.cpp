@@ -23,6 +23,7 @@
  */
 
 #include <cstddef>
+#include <cstring>
 
 #include <vector>
 #include <memory>
@@ -90,30 +91,7 @@ byte *decompressDeflate(const byte *data, size_t inputSize,
 
 	std::unique_ptr<byte[]> decompressedData = std::make_unique<byte[]>(outputSize);
 
-	z_stream strm;
-	BOOST_SCOPE_EXIT( (&strm) ) {
-			inflateEnd(&strm);
-	} BOOST_SCOPE_EXIT_END
-
-	initInflateZStream(strm, windowBits, inputSize, data);
-
-	// Set the output data pointer and size
-	strm.avail_out = outputSize;
-	strm.next_out  = decompressedData.get();
-
-	// Decompress. Z_FINISH, because we want to decompress the whole thing in one go.
-	int zResult = inflate(&strm, Z_FINISH);
-
-	// Was the end of the input stream correctly reached?
-	if ((zResult != Z_STREAM_END) || (strm.avail_out != 0)) {
-		if (zResult == Z_OK)
-			throw Exception("Failed to inflate: premature end of output buffer");
-
-		if (strm.avail_out != 0)
-			throw Exception("Failed to inflate: output buffer not completely filled");
-
-		throw Exception("Failed to inflate: %s (%d)", zError(zResult), zResult);
-	}
+	InflateContext::getThreadContext().decompress(data, inputSize, decompressedData.get(), outputSize, windowBits);
 
 	return decompressedData.release();
 }
@@ -182,6 +160,86 @@ SeekableReadStream *decompressDeflateWithoutOutputSize(ReadStream &input, size_t
 	return new MemoryReadStream(decompressedData, size, true);
 }
 
+/** The zlib stream of an InflateContext. */
+struct InflateContext::ZStream {
+	z_stream strm;
+
+	int windowBits;
+	bool initialized;
+
+	ZStream() : windowBits(0), initialized(false) {
+		std::memset(&strm, 0, sizeof(strm));
+	}
+};
+
+InflateContext::InflateContext() : _zStream(std::make_unique<ZStream>()) {
+}
+
+InflateContext::~InflateContext() {
+	if (_zStream->initialized)
+		inflateEnd(&_zStream->strm);
+}
+
+InflateContext &InflateContext::getThreadContext() {
+	static thread_local InflateContext context;
+
+	return context;
+}
+
+void InflateContext::reset(int windowBits) {
+	z_stream &strm = _zStream->strm;
+
+	if (!_zStream->initialized) {
+		initInflateZStream(strm, windowBits, 0, 0);
+
+		_zStream->windowBits  = windowBits;
+		_zStream->initialized = true;
+
+		return;
+	}
+
+	/* inflateReset() keeps the allocated state and the history window around.
+	 * inflateReset2() additionally reallocates the window if the size changed. */
+
+	const int zResult = (windowBits == _zStream->windowBits) ? inflateReset(&strm) : inflateReset2(&strm, windowBits);
+	if (zResult != Z_OK) {
+		inflateEnd(&strm);
+		_zStream->initialized = false;
+
+		throw Exception("Could not reset zlib inflate: %s (%d)", zError(zResult), zResult);
+	}
+
+	_zStream->windowBits = windowBits;
+}
+
+void InflateContext::decompress(const byte *data, size_t inputSize, byte *output, size_t outputSize,
+                                int windowBits) {
+
+	reset(windowBits);
+
+	z_stream &strm = _zStream->strm;
+
+	setZStreamInput(strm, inputSize, data);
+
+	// Set the output data pointer and size
+	strm.avail_out = outputSize;
+	strm.next_out  = output;
+
+	// Decompress. Z_FINISH, because we want to decompress the whole thing in one go.
+	int zResult = inflate(&strm, Z_FINISH);
+
+	// Was the end of the input stream correctly reached?
+	if ((zResult != Z_STREAM_END) || (strm.avail_out != 0)) {
+		if (zResult == Z_OK)
+			throw Exception("Failed to inflate: premature end of output buffer");
+
+		if (strm.avail_out != 0)
+			throw Exception("Failed to inflate: output buffer not completely filled");
+
+		throw Exception("Failed to inflate: %s (%d)", zError(zResult), zResult);
+	}
+}
+
 size_t decompressDeflateChunk(SeekableReadStream &input, int windowBits,
                               byte *output, size_t outputSize, unsigned int frameSize) {
 
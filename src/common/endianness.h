@@ -336,7 +336,7 @@ static inline uint16_t SWAP_BYTES_16(const uint16_t a) {
 			const uint8_t *b = static_cast<const uint8_t *>(ptr);
 			return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | ((uint32_t)b[3]);
 		}
-		static inline uint32_t READ_BE_UINT64(const void *ptr) {
+		static inline uint64_t READ_BE_UINT64(const void *ptr) {
 			const uint8_t *b = static_cast<const uint8_t *>(ptr);
 			return ((uint64_t)b[0] << 56) | ((uint64_t)b[1] << 48) | ((uint64_t)b[2] << 40) | ((uint64_t)b[3] << 32) |
 			       ((uint64_t)b[4] << 24) | ((uint64_t)b[5] << 16) | ((uint64_t)b[6] <<  8) | ((uint64_t)b[7]);
@@ -41,6 +41,7 @@ using boost::filesystem::exists;
 using boost::filesystem::is_regular_file;
 using boost::filesystem::is_directory;
 using boost::filesystem::file_size;
+using boost::filesystem::last_write_time;
 using boost::filesystem::directory_iterator;
 using boost::filesystem::create_directories;
 
@@ -79,6 +80,19 @@ size_t FilePath::getFileSize(const UString &p) {
 	return size;
 }
 
+std::time_t FilePath::getModificationTime(const UString &p) {
+	if (!isRegularFile(p))
+		return -1;
+
+	boost::system::error_code error;
+
+	const std::time_t time = last_write_time(p.c_str(), error);
+	if (error)
+		return -1;
+
+	return time;
+}
+
 UString FilePath::getFile(const UString &p) {
 	path file(p.c_str());
 
@@ -349,6 +363,30 @@ bool FilePath::createDirectories(const UString &path) {
 	}
 }
 
+void FilePath::renameFile(const UString &from, const UString &to) {
+	try {
+		boost::filesystem::rename(from.c_str(), to.c_str());
+	} catch (std::exception &se) {
+		throw Exception(se);
+	}
+}
+
+bool FilePath::removeFile(const UString &p) {
+	try {
+		return boost::filesystem::remove(p.c_str());
+	} catch (std::exception &se) {
+		throw Exception(se);
+	}
+}
+
+UString FilePath::getUniquePath(const UString &model) {
+	try {
+		return boost::filesystem::unique_path(model.c_str()).string();
+	} catch (std::exception &se) {
+		throw Exception(se);
+	}
+}
+
 UString FilePath::escapeStringLiteral(const UString &str) {
 	const std::regex esc("[\\^\\.\\$\\|\\(\\)\\[\\]\\*\\+\\?\\/\\\\]");
 	const std::string rep("\\$&");
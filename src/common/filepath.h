@@ -26,6 +26,7 @@
 #define COMMON_FILEPATH_H
 
 #include <list>
+#include <ctime>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
@@ -58,6 +59,14 @@ public:
 	 */
 	static size_t getFileSize(const UString &p);
 
+	/** Return the time a file was last modified.
+	 *
+	 *  @param  p The file to look up.
+	 *  @return The modification time of the file, in seconds since the epoch,
+	 *          or -1 if not a valid file.
+	 */
+	static std::time_t getModificationTime(const UString &p);
+
 	/** Return a file name without its path.
 	 *
 	 *  Example: "/path/to/file.ext" > "file.ext"
@@ -201,6 +210,24 @@ public:
 	 */
 	static bool createDirectories(const UString &path);
 
+	/** Rename a file, replacing the file at the new path if it exists.
+	 *
+	 *  Within the same file system, the file at the new path is replaced atomically.
+	 */
+	static void renameFile(const UString &from, const UString &to);
+
+	/** Remove a file.
+	 *
+	 *  @return true if the file existed.
+	 */
+	static bool removeFile(const UString &p);
+
+	/** Return a path that doesn't exist yet.
+	 *
+	 *  Every '%' in the model is replaced by a random hexadecimal digit.
+	 */
+	static UString getUniquePath(const UString &model);
+
 	/** Escape a string literal for use in a regexp. */
 	static UString escapeStringLiteral(const UString &str);
 
@@ -22,33 +22,57 @@
  *  A tree structure of files in directories.
  */
 
+#include <algorithm>
+#include <vector>
+
 #include "src/common/filetree.h"
 #include "src/common/filepath.h"
 #include "src/common/error.h"
+#include "src/common/threadpool.h"
 
 namespace Common {
 
-FileTree::Entry::Entry() {
+FileTree::Entry::Entry() : type(boost::filesystem::status_unknown), size(kFileInvalid) {
+}
+
+static boost::filesystem::file_status getStatus(const boost::filesystem::path &p) {
+	boost::system::error_code error;
+
+	return boost::filesystem::status(p, error);
+}
+
+FileTree::Entry::Entry(const boost::filesystem::path &p) : Entry(p, getStatus(p)) {
 }
 
-FileTree::Entry::Entry(const boost::filesystem::path &p) : name(p.filename().generic_string()), path(p) {
+FileTree::Entry::Entry(const boost::filesystem::path &p, const boost::filesystem::file_status &status) :
+	name(p.filename().generic_string()), path(p), type(status.type()), size(kFileInvalid) {
+
+	if (type == boost::filesystem::regular_file) {
+		boost::system::error_code error;
+
+		const uintmax_t fileSize = boost::filesystem::file_size(path, error);
+		if (!error)
+			size = fileSize;
+	}
 }
 
 bool FileTree::Entry::isDirectory() const {
-	return boost::filesystem::is_directory(path);
+	return type == boost::filesystem::directory_file;
+}
+
+bool FileTree::Entry::isRegularFile() const {
+	return type == boost::filesystem::regular_file;
 }
 
 
-FileTree::FileTree() {
+FileTree::FileTree() : _recurseDepth(0) {
 }
 
 FileTree::~FileTree() {
 }
 
 void FileTree::clear() {
-	_root.name.clear();
-	_root.path.clear();
-	_root.children.clear();
+	_root = Entry();
 }
 
 bool FileTree::isEmpty() const {
@@ -72,29 +96,122 @@ void FileTree::readPath(boost::filesystem::path path, int recurseDepth) {
 
 	path = FilePath::normalize(path.generic_string().c_str()).c_str();
 
-	_root.name = path.filename().generic_string();
-	_root.path = path;
+	_root = Entry(path);
+
+	_recurseDepth = recurseDepth;
 
 	// If we can't or shouldn't recurse, we're done
-	if (boost::filesystem::is_regular_file(path) || (recurseDepth == 0))
+	if (_root.isRegularFile() || (recurseDepth == 0))
 		return;
 
 	addPath(_root, path, (recurseDepth == -1) ? -1 : (recurseDepth - 1));
 }
 
+const FileTree::Entry *FileTree::findEntry(const boost::filesystem::path &path) const {
+	int depth;
+	return const_cast<FileTree *>(this)->findEntry(path, depth);
+}
+
+FileTree::Entry *FileTree::findEntry(const boost::filesystem::path &path, int &depth) {
+	if (isEmpty())
+		return nullptr;
+
+	// The path needs to be below our root
+	boost::filesystem::path::const_iterator p = path.begin();
+	for (boost::filesystem::path::const_iterator r = _root.path.begin(); r != _root.path.end(); ++r, ++p)
+		if ((p == path.end()) || (*p != *r))
+			return nullptr;
+
+	// Walk down the tree, one path element at a time
+	Entry *entry = &_root;
+	for (depth = 0; p != path.end(); ++p, depth++) {
+		const UString name = p->generic_string();
+
+		auto child = std::find_if(entry->children.begin(), entry->children.end(), [&name](const Entry &e) {
+			return e.name == name;
+		});
+
+		if (child == entry->children.end())
+			return nullptr;
+
+		entry = &*child;
+	}
+
+	return entry;
+}
+
+const FileTree::Entry *FileTree::updatePath(const boost::filesystem::path &path) {
+	int depth;
+	Entry *parent = findEntry(path.parent_path(), depth);
+	if (!parent || !parent->isDirectory())
+		return nullptr;
+
+	// Were the contents of the parent directory read at all?
+	if ((_recurseDepth != -1) && (depth >= _recurseDepth))
+		return nullptr;
+
+	Entry entry(path);
+	if ((entry.type == boost::filesystem::status_error) || (entry.type == boost::filesystem::file_not_found)) {
+		removePath(path);
+		return nullptr;
+	}
+
+	// Read the contents of a directory, as deep as the rest of the tree
+	if (entry.isDirectory() && ((_recurseDepth == -1) || ((depth + 1) < _recurseDepth)))
+		addPath(entry, path, (_recurseDepth == -1) ? -1 : (_recurseDepth - depth - 2));
+
+	auto child = std::find_if(parent->children.begin(), parent->children.end(), [&entry](const Entry &e) {
+		return e.name == entry.name;
+	});
+
+	if (child != parent->children.end()) {
+		*child = std::move(entry);
+		return &*child;
+	}
+
+	parent->children.push_back(std::move(entry));
+	return &parent->children.back();
+}
+
+bool FileTree::removePath(const boost::filesystem::path &path) {
+	int depth;
+	Entry *parent = findEntry(path.parent_path(), depth);
+	if (!parent)
+		return false;
+
+	const UString name = path.filename().generic_string();
+
+	auto child = std::find_if(parent->children.begin(), parent->children.end(), [&name](const Entry &e) {
+		return e.name == name;
+	});
+
+	if (child == parent->children.end())
+		return false;
+
+	parent->children.erase(child);
+	return true;
+}
+
 void FileTree::addPath(Entry &entry, const boost::filesystem::path &path, int recurseDepth) {
 	try {
-		// Iterator over the directory's contents
+		/* Iterator over the directory's contents. The status of each directory
+		 * entry usually comes straight from the directory listing, so we only
+		 * need an extra syscall to find the size of regular files.
+		 *
+		 * Entries we can't find the status of, like dangling symlinks or files
+		 * we're not allowed to look at, are skipped. */
 		boost::filesystem::directory_iterator itEnd;
 		for (boost::filesystem::directory_iterator itDir(path); itDir != itEnd; ++itDir) {
-			// Add the file/directory to the entry's children
-			entry.children.push_back(Entry(itDir->path()));
+			boost::system::error_code error;
+
+			const boost::filesystem::file_status status = itDir->status(error);
+			if ((status.type() == boost::filesystem::status_error) ||
+			    (status.type() == boost::filesystem::file_not_found))
+				continue;
 
-			// Recurse into directory until the depth limit is reached
-			if (is_directory(itDir->status()))
-				if (recurseDepth != 0)
-					addPath(entry.children.back(), itDir->path(), (recurseDepth == -1) ? -1 : (recurseDepth - 1));
+			entry.children.emplace_back(itDir->path(), status);
 		}
+
 	} catch (Exception &e) {
 		e.add("Failed to read path \"%s\"", path.generic_string().c_str());
 
@@ -105,6 +222,22 @@ void FileTree::addPath(Entry &entry, const boost::filesystem::path &path, int re
 		se.add("Failed to read path \"%s\"", path.generic_string().c_str());
 		throw se;
 	}
+
+	// Recurse into directories until the depth limit is reached
+	if (recurseDepth == 0)
+		return;
+
+	std::vector<Entry *> directories;
+	for (Entry &child : entry.children)
+		if (child.isDirectory())
+			directories.push_back(&child);
+
+	const int childDepth = (recurseDepth == -1) ? -1 : (recurseDepth - 1);
+
+	// Scan the subdirectories in parallel. Their children are all stored in their own entries
+	ThreadPoolMan.getPool().parallelFor(0, directories.size(), [this, &directories, childDepth](size_t i) {
+		addPath(*directories[i], directories[i]->path, childDepth);
+	}, CancelToken(), 1);
 }
 
 } // End of namespace Common
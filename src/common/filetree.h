@@ -43,13 +43,29 @@ public:
 		/** The full normalized path of the file or directory. */
 		boost::filesystem::path path;
 
-		/** The files and directories inside this directory entry. */
+		/** The type of the file, as found when the tree was read. */
+		boost::filesystem::file_type type;
+		/** The size of the file, or kFileInvalid if this isn't a regular file. */
+		size_t size;
+
+		/** The files and directories inside this directory entry.
+		 *
+		 *  A list, so that an entry keeps its address while its siblings
+		 *  are added or removed.
+		 */
 		std::list<Entry> children;
 
 		Entry();
+		/** Create an entry for this path, looking up its type and size.
+		 *
+		 *  If the path's status can't be read, the type is status_error.
+		 */
 		Entry(const boost::filesystem::path &p);
+		/** Create an entry for this path, with the status found when reading its directory. */
+		Entry(const boost::filesystem::path &p, const boost::filesystem::file_status &status);
 
 		bool isDirectory() const;
+		bool isRegularFile() const;
 	};
 
 	FileTree();
@@ -84,10 +100,35 @@ public:
 	 */
 	void readPath(const Common::UString &path, int recurseDepth = 0);
 
+	/** Find the entry of this path, or return nullptr if it's not in the tree. */
+	const Entry *findEntry(const boost::filesystem::path &path) const;
+
+	/** Update the tree after this path was created or changed.
+	 *
+	 *  The path is read again, a directory together with its contents.
+	 *  If the path doesn't exist anymore, it is removed from the tree.
+	 *
+	 *  @return The updated entry, or nullptr if the path isn't part of the tree.
+	 *          The entry stays valid until it's removed from the tree again.
+	 */
+	const Entry *updatePath(const boost::filesystem::path &path);
+
+	/** Update the tree after this path was removed.
+	 *
+	 *  @return true if the path was part of the tree.
+	 */
+	bool removePath(const boost::filesystem::path &path);
+
 private:
 	Entry _root;
 
+	/** The recursion depth the tree was read with. */
+	int _recurseDepth;
+
 	void addPath(Entry &entry, const boost::filesystem::path &path, int recurseDepth);
+
+	/** Find the entry of this path, together with its depth below the root. */
+	Entry *findEntry(const boost::filesystem::path &path, int &depth);
 };
 
 } // End of namespace Common
@@ -0,0 +1,269 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Watching a file tree for changes.
+ */
+
+#include <cerrno>
+
+#include "src/common/filewatcher.h"
+#include "src/common/util.h"
+
+#if defined(__linux__)
+	#include <sys/inotify.h>
+	#include <unistd.h>
+	#include <cstring>
+#endif
+
+namespace Common {
+
+FileWatcher::Change::Change(ChangeType t, const boost::filesystem::path &p) : type(t), path(p) {
+}
+
+
+#if defined(__linux__)
+
+static const uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                   IN_CLOSE_WRITE | IN_MOVE_SELF | IN_ONLYDIR;
+
+FileWatcher::FileWatcher() : _descriptor(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+	if (_descriptor == -1)
+		warning("Failed to initialize inotify: %s", strerror(errno));
+}
+
+FileWatcher::~FileWatcher() {
+	if (_descriptor != -1)
+		close(_descriptor);
+}
+
+void FileWatcher::addWatch(const boost::filesystem::path &path) {
+	const int watch = inotify_add_watch(_descriptor, path.c_str(), kWatchMask);
+	if (watch == -1) {
+		// Usually, we ran into the limit of watches. Only tell the user once, it'll most likely happen a lot
+		if (_unwatched.empty())
+			warning("Failed to watch \"%s\": %s. Checking directories that can't be watched for changes "
+			        "regularly instead", path.generic_string().c_str(), strerror(errno));
+
+		addUnwatched(path);
+		return;
+	}
+
+	// Adding the same directory again returns the same watch, possibly under a new path
+	_watches[watch] = path;
+}
+
+void FileWatcher::clear() {
+	for (const auto &w : _watches)
+		inotify_rm_watch(_descriptor, w.first);
+
+	_watches.clear();
+	_unwatched.clear();
+
+	// Throw away the events that are still pending
+	readChanges();
+}
+
+std::vector<FileWatcher::Change> FileWatcher::readChanges() {
+	std::vector<Change> changes;
+	if (_descriptor == -1)
+		return changes;
+
+	// Index of the latest change of each path, to drop repeated creations and modifications
+	std::map<boost::filesystem::path, size_t> latest;
+
+	alignas(struct inotify_event) char buffer[4096];
+
+	while (true) {
+		const ssize_t length = read(_descriptor, buffer, sizeof(buffer));
+		if ((length == -1) && (errno == EINTR))
+			continue;
+
+		if (length <= 0) {
+			if ((length == -1) && (errno != EAGAIN))
+				warning("Failed to read inotify events: %s", strerror(errno));
+
+			break;
+		}
+
+		for (ssize_t i = 0; i < length; ) {
+			const struct inotify_event &event = *reinterpret_cast<const struct inotify_event *>(buffer + i);
+			i += sizeof(struct inotify_event) + event.len;
+
+			if (event.mask & IN_Q_OVERFLOW) {
+				warning("Too many file changes at once, some were lost");
+				continue;
+			}
+
+			auto watch = _watches.find(event.wd);
+			if (watch == _watches.end())
+				continue;
+
+			// The directory itself is gone. A moved directory is reported by its parent
+			if (event.mask & (IN_IGNORED | IN_MOVE_SELF)) {
+				if (event.mask & IN_MOVE_SELF)
+					inotify_rm_watch(_descriptor, event.wd);
+
+				_watches.erase(watch);
+				continue;
+			}
+
+			if (event.len == 0)
+				continue;
+
+			ChangeType type;
+			if      (event.mask & (IN_CREATE | IN_MOVED_TO))
+				type = kChangeCreated;
+			else if (event.mask & (IN_DELETE | IN_MOVED_FROM))
+				type = kChangeDeleted;
+			else if (event.mask & IN_CLOSE_WRITE)
+				type = kChangeModified;
+			else
+				continue;
+
+			const boost::filesystem::path path = watch->second / event.name;
+
+			// Reading the path again once is enough for a series of creations and modifications
+			auto last = latest.find(path);
+			if ((last != latest.end()) && (type != kChangeDeleted) && (changes[last->second].type != kChangeDeleted))
+				continue;
+
+			latest[path] = changes.size();
+			changes.emplace_back(type, path);
+		}
+	}
+
+	return changes;
+}
+
+#else // defined(__linux__)
+
+FileWatcher::FileWatcher() : _descriptor(-1) {
+}
+
+FileWatcher::~FileWatcher() {
+}
+
+void FileWatcher::addWatch(const boost::filesystem::path &UNUSED(path)) {
+}
+
+void FileWatcher::clear() {
+	_unwatched.clear();
+}
+
+std::vector<FileWatcher::Change> FileWatcher::readChanges() {
+	return std::vector<Change>();
+}
+
+#endif // defined(__linux__)
+
+bool FileWatcher::isSupported() const {
+	return _descriptor != -1;
+}
+
+int FileWatcher::getDescriptor() const {
+	return _descriptor;
+}
+
+bool FileWatcher::needsRescan() const {
+	return !_unwatched.empty();
+}
+
+void FileWatcher::addUnwatched(const boost::filesystem::path &path) {
+	DirectoryContents &contents = _unwatched[path];
+	if (!readContents(path, contents))
+		_unwatched.erase(path);
+}
+
+bool FileWatcher::readContents(const boost::filesystem::path &path, DirectoryContents &contents) {
+	contents.clear();
+
+	boost::system::error_code error;
+	boost::filesystem::directory_iterator file(path, error), end;
+	if (error)
+		return false;
+
+	for (; file != end; file.increment(error)) {
+		if (error)
+			return false;
+
+		boost::system::error_code fileError;
+
+		std::time_t time = 0;
+		if (!boost::filesystem::is_directory(file->status(fileError)))
+			time = boost::filesystem::last_write_time(file->path(), fileError);
+
+		contents[file->path()] = fileError ? 0 : time;
+	}
+
+	return true;
+}
+
+std::vector<FileWatcher::Change> FileWatcher::rescan() {
+	std::vector<Change> changes;
+
+	for (auto dir = _unwatched.begin(); dir != _unwatched.end(); ) {
+		DirectoryContents contents;
+
+		// The directory itself is gone. That's reported by its parent
+		if (!readContents(dir->first, contents)) {
+			dir = _unwatched.erase(dir);
+			continue;
+		}
+
+		// Both lists are sorted by path, so we can walk them side by side
+		auto oldFile = dir->second.begin();
+		auto newFile = contents.begin();
+		while ((oldFile != dir->second.end()) || (newFile != contents.end())) {
+			if ((newFile == contents.end()) || ((oldFile != dir->second.end()) && (oldFile->first < newFile->first))) {
+				changes.emplace_back(kChangeDeleted, (oldFile++)->first);
+				continue;
+			}
+
+			if ((oldFile == dir->second.end()) || (newFile->first < oldFile->first)) {
+				changes.emplace_back(kChangeCreated, (newFile++)->first);
+				continue;
+			}
+
+			if (oldFile->second != newFile->second)
+				changes.emplace_back(kChangeModified, newFile->first);
+
+			++oldFile;
+			++newFile;
+		}
+
+		dir->second.swap(contents);
+		++dir;
+	}
+
+	return changes;
+}
+
+void FileWatcher::watch(const FileTree::Entry &entry) {
+	if (!isSupported() || !entry.isDirectory())
+		return;
+
+	addWatch(entry.path);
+
+	for (const FileTree::Entry &child : entry.children)
+		watch(child);
+}
+
+} // End of namespace Common
@@ -0,0 +1,121 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Watching a file tree for changes.
+ */
+
+#ifndef COMMON_FILEWATCHER_H
+#define COMMON_FILEWATCHER_H
+
+#include <ctime>
+#include <map>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/filesystem.hpp>
+
+#include "src/common/filetree.h"
+
+namespace Common {
+
+/** Watch the directories of a file tree for changes.
+ *
+ *  The watcher doesn't notify anybody on its own. Instead, it provides a
+ *  file descriptor that becomes readable when there are changes to be
+ *  collected with readChanges(), to be plugged into an event loop.
+ *
+ *  Watching is only supported on Linux, using inotify. On other systems,
+ *  the watcher never reports any changes.
+ *
+ *  Directories that can't be watched, for example because the system's
+ *  limit of inotify watches was reached, are instead compared against
+ *  how they looked before whenever rescan() is called. needsRescan()
+ *  tells if that's necessary.
+ */
+class FileWatcher : boost::noncopyable {
+public:
+	enum ChangeType {
+		kChangeCreated,  ///< A file or directory was created or moved into a watched directory.
+		kChangeDeleted,  ///< A file or directory was deleted or moved out of a watched directory.
+		kChangeModified  ///< A file was written to.
+	};
+
+	/** A change to a file or directory. */
+	struct Change {
+		ChangeType type;
+		boost::filesystem::path path;
+
+		Change(ChangeType t, const boost::filesystem::path &p);
+	};
+
+	FileWatcher();
+	~FileWatcher();
+
+	/** Can changes be watched on this system? */
+	bool isSupported() const;
+
+	/** Return the file descriptor that becomes readable on changes, or -1. */
+	int getDescriptor() const;
+
+	/** Watch this directory entry and all directories below it. */
+	void watch(const FileTree::Entry &entry);
+
+	/** Stop watching all directories. */
+	void clear();
+
+	/** Collect the changes that have happened since the last call, without blocking.
+	 *
+	 *  Repeated creations or modifications of the same path are reported only once.
+	 */
+	std::vector<Change> readChanges();
+
+	/** Are there directories we failed to watch, that need to be checked with rescan() every now and then? */
+	bool needsRescan() const;
+
+	/** Look for changes in the directories we failed to watch, since the last call. */
+	std::vector<Change> rescan();
+
+private:
+	/** The last write times of the files in a directory.
+	 *
+	 *  Subdirectories are listed with a time of 0, since they're checked
+	 *  for changes on their own.
+	 */
+	typedef std::map<boost::filesystem::path, std::time_t> DirectoryContents;
+
+	int _descriptor;
+
+	/** The watched directories, by watch descriptor. */
+	std::map<int, boost::filesystem::path> _watches;
+
+	/** The directories we failed to watch, with their contents as of the last rescan. */
+	std::map<boost::filesystem::path, DirectoryContents> _unwatched;
+
+	void addWatch(const boost::filesystem::path &path);
+	/** Fall back to rescanning a directory that can't be watched. */
+	void addUnwatched(const boost::filesystem::path &path);
+
+	static bool readContents(const boost::filesystem::path &path, DirectoryContents &contents);
+};
+
+} // End of namespace Common
+
+#endif // COMMON_FILEWATCHER_H
@@ -23,6 +23,8 @@
  */
 
 #include <cassert>
+#include <algorithm>
+#include <map>
 
 #include "src/common/huffman.h"
 #include "src/common/util.h"
@@ -31,7 +33,7 @@
 
 namespace Common {
 
-Huffman::Symbol::Symbol(uint32_t c, uint32_t s) : code(c), symbol(s) {
+Huffman::Code::Code(uint32_t c, uint8_t l, uint32_t i) : code(c), length(l), index(i) {
 }
 
 
@@ -59,38 +61,141 @@ void Huffman::init(uint8_t maxLength, size_t codeCount, const uint32_t *codes,
 
 	assert(maxLength <= 32);
 
-	_codes.resize(maxLength);
 	_symbols.resize(codeCount);
+	setSymbols(symbols);
 
-	for (size_t i = 0; i < codeCount; i++) {
-		// The symbol. If none were specified, just assume it's identical to the code index
-		uint32_t symbol = symbols ? symbols[i] : i;
+	// All codes, by length and then in their original order
+	CodeList allCodes;
+	allCodes.reserve(codeCount);
 
-		// Put the code and symbol into the correct list
-		_codes[lengths[i] - 1].push_back(Symbol(codes[i], symbol));
+	_codes.resize(maxLength);
+
+	for (size_t i = 0; i < codeCount; i++) {
+		assert((lengths[i] > 0) && (lengths[i] <= maxLength));
 
-		// And put the pointer to the symbol/code struct into the symbol list.
-		_symbols[i] = &_codes[lengths[i] - 1].back();
+		allCodes.push_back(Code(codes[i], lengths[i], i));
+		_codes[lengths[i] - 1].push_back(allCodes.back());
 	}
+
+	std::stable_sort(allCodes.begin(), allCodes.end(), [](const Code &a, const Code &b) {
+		return a.length < b.length;
+	});
+
+	for (CodeList &list : _codes)
+		std::stable_sort(list.begin(), list.end(), [](const Code &a, const Code &b) {
+			return a.code < b.code;
+		});
+
+	_tableBits = MIN(maxLength, kTableBits);
+
+	_table.resize(1 << _tableBits);
+	buildTable(0, _tableBits, 0, allCodes);
 }
 
 Huffman::~Huffman() {
 }
 
+void Huffman::buildTable(size_t offset, uint8_t tableBits, uint8_t prefixLength, const CodeList &codes) {
+	// Codes too long for this table, by the table index they start with
+	std::map<uint32_t, CodeList> longCodes;
+
+	for (const Code &code : codes) {
+		const uint8_t  length = code.length - prefixLength;
+		const uint32_t bits   = code.code & (uint32_t) ((1ULL << length) - 1);
+
+		if (length > tableBits)
+			longCodes[bits >> (length - tableBits)].push_back(code);
+	}
+
+	for (std::map<uint32_t, CodeList>::const_iterator l = longCodes.begin(); l != longCodes.end(); ++l) {
+		uint8_t maxLength = 0;
+		for (const Code &code : l->second)
+			maxLength = MAX<uint8_t>(maxLength, code.length - prefixLength - tableBits);
+
+		const uint8_t subBits   = MIN(maxLength, kSubTableBits);
+		const size_t  subOffset = _table.size();
+
+		_table.resize(subOffset + (1 << subBits));
+
+		TableEntry &entry = _table[offset + l->first];
+		entry.value   = subOffset;
+		entry.length  = tableBits;
+		entry.subBits = subBits;
+
+		buildTable(subOffset, subBits, prefixLength + tableBits, l->second);
+	}
+
+	/* Now fill in the codes that fit. We go backwards, so that for conflicting
+	 * codes, the shortest and then the first one is the one that stays. Just
+	 * like bit-wise decoding would find them. */
+	for (CodeList::const_reverse_iterator code = codes.rbegin(); code != codes.rend(); ++code) {
+		const uint8_t length = code->length - prefixLength;
+		if (length > tableBits)
+			continue;
+
+		const uint32_t bits = code->code & (uint32_t) ((1ULL << length) - 1);
+
+		// A code fills all entries starting with it
+		const size_t first = offset + (bits << (tableBits - length));
+		const size_t count = 1 << (tableBits - length);
+
+		for (size_t i = first; i < (first + count); i++) {
+			_table[i].value   = code->index;
+			_table[i].length  = length;
+			_table[i].subBits = 0;
+		}
+	}
+}
+
 void Huffman::setSymbols(const uint32_t *symbols) {
 	for (size_t i = 0; i < _symbols.size(); i++)
-		_symbols[i]->symbol = symbols ? *symbols++ : i;
+		_symbols[i] = symbols ? symbols[i] : i;
 }
 
 uint32_t Huffman::getSymbol(BitStream &bits) const {
+	if (bits.isMSBFirst())
+		return getSymbolTable(bits);
+
+	return getSymbolBitwise(bits);
+}
+
+uint32_t Huffman::getSymbolTable(BitStream &bits) const {
+	size_t  offset    = 0;
+	uint8_t tableBits = _tableBits;
+
+	while (true) {
+		const TableEntry &entry = _table[offset + bits.peekBits(tableBits)];
+
+		if (entry.subBits == 0) {
+			if (entry.length == 0)
+				break;
+
+			bits.skip(entry.length);
+			return _symbols[entry.value];
+		}
+
+		bits.skip(entry.length);
+
+		offset    = entry.value;
+		tableBits = entry.subBits;
+	}
+
+	throw Exception("Unknown Huffman code");
+}
+
+uint32_t Huffman::getSymbolBitwise(BitStream &bits) const {
 	uint32_t code = 0;
 
 	for (size_t i = 0; i < _codes.size(); i++) {
 		bits.addBit(code, i);
 
-		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
-			if (code == cCode->code)
-				return cCode->symbol;
+		CodeList::const_iterator cCode = std::lower_bound(_codes[i].begin(), _codes[i].end(), code,
+		                                                  [](const Code &c, uint32_t value) {
+			return c.code < value;
+		});
+
+		if ((cCode != _codes[i].end()) && (cCode->code == code))
+			return _symbols[cCode->index];
 	}
 
 	throw Exception("Unknown Huffman code");
@@ -28,7 +28,6 @@
 #include <cstddef>
 
 #include <vector>
-#include <list>
 
 #include "src/common/types.h"
 
@@ -45,7 +44,16 @@ struct HuffmanTable {
 	const uint32_t *symbols; ///< The symbols, 0 if identical to the codes.
 };
 
-/** Decode a Huffman'd bitstream. */
+/** Decode a Huffman'd bitstream.
+ *
+ *  For bit streams handing out their bits MSB first, codes are decoded with
+ *  a multi-level lookup table: the next few bits are peeked at, and a single
+ *  table entry gives the symbol and length of any short code. Longer codes
+ *  continue into secondary tables, one for each prefix.
+ *
+ *  For LSB-first bit streams, the code is read one bit at a time instead,
+ *  searching through the codes of each length.
+ */
 class Huffman {
 public:
 	/** Construct a Huffman decoder.
@@ -68,25 +76,58 @@ public:
 	uint32_t getSymbol(BitStream &bits) const;
 
 private:
-	struct Symbol {
+	/** The number of bits the primary lookup table is indexed with. */
+	static const uint8_t kTableBits    = 9;
+	/** The maximum number of bits a secondary lookup table is indexed with. */
+	static const uint8_t kSubTableBits = 6;
+
+	/** A code, together with the index of its symbol. */
+	struct Code {
 		uint32_t code;
-		uint32_t symbol;
+		uint8_t  length;
+		uint32_t index;
+
+		Code(uint32_t c, uint8_t l, uint32_t i);
+	};
 
-		Symbol(uint32_t c, uint32_t s);
+	/** An entry in a lookup table.
+	 *
+	 *  If subBits is 0, this entry decodes a code: value is the index of its
+	 *  symbol and length the number of bits of the code within this table.
+	 *  A length of 0 marks an invalid code.
+	 *
+	 *  Otherwise, length bits are consumed and decoding continues in the table
+	 *  starting at value, indexed with the next subBits bits.
+	 */
+	struct TableEntry {
+		uint32_t value;
+		uint8_t  length;
+		uint8_t  subBits;
 	};
 
-	typedef std::list<Symbol>     CodeList;
-	typedef std::vector<CodeList> CodeLists;
-	typedef std::vector<Symbol *> SymbolList;
+	typedef std::vector<Code>       CodeList;
+	typedef std::vector<CodeList>   CodeLists;
+	typedef std::vector<TableEntry> Table;
 
-	/** Lists of codes and their symbols, sorted by code length. */
+	/** The symbols, indexed by code index. */
+	std::vector<uint32_t> _symbols;
+
+	/** Lists of codes, by code length, sorted by code. */
 	CodeLists _codes;
 
-	/** Sorted list of pointers to the symbols. */
-	SymbolList _symbols;
+	/** All lookup tables, the primary one first. */
+	Table _table;
+	/** The number of bits the primary lookup table is indexed with. */
+	uint8_t _tableBits;
 
 	void init(uint8_t maxLength, size_t codeCount, const uint32_t *codes,
 	          const uint8_t *lengths, const uint32_t *symbols);
+
+	/** Fill a lookup table with all the codes starting with its prefix. */
+	void buildTable(size_t offset, uint8_t tableBits, uint8_t prefixLength, const CodeList &codes);
+
+	uint32_t getSymbolTable(BitStream &bits) const;
+	uint32_t getSymbolBitwise(BitStream &bits) const;
 };
 
 } // End of namespace Common
@@ -0,0 +1,242 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A stream that decompresses (inflates) DEFLATE data on demand.
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include <zlib.h>
+
+#include "src/common/inflatereadstream.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+namespace Common {
+
+/** Size of the chunks the compressed input is read in. */
+static const size_t kInputBufferSize  = 16 * 1024;
+/** Maximum size of the chunks the output is decompressed in. */
+static const size_t kOutputBufferSize = 64 * 1024;
+
+/** A zlib stream, ended automatically. */
+struct InflateReadStream::ZStream : boost::noncopyable {
+	z_stream strm;
+	bool initialized;
+
+	ZStream() : initialized(false) {
+		std::memset(&strm, 0, sizeof(strm));
+	}
+
+	~ZStream() {
+		end();
+	}
+
+	void end() {
+		if (initialized)
+			inflateEnd(&strm);
+
+		initialized = false;
+	}
+};
+
+InflateReadStream::Checkpoint::Checkpoint(size_t in, size_t out, std::unique_ptr<ZStream> s) :
+	inputPos(in), outputPos(out), state(std::move(s)) {
+
+}
+
+InflateReadStream::Checkpoint::~Checkpoint() {
+}
+
+InflateReadStream::InflateReadStream(SeekableReadStream *input, size_t outputSize, int windowBits,
+                                     bool disposeInput, size_t checkpointInterval) :
+	_input(input, disposeInput), _size(outputSize), _windowBits(windowBits),
+	_checkpointInterval(checkpointInterval), _pos(0), _eos(false), _inputPos(0), _outputPos(0),
+	_bufferSize(0), _bufferPos(0) {
+
+	assert(input);
+
+	_bufferSize = MAX<size_t>(MIN(kOutputBufferSize, _size), 1);
+
+	// Checkpoints can only be created at chunk boundaries
+	_checkpointInterval = MAX(_checkpointInterval, _bufferSize);
+	_checkpointInterval = ((_checkpointInterval + _bufferSize - 1) / _bufferSize) * _bufferSize;
+
+	_inputBuffer = std::make_unique<byte[]>(kInputBufferSize);
+	_buffer      = std::make_unique<byte[]>(_bufferSize);
+
+	_zStream = std::make_unique<ZStream>();
+
+	const int zResult = inflateInit2(&_zStream->strm, _windowBits);
+	if (zResult != Z_OK)
+		throw Exception("Could not initialize zlib inflate: %s (%d)", zError(zResult), zResult);
+
+	_zStream->initialized = true;
+}
+
+InflateReadStream::~InflateReadStream() {
+}
+
+bool InflateReadStream::eos() const {
+	return _eos;
+}
+
+size_t InflateReadStream::pos() const {
+	return _pos;
+}
+
+size_t InflateReadStream::size() const {
+	return _size;
+}
+
+size_t InflateReadStream::getCheckpointCount() const {
+	return _checkpoints.size();
+}
+
+size_t InflateReadStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	// Decompression happens lazily on the next read
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t InflateReadStream::read(void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	if (dataSize > (_size - _pos)) {
+		dataSize = _size - _pos;
+		_eos     = true;
+	}
+
+	byte *data = static_cast<byte *>(dataPtr);
+
+	size_t readSize = 0;
+	while (readSize < dataSize) {
+		if (_pos < _bufferPos)
+			restart(_pos);
+
+		while (_pos >= _outputPos)
+			inflateChunk();
+
+		const size_t chunkSize = MIN(dataSize - readSize, _outputPos - _pos);
+		std::memcpy(data + readSize, _buffer.get() + (_pos - _bufferPos), chunkSize);
+
+		readSize += chunkSize;
+		_pos     += chunkSize;
+	}
+
+	return readSize;
+}
+
+void InflateReadStream::restart(size_t position) {
+	z_stream &strm = _zStream->strm;
+
+	// Find the last checkpoint at or before the position
+	auto checkpoint = _checkpoints.rbegin();
+	while ((checkpoint != _checkpoints.rend()) && (checkpoint->outputPos > position))
+		++checkpoint;
+
+	if (checkpoint != _checkpoints.rend()) {
+		_zStream->end();
+
+		const int zResult = inflateCopy(&strm, &checkpoint->state->strm);
+		if (zResult != Z_OK)
+			throw Exception("Failed to restore inflate checkpoint: %s (%d)", zError(zResult), zResult);
+
+		_zStream->initialized = true;
+
+		_inputPos  = checkpoint->inputPos;
+		_outputPos = checkpoint->outputPos;
+
+	} else {
+		const int zResult = inflateReset(&strm);
+		if (zResult != Z_OK)
+			throw Exception("Failed to reset inflate: %s (%d)", zError(zResult), zResult);
+
+		_inputPos  = 0;
+		_outputPos = 0;
+	}
+
+	strm.next_in  = Z_NULL;
+	strm.avail_in = 0;
+
+	_bufferPos = _outputPos;
+}
+
+void InflateReadStream::inflateChunk() {
+	assert(_outputPos < _size);
+
+	z_stream &strm = _zStream->strm;
+
+	const size_t chunkSize = MIN(_bufferSize, _size - _outputPos);
+
+	strm.next_out  = _buffer.get();
+	strm.avail_out = chunkSize;
+
+	while (strm.avail_out > 0) {
+		if (strm.avail_in == 0) {
+			const size_t inputSize = _input->readAt(_inputPos, _inputBuffer.get(), kInputBufferSize);
+			if (inputSize == 0)
+				throw Exception("Failed to inflate: compressed data ends prematurely");
+
+			strm.next_in  = _inputBuffer.get();
+			strm.avail_in = inputSize;
+
+			_inputPos += inputSize;
+		}
+
+		const int zResult = inflate(&strm, Z_NO_FLUSH);
+		if (zResult == Z_STREAM_END)
+			break;
+
+		if (zResult != Z_OK)
+			throw Exception("Failed to inflate: %s (%d)", zError(zResult), zResult);
+	}
+
+	if (strm.avail_out != 0)
+		throw Exception("Failed to inflate: compressed data ends prematurely");
+
+	_bufferPos  = _outputPos;
+	_outputPos += chunkSize;
+
+	// Save a restart checkpoint, if we arrived at a new one
+	if (((_outputPos % _checkpointInterval) != 0) || (_outputPos >= _size))
+		return;
+	if (!_checkpoints.empty() && (_checkpoints.back().outputPos >= _outputPos))
+		return;
+
+	std::unique_ptr<ZStream> state = std::make_unique<ZStream>();
+	if (inflateCopy(&state->strm, &strm) != Z_OK)
+		return;
+
+	state->initialized = true;
+
+	_checkpoints.emplace_back(_inputPos - strm.avail_in, _outputPos, std::move(state));
+}
+
+} // End of namespace Common
@@ -0,0 +1,129 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A stream that decompresses (inflates) DEFLATE data on demand.
+ */
+
+#ifndef COMMON_INFLATEREADSTREAM_H
+#define COMMON_INFLATEREADSTREAM_H
+
+#include <cstddef>
+
+#include <vector>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/readstream.h"
+#include "src/common/disposableptr.h"
+
+namespace Common {
+
+/** A stream of DEFLATE compressed data, decompressed on demand.
+ *
+ *  Instead of decompressing everything up front, only the data up to the
+ *  furthest position read from so far is decompressed, chunk by chunk.
+ *  Reading only the header of a large compressed file is cheap.
+ *
+ *  Every checkpointInterval bytes of decompressed data, the state of the
+ *  decompressor is saved as a restart checkpoint. Seeking backwards resumes
+ *  decompression from the nearest checkpoint instead of the very beginning.
+ *
+ *  The compressed data is read from the input stream with readAt().
+ */
+class InflateReadStream : boost::noncopyable, public SeekableReadStream {
+public:
+	static const size_t kDefaultCheckpointInterval = 1024 * 1024;
+
+	/** Create an on-demand inflating stream.
+	 *
+	 *  @param input              The compressed input data.
+	 *  @param outputSize         The size of the decompressed data.
+	 *  @param windowBits         The base two logarithm of the window size (the size of
+	 *                            the history buffer). See the zlib documentation on
+	 *                            inflateInit2() for details.
+	 *  @param disposeInput       Should the input stream be deleted together with this stream?
+	 *  @param checkpointInterval The distance between restart checkpoints, in decompressed bytes.
+	 */
+	InflateReadStream(SeekableReadStream *input, size_t outputSize, int windowBits,
+	                  bool disposeInput = true, size_t checkpointInterval = kDefaultCheckpointInterval);
+	~InflateReadStream();
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+
+	/** Return the number of restart checkpoints created so far. */
+	size_t getCheckpointCount() const;
+
+private:
+	struct ZStream;
+
+	/** A saved decompressor state, to restart decompression from. */
+	struct Checkpoint {
+		size_t inputPos;  ///< Position in the compressed input.
+		size_t outputPos; ///< Position in the decompressed output.
+
+		std::unique_ptr<ZStream> state; ///< The state of the decompressor.
+
+		Checkpoint(size_t in, size_t out, std::unique_ptr<ZStream> s);
+		Checkpoint(Checkpoint &&) = default;
+		~Checkpoint();
+	};
+
+	DisposablePtr<SeekableReadStream> _input;
+
+	const size_t _size;
+	const int _windowBits;
+
+	size_t _checkpointInterval;
+
+	size_t _pos;
+	bool _eos;
+
+	std::unique_ptr<ZStream> _zStream;
+
+	size_t _inputPos;  ///< Position of the next compressed byte to feed the decompressor.
+	size_t _outputPos; ///< Position of the next decompressed byte the decompressor produces.
+
+	std::unique_ptr<byte[]> _inputBuffer;
+
+	/** Decompressed data of the range [_bufferPos, _outputPos). */
+	std::unique_ptr<byte[]> _buffer;
+	size_t _bufferSize;
+	size_t _bufferPos;
+
+	std::vector<Checkpoint> _checkpoints;
+
+	/** Restart decompression at the last checkpoint at or before this position. */
+	void restart(size_t position);
+	/** Decompress the next chunk into the buffer. */
+	void inflateChunk();
+};
+
+} // End of namespace Common
+
+#endif // COMMON_INFLATEREADSTREAM_H
@@ -26,10 +26,10 @@
 #include "src/common/types.h"
 #include <lzma.h>
 
+#include <algorithm>
+#include <vector>
 #include <memory>
 
-#include <boost/scope_exit.hpp>
-
 #include "src/common/lzma.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
@@ -63,58 +63,142 @@ static lzma_allocator kLZMAAllocator = {
 	&lzmaAlloc, &lzmaFree, 0
 };
 
-byte *decompressLZMA1(const byte *data, size_t inputSize, size_t outputSize) {
-	lzma_filter filters[2] = {
-		{ LZMA_FILTER_LZMA1, 0 },
-		{ LZMA_VLI_UNKNOWN , 0 }
-	};
+/** The liblzma decoder of an LZMA1Context. */
+struct LZMA1Context::Decoder {
+	lzma_stream strm;
+	lzma_filter filters[2];
+
+	/** The encoded properties the filter options were decoded from. */
+	std::vector<byte> properties;
+
+	bool initialized;
+	bool finished;
+
+	Decoder() : initialized(false), finished(false) {
+		const lzma_stream streamInit = LZMA_STREAM_INIT;
+		strm = streamInit;
+
+		filters[0].id      = LZMA_FILTER_LZMA1;
+		filters[0].options = 0;
+		filters[1].id      = LZMA_VLI_UNKNOWN;
+		filters[1].options = 0;
+	}
+
+	~Decoder() {
+		kLZMAAllocator.free(0, filters[0].options);
+		lzma_end(&strm);
+	}
+};
+
+LZMA1Context::LZMA1Context() : _decoder(std::make_unique<Decoder>()) {
+}
+
+LZMA1Context::~LZMA1Context() {
+}
+
+LZMA1Context &LZMA1Context::getThreadContext() {
+	static thread_local LZMA1Context context;
+
+	return context;
+}
+
+size_t LZMA1Context::getPropertiesSize() {
+	lzma_filter filter = { LZMA_FILTER_LZMA1, 0 };
 
-	if (!lzma_filter_decoder_is_supported(filters[0].id))
+	if (!lzma_filter_decoder_is_supported(filter.id))
 		throw Exception("LZMA1 compression not supported");
 
 	uint32_t propsSize;
-	if (lzma_properties_size(&propsSize, &filters[0]) != LZMA_OK)
+	if (lzma_properties_size(&propsSize, &filter) != LZMA_OK)
 		throw Exception("Can't get LZMA1 properties size");
 
-	if (propsSize > inputSize)
-		throw Exception("LZMA1 properties size larger than input data");
+	return propsSize;
+}
 
-	if (lzma_properties_decode(&filters[0], &kLZMAAllocator, data, propsSize) != LZMA_OK)
-		throw Exception("Failed to decode LZMA1 properties");
+void LZMA1Context::reset(const byte *properties, size_t propertiesSize) {
+	Decoder &decoder = *_decoder;
 
-	data      += propsSize;
-	inputSize -= propsSize;
+	// Only decode the properties if they changed
+	if (!decoder.filters[0].options ||
+	    !std::equal(properties, properties + propertiesSize, decoder.properties.begin(), decoder.properties.end())) {
 
-	lzma_stream strm = LZMA_STREAM_INIT;
-	BOOST_SCOPE_EXIT( (&strm) (&filters) ) {
-		kLZMAAllocator.free(0, filters[0].options);
-		lzma_end(&strm);
-	} BOOST_SCOPE_EXIT_END
+		kLZMAAllocator.free(0, decoder.filters[0].options);
+		decoder.filters[0].options = 0;
+		decoder.properties.clear();
 
-	lzma_ret lzmaRet = LZMA_OK;
+		if (lzma_properties_decode(&decoder.filters[0], &kLZMAAllocator, properties, propertiesSize) != LZMA_OK)
+			throw Exception("Failed to decode LZMA1 properties");
+
+		decoder.properties.assign(properties, properties + propertiesSize);
+	}
+
+	/* Reinitializing the decoder of an existing stream reuses the memory
+	 * allocated for the previous decoder, including the dictionary. */
+
+	decoder.initialized = false;
+	decoder.finished    = false;
 
-	if ((lzmaRet = lzma_raw_decoder(&strm, filters)) != LZMA_OK)
+	const lzma_ret lzmaRet = lzma_raw_decoder(&decoder.strm, decoder.filters);
+	if (lzmaRet != LZMA_OK)
 		throw Exception("Failed to create raw LZMA1 decoder: %d", (int) lzmaRet);
 
-	std::unique_ptr<byte[]> outputData = std::make_unique<byte[]>(outputSize);
+	decoder.initialized = true;
+}
 
-	strm.next_in   = data;
-	strm.avail_in  = inputSize;
-	strm.next_out  = outputData.get();
-	strm.avail_out = outputSize;
+size_t LZMA1Context::decompress(const byte *data, size_t inputSize, byte *output, size_t outputSize,
+                                size_t &consumed) {
 
-	lzmaRet = lzma_code(&strm, LZMA_FINISH);
+	Decoder &decoder = *_decoder;
+	if (!decoder.initialized)
+		throw Exception("LZMA1 decoder not initialized");
 
-	if ((lzmaRet != LZMA_STREAM_END) || (strm.avail_out != 0)) {
-		if (lzmaRet == LZMA_OK)
-			throw Exception("Failed to uncompress LZMA1 data: premature end of output buffer");
+	decoder.strm.next_in   = data;
+	decoder.strm.avail_in  = inputSize;
+	decoder.strm.next_out  = output;
+	decoder.strm.avail_out = outputSize;
 
-		if (strm.avail_out != 0)
-			throw Exception("Failed to uncompress LZMA1 data: output buffer not completely filled");
+	const lzma_ret lzmaRet = lzma_code(&decoder.strm, LZMA_FINISH);
+	if ((lzmaRet != LZMA_OK) && (lzmaRet != LZMA_STREAM_END)) {
+		// The decoder can't continue after an error
+		decoder.initialized = false;
 
 		throw Exception("Failed to uncompress LZMA1 data: %d", (int) lzmaRet);
 	}
 
+	decoder.finished = lzmaRet == LZMA_STREAM_END;
+
+	consumed = inputSize - decoder.strm.avail_in;
+	return outputSize - decoder.strm.avail_out;
+}
+
+bool LZMA1Context::isFinished() const {
+	return _decoder->finished;
+}
+
+byte *decompressLZMA1(const byte *data, size_t inputSize, size_t outputSize) {
+	LZMA1Context &context = LZMA1Context::getThreadContext();
+
+	const size_t propsSize = LZMA1Context::getPropertiesSize();
+	if (propsSize > inputSize)
+		throw Exception("LZMA1 properties size larger than input data");
+
+	context.reset(data, propsSize);
+
+	data      += propsSize;
+	inputSize -= propsSize;
+
+	std::unique_ptr<byte[]> outputData = std::make_unique<byte[]>(outputSize);
+
+	size_t consumed = 0;
+	const size_t written = context.decompress(data, inputSize, outputData.get(), outputSize, consumed);
+
+	if (!context.isFinished() || (written != outputSize)) {
+		if (written == outputSize)
+			throw Exception("Failed to uncompress LZMA1 data: premature end of output buffer");
+
+		throw Exception("Failed to uncompress LZMA1 data: output buffer not completely filled");
+	}
+
 	return outputData.release();
 }
 
@@ -129,32 +213,13 @@ SeekableReadStream *decompressLZMA1(ReadStream &input, size_t inputSize, size_t
 }
 
 std::unique_ptr<SeekableReadStream> decompressERFLZMA(ReadStream &input, size_t inputSize, size_t outputSize) {
-	lzma_filter filters[2] = {
-		{ LZMA_FILTER_LZMA1, 0 },
-		{ LZMA_VLI_UNKNOWN , 0 }
-	};
-
-	if (!lzma_filter_decoder_is_supported(filters[0].id))
-		throw Exception("LZMA1 compression not supported");
-
-	uint32_t propsSize;
-	if (lzma_properties_size(&propsSize, &filters[0]) != LZMA_OK)
-		throw Exception("Can't get LZMA1 properties size");
-
+	const size_t propsSize = LZMA1Context::getPropertiesSize();
 	if (propsSize > inputSize)
 		throw Exception("LZMA1 properties size larger than input data");
 
-	{
-		// Read the properties
-		std::unique_ptr<byte[]> propertyData = std::make_unique<byte[]>(propsSize);
-		input.readChecked(propertyData.get(), propsSize);
-		if (lzma_properties_decode(&filters[0], &kLZMAAllocator, propertyData.get(), propsSize) != LZMA_OK)
-			throw Exception("Failed to decode LZMA1 properties");
-	}
-
-	BOOST_SCOPE_EXIT((&filters)) {
-		kLZMAAllocator.free(0, filters[0].options);
-	} BOOST_SCOPE_EXIT_END;
+	// Read the properties
+	std::unique_ptr<byte[]> propertyData = std::make_unique<byte[]>(propsSize);
+	input.readChecked(propertyData.get(), propsSize);
 
 	// Not sure what this byte is (possibly number of pages per decode?)
 	byte unk0 = input.readByte();
@@ -175,44 +240,41 @@ std::unique_ptr<SeekableReadStream> decompressERFLZMA(ReadStream &input, size_t
 	byte *outputPtr  = outputData.get();
 	size_t remaining = outputSize;
 
+	LZMA1Context &context = LZMA1Context::getThreadContext();
+
 	// Read each of the chunks
+	std::unique_ptr<byte[]> chunkData;
+	size_t chunkDataSize = 0;
+
 	for (uint32_t chunkSize : chunkSizes) {
 		// Read the compressed chunk
-		std::unique_ptr<byte[]> chunkData = std::make_unique<byte[]>(chunkSize);
+		if (chunkSize > chunkDataSize) {
+			chunkData     = std::make_unique<byte[]>(chunkSize);
+			chunkDataSize = chunkSize;
+		}
+
 		input.readChecked(chunkData.get(), chunkSize);
 
-		// Allocate the stream
-		lzma_stream strm = LZMA_STREAM_INIT;
-		BOOST_SCOPE_EXIT((&strm)) {
-			lzma_end(&strm);
-		} BOOST_SCOPE_EXIT_END
-
-		// Create the raw decoder
-		lzma_ret lzmaRet = lzma_raw_decoder(&strm, filters);
-		if (lzmaRet)
-			throw Exception("Failed to create raw LZMA1 decoder: %d", (int)lzmaRet);
-
-		// Fill in the stream info for the chunk. Note that we clamp the decoded
-		// chunks to 0x10000 bytes because sometimes there is an excess byte
-		// leftover when decoding that doesn't belong in the decoded stream (e.g. DA2 PS3's
-		// lt_gallowstemplar_n_2384.rml).
-		strm.next_in   = chunkData.get();
-		strm.avail_in  = chunkSize;
-		strm.next_out  = outputPtr;
-		strm.avail_out = std::min<size_t>(remaining, 0x10000);
-
-		// Read until we can't read anymore
-		lzmaRet = lzma_code(&strm, LZMA_FINISH);
-		if (lzmaRet != LZMA_OK)
-			throw Exception("Failed to uncompress ERF LZMA data: %d", (int)lzmaRet);
+		// Each chunk is an independent LZMA1 stream
+		context.reset(propertyData.get(), propsSize);
+
+		// Decode the chunk. Note that we clamp the decoded chunks to 0x10000 bytes
+		// because sometimes there is an excess byte leftover when decoding that
+		// doesn't belong in the decoded stream (e.g. DA2 PS3's lt_gallowstemplar_n_2384.rml).
+		size_t consumed = 0;
+		const size_t written = context.decompress(chunkData.get(), chunkSize, outputPtr,
+		                                          std::min<size_t>(remaining, 0x10000), consumed);
+
+		if (context.isFinished())
+			throw Exception("Failed to uncompress ERF LZMA data: unexpected end of stream");
 
 		// Verify that we consumed the entire chunk
-		if (strm.avail_in != 0)
-			throw Exception("Found remaining ERF LZMA data: %u", (uint32_t)strm.avail_in);
+		if (consumed != chunkSize)
+			throw Exception("Found remaining ERF LZMA data: %u", (uint32_t)(chunkSize - consumed));
 
 		// Update our pointers
-		outputPtr += strm.total_out;
-		remaining -= strm.total_out;
+		outputPtr += written;
+		remaining -= written;
 	}
 
 	// Verify we filled up the data
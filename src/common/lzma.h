@@ -27,6 +27,8 @@
 
 #include <memory>
 
+#include <boost/noncopyable.hpp>
+
 #include "src/common/types.h"
 
 namespace Common {
@@ -70,6 +72,55 @@ SeekableReadStream *decompressLZMA1(ReadStream &input, size_t inputSize, size_t
  */
 std::unique_ptr<SeekableReadStream> decompressERFLZMA(ReadStream &input, size_t inputSize, size_t outputSize);
 
+/** A reusable LZMA1 decoder context.
+ *
+ *  Creating an LZMA decoder allocates the whole decoder state, including
+ *  the dictionary, which can be several megabytes large. For archives with
+ *  thousands of small compressed resources, that quickly dominates the time
+ *  spent decompressing. An LZMA1Context keeps its decoder around, and
+ *  liblzma reuses the allocated memory when the decoder is reinitialized.
+ *
+ *  An LZMA1Context must only be used by one thread at a time. Each thread
+ *  has its own context, available through getThreadContext().
+ */
+class LZMA1Context : boost::noncopyable {
+public:
+	LZMA1Context();
+	~LZMA1Context();
+
+	/** Return the size of the encoded LZMA1 properties, in bytes. */
+	static size_t getPropertiesSize();
+
+	/** Start decompressing a new LZMA1 stream.
+	 *
+	 *  @param properties     The encoded LZMA1 properties.
+	 *  @param propertiesSize The size of the encoded properties, in bytes.
+	 */
+	void reset(const byte *properties, size_t propertiesSize);
+
+	/** Decompress as much of the input data as fits into the output buffer.
+	 *
+	 *  @param  data       The compressed input data.
+	 *  @param  inputSize  The size of the input data in bytes.
+	 *  @param  output     The buffer to decompress into.
+	 *  @param  outputSize The size of the output buffer in bytes.
+	 *  @param  consumed   Will be set to the number of input bytes consumed.
+	 *  @return The number of bytes written into the output buffer.
+	 */
+	size_t decompress(const byte *data, size_t inputSize, byte *output, size_t outputSize, size_t &consumed);
+
+	/** Was the end of the LZMA1 stream reached in the last decompress() call? */
+	bool isFinished() const;
+
+	/** Return the LZMA1 decoder context of the calling thread. */
+	static LZMA1Context &getThreadContext();
+
+private:
+	struct Decoder;
+
+	std::unique_ptr<Decoder> _decoder;
+};
+
 } // End of namespace Common
 
 #endif // COMMON_LZMA_H
@@ -135,31 +135,73 @@ mspack_system makeMSPackSystem() {
 
 } // End of anonymous namespace
 
-std::unique_ptr<SeekableReadStream> decompressXboxLZX(ReadStream &input, size_t outputSize) {
-	std::unique_ptr<byte[]> outputBuf = std::make_unique<byte[]>(outputSize);
-	Common::MemoryWriteStream writeStream(outputBuf.get(), outputSize);
+static const int kXboxLZXWindowBits      = 17;
+static const int kXboxLZXInputBufferSize = 256 * 1024;
 
-	StreamHolder inputHolder;
-	std::memset(&inputHolder, 0, sizeof(inputHolder));
-	inputHolder.input = &input;
+/** The libmspack LZX decoder of an XboxLZXContext. */
+struct XboxLZXContext::Decoder {
+	/** The system and file handles need to stay put, since lzxd_stream points to them. */
+	mspack_system system;
 
+	StreamHolder inputHolder;
 	StreamHolder outputHolder;
-	std::memset(&outputHolder, 0, sizeof(outputHolder));
-	outputHolder.output = &writeStream;
 
-	mspack_system system = makeMSPackSystem();
+	lzxd_stream *lzxd;
 
-	lzxd_stream *lzxd = lzxd_init(&system, &inputHolder, &outputHolder, 17, 0, 256 * 1024, outputSize, 0);
-	if (!lzxd)
-		throw Exception("Failed to initialize lzxd");
+	Decoder() : system(makeMSPackSystem()), lzxd(0) {
+		std::memset(&inputHolder , 0, sizeof(inputHolder));
+		std::memset(&outputHolder, 0, sizeof(outputHolder));
+	}
 
-	BOOST_SCOPE_EXIT((lzxd)) {
+	~Decoder() {
 		lzxd_free(lzxd);
+	}
+};
+
+XboxLZXContext::XboxLZXContext() : _decoder(std::make_unique<Decoder>()) {
+}
+
+XboxLZXContext::~XboxLZXContext() {
+}
+
+XboxLZXContext &XboxLZXContext::getThreadContext() {
+	static thread_local XboxLZXContext context;
+
+	return context;
+}
+
+void XboxLZXContext::decompress(ReadStream &input, byte *output, size_t outputSize) {
+	Decoder &decoder = *_decoder;
+
+	Common::MemoryWriteStream writeStream(output, outputSize);
+
+	decoder.inputHolder.input   = &input;
+	decoder.inputHolder.rest    = 0;
+	decoder.outputHolder.output = &writeStream;
+
+	BOOST_SCOPE_EXIT((&decoder)) {
+		decoder.inputHolder.input   = 0;
+		decoder.outputHolder.output = 0;
 	} BOOST_SCOPE_EXIT_END;
 
-	int result = lzxd_decompress(lzxd, outputSize);
+	if (!decoder.lzxd) {
+		decoder.lzxd = lzxd_init(&decoder.system, &decoder.inputHolder, &decoder.outputHolder,
+		                         kXboxLZXWindowBits, 0, kXboxLZXInputBufferSize, outputSize, 0);
+		if (!decoder.lzxd)
+			throw Exception("Failed to initialize lzxd");
+
+	} else if (lzxd_reset(decoder.lzxd, &decoder.inputHolder, &decoder.outputHolder, outputSize) != MSPACK_ERR_OK)
+		throw Exception("Failed to reset lzxd");
+
+	int result = lzxd_decompress(decoder.lzxd, outputSize);
 	if (result != MSPACK_ERR_OK)
 		throw Exception("lzxd_decompress returned %d", result);
+}
+
+std::unique_ptr<SeekableReadStream> decompressXboxLZX(ReadStream &input, size_t outputSize) {
+	std::unique_ptr<byte[]> outputBuf = std::make_unique<byte[]>(outputSize);
+
+	XboxLZXContext::getThreadContext().decompress(input, outputBuf.get(), outputSize);
 
 	return std::make_unique<MemoryReadStream>(std::move(outputBuf), outputSize);
 }
@@ -25,6 +25,10 @@
 #ifndef COMMON_LZX_H
 #define COMMON_LZX_H
 
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
 #include "src/common/types.h"
 
 namespace Common {
@@ -43,6 +47,38 @@ class SeekableReadStream;
  */
 std::unique_ptr<SeekableReadStream> decompressXboxLZX(ReadStream &input, size_t outputSize);
 
+/** A reusable Xbox 360 LZX decoder context.
+ *
+ *  Creating an LZX decoder allocates the decoding window and the input
+ *  buffer. For archives with thousands of small compressed resources, that
+ *  quickly dominates the time spent decompressing. An XboxLZXContext keeps
+ *  its decoder around and merely resets it between uses.
+ *
+ *  An XboxLZXContext must only be used by one thread at a time. Each thread
+ *  has its own context, available through getThreadContext().
+ */
+class XboxLZXContext : boost::noncopyable {
+public:
+	XboxLZXContext();
+	~XboxLZXContext();
+
+	/** Decompress using the Xbox 360 LZX algorithm.
+	 *
+	 *  @param  input      The compressed input data.
+	 *  @param  output     The buffer to decompress into.
+	 *  @param  outputSize The size of the decompressed output data.
+	 */
+	void decompress(ReadStream &input, byte *output, size_t outputSize);
+
+	/** Return the Xbox 360 LZX decoder context of the calling thread. */
+	static XboxLZXContext &getThreadContext();
+
+private:
+	struct Decoder;
+
+	std::unique_ptr<Decoder> _decoder;
+};
+
 } // End of namespace Common
 
 #endif // COMMON_LZX_H
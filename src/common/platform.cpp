@@ -36,8 +36,19 @@
 	#include <unistd.h>
 #endif
 
+#if defined(WIN32)
+	#include <io.h>
+#else
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
 #include <cassert>
 #include <cstdlib>
+#include <cerrno>
 
 #include <memory>
 
@@ -45,6 +56,7 @@
 #include <boost/filesystem/path.hpp>
 
 #include "src/common/platform.h"
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/encoding.h"
 #include "src/common/filepath.h"
@@ -119,6 +131,191 @@ std::FILE *Platform::openFile(const UString &fileName, FileMode mode) {
 }
 // '--- openFile() ---'
 
+// .--- readFileAt() ---.
+#if defined(WIN32)
+/** An event to wait for the overlapped reads of one thread. */
+struct ReadAtEvent {
+	HANDLE event;
+
+	ReadAtEvent() : event(CreateEventW(0, TRUE, FALSE, 0)) {
+	}
+
+	~ReadAtEvent() {
+		if (event)
+			CloseHandle(event);
+	}
+};
+#endif
+
+Platform::ReadAtHandle Platform::openReadAtHandle(std::FILE *file) {
+	assert(file);
+
+#if defined(WIN32)
+	/* Reading with an explicit offset still moves the file pointer of a
+	 * synchronous handle, which would confuse the C runtime's buffered reads.
+	 * So we read through a second, overlapped handle of the same file instead. */
+	HANDLE handle = ReOpenFile(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file))),
+	                           GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, FILE_FLAG_OVERLAPPED);
+	if (handle == INVALID_HANDLE_VALUE)
+		return kReadAtHandleInvalid;
+
+	return reinterpret_cast<ReadAtHandle>(handle);
+#else
+	const int fd = fileno(file);
+	if (fd < 0)
+		return kReadAtHandleInvalid;
+
+	return fd;
+#endif
+}
+
+void Platform::closeReadAtHandle(ReadAtHandle handle) {
+#if defined(WIN32)
+	if (handle != kReadAtHandleInvalid)
+		CloseHandle(reinterpret_cast<HANDLE>(handle));
+#else
+	// The descriptor belongs to the file
+	(void) handle;
+#endif
+}
+
+size_t Platform::readFileAt(ReadAtHandle handle, size_t offset, void *data, size_t size) {
+	assert((handle != kReadAtHandleInvalid) && data);
+
+	size_t total = 0;
+
+#if defined(WIN32)
+	static thread_local ReadAtEvent readEvent;
+	if (!readEvent.event)
+		return 0;
+
+	while (total < size) {
+		OVERLAPPED overlapped = {};
+		overlapped.Offset     = (DWORD) ((uint64_t)(offset + total) & 0xFFFFFFFF);
+		overlapped.OffsetHigh = (DWORD)(((uint64_t)(offset + total)) >> 32);
+		overlapped.hEvent     = readEvent.event;
+
+		const DWORD toRead = (DWORD) MIN<size_t>(size - total, 0x40000000);
+
+		DWORD readCount = 0;
+		if (!::ReadFile(reinterpret_cast<HANDLE>(handle), reinterpret_cast<byte *>(data) + total,
+		                toRead, 0, &overlapped) && (GetLastError() != ERROR_IO_PENDING))
+			break;
+
+		if (!GetOverlappedResult(reinterpret_cast<HANDLE>(handle), &overlapped, &readCount, TRUE) ||
+		    (readCount == 0))
+			break;
+
+		total += readCount;
+	}
+#else
+	const int fd = (int) handle;
+
+	while (total < size) {
+		const ssize_t readCount = pread(fd, reinterpret_cast<byte *>(data) + total, size - total, offset + total);
+		if (readCount < 0) {
+			if (errno == EINTR)
+				continue;
+
+			break;
+		}
+
+		if (readCount == 0)
+			break;
+
+		total += readCount;
+	}
+#endif
+
+	return total;
+}
+// '--- readFileAt() ---'
+
+// .--- mapFile() ---.
+/** Dummy data returned when mapping an empty file, which can't be mapped. */
+static const byte kEmptyMapping[1] = { 0 };
+
+const byte *Platform::mapFile(const UString &fileName, size_t &size) {
+	size = 0;
+
+#if defined(WIN32)
+	HANDLE file = CreateFileW(boost::filesystem::path(fileName.c_str()).c_str(), GENERIC_READ,
+	                          FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return 0;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart < 0) ||
+	    ((uint64_t)fileSize.QuadPart > (uint64_t)SIZE_MAX)) {
+
+		CloseHandle(file);
+		return 0;
+	}
+
+	if (fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return kEmptyMapping;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+	CloseHandle(file);
+
+	if (!mapping)
+		return 0;
+
+	// The view keeps a reference to the mapping object
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+
+	if (!data)
+		return 0;
+
+	size = (size_t)fileSize.QuadPart;
+#else
+	int file = ::open(boost::filesystem::path(fileName.c_str()).c_str(), O_RDONLY);
+	if (file < 0)
+		return 0;
+
+	struct stat fileStat;
+	if ((fstat(file, &fileStat) != 0) || !S_ISREG(fileStat.st_mode) || (fileStat.st_size < 0) ||
+	    ((uint64_t)fileStat.st_size > (uint64_t)SIZE_MAX)) {
+
+		::close(file);
+		return 0;
+	}
+
+	if (fileStat.st_size == 0) {
+		::close(file);
+		return kEmptyMapping;
+	}
+
+	// The mapping stays valid after the descriptor has been closed
+	void *data = mmap(0, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+
+	if (data == MAP_FAILED)
+		return 0;
+
+	size = (size_t)fileStat.st_size;
+#endif
+
+	return reinterpret_cast<const byte *>(data);
+}
+
+void Platform::unmapFile(const byte *data, size_t size) {
+	if (!data || (data == kEmptyMapping))
+		return;
+
+#if defined(WIN32)
+	(void) size;
+
+	UnmapViewOfFile(data);
+#else
+	munmap(const_cast<byte *>(data), size);
+#endif
+}
+// '--- mapFile() ---'
+
 // .--- Windows utility functions ---.
 #if defined(WIN32)
 
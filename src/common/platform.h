@@ -26,9 +26,11 @@
 #define COMMON_PLATFORM_H
 
 #include <cstdio>
+#include <cstddef>
 
 #include <vector>
 
+#include "src/common/types.h"
 #include "src/common/ustring.h"
 
 namespace Common {
@@ -51,6 +53,42 @@ public:
 	/** Open a file with an UTF-8 encoded name. */
 	static std::FILE *openFile(const UString &fileName, FileMode mode);
 
+	/** A handle for reading from an open file at arbitrary offsets, see readFileAt(). */
+	typedef intptr_t ReadAtHandle;
+
+	static const ReadAtHandle kReadAtHandleInvalid = -1;
+
+	/** Open a handle for reading from an open file at arbitrary offsets.
+	 *
+	 *  On Windows, this is a second, overlapped handle of the same file, so
+	 *  that reads never touch the file position the C runtime relies on. It
+	 *  should be kept around for as long as the file is open, and closed with
+	 *  closeReadAtHandle(). Elsewhere, it's just the file's descriptor.
+	 *
+	 *  @return The handle, or kReadAtHandleInvalid on failure.
+	 */
+	static ReadAtHandle openReadAtHandle(std::FILE *file);
+	/** Close a handle opened with openReadAtHandle(). */
+	static void closeReadAtHandle(ReadAtHandle handle);
+
+	/** Read from a file at the given offset, without moving its file position.
+	 *
+	 *  This can safely be called concurrently from several threads on the same file.
+	 *
+	 *  @return The number of bytes actually read.
+	 */
+	static size_t readFileAt(ReadAtHandle handle, size_t offset, void *data, size_t size);
+
+	/** Map a file with an UTF-8 encoded name read-only into memory.
+	 *
+	 *  @param  fileName The name of the file to map.
+	 *  @param  size Will be set to the size of the file.
+	 *  @return A pointer to the mapped file data, or 0 on failure.
+	 */
+	static const byte *mapFile(const UString &fileName, size_t &size);
+	/** Unmap a file previously mapped with mapFile(). */
+	static void unmapFile(const byte *data, size_t size);
+
 	/** Return the OS-specific path of the user's home directory. */
 	static UString getHomeDirectory();
 	/** Return the OS-specific path of the config directory. */
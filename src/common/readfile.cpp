@@ -23,7 +23,9 @@
  */
 
 #include <cassert>
+#include <cstring>
 
+#include "src/common/util.h"
 #include "src/common/readfile.h"
 #include "src/common/error.h"
 #include "src/common/ustring.h"
@@ -31,10 +33,12 @@
 
 namespace Common {
 
-ReadFile::ReadFile() : _handle(0), _size(kSizeInvalid) {
+ReadFile::ReadFile() : _handle(0), _readAtHandle(Platform::kReadAtHandleInvalid), _size(kSizeInvalid) {
 }
 
-ReadFile::ReadFile(const UString &fileName) : _handle(0), _size(kSizeInvalid) {
+ReadFile::ReadFile(const UString &fileName) :
+	_handle(0), _readAtHandle(Platform::kReadAtHandleInvalid), _size(kSizeInvalid) {
+
 	if (!open(fileName))
 		throw Exception("Can't open file \"%s\"", fileName.c_str());
 }
@@ -76,16 +80,24 @@ bool ReadFile::open(const UString &fileName) {
 		return false;
 	}
 
+	if ((_readAtHandle = Platform::openReadAtHandle(_handle)) == Platform::kReadAtHandleInvalid) {
+		close();
+		return false;
+	}
+
 	_size = (size_t)fileSize;
 
 	return true;
 }
 
 void ReadFile::close() {
+	Platform::closeReadAtHandle(_readAtHandle);
+
 	if (_handle)
 		std::fclose(_handle);
 
 	_handle = 0;
+	_readAtHandle = Platform::kReadAtHandleInvalid;
 	_size   = kSizeInvalid;
 }
 
@@ -139,4 +151,127 @@ size_t ReadFile::read(void *dataPtr, size_t dataSize) {
 	return std::fread(dataPtr, 1, dataSize, _handle);
 }
 
+size_t ReadFile::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (!_handle || (offset >= _size))
+		return 0;
+
+	assert(dataPtr);
+	return Platform::readFileAt(_readAtHandle, offset, dataPtr, MIN(dataSize, _size - offset));
+}
+
+
+MappedReadFile::MappedReadFile() : _data(0), _size(kSizeInvalid), _pos(0), _eos(false) {
+}
+
+MappedReadFile::MappedReadFile(const UString &fileName) :
+	_data(0), _size(kSizeInvalid), _pos(0), _eos(false) {
+
+	if (!open(fileName))
+		throw Exception("Can't open file \"%s\"", fileName.c_str());
+}
+
+MappedReadFile::~MappedReadFile() {
+	close();
+}
+
+bool MappedReadFile::open(const UString &fileName) {
+	close();
+
+	size_t fileSize = 0;
+	if (!(_data = Platform::mapFile(fileName, fileSize)))
+		return false;
+
+	if ((uint64_t)fileSize > (uint64_t)0x7FFFFFFFULL) {
+		warning("MappedReadFile \"%s\" is too big", fileName.c_str());
+
+		Platform::unmapFile(_data, fileSize);
+		_data = 0;
+
+		return false;
+	}
+
+	_size = fileSize;
+	_pos  = 0;
+	_eos  = false;
+
+	return true;
+}
+
+void MappedReadFile::close() {
+	if (_data)
+		Platform::unmapFile(_data, _size);
+
+	_data = 0;
+	_size = kSizeInvalid;
+	_pos  = 0;
+	_eos  = false;
+}
+
+bool MappedReadFile::isOpen() const {
+	return _data != 0;
+}
+
+bool MappedReadFile::eos() const {
+	return _eos;
+}
+
+size_t MappedReadFile::pos() const {
+	if (!_data)
+		return kPositionInvalid;
+
+	return _pos;
+}
+
+size_t MappedReadFile::size() const {
+	return _size;
+}
+
+size_t MappedReadFile::seek(ptrdiff_t offset, Origin whence) {
+	if (!_data)
+		throw Exception(kSeekError);
+
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t MappedReadFile::read(void *dataPtr, size_t dataSize) {
+	if (!_data)
+		return 0;
+
+	assert(dataPtr);
+
+	if (dataSize > (_size - _pos)) {
+		dataSize = _size - _pos;
+		_eos     = true;
+	}
+
+	std::memcpy(dataPtr, _data + _pos, dataSize);
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+size_t MappedReadFile::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (!_data || (offset >= _size))
+		return 0;
+
+	assert(dataPtr);
+
+	dataSize = MIN(dataSize, _size - offset);
+	std::memcpy(dataPtr, _data + offset, dataSize);
+
+	return dataSize;
+}
+
+const byte *MappedReadFile::getData() const {
+	return _data;
+}
+
 } // End of namespace Common
@@ -32,6 +32,7 @@
 
 #include "src/common/types.h"
 #include "src/common/readstream.h"
+#include "src/common/platform.h"
 
 namespace Common {
 
@@ -68,9 +69,65 @@ public:
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
 	size_t read(void *dataPtr, size_t dataSize);
 
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+protected:
+	std::FILE *_handle;                  ///< The actual file handle.
+	Platform::ReadAtHandle _readAtHandle; ///< Handle for readAt(), open as long as _handle.
+	size_t _size;                        ///< The file's size.
+};
+
+/** A file reading class that maps the whole file into memory.
+ *
+ *  Instead of reading the file piecemeal, the operating system maps the file
+ *  into the address space of the process. Reading is then a simple memory
+ *  copy, and the data can be accessed directly with getData(), for example
+ *  to create sub streams of the file without copying (see
+ *  SeekableReadStream::createSubStream()).
+ *
+ *  The file must not be truncated or rewritten while it's mapped: accessing
+ *  the mapping then crashes with SIGBUS, instead of failing to read. Only
+ *  map files that aren't expected to change, like those of a game install.
+ */
+class MappedReadFile : boost::noncopyable, public SeekableReadStream {
+public:
+	MappedReadFile();
+	MappedReadFile(const UString &fileName);
+	~MappedReadFile();
+
+	/** Try to open and map the file with the given fileName.
+	 *
+	 *  @param  fileName the name of the file to open
+	 *  @return true if file was opened successfully, false otherwise
+	 */
+	bool open(const UString &fileName);
+
+	/** Close the file, if open. */
+	void close();
+
+	/** Checks if the object opened a file successfully.
+	 *
+	 *  @return true if any file is opened, false otherwise.
+	 */
+	bool isOpen() const;
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+	const byte *getData() const;
+
 protected:
-	std::FILE *_handle; ///< The actual file handle.
-	size_t _size;       ///< The file's size.
+	const byte *_data; ///< The mapped file data.
+	size_t _size;      ///< The file's size.
+	size_t _pos;       ///< The current position within the file.
+	bool _eos;         ///< Did we try to read past the end of the file?
 };
 
 } // End of namespace Common
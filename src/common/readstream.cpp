@@ -81,6 +81,42 @@ SeekableReadStream::SeekableReadStream() {
 SeekableReadStream::~SeekableReadStream() {
 }
 
+size_t SeekableReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	const size_t oldPos = pos();
+
+	seek(offset);
+	dataSize = read(dataPtr, dataSize);
+	seek(oldPos);
+
+	return dataSize;
+}
+
+MemoryReadStream *SeekableReadStream::readStreamAt(size_t offset, size_t dataSize) {
+	std::unique_ptr<byte[]> buf = std::make_unique<byte[]>(dataSize);
+
+	if (readAt(offset, buf.get(), dataSize) != dataSize)
+		throw Exception(kReadError);
+
+	return new MemoryReadStream(buf.release(), dataSize, true);
+}
+
+const byte *SeekableReadStream::getData() const {
+	return 0;
+}
+
+SeekableReadStream *SeekableReadStream::createSubStream(size_t begin, size_t end) {
+	assert(begin <= end);
+
+	const byte *data = getData();
+	if (!data)
+		return new SeekableSubReadStream(this, begin, end);
+
+	if (end > size())
+		throw Exception(kReadError);
+
+	return new MemoryReadStream(data + begin, end - begin);
+}
+
 size_t SeekableReadStream::evalSeek(ptrdiff_t offset, Origin whence, size_t pos, size_t begin, size_t size) {
 	switch (whence) {
 		case kOriginEnd:
@@ -132,7 +168,6 @@ SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, s
 	assert(_begin <= _end);
 
 	_pos = begin;
-	_parentStream->seek(_pos);
 }
 
 SeekableSubReadStream::~SeekableSubReadStream() {
@@ -146,6 +181,25 @@ size_t SeekableSubReadStream::size() const {
 	return _end - _begin;
 }
 
+bool SeekableSubReadStream::eos() const {
+	return _eos;
+}
+
+size_t SeekableSubReadStream::read(void *dataPtr, size_t dataSize) {
+	if (dataSize > (size_t)(_end - _pos)) {
+		dataSize = _end - _pos;
+		_eos = true;
+	}
+
+	const size_t readSize = _parentStream->readAt(_pos, dataPtr, dataSize);
+	if (readSize != dataSize)
+		_eos = true;
+
+	_pos += readSize;
+
+	return readSize;
+}
+
 size_t SeekableSubReadStream::seek(ptrdiff_t offset, Origin whence) {
 	assert(_pos >= _begin);
 	assert(_pos <= _end);
@@ -157,12 +211,28 @@ size_t SeekableSubReadStream::seek(ptrdiff_t offset, Origin whence) {
 
 	_pos = newPos;
 
-	_parentStream->seek(_pos);
 	_eos = false; // reset eos on successful seek
 
 	return oldPos;
 }
 
+size_t SeekableSubReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (offset >= size())
+		return 0;
+
+	dataSize = MIN<size_t>(dataSize, size() - offset);
+
+	return _parentStream->readAt(_begin + offset, dataPtr, dataSize);
+}
+
+const byte *SeekableSubReadStream::getData() const {
+	const byte *data = _parentStream->getData();
+	if (!data)
+		return 0;
+
+	return data + _begin;
+}
+
 
 SeekableSubReadStreamEndian::SeekableSubReadStreamEndian(SeekableReadStream *parentStream,
 		size_t begin, size_t end, bool bigEndian, bool disposeParentStream) :
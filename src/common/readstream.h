@@ -316,6 +316,50 @@ public:
 		return seek(offset, kOriginCurrent);
 	}
 
+	/** Read data from the given position in the stream, without using or
+	 *  moving the stream's position indicator.
+	 *
+	 *  Files, memory streams and sub streams of those implement this as a
+	 *  true positional read, which can safely be called concurrently from
+	 *  several threads. All other streams fall back to seeking, reading and
+	 *  seeking back, which is not thread-safe.
+	 *
+	 *  @param  offset the position, from the beginning of the stream, to read from.
+	 *  @param  dataPtr pointer to a buffer into which the data is read.
+	 *  @param  dataSize number of bytes to be read.
+	 *  @return the number of bytes which were actually read.
+	 */
+	virtual size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+	/** Read the specified amount of data from the given position into a
+	 *  new[]'ed buffer which then is wrapped into a MemoryReadStream.
+	 *
+	 *  Like readAt(), this does not use or move the position indicator.
+	 *
+	 *  When reading fails, a kReadError exception is thrown.
+	 */
+	MemoryReadStream *readStreamAt(size_t offset, size_t dataSize);
+
+	/** Return the stream's complete data, if it is held in memory.
+	 *
+	 *  Streams that keep all their data in memory, like memory streams and
+	 *  memory-mapped files, return a pointer to the start of the data, so
+	 *  that it can be accessed directly without copying. All other streams
+	 *  return 0.
+	 */
+	virtual const byte *getData() const;
+
+	/** Create a stream of the range [begin, end) of this stream, without
+	 *  copying the data.
+	 *
+	 *  If the stream's data is held in memory (see getData()), the new stream
+	 *  directly references that memory. Otherwise, a SeekableSubReadStream
+	 *  is created, which reads from this stream with readAt().
+	 *
+	 *  Either way, the new stream must not outlive this stream.
+	 */
+	SeekableReadStream *createSubStream(size_t begin, size_t end);
+
 	/** Evaluate the seek offset relative to whence into a position from the beginning. */
 	static size_t evalSeek(ptrdiff_t offset, Origin whence, size_t pos, size_t begin, size_t size);
 };
@@ -351,8 +395,10 @@ protected:
  *  the range [begin, end).
  *  The same caveats apply to SeekableSubReadStream as do to SeekableReadStream.
  *
- *  Manipulating the parent stream directly /will/ mess up a substream.
- *  @see SubReadStream
+ *  Unlike SubReadStream, all reads go through the parent's readAt(). The
+ *  position of the parent stream is neither used nor changed, and several
+ *  substreams of a parent stream that supports positional reads can be
+ *  read from concurrently.
  */
 class SeekableSubReadStream : public SubReadStream, public SeekableReadStream {
 public:
@@ -363,8 +409,16 @@ public:
 	size_t pos() const;
 	size_t size() const;
 
+	bool eos() const;
+
+	size_t read(void *dataPtr, size_t dataSize);
+
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
 
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+	const byte *getData() const;
+
 protected:
 	SeekableReadStream *_parentStream;
 
@@ -375,8 +429,7 @@ protected:
 /** This is a wrapper around SeekableSubReadStream, but it adds non-endian
  *  read methods whose endianness is set on the stream creation.
  *
- *  Manipulating the parent stream directly /will/ mess up a substream.
- *  @see SubReadStream
+ *  @see SeekableSubReadStream
  */
 class SeekableSubReadStreamEndian : public SeekableSubReadStream {
 private:
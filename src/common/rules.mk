@@ -44,13 +44,16 @@ src_common_libcommon_la_SOURCES += \
     src/common/hash.h \
     src/common/md5.h \
     src/common/blowfish.h \
+    src/common/blowfishreadstream.h \
     src/common/deflate.h \
+    src/common/inflatereadstream.h \
     src/common/lzma.h \
     src/common/readfile.h \
     src/common/writefile.h \
     src/common/filepath.h \
     src/common/filelist.h \
     src/common/filetree.h \
+    src/common/filewatcher.h \
     src/common/zipfile.h \
     src/common/bitstream.h \
     src/common/huffman.h \
@@ -60,6 +63,7 @@ src_common_libcommon_la_SOURCES += \
     src/common/mdct.h \
     src/common/mutex.h \
     src/common/thread.h \
+    src/common/threadpool.h \
     src/common/binsearch.h \
     src/common/streamtokenizer.h \
     src/common/string.h \
@@ -78,7 +82,9 @@ src_common_libcommon_la_SOURCES += \
     src/common/maths.cpp \
     src/common/md5.cpp \
     src/common/blowfish.cpp \
+    src/common/blowfishreadstream.cpp \
     src/common/deflate.cpp \
+    src/common/inflatereadstream.cpp \
     src/common/lzma.cpp \
     src/common/error.cpp \
     src/common/ustring.cpp \
@@ -87,6 +93,7 @@ src_common_libcommon_la_SOURCES += \
     src/common/filepath.cpp \
     src/common/filelist.cpp \
     src/common/filetree.cpp \
+    src/common/filewatcher.cpp \
     src/common/zipfile.cpp \
     src/common/huffman.cpp \
     src/common/sinewindows.cpp \
@@ -94,6 +101,7 @@ src_common_libcommon_la_SOURCES += \
     src/common/fft.cpp \
     src/common/mdct.cpp \
     src/common/thread.cpp \
+    src/common/threadpool.cpp \
     src/common/streamtokenizer.cpp \
     src/common/string.cpp \
     src/common/lzx.cpp \
@@ -31,6 +31,8 @@
 #if defined(__linux__)
 	#include <sys/prctl.h>
 	#include <cstring>
+	#include <pthread.h>
+	#include <sched.h>
 #elif defined(__APPLE__)
 	#include <dlfcn.h>
 #elif defined(__MINGW32__) || defined(__FreeBSD__) || defined(__OpenBSD__)
@@ -236,4 +238,22 @@ void Thread::setCurrentThreadName(const Common::UString &name) {
 #endif
 }
 
+void Thread::setCurrentThreadAffinity(size_t core) {
+	const size_t coreCount = MAX<size_t>(std::thread::hardware_concurrency(), 1);
+	core %= coreCount;
+
+#if defined(__linux__)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(core % CPU_SETSIZE, &cpuSet);
+
+	pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#elif defined(_WIN32)
+	SetThreadAffinityMask(GetCurrentThread(), ((DWORD_PTR) 1) << (core % (sizeof(DWORD_PTR) * 8)));
+#else
+	// Do nothing; silence the unused warning
+	(void)core;
+#endif
+}
+
 } // End of namespace Common
@@ -55,6 +55,13 @@ public:
 	 */
 	static void setCurrentThreadName(const Common::UString &name);
 
+	/**
+	 * Bind the current thread to the given CPU core, if available on the
+	 * platform. Otherwise, a no-op. Core numbers beyond the number of cores
+	 * wrap around.
+	 */
+	static void setCurrentThreadAffinity(size_t core);
+
 protected:
 	std::atomic<bool> _killThread;
 
@@ -0,0 +1,273 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A work-stealing pool of worker threads.
+ */
+
+#include <cassert>
+
+#include <exception>
+
+#include "src/common/threadpool.h"
+#include "src/common/util.h"
+#include "src/common/strutil.h"
+
+DECLARE_SINGLETON(Common::ThreadPoolManager)
+
+namespace Common {
+
+/** The pool the current thread is a worker of, if any. */
+static thread_local ThreadPool *currentPool = 0;
+/** The index of the current thread within its pool. */
+static thread_local size_t currentWorker = SIZE_MAX;
+
+ThreadPool::ThreadPool(size_t threadCount, bool pinThreads) : _pending(0), _nextQueue(0), _stop(false) {
+	if (threadCount == 0)
+		threadCount = MAX<size_t>(std::thread::hardware_concurrency(), 1);
+
+	_workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++)
+		_workers.emplace_back(std::make_unique<Worker>());
+
+	// Only start the threads once all queues exist, since they steal from each other
+	for (size_t i = 0; i < threadCount; i++)
+		_workers[i]->thread = std::thread(&ThreadPool::workerMain, this, i, pinThreads);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_stop = true;
+	}
+
+	_wakeUp.notify_all();
+
+	for (auto &worker : _workers)
+		if (worker->thread.joinable())
+			worker->thread.join();
+}
+
+size_t ThreadPool::getThreadCount() const {
+	return _workers.size();
+}
+
+void ThreadPool::push(Task task) {
+	const size_t index = (currentPool == this) ? currentWorker : (_nextQueue++ % _workers.size());
+
+	// Announce the task before it is visible, so that _pending never undercounts
+	_pending++;
+
+	{
+		std::lock_guard<std::mutex> lock(_workers[index]->mutex);
+		_workers[index]->tasks.push_back(std::move(task));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+	}
+
+	_wakeUp.notify_one();
+}
+
+bool ThreadPool::pop(size_t index, Task &task) {
+	// Our own queue first, newest task first
+	if (index < _workers.size()) {
+		Worker &worker = *_workers[index];
+
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (!worker.tasks.empty()) {
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+
+			_pending--;
+			return true;
+		}
+	}
+
+	// Then steal the oldest task from one of the others
+	const size_t start = (index < _workers.size()) ? (index + 1) : 0;
+	for (size_t i = 0; i < _workers.size(); i++) {
+		Worker &worker = *_workers[(start + i) % _workers.size()];
+
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (!worker.tasks.empty()) {
+			task = std::move(worker.tasks.front());
+			worker.tasks.pop_front();
+
+			_pending--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::workerMain(size_t index, bool pinThread) {
+	currentPool   = this;
+	currentWorker = index;
+
+	Thread::setCurrentThreadName("pool worker " + composeString(index));
+	if (pinThread)
+		Thread::setCurrentThreadAffinity(index);
+
+	while (true) {
+		Task task;
+		if (pop(index, task)) {
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		_wakeUp.wait(lock, [this]() { return _stop || (_pending.load() > 0); });
+
+		// Only quit once all remaining tasks are done
+		if (_stop && (_pending.load() == 0))
+			break;
+	}
+
+	currentPool   = 0;
+	currentWorker = SIZE_MAX;
+}
+
+
+/** The state of one parallelFor() call, shared by all threads working on it. */
+struct ParallelForState {
+	const std::function<void(size_t)> *body;
+
+	size_t begin;
+	size_t end;
+	size_t grainSize;
+	size_t chunkCount;
+
+	CancelToken token;
+
+	std::atomic<size_t> nextChunk;
+	std::atomic<size_t> doneChunks;
+
+	std::atomic<bool> skipped;
+	std::atomic<bool> failed;
+	std::exception_ptr exception;
+
+	std::mutex mutex;
+	std::condition_variable done;
+
+	ParallelForState(const std::function<void(size_t)> &b, size_t bg, size_t e, size_t g,
+	                 const CancelToken &t) : body(&b), begin(bg), end(e), grainSize(g), token(t),
+	                 nextChunk(0), doneChunks(0), skipped(false), failed(false) {
+
+		chunkCount = (end - begin + grainSize - 1) / grainSize;
+	}
+};
+
+/** Process chunks of a parallelFor() loop until there are none left. */
+static void runParallelForChunks(ParallelForState &state) {
+	for (size_t chunk = state.nextChunk++; chunk < state.chunkCount; chunk = state.nextChunk++) {
+		if (state.failed.load() || state.token.isCancelled()) {
+			state.skipped.store(true);
+		} else {
+			const size_t chunkBegin = state.begin + chunk * state.grainSize;
+			const size_t chunkEnd   = MIN(chunkBegin + state.grainSize, state.end);
+
+			try {
+				for (size_t i = chunkBegin; i < chunkEnd; i++)
+					(*state.body)(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(state.mutex);
+
+				if (!state.exception)
+					state.exception = std::current_exception();
+
+				state.failed.store(true);
+			}
+		}
+
+		if (++state.doneChunks == state.chunkCount) {
+			std::lock_guard<std::mutex> lock(state.mutex);
+			state.done.notify_all();
+		}
+	}
+}
+
+bool ThreadPool::parallelFor(size_t begin, size_t end, const std::function<void(size_t)> &body,
+                             CancelToken token, size_t grainSize) {
+
+	if (begin >= end)
+		return !token.isCancelled();
+
+	// Aim for a few chunks per thread, so that uneven chunks balance out
+	if (grainSize == 0)
+		grainSize = MAX<size_t>((end - begin) / (4 * (_workers.size() + 1)), 1);
+
+	/* Helper tasks might only start after we're done, so they need to share
+	 * ownership of the state. They won't find any chunks left to process
+	 * then, so they never touch the body after we returned. */
+	std::shared_ptr<ParallelForState> state =
+		std::make_shared<ParallelForState>(body, begin, end, grainSize, token);
+
+	const size_t helperCount = MIN(_workers.size(), state->chunkCount - 1);
+	for (size_t i = 0; i < helperCount; i++)
+		push([state]() { runParallelForChunks(*state); });
+
+	// Work on the loop ourselves, then wait for the chunks other threads are still busy with
+	runParallelForChunks(*state);
+
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->done.wait(lock, [&state]() { return state->doneChunks.load() == state->chunkCount; });
+	}
+
+	if (state->exception)
+		std::rethrow_exception(state->exception);
+
+	return !state->skipped.load();
+}
+
+
+ThreadPoolManager::ThreadPoolManager() {
+}
+
+ThreadPoolManager::~ThreadPoolManager() {
+	deinit();
+}
+
+void ThreadPoolManager::init(size_t threadCount, bool pinThreads) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_pool.reset();
+	_pool = std::make_unique<ThreadPool>(threadCount, pinThreads);
+}
+
+void ThreadPoolManager::deinit() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_pool.reset();
+}
+
+ThreadPool &ThreadPoolManager::getPool() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (!_pool)
+		_pool = std::make_unique<ThreadPool>();
+
+	return *_pool;
+}
+
+} // End of namespace Common
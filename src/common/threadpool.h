@@ -0,0 +1,276 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A work-stealing pool of worker threads.
+ */
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include <cstddef>
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <future>
+#include <type_traits>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/error.h"
+#include "src/common/singleton.h"
+#include "src/common/mutex.h"
+#include "src/common/thread.h"
+
+namespace Common {
+
+/** A flag to cancel a group of tasks.
+ *
+ *  Copies of a CancelToken share the same flag, so a token can be handed
+ *  to any number of tasks, and cancelling any copy cancels all of them.
+ */
+class CancelToken {
+public:
+	CancelToken() : _cancelled(std::make_shared<std::atomic<bool>>(false)) {
+	}
+
+	/** Request all tasks using this token to be cancelled. */
+	void cancel() {
+		_cancelled->store(true, std::memory_order_relaxed);
+	}
+
+	/** Was cancel() called on this token, or any of its copies? */
+	bool isCancelled() const {
+		return _cancelled->load(std::memory_order_relaxed);
+	}
+
+private:
+	std::shared_ptr<std::atomic<bool>> _cancelled;
+};
+
+/** A function that is run at most once, by whoever claims it first. */
+class ClaimableTask : boost::noncopyable {
+public:
+	ClaimableTask(std::function<void()> func) : _func(std::move(func)), _claimed(false) {
+	}
+
+	/** Run the function, unless somebody else already did or is doing that.
+	 *
+	 *  @return true if the function was run by this call.
+	 */
+	bool run() {
+		if (_claimed.exchange(true))
+			return false;
+
+		_func();
+		_func = nullptr;
+
+		return true;
+	}
+
+private:
+	std::function<void()> _func;
+	std::atomic<bool> _claimed;
+};
+
+/** The future of a task submitted to a ThreadPool.
+ *
+ *  It can be used like any std::future. Additionally, ThreadPool::wait()
+ *  runs the task in the waiting thread, if no worker has started it yet.
+ */
+template<typename T>
+class TaskFuture : public std::future<T> {
+public:
+	TaskFuture() {
+	}
+
+	TaskFuture(std::future<T> &&f, std::shared_ptr<ClaimableTask> task) :
+		std::future<T>(std::move(f)), _task(std::move(task)) {
+	}
+
+	TaskFuture(TaskFuture &&) = default;
+	TaskFuture &operator=(TaskFuture &&) = default;
+
+private:
+	std::shared_ptr<ClaimableTask> _task;
+
+	friend class ThreadPool;
+};
+
+/** A pool of worker threads that execute tasks.
+ *
+ *  Every worker thread has its own task queue. Tasks submitted from within
+ *  a worker go into that worker's queue, all other tasks are distributed
+ *  over the queues in turn. A worker runs the tasks of its own queue, newest
+ *  first, and when it runs out of tasks, it steals the oldest tasks from the
+ *  queues of other workers.
+ *
+ *  Tasks must not block waiting on other tasks of the same pool, as this can
+ *  deadlock when all workers are waiting. Use parallelFor(), or wait(), which
+ *  both run the work they're waiting for themselves if nobody started it yet,
+ *  instead.
+ */
+class ThreadPool : boost::noncopyable {
+public:
+	/** Create a thread pool.
+	 *
+	 *  @param threadCount The number of worker threads, 0 for one per CPU core.
+	 *  @param pinThreads  Bind each worker thread to its own CPU core?
+	 */
+	ThreadPool(size_t threadCount = 0, bool pinThreads = false);
+	/** Destroy the pool, after all tasks still queued have finished. */
+	~ThreadPool();
+
+	/** Return the number of worker threads in this pool. */
+	size_t getThreadCount() const;
+
+	/** Queue a function for execution on a worker thread.
+	 *
+	 *  If the token is cancelled before the function was started, it will
+	 *  not run at all, and the future will throw an exception instead.
+	 *  Exceptions thrown by the function are passed on through the future
+	 *  as well.
+	 *
+	 *  @param  func The function to call, taking no parameters.
+	 *  @param  token The token that can cancel the function.
+	 *  @return A future of the function's return value.
+	 */
+	template<typename F>
+	TaskFuture<typename std::result_of<F()>::type> submit(F func, CancelToken token = CancelToken()) {
+		typedef typename std::result_of<F()>::type Result;
+
+		std::shared_ptr<std::packaged_task<Result()>> task =
+			std::make_shared<std::packaged_task<Result()>>([func, token]() mutable -> Result {
+				if (token.isCancelled())
+					throw Exception("Task cancelled");
+
+				return func();
+			});
+
+		// The queue and a waiting thread race to run the task, only the first one does
+		std::shared_ptr<ClaimableTask> claimable = std::make_shared<ClaimableTask>([task]() { (*task)(); });
+
+		TaskFuture<Result> future(task->get_future(), claimable);
+
+		push([claimable]() { claimable->run(); });
+
+		return future;
+	}
+
+	/** Call body(i) for every i in [begin, end), in parallel.
+	 *
+	 *  The range is split into chunks of grainSize indices, which are then
+	 *  processed by the worker threads and the calling thread together.
+	 *  This returns after all started chunks have finished.
+	 *
+	 *  If the body throws, no further chunks are started, and the first
+	 *  exception is rethrown in the calling thread.
+	 *
+	 *  @param  begin The first index.
+	 *  @param  end One past the last index.
+	 *  @param  body The function to call for each index.
+	 *  @param  token The token that can cancel the remaining iterations.
+	 *  @param  grainSize The number of indices per chunk, 0 for an automatic value.
+	 *  @return true if all iterations ran, false if the loop was cancelled.
+	 */
+	bool parallelFor(size_t begin, size_t end, const std::function<void(size_t)> &body,
+	                 CancelToken token = CancelToken(), size_t grainSize = 0);
+
+	/** Wait for a task of this pool to finish.
+	 *
+	 *  If no worker has started the task yet, it is run in the calling thread
+	 *  instead. Otherwise, this blocks until the worker is done with it. No
+	 *  other tasks are run in the meantime.
+	 */
+	template<typename T>
+	void wait(const TaskFuture<T> &future) {
+		if (future._task)
+			future._task->run();
+
+		future.wait();
+	}
+
+private:
+	typedef std::function<void()> Task;
+
+	/** A worker thread, together with its task queue. */
+	struct Worker {
+		std::thread thread;
+
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Worker>> _workers;
+
+	/** Number of tasks queued, but not yet taken. */
+	std::atomic<size_t> _pending;
+	/** Queue the next task from a non-worker thread goes into. */
+	std::atomic<size_t> _nextQueue;
+
+	std::mutex _sleepMutex;
+	std::condition_variable _wakeUp;
+	bool _stop;
+
+	void push(Task task);
+
+	/** Take a task, from our own queue first, otherwise stealing one from the others. */
+	bool pop(size_t index, Task &task);
+
+	void workerMain(size_t index, bool pinThread);
+};
+
+/** The manager of the thread pool shared by the whole program.
+ *
+ *  This is the one place where the number of threads and their
+ *  affinity is configured.
+ */
+class ThreadPoolManager : public Singleton<ThreadPoolManager> {
+public:
+	ThreadPoolManager();
+	~ThreadPoolManager();
+
+	/** Create the shared thread pool.
+	 *
+	 *  @param threadCount The number of worker threads, 0 for one per CPU core.
+	 *  @param pinThreads  Bind each worker thread to its own CPU core?
+	 */
+	void init(size_t threadCount = 0, bool pinThreads = false);
+	/** Destroy the shared thread pool, after all its tasks have finished. */
+	void deinit();
+
+	/** Return the shared thread pool, creating it with the default configuration if necessary. */
+	ThreadPool &getPool();
+
+private:
+	std::mutex _mutex;
+	std::unique_ptr<ThreadPool> _pool;
+};
+
+} // End of namespace Common
+
+/** Shortcut for accessing the thread pool manager. */
+#define ThreadPoolMan Common::ThreadPoolManager::instance()
+
+#endif // COMMON_THREADPOOL_H
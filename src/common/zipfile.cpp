@@ -129,29 +129,31 @@ const ZipFile::IFile &ZipFile::getIFile(uint32_t index) const {
 	return _iFiles[index];
 }
 
-void ZipFile::getFileProperties(SeekableReadStream &zip, const IFile &file,
-		uint16_t &compMethod, uint32_t &compSize, uint32_t &realSize) const {
+void ZipFile::getFileProperties(SeekableReadStream &zip, const IFile &file, uint16_t &compMethod,
+		uint32_t &compSize, uint32_t &realSize, size_t &dataOffset) const {
 
-	zip.seek(file.offset);
+	// Read the local file header positionally, so that concurrent calls don't interfere
+	static const size_t kLocalHeaderSize = 30;
 
-	uint32_t tag = zip.readUint32LE();
+	std::unique_ptr<SeekableReadStream> header(zip.readStreamAt(file.offset, kLocalHeaderSize));
+
+	uint32_t tag = header->readUint32LE();
 	if (tag != 0x04034B50)
 		throw Exception("Unknown ZIP record %08X", tag);
 
-	zip.skip(4);
+	header->skip(4);
 
-	compMethod = zip.readUint16LE();
+	compMethod = header->readUint16LE();
 
-	zip.skip(8);
+	header->skip(8);
 
-	compSize = zip.readUint32LE();
-	realSize = zip.readUint32LE();
+	compSize = header->readUint32LE();
+	realSize = header->readUint32LE();
 
-	uint16_t nameLength  = zip.readUint16LE();
-	uint16_t extraLength = zip.readUint16LE();
+	uint16_t nameLength  = header->readUint16LE();
+	uint16_t extraLength = header->readUint16LE();
 
-	zip.skip(nameLength);
-	zip.skip(extraLength);
+	dataOffset = file.offset + kLocalHeaderSize + nameLength + extraLength;
 }
 
 size_t ZipFile::getFileSize(uint32_t index) const {
@@ -164,13 +166,15 @@ SeekableReadStream *ZipFile::getFile(uint32_t index, bool tryNoCopy) const {
 	uint16_t compMethod;
 	uint32_t compSize;
 	uint32_t realSize;
+	size_t dataOffset;
 
-	getFileProperties(*_zip, file, compMethod, compSize, realSize);
+	getFileProperties(*_zip, file, compMethod, compSize, realSize, dataOffset);
 
+	std::unique_ptr<SeekableReadStream> compStream(_zip->createSubStream(dataOffset, dataOffset + compSize));
 	if (tryNoCopy && (compMethod == 0))
-		return new SeekableSubReadStream(_zip.get(), _zip->pos(), _zip->pos() + compSize);
+		return compStream.release();
 
-	return decompressFile(*_zip, compMethod, compSize, realSize);
+	return decompressFile(*compStream, compMethod, compSize, realSize);
 }
 
 SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, uint32_t method,
@@ -84,8 +84,8 @@ private:
 			uint32_t compSize, uint32_t realSize);
 
 	const IFile &getIFile(uint32_t index) const;
-	void getFileProperties(SeekableReadStream &zip, const IFile &file,
-			uint16_t &compMethod, uint32_t &compSize, uint32_t &realSize) const;
+	void getFileProperties(SeekableReadStream &zip, const IFile &file, uint16_t &compMethod,
+			uint32_t &compSize, uint32_t &realSize, size_t &dataOffset) const;
 };
 
 } // End of namespace Common
@@ -0,0 +1,251 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Extracting whole archives from the command line.
+ */
+
+#include <cstdio>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <set>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+#include "src/common/filepath.h"
+#include "src/common/writefile.h"
+#include "src/common/mutex.h"
+#include "src/common/threadpool.h"
+
+#include "src/aurora/util.h"
+#include "src/aurora/archive.h"
+#include "src/aurora/archivecache.h"
+#include "src/aurora/openarchive.h"
+#include "src/aurora/keyfile.h"
+
+#include "src/extract.h"
+
+/** Maximum amount of resource data held in memory by all extraction jobs together. */
+static const size_t kMaxBytesInFlight = 256 * 1024 * 1024;
+
+/** Limits the amount of memory used by concurrent extraction jobs. */
+class MemoryBudget : boost::noncopyable {
+public:
+	MemoryBudget(size_t size) : _size(size), _available(size) {
+	}
+
+	/** Wait until the requested amount of memory is available, and take it.
+	 *
+	 *  Requests larger than the whole budget are clipped to it, so that they
+	 *  still go through, albeit only alone.
+	 *
+	 *  @return The amount of memory actually taken, to be given back with release().
+	 */
+	size_t acquire(size_t size) {
+		size = MIN(size, _size);
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_condition.wait(lock, [this, size]() { return _available >= size; });
+
+		_available -= size;
+
+		return size;
+	}
+
+	void release(size_t size) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_available += size;
+		}
+
+		_condition.notify_all();
+	}
+
+private:
+	const size_t _size;
+	size_t _available;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+};
+
+static Common::UString getResourceFileName(const Aurora::Archive::Resource &resource, size_t number = 0) {
+	Common::UString name = resource.name;
+	if (name.empty())
+		name = Common::composeString(resource.hash);
+
+	if (number > 0)
+		name += "_" + Common::composeString(number);
+
+	return TypeMan.setFileType(name, resource.type);
+}
+
+/** Find a unique output file name for every resource.
+ *
+ *  Different resources can have the same name: a ZIP file only keeps the stem
+ *  of a file name, losing its directory, and a KEY file can list the same
+ *  resource more than once. The first resource keeps the name, the others get
+ *  a number appended, so that no two extraction jobs write to the same file.
+ *  Names are compared case-insensitively, for case-insensitive file systems.
+ *
+ *  @return The number of resources that had to be renamed.
+ */
+static size_t getResourceFileNames(const Aurora::Archive::ResourceList &resources,
+                                   std::vector<Common::UString> &names) {
+
+	names.clear();
+	names.reserve(resources.size());
+
+	std::set<Common::UString, Common::UString::iless> taken;
+	std::vector<size_t> duplicates;
+
+	for (size_t i = 0; i < resources.size(); i++) {
+		names.push_back(getResourceFileName(resources[i]));
+
+		if (!taken.insert(names.back()).second)
+			duplicates.push_back(i);
+	}
+
+	// Only rename after all original names have been taken, so that we don't steal one
+	for (size_t i : duplicates) {
+		for (size_t number = 1; !taken.insert(names[i]).second; number++)
+			names[i] = getResourceFileName(resources[i], number);
+	}
+
+	return duplicates.size();
+}
+
+/** State shared between all extraction jobs. */
+struct ExtractState {
+	const Aurora::Archive *archive;
+	Common::UString outPath;
+
+	MemoryBudget memory;
+
+	std::atomic<size_t> extractedCount;
+	std::atomic<size_t> extractedSize;
+	std::atomic<size_t> failedCount;
+
+	ExtractState(const Aurora::Archive &a, const Common::UString &o) : archive(&a), outPath(o),
+		memory(kMaxBytesInFlight), extractedCount(0), extractedSize(0), failedCount(0) {
+	}
+};
+
+static void extractResource(ExtractState &state, const Aurora::Archive::Resource &resource,
+                            const Common::UString &name) {
+
+	// Reserve the memory for the resource, if we know its size
+	uint32_t size = state.archive->getResourceSize(resource.index);
+	const size_t reserved = state.memory.acquire((size == 0xFFFFFFFF) ? 0 : size);
+
+	try {
+		std::unique_ptr<Common::SeekableReadStream> stream(state.archive->getResource(resource.index));
+
+		Common::WriteFile file(state.outPath + "/" + name);
+
+		const size_t written = file.writeStream(*stream);
+		file.flush();
+
+		state.extractedSize += written;
+		state.extractedCount++;
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to extract \"%s\"", name.c_str());
+		Common::printException(e, "WARNING: ");
+
+		state.failedCount++;
+	}
+
+	state.memory.release(reserved);
+}
+
+static void saveArchiveCache(Aurora::ArchiveCache &cache, const Common::UString &cacheFile) {
+	try {
+		cache.save(cacheFile);
+	} catch (Common::Exception &e) {
+		e.add("Failed to save archive cache \"%s\"", cacheFile.c_str());
+		Common::printException(e, "WARNING: ");
+	}
+}
+
+void extractArchive(const Common::UString &archive, const Common::UString &outPath) {
+	// Reuse the archive indices of earlier runs
+	const Common::UString cacheFile = Aurora::ArchiveCache::getDefaultCacheFile();
+
+	Aurora::ArchiveCache cache;
+	cache.load(cacheFile);
+
+	// KEY data files are opened through the cache, so the archive has to go first
+	std::unique_ptr<Aurora::Archive> arch;
+
+	try {
+		arch.reset(Aurora::openArchive(archive, &cache));
+	} catch (Common::Exception &e) {
+		e.add("Failed to open archive \"%s\"", archive.c_str());
+		throw;
+	}
+
+	if (!Common::FilePath::createDirectories(outPath) && !Common::FilePath::isDirectory(outPath))
+		throw Common::Exception("Failed to create directory \"%s\"", outPath.c_str());
+
+	const Aurora::Archive::ResourceList &resources = arch->getResources();
+
+	Common::ThreadPool &pool = ThreadPoolMan.getPool();
+
+	std::printf("Extracting %u resources from \"%s\" into \"%s\", using %u threads...\n",
+	            (uint)resources.size(), archive.c_str(), outPath.c_str(), (uint)pool.getThreadCount());
+
+	// We're going to read every resource, so open all KEY data files right away, in parallel
+	Aurora::KEYFile *key = dynamic_cast<Aurora::KEYFile *>(arch.get());
+	if (key)
+		key->prewarmDataFiles(pool);
+
+	std::vector<Common::UString> names;
+	const size_t renamed = getResourceFileNames(resources, names);
+	if (renamed > 0)
+		std::printf("Renaming %u resources with duplicate names\n", (uint)renamed);
+
+	ExtractState state(*arch, outPath);
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	pool.parallelFor(0, resources.size(), [&state, &resources, &names](size_t i) {
+		extractResource(state, resources[i], names[i]);
+	}, Common::CancelToken(), 1);
+
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+	const double seconds = MAX(duration.count(), 0.001);
+
+	std::printf("Extracted %u resources (%s) in %.2fs: %.1f resources/s, %.2f MB/s\n",
+	            (uint)state.extractedCount, Common::FilePath::getHumanReadableSize(state.extractedSize).c_str(),
+	            seconds, state.extractedCount / seconds, (state.extractedSize / (1024.0 * 1024.0)) / seconds);
+
+	// Only now all KEY data files have been opened, and their indices added to the cache
+	saveArchiveCache(cache, cacheFile);
+
+	if (state.failedCount > 0)
+		throw Common::Exception("Failed to extract %u resources", (uint)state.failedCount);
+}
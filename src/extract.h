@@ -0,0 +1,41 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Extracting whole archives from the command line.
+ */
+
+#ifndef EXTRACT_H
+#define EXTRACT_H
+
+#include "src/common/ustring.h"
+
+/** Extract all resources of an archive into a directory.
+ *
+ *  The resources are extracted in parallel on the shared thread pool, while
+ *  limiting the amount of resource data held in memory at any one time.
+ *  Data files of a KEY file are looked for relative to the KEY file itself.
+ *
+ *  @param archive The path of the archive to extract.
+ *  @param outPath The directory to write the resources into.
+ */
+void extractArchive(const Common::UString &archive, const Common::UString &outPath);
+
+#endif // EXTRACT_H
@@ -41,6 +41,8 @@
 #include <QFileDialog>
 #include <QStandardPaths>
 #include <QStatusBar>
+#include <QSocketNotifier>
+#include <QTimer>
 
 #include <boost/scope_exit.hpp>
 
@@ -72,6 +74,9 @@ namespace GUI {
 
 W_OBJECT_IMPL(MainWindow)
 
+/** How often to look for changes in directories that can't be watched, in milliseconds. */
+static const int kRescanInterval = 5000;
+
 MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, const char *path) :
 	QMainWindow(parent), _status(statusBar()), _panelManager(new PanelManager()),
 	_watcher(new QFutureWatcher<void>(this)) {
@@ -144,6 +149,24 @@ MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, co
 		_treeView->setSizePolicy(sp);
 	}
 
+	QObject::connect(_treeView, &QTreeView::collapsed, this, &MainWindow::resourceCollapse);
+
+	// Keep the tree up-to-date with changes on disk, where we can watch for them
+	if (_fileWatcher.isSupported()) {
+		_fileNotifier = new QSocketNotifier(_fileWatcher.getDescriptor(), QSocketNotifier::Read, this);
+
+		// activated() is overloaded in newer Qt versions, so it can't be connected by pointer
+		QObject::connect(_fileNotifier, SIGNAL(activated(int)), this, SLOT(slotFilesChanged()));
+	}
+
+	// Directories that can't be watched are checked for changes regularly instead
+	_rescanTimer = new QTimer(this);
+	_rescanTimer->setInterval(kRescanInterval);
+
+	QObject::connect(_rescanTimer, &QTimer::timeout, this, [this]() {
+		applyFileChanges(_fileWatcher.rescan());
+	});
+
 	// Preview wrapper
 	previewWrapper->setLayout(previewWrapperLayout);
 	previewWrapper->setContentsMargins(0, 0, 0, 0);
@@ -324,6 +347,10 @@ void MainWindow::openFinish() {
 	QObject::connect(_treeView->selectionModel(), &QItemSelectionModel::selectionChanged,
 		this, &MainWindow::resourceSelect);
 
+	// Only now that the tree is complete can we apply changes to it
+	_fileWatcher.watch(_files.getRoot());
+	updateRescanTimer();
+
 	_status.pop();
 }
 
@@ -336,6 +363,9 @@ void MainWindow::close() {
 	_treeModel.reset(nullptr);
 	_currentItem = nullptr;
 
+	_fileWatcher.clear();
+	updateRescanTimer();
+
 	_rootPath = "";
 
 	_actionClose->setEnabled(false);
@@ -353,6 +383,13 @@ void MainWindow::statusPop() {
 
 void MainWindow::resourceSelect(const QItemSelection &selected, const QItemSelection &UNUSED(deselected)) {
 	const QModelIndexList index = _proxyModel->mapSelectionToSource(selected).indexes();
+
+	// The selected item was removed from the tree
+	if (index.isEmpty()) {
+		forgetItem(_currentItem);
+		return;
+	}
+
 	_currentItem = _treeModel->itemFromIndex(index.at(0));
 
 	_panelResourceInfo->update(_currentItem);
@@ -363,6 +400,70 @@ void MainWindow::resourceSelect(const QItemSelection &selected, const QItemSelec
 		_panelManager->setItem(nullptr);
 }
 
+void MainWindow::resourceCollapse(const QModelIndex &index) {
+	// Don't bother continuing to load the members of an archive that was collapsed again
+	if (_treeModel)
+		_treeModel->cancelFetch(_proxyModel->mapToSource(index));
+}
+
+void MainWindow::forgetItem(const ResourceTreeItem *item) {
+	if (!item || (item != _currentItem))
+		return;
+
+	_currentItem = nullptr;
+
+	_panelManager->setItem(nullptr);
+	_panelResourceInfo->clearLabels();
+	_panelResourceInfo->showExportButtons(nullptr);
+}
+
+void MainWindow::slotFilesChanged() {
+	applyFileChanges(_fileWatcher.readChanges());
+}
+
+void MainWindow::applyFileChanges(const std::vector<Common::FileWatcher::Change> &changes) {
+	if (!_treeModel || _files.isEmpty())
+		return;
+
+	/* Only the files and directories that actually changed are read again,
+	 * and only their items in the tree are replaced. */
+
+	for (const Common::FileWatcher::Change &change : changes) {
+		if (change.type == Common::FileWatcher::kChangeDeleted) {
+			if (_files.removePath(change.path))
+				_treeModel->removeEntry(change.path);
+
+			continue;
+		}
+
+		try {
+			const Common::FileTree::Entry *entry = _files.updatePath(change.path);
+			if (!entry) {
+				// Already gone again
+				_treeModel->removeEntry(change.path);
+				continue;
+			}
+
+			_treeModel->updateEntry(*entry);
+
+			// Also watch the directories that were just created
+			_fileWatcher.watch(*entry);
+
+		} catch (Common::Exception &e) {
+			Common::printException(e, "WARNING: ");
+		}
+	}
+
+	updateRescanTimer();
+}
+
+void MainWindow::updateRescanTimer() {
+	if (!_fileWatcher.needsRescan())
+		_rescanTimer->stop();
+	else if (!_rescanTimer->isActive())
+		_rescanTimer->start();
+}
+
 QString constructStatus(const QString &_action, const QString &name, const QString &destination) {
 	return _action + " \"" + name + "\" to \"" + destination + "\"...";
 }
@@ -26,11 +26,13 @@
 #define GUI_MAINWINDOW_H
 
 #include <memory>
+#include <vector>
 
 #include <QMainWindow>
 #include <QFutureWatcher>
 
 #include "src/common/filetree.h"
+#include "src/common/filewatcher.h"
 
 #include "src/gui/resourcetree.h"
 #include "src/gui/proxymodel.h"
@@ -43,6 +45,8 @@ class QTreeView;
 class QGridLayout;
 class QFrame;
 class QTextEdit;
+class QSocketNotifier;
+class QTimer;
 
 namespace GUI {
 
@@ -91,6 +95,9 @@ private /*slots*/:
 	void exportWAV();
 	W_SLOT(exportWAV, W_Access::Private)
 
+	void slotFilesChanged();
+	W_SLOT(slotFilesChanged, W_Access::Private)
+
 private:
 	void open(const QString &path);
 	void openFinish();
@@ -101,6 +108,15 @@ private:
 	void statusPop();
 
 	void resourceSelect(const QItemSelection &selected, const QItemSelection &deselected);
+	void resourceCollapse(const QModelIndex &index);
+
+	/** This item is about to be removed from the tree. Stop showing it. */
+	void forgetItem(const ResourceTreeItem *item);
+
+	/** Update the tree with these changes on disk. */
+	void applyFileChanges(const std::vector<Common::FileWatcher::Change> &changes);
+	/** Start looking for changes in directories we can't watch, if there are any, else stop. */
+	void updateRescanTimer();
 
 	void exportBMUMP3Impl(Common::SeekableReadStream &bmu, Common::WriteStream &mp3);
 	void exportWAVImpl(Sound::AudioStream *sound, Common::WriteStream &wav);
@@ -129,6 +145,10 @@ private:
 
 	Common::FileTree _files;
 
+	Common::FileWatcher _fileWatcher;
+	QSocketNotifier *_fileNotifier { nullptr };
+	QTimer *_rescanTimer { nullptr };
+
 	std::unique_ptr<ResourceTree> _treeModel { nullptr };
 	std::unique_ptr<ProxyModel> _proxyModel { nullptr };
 
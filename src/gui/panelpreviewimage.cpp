@@ -40,6 +40,8 @@
 #include "src/gui/panelpreviewimage.h"
 #include "src/gui/resourcetreeitem.h"
 
+#include "src/images/convert.h"
+
 // FIXME: Zooming is kind of broken.
 
 namespace GUI {
@@ -155,7 +157,7 @@ void PanelPreviewImage::loadImage() {
 
 	convertImage(*image, rgbaData.get());
 
-	QImage qImage(rgbaData.get(), width, height, QImage::Format_RGBA8888, cleanupImage, rgbaData.get());
+	QImage qImage(rgbaData.get(), width, height, QImage::Format_RGBA8888_Premultiplied, cleanupImage, rgbaData.get());
 	rgbaData.release();
 
 	_originalPixmap = QPixmap::fromImage(qImage.mirrored());
@@ -170,77 +172,18 @@ void PanelPreviewImage::convertImage(const Images::Decoder &image, byte *dataOut
 	int32_t width, height;
 	getImageDimensions(image, width, height);
 
+	byte *layerOut = dataOut;
 	for (size_t i = 0; i < image.getLayerCount(); i++) {
 		const Images::Decoder::MipMap &mipMap = image.getMipMap(0, i);
-		const byte *mipMapData = mipMap.data.get();
 
-		uint32_t count = mipMap.width * mipMap.height;
-		while (count-- > 0)
-			writePixel(mipMapData, image.getFormat(), dataOut);
-	}
-}
+		const size_t count = mipMap.width * mipMap.height;
 
-void PanelPreviewImage::writePixel(const byte *&dataIn, Images::PixelFormat format, byte *&dataOut) {
-	switch (format) {
-		case Images::kPixelFormatR8G8B8:
-			*dataOut++ = dataIn[0];
-			*dataOut++ = dataIn[1];
-			*dataOut++ = dataIn[2];
-			*dataOut++ = 0xFF;
-			dataIn    += 3;
-			break;
-
-		case Images::kPixelFormatB8G8R8:
-			*dataOut++ = dataIn[2];
-			*dataOut++ = dataIn[1];
-			*dataOut++ = dataIn[0];
-			*dataOut++ = 0xFF;
-			dataIn    += 3;
-			break;
-
-		case Images::kPixelFormatR8G8B8A8:
-			*dataOut++ = dataIn[0];
-			*dataOut++ = dataIn[1];
-			*dataOut++ = dataIn[2];
-			*dataOut++ = dataIn[3];
-			dataIn    += 4;
-			break;
-
-		case Images::kPixelFormatB8G8R8A8:
-			*dataOut++ = dataIn[2];
-			*dataOut++ = dataIn[1];
-			*dataOut++ = dataIn[0];
-			*dataOut++ = dataIn[3];
-			dataIn    += 4;
-			break;
-
-		case Images::kPixelFormatR5G6B5:
-			{
-				const uint16_t color = READ_LE_UINT16(dataIn);
-
-				*dataOut++ =  color & 0x001F;
-				*dataOut++ = (color & 0x07E0) >>  5;
-				*dataOut++ = (color & 0xF800) >> 11;
-				*dataOut++ = 0xFF;
-				dataIn    += 2;
-			}
-			break;
-
-		case Images::kPixelFormatA1R5G5B5:
-			{
-				const uint16_t color = READ_LE_UINT16(dataIn);
-
-				*dataOut++ =  color & 0x001F;
-				*dataOut++ = (color & 0x03E0) >>  5;
-				*dataOut++ = (color & 0x7C00) >> 10;
-				*dataOut++ = (color & 0x8000) ? 0xFF : 0x00;
-				dataIn    += 2;
-			}
-			break;
-
-		default:
-			throw Common::Exception("Unsupported pixel format: %d", (int) format);
+		Images::convertToRGBA(layerOut, mipMap.data.get(), count, image.getFormat());
+		layerOut += count * 4;
 	}
+
+	// Qt draws with premultiplied alpha, so we might as well do that here in one go
+	Images::premultiplyAlpha(dataOut, dataOut, width * height);
 }
 
 void PanelPreviewImage::getImageDimensions(const Images::Decoder &image, int32_t &width, int32_t &height) {
@@ -22,6 +22,8 @@
  *  Helper class to facilitate sorting of items within the resource tree.
  */
 
+#include <cassert>
+
 #include <QString>
 
 #include "external/verdigris/wobjectdefs.h"
@@ -37,6 +39,15 @@ W_OBJECT_IMPL(ProxyModel)
 bool ProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const {
 	ResourceTree *model = qobject_cast<ResourceTree *>(sourceModel());
 
+	/* Archive members are already sorted by the model, which saves creating their
+	 * items here. That order is by name, then type, and is only right because the
+	 * name is the only column we can sort by. It doesn't need to match the order of
+	 * other items exactly, since archive members only ever have each other as siblings. */
+	assert(sortColumn() == 0);
+
+	if (model->isArchiveMember(left) && model->isArchiveMember(right))
+		return left.row() < right.row();
+
 	ResourceTreeItem *itemLeft = model->itemFromIndex(left);
 	ResourceTreeItem *itemRight = model->itemFromIndex(right);
 
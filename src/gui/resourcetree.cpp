@@ -23,6 +23,8 @@
  */
 
 #include <memory>
+#include <numeric>
+#include <algorithm>
 
 #include <QDir>
 #include <QFuture>
@@ -30,24 +32,21 @@
 #include <QtConcurrentRun>
 #include <QFileInfo>
 #include <QModelIndex>
+#include <QTimer>
 #include <QVariant>
 
-#include <boost/scope_exit.hpp>
-
 #include "external/verdigris/wobjectimpl.h"
 
-#include "src/aurora/biffile.h"
-#include "src/aurora/bzffile.h"
-#include "src/aurora/erffile.h"
+#include "src/aurora/archivecache.h"
 #include "src/aurora/keyfile.h"
-#include "src/aurora/rimfile.h"
-#include "src/aurora/zipfile.h"
-#include "src/aurora/herffile.h"
-#include "src/aurora/ndsrom.h"
+#include "src/aurora/openarchive.h"
 
 #include "src/common/filepath.h"
 #include "src/common/readfile.h"
+#include "src/common/string.h"
 #include "src/common/system.h"
+#include "src/common/threadpool.h"
+#include "src/common/util.h"
 
 #include "src/gui/mainwindow.h"
 #include "src/gui/resourcetree.h"
@@ -58,10 +57,19 @@ namespace GUI {
 
 W_OBJECT_IMPL(ResourceTree)
 
+/** The number of archive members we add to the tree in one go. */
+static const size_t kBatchSize = 4096;
+
 ResourceTree::ResourceTree(MainWindow *mainWindow, QObject *parent) : QAbstractItemModel(parent),
 	_mainWindow(mainWindow) {
 	_root = std::make_unique<ResourceTreeItem>("Filename");
 	_iconProvider = std::make_unique<QFileIconProvider>();
+
+	_archiveCache = std::make_shared<Aurora::ArchiveCache>();
+	_archiveCache->load(Aurora::ArchiveCache::getDefaultCacheFile());
+
+	// Files can change on disk while we have them open. Mapping them would crash us then
+	_archiveCache->setMapFiles(false);
 }
 
 void ResourceTree::populate(const Common::FileTree::Entry &rootEntry) {
@@ -89,32 +97,78 @@ void ResourceTree::populate(const Common::FileTree::Entry &entry, ResourceTreeIt
 }
 
 ResourceTree::~ResourceTree() {
+	// Archives that are still being opened in the background just finish on their own
+	for (auto &load : _loads) {
+		load.second->cancel.cancel();
+		detachLoad(*load.second->job);
+	}
+
+	_loads.clear();
 	_archives.clear();
-	_keyDataFiles.clear();
+
+	try {
+		_archiveCache->save(Aurora::ArchiveCache::getDefaultCacheFile());
+	} catch (Common::Exception &e) {
+		e.add("Failed to save the archive cache");
+		Common::printException(e, "WARNING: ");
+	}
+}
+
+/* The indices of archive members don't point to their own item, but to the
+ * item of their archive, tagged with the lowest bit. That way, Qt can sort
+ * and lay out the archive members without creating an item for each of them.
+ * Their items are created once something actually looks at their data. */
+
+static const quintptr kArchiveMemberTag = 1;
+
+static ResourceTreeItem *getArchiveItem(const QModelIndex &index) {
+	return reinterpret_cast<ResourceTreeItem *>(index.internalId() & ~kArchiveMemberTag);
 }
 
 ResourceTreeItem *ResourceTree::itemFromIndex(const QModelIndex &index) const {
 	if (!index.isValid())
 		return _root.get();
 
+	if (isArchiveMember(index))
+		return getArchiveItem(index)->childAt(index.row());
+
 	return static_cast<ResourceTreeItem *>(index.internalPointer());
 }
 
+bool ResourceTree::isArchiveMember(const QModelIndex &index) const {
+	return index.isValid() && (index.internalId() & kArchiveMemberTag);
+}
+
+QModelIndex ResourceTree::createChildIndex(ResourceTreeItem *parent, int row, int col) const {
+	if (parent->hasArchiveChildren())
+		return createIndex(row, col, reinterpret_cast<quintptr>(parent) | kArchiveMemberTag);
+
+	return createIndex(row, col, parent->childAt(row));
+}
+
 QModelIndex ResourceTree::index(int row, int col, const QModelIndex &parent) const {
-	ResourceTreeItem *item = itemFromIndex(parent)->childAt(row);
+	ResourceTreeItem *parentItem = itemFromIndex(parent);
 
-	if (!item)
+	if ((row < 0) || (row >= parentItem->childCount()))
 		return QModelIndex();
 
-	return createIndex(row, col, item);
+	return createChildIndex(parentItem, row, col);
 }
 
 QModelIndex ResourceTree::parent(const QModelIndex &index) const {
-	ResourceTreeItem *parent = itemFromIndex(index)->getParent();
-	if (parent == _root.get())
+	if (!index.isValid())
+		return QModelIndex();
+
+	ResourceTreeItem *parent = isArchiveMember(index) ? getArchiveItem(index) : itemFromIndex(index)->getParent();
+
+	return createItemIndex(parent);
+}
+
+QModelIndex ResourceTree::createItemIndex(ResourceTreeItem *item) const {
+	if (item == _root.get())
 		return QModelIndex();
 
-	return createIndex(parent->row(), 0, parent);
+	return createChildIndex(item->getParent(), item->row(), 0);
 }
 
 int ResourceTree::rowCount(const QModelIndex &parent) const {
@@ -168,6 +222,34 @@ bool ResourceTree::canFetchMore(const QModelIndex &index) const {
 	return itemFromIndex(index)->isArchive();
 }
 
+/** Order archive resources by name, then type. Resources without a name come last, ordered by hash.
+ *
+ *  This compares the raw names, instead of the names the resources are
+ *  displayed with, so that sorting doesn't need to build a string for each.
+ */
+static bool lessResource(const Aurora::Archive::Resource &a, const Aurora::Archive::Resource &b) {
+	const bool aNamed = a.name[0] != '\0';
+	const bool bNamed = b.name[0] != '\0';
+	if (aNamed != bNamed)
+		return aNamed;
+
+	if (aNamed) {
+		const int compare = Common::String::compareIgnoreCase(a.name, b.name);
+		if (compare != 0)
+			return compare < 0;
+
+	} else if (a.hash != b.hash)
+		return a.hash < b.hash;
+
+	return a.type < b.type;
+}
+
+static void sortResources(const Aurora::Archive::ResourceList &resources, std::vector<uint32_t> &indices) {
+	std::sort(indices.begin(), indices.end(), [&resources](uint32_t a, uint32_t b) {
+		return lessResource(resources[a], resources[b]);
+	});
+}
+
 void ResourceTree::fetchMore(const QModelIndex &index) {
 	if (!index.isValid())
 		return;
@@ -175,193 +257,534 @@ void ResourceTree::fetchMore(const QModelIndex &index) {
 	ResourceTreeItem *item = itemFromIndex(index);
 
 	// We already added the archive members. Nothing to do
-	Archive &archive = item->getArchive();
-	if (archive.addedMembers)
+	if (item->getArchive().addedMembers)
 		return;
 
-	_mainWindow->statusPush(tr("Loading archive") + item->getName() + "...");
-	BOOST_SCOPE_EXIT((&_mainWindow)) {
-		_mainWindow->statusPop();
-	} BOOST_SCOPE_EXIT_END
+	auto load = _loads.find(item);
+	if (load != _loads.end()) {
+		// Still busy. If this was cancelled in the meantime, start over once the background work is done
+		if (load->second->cancel.isCancelled())
+			load->second->restart = true;
+
+		return;
+	}
+
+	startLoad(item);
+}
+
+void ResourceTree::startLoad(ResourceTreeItem *item) {
+	/* Opening the archive, especially a KEY with all its data files, can take
+	 * quite a while. So we do that in the background, and then add the members
+	 * bit by bit, to keep the GUI responsive. */
+
+	ArchiveLoad *load = new ArchiveLoad;
+	_loads.insert(std::make_pair(item, std::unique_ptr<ArchiveLoad>(load)));
+
+	load->item = item;
+
+	// Collect everything the background work needs now, so that it doesn't need to touch our items
+	std::shared_ptr<ArchiveJob> job = std::make_shared<ArchiveJob>();
+	load->job = job;
+
+	job->cancel  = load->cancel;
+	job->tree    = this;
+	job->cache   = _archiveCache;
+	job->dataDir = USTR(_root->childAt(0)->getPath());
+	job->name    = item->getName();
 
 	if (item->getFileType() == Aurora::kFileTypeBIF) {
-		for (ResourceTreeItem *keyItem : _keys) {
-			Aurora::KEYFile *keyFile = static_cast<Aurora::KEYFile *>(getArchive(*keyItem));
-			const auto &dataFiles = keyFile->getDataFileList();
-			for (const Common::UString &dataFile : dataFiles) {
-				if (dataFile.endsWith(USTR(item->getName()))) {
-					archive.data = keyFile;
-					insertItemsFromArchive(archive, *item, index);
+		// The members of a BIF are resources of the KEYs that index it
+		job->dataFilePath = item->getParent()->getName() + "/" + item->getName();
+
+		for (ResourceTreeItem *keyItem : _keys)
+			job->keys.push_back(getArchiveSource(*keyItem));
+
+	} else
+		job->archive = getArchiveSource(*item);
+
+	_mainWindow->statusPush(tr("Loading archive %1...").arg(item->getName()));
+
+	/* This isn't submitted with the load's cancel token: the job checks it
+	 * itself, so that we always hear back, even from a cancelled load. */
+	ThreadPoolMan.getPool().submit([job]() {
+		loadArchiveMembers(*job);
+		notifyLoadFinished(*job);
+	});
+}
+
+void ResourceTree::cancelFetch(const QModelIndex &index) {
+	if (!index.isValid())
+		return;
+
+	auto load = _loads.find(itemFromIndex(index));
+	if (load == _loads.end())
+		return;
+
+	/* If the archive is still being opened, the results are thrown away once
+	 * that's done. Otherwise, we just stop adding members. When expanded again,
+	 * we'll pick up where we left off. */
+
+	load->second->cancel.cancel();
+	load->second->restart = false;
+
+	if (load->second->job->done)
+		_loads.erase(load);
+
+	_mainWindow->statusPop();
+}
+
+void ResourceTree::loadArchiveMembers(ArchiveJob &job) {
+	if (job.cancel.isCancelled())
+		return;
+
+	try {
+		if (!job.dataFilePath.isEmpty()) {
+			const Common::UString dataFilePath = USTR(job.dataFilePath);
+			const Common::UString dataFileName = USTR(job.name);
+
+			for (ArchiveSource &key : job.keys) {
+				Aurora::KEYFile *keyFile = static_cast<Aurora::KEYFile *>(openArchive(key, job));
+				if (!keyFile)
+					return;
+
+				const auto &dataFiles = keyFile->getDataFileList();
+				for (size_t i = 0; i < dataFiles.size(); i++) {
+					if (!dataFiles[i].endsWith(dataFileName))
+						continue;
+
+					job.data = keyFile;
+
+					if (dataFiles[i] != dataFilePath)
+						continue;
+
+					// Only visit the resources of this data file, not the whole KEY
+					const Aurora::KEYFile::DataFileResources indices = keyFile->getDataFileResources(i);
+
+					job.members.emplace_back();
+					job.members.back().archive = keyFile;
+					job.members.back().path    = job.dataFilePath;
+					job.members.back().resources.assign(indices.begin(), indices.end());
 				}
 			}
+
+		} else {
+			job.data = openArchive(job.archive, job);
+			if (!job.data)
+				return;
+
+			job.members.emplace_back();
+			job.members.back().archive = job.data;
+			job.members.back().path    = QString::fromUtf8(job.archive.path.c_str());
+			job.members.back().resources.resize(job.data->getResources().size());
+
+			std::iota(job.members.back().resources.begin(), job.members.back().resources.end(), 0);
 		}
+
+		/* Presort the members, so that the ProxyModel can keep them in row order.
+		 * It would otherwise need to create all their items just to compare them. */
+		for (ArchiveMembers &members : job.members) {
+			if (job.cancel.isCancelled())
+				return;
+
+			sortResources(members.archive->getResources(), members.resources);
+		}
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to load archive \"%s\"", job.name.toStdString().c_str());
+
+		job.failed = true;
+		job.error  = e;
+	} catch (std::exception &e) {
+		job.failed = true;
+		job.error  = Common::Exception(e);
+
+		job.error.add("Failed to load archive \"%s\"", job.name.toStdString().c_str());
+	}
+}
+
+void ResourceTree::notifyLoadFinished(ArchiveJob &job) {
+	job.done = true;
+
+	std::lock_guard<std::mutex> lock(job.treeMutex);
+
+	if (job.tree)
+		QMetaObject::invokeMethod(job.tree, "slotLoadsFinished", Qt::QueuedConnection);
+}
+
+void ResourceTree::detachLoad(ArchiveJob &job) {
+	std::lock_guard<std::mutex> lock(job.treeMutex);
+
+	job.tree = nullptr;
+}
+
+void ResourceTree::slotLoadsFinished() {
+	// Finishing a load can start and remove others, so collect them first
+	std::vector<ResourceTreeItem *> finished;
+	for (const auto &load : _loads)
+		if (load.second->job->done && !load.second->inserting)
+			finished.push_back(load.first);
+
+	for (ResourceTreeItem *item : finished)
+		finishLoad(item);
+}
+
+void ResourceTree::finishLoad(ResourceTreeItem *item) {
+	auto loadIter = _loads.find(item);
+	if (loadIter == _loads.end())
+		return;
+
+	ArchiveLoad &load = *loadIter->second;
+
+	if (load.cancel.isCancelled()) {
+		const bool restart = load.restart;
+
+		_loads.erase(loadIter);
+
+		// We were expanded again while still busy. The archive itself is open now, so this is quick
+		if (restart)
+			startLoad(item);
+
 		return;
 	}
 
-	// Load the archive, if necessary
-	if (!archive.data) {
-		try {
-			archive.data = getArchive(*item);
-		} catch (Common::Exception &e) {
-			// If that fails, print the error and treat this archive as empty
+	if (load.job->failed) {
+		// Print the error and treat this archive as empty
+		Common::printException(load.job->error, "WARNING: ");
 
-			e.add("Failed to load archive \"%s\"", item->getName().toStdString().c_str());
-			Common::printException(e, "WARNING: ");
+		_loads.erase(loadIter);
+		_mainWindow->statusPop();
+		return;
+	}
 
-			return;
-		}
+	item->getArchive().data = load.job->data;
+
+	for (const ArchiveMembers &members : load.job->members)
+		load.total += members.resources.size();
+
+	// When this archive was collapsed while we were adding members, skip those we already added
+	load.inserted  = item->childCount();
+	load.inserting = true;
+
+	insertNextBatch(item);
+}
+
+void ResourceTree::insertNextBatch(ResourceTreeItem *item) {
+	auto loadIter = _loads.find(item);
+	if ((loadIter == _loads.end()) || !loadIter->second->inserting)
+		return;
+
+	ArchiveLoad &load = *loadIter->second;
+
+	// Find the members we stopped at
+	size_t skip = load.inserted;
+
+	auto members = load.job->members.begin();
+	while ((members != load.job->members.end()) && (skip >= members->resources.size()))
+		skip -= (members++)->resources.size();
+
+	if (members != load.job->members.end()) {
+		const size_t count = MIN<size_t>(members->resources.size() - skip, kBatchSize);
+
+		const std::vector<uint32_t> batch(members->resources.begin() + skip,
+		                                  members->resources.begin() + skip + count);
+
+		const int position = item->childCount();
+
+		beginInsertRows(createItemIndex(item), position, position + count - 1);
+		item->addArchiveChildren(members->archive, members->path, batch);
+		endInsertRows();
+
+		load.inserted += count;
+	}
+
+	if (load.inserted < load.total) {
+		_mainWindow->statusPop();
+		_mainWindow->statusPush(tr("Loading archive %1... %2 of %3 resources").arg(item->getName())
+		                        .arg(load.inserted).arg(load.total));
+
+		// Give the GUI a chance to handle other events before we continue
+		QTimer::singleShot(0, this, [this, item]() {
+			insertNextBatch(item);
+		});
+
+		return;
 	}
 
-	insertItemsFromArchive(archive, *item, index);
+	item->getArchive().addedMembers = true;
 
-	archive.addedMembers = true;
+	_loads.erase(loadIter);
+	_mainWindow->statusPop();
 }
 
-bool ResourceTree::hasChildren(const QModelIndex &index) const {
-	if (!index.isValid())
-		return true;
+void ResourceTree::discardLoad(ResourceTreeItem *item) {
+	auto load = _loads.find(item);
+	if (load == _loads.end())
+		return;
 
-	if (itemFromIndex(index)->isArchive())
+	// A cancelled load already gave up its status message
+	if (!load->second->cancel.isCancelled())
+		_mainWindow->statusPop();
+
+	// The background work shares what it needs, so we don't have to wait for it
+	load->second->cancel.cancel();
+	detachLoad(*load->second->job);
+
+	_loads.erase(load);
+}
+
+/** Does this item, or anything below it, take part in resolving the resources of KEYs? */
+static bool affectsKEYs(const ResourceTreeItem &item) {
+	const Aurora::FileType type = item.getFileType();
+	if ((type == Aurora::kFileTypeKEY) || (type == Aurora::kFileTypeBIF) || (type == Aurora::kFileTypeBZF))
 		return true;
 
-	return itemFromIndex(index)->hasChildren();
+	if (item.isDir())
+		for (int i = 0; i < item.childCount(); i++)
+			if (affectsKEYs(*item.childAt(i)))
+				return true;
+
+	return false;
 }
 
-void ResourceTree::insertItemsFromArchive(Archive &archive, const ResourceTreeItem &item,
-                                          const QModelIndex &parentIndex) {
-	QList<ResourceTreeItem *> items;
+/** Collect all KEY and BIF items on disk at or below this item. */
+static void findKEYItems(ResourceTreeItem &item, std::vector<ResourceTreeItem *> &items) {
+	if ((item.getFileType() == Aurora::kFileTypeKEY) || (item.getFileType() == Aurora::kFileTypeBIF))
+		items.push_back(&item);
 
-	if (item.getFileType() == Aurora::kFileTypeBIF) {
-		const QString localArchivePath = item.getParent()->getName() + "/" + item.getName();
-		auto resList = static_cast<Aurora::KEYFile *>(archive.data)->getResourceListForDataFile(localArchivePath.toStdString().c_str());
-		for (auto res : resList) {
-			items.push_back(new ResourceTreeItem(archive.data, localArchivePath, *res));
-		}
-	} else {
-		auto &resources = archive.data->getResources();
-		for (auto r = resources.begin(); r != resources.end(); ++r) {
-			items.push_back(new ResourceTreeItem(archive.data, item.getPath(), *r));
+	if (item.isDir())
+		for (int i = 0; i < item.childCount(); i++)
+			findKEYItems(*item.childAt(i), items);
+}
+
+ResourceTreeItem *ResourceTree::findItem(const boost::filesystem::path &path) const {
+	if (_root->childCount() == 0)
+		return nullptr;
+
+	ResourceTreeItem *item = _root->childAt(0);
+
+	// The path needs to be below our root
+	const boost::filesystem::path rootPath(item->getPath().toStdString());
+
+	boost::filesystem::path::const_iterator p = path.begin();
+	for (boost::filesystem::path::const_iterator r = rootPath.begin(); r != rootPath.end(); ++r, ++p)
+		if ((p == path.end()) || (*p != *r))
+			return nullptr;
+
+	// Walk down the directories, one path element at a time
+	for (; p != path.end(); ++p) {
+		if (!item->isDir())
+			return nullptr;
+
+		const QString name = QString::fromUtf8(p->string().c_str());
+
+		ResourceTreeItem *child = nullptr;
+		for (int i = 0; (i < item->childCount()) && !child; i++)
+			if (item->childAt(i)->getName() == name)
+				child = item->childAt(i);
+
+		if (!child)
+			return nullptr;
+
+		item = child;
+	}
+
+	return item;
+}
+
+void ResourceTree::updateEntry(const Common::FileTree::Entry &entry) {
+	ResourceTreeItem *parent = findItem(entry.path.parent_path());
+	if (!parent || !parent->isDir())
+		return;
+
+	// A changed file might be something else entirely now, so we start over with its item
+	const QString name = QString::fromUtf8(entry.name.c_str());
+	for (int i = 0; i < parent->childCount(); i++) {
+		if (parent->childAt(i)->getName() == name) {
+			removeItem(parent->childAt(i));
+			break;
 		}
 	}
-	archive.addedMembers = true;
 
-	insertItems(0, items, parentIndex);
+	ResourceTreeItem *item = new ResourceTreeItem(entry);
+	populate(entry, item);
+
+	// Stop the loads that used the KEYs as they were, before the new ones are added
+	if (affectsKEYs(*item))
+		invalidateKEYs();
+
+	if (item->getFileType() == Aurora::kFileTypeKEY)
+		_keys.push_back(item);
+
+	QList<ResourceTreeItem *> items;
+	items << item;
+
+	insertItems(parent->childCount(), items, createItemIndex(parent));
 }
 
-void ResourceTree::insertItems(size_t position, QList<ResourceTreeItem*> &items, const QModelIndex &parent) {
-	ResourceTreeItem *parentItem = itemFromIndex(parent);
+void ResourceTree::removeEntry(const boost::filesystem::path &path) {
+	ResourceTreeItem *item = findItem(path);
+	if (!item || (item->getParent() == _root.get()))
+		return;
 
-	beginInsertRows(parent, position, position + items.size() - 1);
+	removeItem(item);
+}
 
-	for (const auto &item : items)
-	{
-		parentItem->addChild(item);
+void ResourceTree::removeItem(ResourceTreeItem *item) {
+	if (affectsKEYs(*item))
+		invalidateKEYs();
+
+	releaseItem(item);
+
+	ResourceTreeItem *parent = item->getParent();
+	const int row = item->row();
+
+	beginRemoveRows(createItemIndex(parent), row, row);
+	parent->removeChild(row);
+	endRemoveRows();
+}
+
+void ResourceTree::releaseItem(ResourceTreeItem *item) {
+	// Archive members can be archives themselves, reading from their parent archive
+	for (int i = 0; i < item->childCount(); i++) {
+		ResourceTreeItem *child = item->createdChildAt(i);
+		if (child)
+			releaseItem(child);
 	}
 
-	endInsertRows();
+	discardLoad(item);
+
+	_mainWindow->forgetItem(item);
+
+	_keys.erase(std::remove(_keys.begin(), _keys.end(), item), _keys.end());
+
+	_archives.erase(item->getPath());
 }
 
-Aurora::Archive *ResourceTree::getArchive(ResourceTreeItem &item) {
-	auto archiveIter = _archives.find(item.getPath());
-	if (archiveIter != _archives.end())
-		return archiveIter->second.get();
+void ResourceTree::clearArchive(ResourceTreeItem *item) {
+	for (int i = 0; i < item->childCount(); i++) {
+		ResourceTreeItem *child = item->createdChildAt(i);
+		if (child)
+			releaseItem(child);
+	}
 
-	std::unique_ptr<Common::SeekableReadStream> stream(item.getResourceData());
+	discardLoad(item);
 
-	Aurora::Archive *arch = nullptr;
-	switch (item.getFileType()) {
-		case Aurora::kFileTypeZIP:
-			arch = new Aurora::ZIPFile(stream.release());
-			break;
+	if (item->childCount() > 0) {
+		beginRemoveRows(createItemIndex(item), 0, item->childCount() - 1);
+		item->clearChildren();
+		endRemoveRows();
+	}
 
-		case Aurora::kFileTypeERF:
-		case Aurora::kFileTypeMOD:
-		case Aurora::kFileTypeNWM:
-		case Aurora::kFileTypeSAV:
-		case Aurora::kFileTypeHAK:
-			arch = new Aurora::ERFFile(stream.release());
-			break;
+	item->getArchive() = Archive();
 
-		case Aurora::kFileTypeRIM: {
-			const bool isERF = Aurora::ERFFile::isERFID(stream->readUint32BE());
-			stream->seek(0);
+	_archives.erase(item->getPath());
+}
 
-			if (isERF)
-				arch = new Aurora::ERFFile(stream.release());
-			else
-				arch = new Aurora::RIMFile(stream.release());
-			break;
-		}
+void ResourceTree::invalidateKEYs() {
+	/* KEYs look for their data files when they're opened, and BIFs show the
+	 * resources the KEYs have in them. So when any of these files change, we
+	 * have to open all KEYs again, and read the members of all BIFs again. */
 
-		case Aurora::kFileTypeKEY: {
-			Aurora::KEYFile *key = new Aurora::KEYFile(stream.release());
-			loadKEYDataFiles(*key);
+	if (_root->childCount() == 0)
+		return;
 
-			arch = key;
-			break;
-		}
+	std::vector<ResourceTreeItem *> items;
+	findKEYItems(*_root->childAt(0), items);
 
-		case Aurora::kFileTypeHERF:
-			arch = new Aurora::HERFFile(stream.release());
-			break;
+	// Loads of BIFs use all KEYs, so their results are just as outdated. Stop all of them first
+	for (ResourceTreeItem *item : items)
+		discardLoad(item);
 
-		case Aurora::kFileTypeNDS:
-			arch = new Aurora::NDSFile(stream.release());
-			break;
+	for (ResourceTreeItem *item : items)
+		clearArchive(item);
+}
 
-		default:
-			throw Common::Exception("Invalid archive file \"%s\"", item.getPath().toStdString().c_str());
-	}
+bool ResourceTree::hasChildren(const QModelIndex &index) const {
+	if (!index.isValid())
+		return true;
 
-	_archives.insert(std::make_pair(item.getPath(), std::unique_ptr<Aurora::Archive>(arch)));
-	return arch;
+	if (itemFromIndex(index)->isArchive())
+		return true;
+
+	return itemFromIndex(index)->hasChildren();
 }
 
-Aurora::KEYDataFile *ResourceTree::getKEYDataFile(const QString &file) {
-	auto keyDataFileIter = _keyDataFiles.find(file);
-	if (keyDataFileIter != _keyDataFiles.end())
-		return keyDataFileIter->second.get();
+void ResourceTree::insertItems(size_t position, QList<ResourceTreeItem*> &items, const QModelIndex &parent) {
+	ResourceTreeItem *parentItem = itemFromIndex(parent);
 
-	Common::UString path = Common::FilePath::normalize(USTR(_root->childAt(0)->getPath() + "/" + file));
-	if (path.empty())
-		throw Common::Exception("No such file or directory \"%s\"", (_root->getPath() + "/" + file).toStdString().c_str());
+	beginInsertRows(parent, position, position + items.size() - 1);
+
+	for (const auto &item : items)
+	{
+		parentItem->addChild(item);
+	}
 
-	Aurora::FileType type = TypeMan.getFileType(file.toStdString().c_str());
+	endInsertRows();
+}
 
-	Aurora::KEYDataFile *dataFile = nullptr;
-	switch (type) {
-		case Aurora::kFileTypeBIF:
-			dataFile = new Aurora::BIFFile(new Common::ReadFile(path));
-			break;
+ResourceTree::ArchiveSource ResourceTree::getArchiveSource(ResourceTreeItem &item) {
+	ArchiveSource source;
 
-		case Aurora::kFileTypeBZF:
-			dataFile = new Aurora::BZFFile(new Common::ReadFile(path));
-			break;
+	std::shared_ptr<ArchiveSlot> &slot = _archives[item.getPath()];
+	if (!slot)
+		slot = std::make_shared<ArchiveSlot>();
 
-		default:
-			throw Common::Exception("Unknown KEY data file type %d\n", type);
+	source.slot = slot;
+	source.path = USTR(item.getPath());
+	source.type = item.getFileType();
+
+	// Archive files on disk can be opened with their index cached by an earlier session
+	source.onDisk = item.getSource() == kSourceFile;
+
+	if (item.getSource() == kSourceArchiveFile) {
+		source.owner = findArchiveSlot(item.getArchive().owner);
+		source.index = item.getArchive().index;
 	}
 
-	_keyDataFiles.insert(std::make_pair(file, std::unique_ptr<Aurora::KEYDataFile>(dataFile)));
-	return dataFile;
+	return source;
 }
 
-void ResourceTree::loadKEYDataFiles(Aurora::KEYFile &key) {
-	const std::vector<Common::UString> dataFiles = key.getDataFileList();
-	for (size_t i = 0; i < dataFiles.size(); i++) {
-		try {
-			_mainWindow->statusPush(tr("Loading data file") + QString::fromUtf8(dataFiles[i].c_str()) + "...");
+std::shared_ptr<ResourceTree::ArchiveSlot> ResourceTree::findArchiveSlot(const Aurora::Archive *archive) const {
+	for (const auto &slot : _archives)
+		if (slot.second->opened == archive)
+			return slot.second;
 
-			Aurora::KEYDataFile *dataFile = getKEYDataFile(QString::fromUtf8(dataFiles[i].c_str()));
-			key.addDataFile(i, dataFile);
+	return nullptr;
+}
 
-			_mainWindow->statusPop();
-		} catch (Common::Exception &e) {
-			e.add("Failed to load KEY data file \"%s\"", dataFiles[i].c_str());
-			_mainWindow->statusPop();
-			Common::printException(e, "WARNING: ");
-		}
+Aurora::Archive *ResourceTree::openArchive(ArchiveSource &source, ArchiveJob &job) {
+	ArchiveSlot &slot = *source.slot;
+
+	// If another load is opening the same archive right now, wait for it and use theirs
+	std::lock_guard<std::mutex> lock(slot.mutex);
+	if (slot.archive)
+		return slot.archive.get();
+
+	Aurora::Archive *archive = nullptr;
+	if (source.onDisk) {
+		archive = Aurora::openArchive(source.path, job.cache.get(), job.dataDir, &job.cancel);
+
+	} else {
+		if (!source.owner || !source.owner->opened)
+			throw Common::Exception("Archive \"%s\" is not within an open archive", source.path.c_str());
+
+		Aurora::Archive *owner = source.owner->opened;
+		archive = Aurora::openArchive(owner->getResource(source.index), source.type,
+		                              job.cache.get(), job.dataDir, &job.cancel);
 	}
+
+	if (!archive)
+		return nullptr;
+
+	slot.archive.reset(archive);
+	slot.opened = archive;
+
+	// Open the KEY data files in the background, so they're likely ready once they're needed
+	Aurora::KEYFile *key = dynamic_cast<Aurora::KEYFile *>(archive);
+	if (key)
+		key->prewarmDataFiles(ThreadPoolMan.getPool());
+
+	return archive;
 }
 
 } // End of namespace GUI
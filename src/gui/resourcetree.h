@@ -25,6 +25,9 @@
 #ifndef GUI_RESOURCETREE_H
 #define GUI_RESOURCETREE_H
 
+#include <map>
+#include <atomic>
+#include <vector>
 #include <memory>
 
 #include <QAbstractItemModel>
@@ -35,7 +38,10 @@
 #include "src/aurora/archive.h"
 #include "src/aurora/util.h"
 
+#include "src/common/error.h"
+#include "src/common/mutex.h"
 #include "src/common/filetree.h"
+#include "src/common/threadpool.h"
 
 #include "src/gui/resourcetreeitem.h"
 
@@ -55,7 +61,7 @@ namespace Images {
 
 namespace Aurora {
 	class KEYFile;
-	class KEYDataFile;
+	class ArchiveCache;
 }
 
 namespace GUI {
@@ -73,16 +79,19 @@ public:
 	void populate(const Common::FileTree::Entry &rootEntry);
 	void populate(const Common::FileTree::Entry &rootEntry, ResourceTreeItem *parent);
 
-	void insertItemsFromArchive(Archive &archive, const ResourceTreeItem &item, const QModelIndex &parentIndex);
 	void insertItems(size_t position, QList<ResourceTreeItem *> &items, const QModelIndex &parentIndex);
 
-	Aurora::Archive     *getArchive(ResourceTreeItem &item);
-	Aurora::KEYDataFile *getKEYDataFile(const QString &file);
-	void                loadKEYDataFiles(Aurora::KEYFile &key);
+	/** Update the item of this file tree entry, after it was created or changed on disk. */
+	void updateEntry(const Common::FileTree::Entry &entry);
+	/** Remove the item of this path, after it was removed from disk. */
+	void removeEntry(const boost::filesystem::path &path);
 
 	/** Return the item in the tree structure that corresponds to the given index. */
 	ResourceTreeItem *itemFromIndex(const QModelIndex &index) const;
 
+	/** Is this index a member of an archive? Its item might not have been created yet. */
+	bool isArchiveMember(const QModelIndex &index) const;
+
 	// Model functions
 
 	/** Return the index if it exists, else create it. */
@@ -112,16 +121,146 @@ public:
 	/** Add children to the given index. */
 	void fetchMore(const QModelIndex &index);
 
+	/** Stop adding children to the given index, if we're still busy doing that. */
+	void cancelFetch(const QModelIndex &index);
+
+private /*slots*/:
+	/** Finish all archive loads whose background work is done. */
+	void slotLoadsFinished();
+	W_SLOT(slotLoadsFinished, W_Access::Private)
+
 private:
 	std::unique_ptr<ResourceTreeItem> _root { nullptr };
 	MainWindow *_mainWindow { nullptr };
 
 	std::unique_ptr<QFileIconProvider> _iconProvider { nullptr };
 
+	/** All KEY items. Only used on the GUI thread, background loads get the archives they need up front. */
 	std::vector<ResourceTreeItem *> _keys;
 
-	std::map<QString, std::unique_ptr<Aurora::Archive> > _archives;
-	std::map<QString, std::unique_ptr<Aurora::KEYDataFile> > _keyDataFiles;
+	/** An archive, opened by the first background load that needs it. */
+	struct ArchiveSlot {
+		std::mutex mutex; ///< Held while the archive is being opened.
+		std::unique_ptr<Aurora::Archive> archive;
+
+		std::atomic<Aurora::Archive *> opened { nullptr }; ///< The archive, once it's open.
+	};
+
+	/** Where a background load finds an archive. */
+	struct ArchiveSource {
+		std::shared_ptr<ArchiveSlot> slot;
+
+		Common::UString path;
+		Aurora::FileType type { Aurora::kFileTypeNone };
+
+		bool onDisk { false };
+
+		std::shared_ptr<ArchiveSlot> owner; ///< For an archive within an archive, the one it's in.
+		uint32_t index { 0xFFFFFFFF };      ///< For an archive within an archive, its index there.
+	};
+
+	/** The members of an archive, to be added as children of an item. */
+	struct ArchiveMembers {
+		Aurora::Archive *archive { nullptr };
+		QString path;
+
+		std::vector<uint32_t> resources; ///< Indices into the archive's resource list, sorted by name.
+	};
+
+	/** The part of an archive load done in the background.
+	 *
+	 *  Everything it needs is collected on the GUI thread beforehand, and
+	 *  it shares ownership of its archives. So it can simply be abandoned
+	 *  once cancelled, even after the ResourceTree is long gone.
+	 */
+	struct ArchiveJob {
+		Common::CancelToken cancel;
+
+		std::mutex treeMutex;          ///< Held while telling the tree that we're done.
+		ResourceTree *tree { nullptr }; ///< The tree to tell, or nullptr once it's not interested anymore.
+
+		std::atomic<bool> done { false };
+
+		std::shared_ptr<Aurora::ArchiveCache> cache;
+		Common::UString dataDir; ///< Where KEYs look for their data files.
+
+		QString name;
+		ArchiveSource archive; ///< The archive to load, unless it's a BIF.
+
+		/** For a BIF, the KEYs that might index it, and its path relative to them. */
+		std::vector<ArchiveSource> keys;
+		QString dataFilePath;
+
+		Aurora::Archive *data { nullptr };
+		std::vector<ArchiveMembers> members;
+
+		bool failed { false };
+		Common::Exception error;
+	};
+
+	/** An archive that's opened in the background, and then has its members added bit by bit. */
+	struct ArchiveLoad {
+		ResourceTreeItem *item { nullptr };
+
+		Common::CancelToken cancel;
+
+		bool restart { false }; ///< Expanded again after being cancelled?
+
+		std::shared_ptr<ArchiveJob> job;
+
+		size_t total { 0 };
+		size_t inserted { 0 };
+
+		bool inserting { false }; ///< Done in the background, now adding members?
+	};
+
+	std::map<QString, std::shared_ptr<ArchiveSlot> > _archives;
+
+	std::map<ResourceTreeItem *, std::unique_ptr<ArchiveLoad> > _loads;
+
+	/** Indices of the archives opened in this and earlier sessions. */
+	std::shared_ptr<Aurora::ArchiveCache> _archiveCache;
+
+	/** Return the index of a child of this item, without creating the child's item. */
+	QModelIndex createChildIndex(ResourceTreeItem *parent, int row, int col) const;
+	/** Return the index of this item. */
+	QModelIndex createItemIndex(ResourceTreeItem *item) const;
+
+	/** Start opening the archive of this item in the background. */
+	void startLoad(ResourceTreeItem *item);
+	/** Collect where the archive of this item can be found. */
+	ArchiveSource getArchiveSource(ResourceTreeItem &item);
+	/** Find the slot of this open archive. */
+	std::shared_ptr<ArchiveSlot> findArchiveSlot(const Aurora::Archive *archive) const;
+
+	/** Open the archive of this source, unless that's already done. Runs in the background.
+	 *
+	 *  @return The archive, or nullptr if the job was cancelled.
+	 */
+	static Aurora::Archive *openArchive(ArchiveSource &source, ArchiveJob &job);
+	/** Open an archive and find its members. Runs in the background. */
+	static void loadArchiveMembers(ArchiveJob &job);
+	/** Tell the tree that the background work of this job is done. */
+	static void notifyLoadFinished(ArchiveJob &job);
+	/** Stop the background work of this job from telling us when it's done. */
+	static void detachLoad(ArchiveJob &job);
+	/** The archive of this item has been opened, now add its members. */
+	void finishLoad(ResourceTreeItem *item);
+	/** Add the next batch of archive members to this item. */
+	void insertNextBatch(ResourceTreeItem *item);
+	/** Stop opening the archive of this item, if we're still busy doing that. */
+	void discardLoad(ResourceTreeItem *item);
+
+	/** Find the item of this path on disk, or return nullptr. */
+	ResourceTreeItem *findItem(const boost::filesystem::path &path) const;
+	/** Remove this item, together with everything below it. */
+	void removeItem(ResourceTreeItem *item);
+	/** Close the archives and stop the loads of this item and everything below it. */
+	void releaseItem(ResourceTreeItem *item);
+	/** Remove the members of this archive item, so that they're read again when expanded. */
+	void clearArchive(ResourceTreeItem *item);
+	/** Start over with all KEYs and BIFs, after one of their files changed. */
+	void invalidateKEYs();
 };
 
 } // End of namespace GUI
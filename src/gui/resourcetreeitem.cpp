@@ -25,6 +25,7 @@
 #include <cassert>
 
 #include <memory>
+#include <algorithm>
 
 #include "src/common/strutil.h"
 #include "src/common/readfile.h"
@@ -39,8 +40,9 @@ ResourceTreeItem::ResourceTreeItem(const Common::FileTree::Entry &entry) :
 
 	_path = QString::fromUtf8(entry.path.string().c_str());
 
+	// The size was already looked up when reading the directory
 	if (_source == kSourceFile)
-		_size = Common::FilePath::getFileSize(entry.path.generic_string().c_str());
+		_size = entry.size;
 
 	if (_source != kSourceDirectory) {
 		_fileType = TypeMan.getFileType(_name.toStdString());
@@ -52,22 +54,15 @@ ResourceTreeItem::ResourceTreeItem(const Common::FileTree::Entry &entry) :
 
 ResourceTreeItem::ResourceTreeItem(Aurora::Archive *archive, const QString &archivePath,
                                    const Aurora::Archive::Resource &resource) :
-	_name(QString::fromUtf8(TypeMan.setFileType(resource.name, resource.type).c_str())),
+	_name(QString::fromUtf8(getResourceName(resource).c_str())),
 	_source(kSourceArchiveFile) {
 
-	Common::UString resName = resource.name;
-	if (resName.empty())
-		resName = Common::composeString(resource.hash);
-
-	resName = TypeMan.setFileType(resName, resource.type);
-	_name = QString::fromUtf8(resName.c_str());
-
 	_archive.owner = archive;
 	_archive.index = resource.index;
 
 	_path = archivePath + "/" + _name;
 
-	_size = archive->getResourceSize(resource.index);
+	_triedSize = false;
 
 	if (_source != kSourceDirectory) {
 		_fileType = TypeMan.getFileType(_name.toStdString());
@@ -80,21 +75,104 @@ ResourceTreeItem::ResourceTreeItem(Aurora::Archive *archive, const QString &arch
 ResourceTreeItem::ResourceTreeItem(const QString &data) : _name(data) {
 }
 
+Common::UString ResourceTreeItem::getResourceName(const Aurora::Archive::Resource &resource) {
+	Common::UString resName = resource.name;
+	if (resName.empty())
+		resName = Common::composeString(resource.hash);
+
+	return TypeMan.setFileType(resName, resource.type);
+}
+
 void ResourceTreeItem::addChild(ResourceTreeItem *child) {
+	assert(!_archiveChildren);
+
 	child->setParent(this);
+	child->_row = _children.size();
+
 	_children.push_back(std::unique_ptr<ResourceTreeItem>(child));
 }
 
 bool ResourceTreeItem::insertChild(size_t position, ResourceTreeItem *child) {
+	assert(!_archiveChildren);
+
 	if (position >= _children.size())
 		return false;
 
+	child->setParent(this);
 	_children.insert(_children.begin() + position, std::unique_ptr<ResourceTreeItem>(child));
 
+	// Everything from here on moved down by one row
+	for (size_t i = position; i < _children.size(); i++)
+		_children[i]->_row = i;
+
 	return true;
 }
 
+void ResourceTreeItem::removeChild(int row) {
+	assert(!_archiveChildren);
+	assert((row >= 0) && ((size_t) row < _children.size()));
+
+	_children.erase(_children.begin() + row);
+
+	// Everything from here on moved up by one row
+	for (size_t i = row; i < _children.size(); i++)
+		_children[i]->_row = i;
+}
+
+void ResourceTreeItem::clearChildren() {
+	_children.clear();
+	_archiveChildren.reset();
+}
+
+void ResourceTreeItem::addArchiveChildren(Aurora::Archive *archive, const QString &archivePath,
+                                          const std::vector<uint32_t> &resources) {
+
+	assert(_children.empty() || _archiveChildren);
+
+	if (!_archiveChildren)
+		_archiveChildren = std::make_unique<ArchiveChildren>();
+
+	std::vector<ArchiveChildren::Segment> &segments = _archiveChildren->segments;
+	if (segments.empty() || (segments.back().archive != archive) || !(segments.back().path == archivePath)) {
+		segments.emplace_back();
+
+		segments.back().archive  = archive;
+		segments.back().path     = archivePath;
+		segments.back().firstRow = _children.size();
+	}
+
+	_archiveChildren->resources.insert(_archiveChildren->resources.end(), resources.begin(), resources.end());
+	_children.resize(_archiveChildren->resources.size());
+}
+
+bool ResourceTreeItem::hasArchiveChildren() const {
+	return _archiveChildren != nullptr;
+}
+
 ResourceTreeItem *ResourceTreeItem::childAt(int row) const {
+	std::unique_ptr<ResourceTreeItem> &child = _children[row];
+
+	// Create the items of archive members only once they're actually needed
+	if (!child && _archiveChildren) {
+		const std::vector<ArchiveChildren::Segment> &segments = _archiveChildren->segments;
+
+		auto segment = std::upper_bound(segments.begin(), segments.end(), (size_t) row,
+		                                [](size_t r, const ArchiveChildren::Segment &s) { return r < s.firstRow; });
+		--segment;
+
+		const Aurora::Archive::ResourceList &resources = segment->archive->getResources();
+
+		child = std::make_unique<ResourceTreeItem>(segment->archive, segment->path,
+		                                           resources[_archiveChildren->resources[row]]);
+
+		child->_parent = const_cast<ResourceTreeItem *>(this);
+		child->_row    = row;
+	}
+
+	return child.get();
+}
+
+ResourceTreeItem *ResourceTreeItem::createdChildAt(int row) const {
 	return _children[row].get();
 }
 
@@ -103,13 +181,7 @@ int ResourceTreeItem::childCount() const {
 }
 
 int ResourceTreeItem::row() const {
-	if (_parent) {
-		for (size_t i = 0; i < _parent->_children.size(); i++) {
-			if (_parent->_children[i].get() == this)
-				return i;
-		}
-	}
-	return 0;
+	return _row;
 }
 
 ResourceTreeItem *ResourceTreeItem::getParent() const {
@@ -137,6 +209,13 @@ const QString &ResourceTreeItem::getPath() const {
 }
 
 qint64 ResourceTreeItem::getSize() const {
+	if (_triedSize)
+		return _size;
+
+	_triedSize = true;
+
+	_size = _archive.owner->getResourceSize(_archive.index);
+
 	return _size;
 }
 
@@ -159,6 +238,7 @@ Common::SeekableReadStream *ResourceTreeItem::getResourceData() const {
 				throw Common::Exception("Can't get file data of a directory");
 
 			case kSourceFile:
+				// Not mapped, so that a file changing on disk is a read error instead of a crash
 				return new Common::ReadFile(_path.toStdString().c_str());
 
 			case kSourceArchiveFile:
@@ -196,26 +276,29 @@ Images::Decoder *ResourceTreeItem::getImage() const {
 }
 
 Images::Decoder *ResourceTreeItem::getImage(Common::SeekableReadStream &res, Aurora::FileType type) const {
+	/* We only ever show and export the first mip map of each layer, so
+	 * the others are only decompressed should they be needed after all. */
+
 	Images::Decoder *img = nullptr;
 	switch (type) {
 		case Aurora::kFileTypeDDS:
-			img = new Images::DDS(res);
+			img = new Images::DDS(res, true);
 			break;
 
 		case Aurora::kFileTypeTPC:
-			img = new Images::TPC(res);
+			img = new Images::TPC(res, true);
 			break;
 
 		// TXB may be actually TPC
 		case Aurora::kFileTypeTXB:
 		case Aurora::kFileTypeTXB2:
 			try {
-				img = new Images::TXB(res);
+				img = new Images::TXB(res, true);
 			} catch (Common::Exception &e1) {
 
 				try {
 					res.seek(0);
-					img = new Images::TPC(res);
+					img = new Images::TPC(res, true);
 
 				} catch (Common::Exception &e2) {
 					e1.add(e2);
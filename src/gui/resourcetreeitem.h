@@ -26,6 +26,7 @@
 #define GUI_RESOURCETREEITEM_H
 
 #include <memory>
+#include <vector>
 
 #include <QString>
 
@@ -86,8 +87,26 @@ public:
 	ResourceTreeItem *childAt(int row) const;
 	ResourceTreeItem *getParent() const;
 	void             addChild(ResourceTreeItem *child);
+	void             removeChild(int row);
+	void             clearChildren();
 	void             setParent(ResourceTreeItem *parent);
 
+	/** Return the child in this row, or nullptr if its item hasn't been created yet. */
+	ResourceTreeItem *createdChildAt(int row) const;
+
+	/** Add children backed by these resources of an archive.
+	 *
+	 *  Each resource index is a position within the archive's resource list.
+	 *  The items for these children are only created once they're accessed.
+	 */
+	void addArchiveChildren(Aurora::Archive *archive, const QString &archivePath,
+	                        const std::vector<uint32_t> &resources);
+	/** Are our children backed by the resources of an archive? */
+	bool hasArchiveChildren() const;
+
+	/** Return the name an archive resource is displayed with. */
+	static Common::UString getResourceName(const Aurora::Archive::Resource &resource);
+
 	// Both model and file info
 	const QString &getName() const; ///< Doubles as filename.
 
@@ -108,12 +127,31 @@ public:
 	uint64_t                    getSoundDuration() const;
 
 private:
+	/** The resources backing the children of an archive item. */
+	struct ArchiveChildren {
+		/** A run of rows backed by the same archive. */
+		struct Segment {
+			Aurora::Archive *archive { nullptr };
+			QString path;
+
+			size_t firstRow { 0 };
+		};
+
+		std::vector<Segment> segments;
+		std::vector<uint32_t> resources; ///< Index into the archive's resource list for each row.
+	};
+
 	ResourceTreeItem *_parent { nullptr };
-	std::vector<std::unique_ptr<ResourceTreeItem> > _children;
+	mutable std::vector<std::unique_ptr<ResourceTreeItem> > _children;
+	std::unique_ptr<ArchiveChildren> _archiveChildren;
+	int _row { 0 }; ///< Our index within our parent's children.
 	QString _name; ///< The filename. This is what the tree view displays.
 
 	QString _path;
-	size_t _size { Common::kFileInvalid };
+	mutable size_t _size { Common::kFileInvalid };
+
+	/** Archive members look up their size on first use, so that KEY data files can stay closed until then. */
+	mutable bool _triedSize { true };
 
 	mutable bool _triedDuration { false };
 	mutable uint64_t _duration { Sound::RewindableAudioStream::kInvalidLength };
@@ -0,0 +1,293 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Row-at-a-time pixel format conversion.
+ */
+
+#include <cstring>
+
+#include "src/common/util.h"
+#include "src/common/endianness.h"
+#include "src/common/error.h"
+
+#include "src/images/convert.h"
+
+#if defined(__SSE2__) && defined(PHAETHON_LITTLE_ENDIAN)
+	#include <emmintrin.h>
+
+	#define PHAETHON_CONVERT_SSE2 1
+#else
+	#define PHAETHON_CONVERT_SSE2 0
+#endif
+
+namespace Images {
+
+/* The SSE2 loops handle 4 pixels at a time, and leave the rest to the
+ * scalar loops after them. With the pixels loaded as little-endian 32-bit
+ * values, the first byte of a pixel is its least significant byte. */
+
+#if PHAETHON_CONVERT_SSE2
+/** Load the 4 3-byte pixels at src into 4 lanes. Reads 1 byte past the 4th pixel. */
+static inline __m128i loadRGB(const byte *src) {
+	return _mm_setr_epi32(READ_UINT32(src), READ_UINT32(src + 3), READ_UINT32(src + 6), READ_UINT32(src + 9));
+}
+
+/** Swap the first and third byte of each 32-bit lane. */
+static inline __m128i swapRB(__m128i v) {
+	const __m128i maskGA = _mm_set1_epi32(0xFF00FF00);
+	const __m128i maskR  = _mm_set1_epi32(0x000000FF);
+
+	return _mm_or_si128(_mm_and_si128(v, maskGA),
+	                    _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), maskR),
+	                                 _mm_slli_epi32(_mm_and_si128(v, maskR), 16)));
+}
+#endif
+
+void convertRGBToRGBA(byte *dest, const byte *src, size_t count) {
+	size_t i = 0;
+
+#if PHAETHON_CONVERT_SSE2
+	const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+	// We need one more pixel after each block, for the over-read
+	for (; (i + 5) <= count; i += 4, src += 12, dest += 16)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_or_si128(loadRGB(src), alpha));
+#endif
+
+	for (; i < count; i++, src += 3, dest += 4) {
+		dest[0] = src[0];
+		dest[1] = src[1];
+		dest[2] = src[2];
+		dest[3] = 0xFF;
+	}
+}
+
+void convertBGRToRGBA(byte *dest, const byte *src, size_t count) {
+	size_t i = 0;
+
+#if PHAETHON_CONVERT_SSE2
+	const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+	// We need one more pixel after each block, for the over-read
+	for (; (i + 5) <= count; i += 4, src += 12, dest += 16)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_or_si128(swapRB(loadRGB(src)), alpha));
+#endif
+
+	for (; i < count; i++, src += 3, dest += 4) {
+		dest[0] = src[2];
+		dest[1] = src[1];
+		dest[2] = src[0];
+		dest[3] = 0xFF;
+	}
+}
+
+void convertBGRAToRGBA(byte *dest, const byte *src, size_t count) {
+	size_t i = 0;
+
+#if PHAETHON_CONVERT_SSE2
+	for (; (i + 4) <= count; i += 4, src += 16, dest += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), swapRB(v));
+	}
+#endif
+
+	for (; i < count; i++, src += 4, dest += 4) {
+		const uint32_t v = READ_LE_UINT32(src);
+
+		WRITE_LE_UINT32(dest, (v & 0xFF00FF00) | ((v >> 16) & 0x000000FF) | ((v & 0x000000FF) << 16));
+	}
+}
+
+/** Return x * a / 255, rounded. */
+static inline byte multiplyAlpha(uint32_t x, uint32_t a) {
+	const uint32_t t = x * a + 128;
+
+	return (t + (t >> 8)) >> 8;
+}
+
+void premultiplyAlpha(byte *dest, const byte *src, size_t count) {
+	size_t i = 0;
+
+#if PHAETHON_CONVERT_SSE2
+	const __m128i zero      = _mm_setzero_si128();
+	const __m128i round     = _mm_set1_epi16(128);
+	const __m128i maskAlpha = _mm_set1_epi32(0xFF000000);
+
+	for (; (i + 4) <= count; i += 4, src += 16, dest += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		// 2 pixels each, with 16 bits per component, and the alpha spread over the whole pixel
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+
+		const __m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xFF), 0xFF);
+		const __m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xFF), 0xFF);
+
+		lo = _mm_add_epi16(_mm_mullo_epi16(lo, alphaLo), round);
+		hi = _mm_add_epi16(_mm_mullo_epi16(hi, alphaHi), round);
+
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+		const __m128i colors = _mm_andnot_si128(maskAlpha, _mm_packus_epi16(lo, hi));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_or_si128(colors, _mm_and_si128(v, maskAlpha)));
+	}
+#endif
+
+	for (; i < count; i++, src += 4, dest += 4) {
+		const byte a = src[3];
+
+		dest[0] = multiplyAlpha(src[0], a);
+		dest[1] = multiplyAlpha(src[1], a);
+		dest[2] = multiplyAlpha(src[2], a);
+		dest[3] = a;
+	}
+}
+
+void adjustBrightness(byte *dest, const byte *src, size_t count, uint16_t factor) {
+	size_t i = 0;
+
+#if PHAETHON_CONVERT_SSE2
+	const __m128i zero      = _mm_setzero_si128();
+	const __m128i scale     = _mm_set1_epi16((int16_t) factor);
+	const __m128i max       = _mm_set1_epi16(255);
+	const __m128i maskAlpha = _mm_set1_epi32(0xFF000000);
+
+	for (; (i + 4) <= count; i += 4, src += 16, dest += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		// (x << 8) * factor >> 16 is x * factor >> 8, without overflowing 16 bits
+		__m128i lo = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpacklo_epi8(v, zero), 8), scale);
+		__m128i hi = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpackhi_epi8(v, zero), 8), scale);
+
+		// Unsigned minimum with 255, since packus_epi16() saturates signed values
+		lo = _mm_sub_epi16(lo, _mm_subs_epu16(lo, max));
+		hi = _mm_sub_epi16(hi, _mm_subs_epu16(hi, max));
+
+		const __m128i colors = _mm_andnot_si128(maskAlpha, _mm_packus_epi16(lo, hi));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_or_si128(colors, _mm_and_si128(v, maskAlpha)));
+	}
+#endif
+
+	for (; i < count; i++, src += 4, dest += 4) {
+		dest[0] = MIN<uint32_t>((src[0] * factor) >> 8, 255);
+		dest[1] = MIN<uint32_t>((src[1] * factor) >> 8, 255);
+		dest[2] = MIN<uint32_t>((src[2] * factor) >> 8, 255);
+		dest[3] = src[3];
+	}
+}
+
+/* The 16-bit formats have always been expanded into the same bytes for both
+ * R8G8B8A8 and B8G8R8A8, with the components not scaled up to 8 bits. */
+
+static void convertR5G6B5(byte *dest, const byte *src, size_t count) {
+	for (size_t i = 0; i < count; i++, src += 2, dest += 4) {
+		const uint16_t color = READ_LE_UINT16(src);
+
+		dest[0] =  color & 0x001F;
+		dest[1] = (color & 0x07E0) >>  5;
+		dest[2] = (color & 0xF800) >> 11;
+		dest[3] = 0xFF;
+	}
+}
+
+static void convertA1R5G5B5(byte *dest, const byte *src, size_t count) {
+	for (size_t i = 0; i < count; i++, src += 2, dest += 4) {
+		const uint16_t color = READ_LE_UINT16(src);
+
+		dest[0] =  color & 0x001F;
+		dest[1] = (color & 0x03E0) >>  5;
+		dest[2] = (color & 0x7C00) >> 10;
+		dest[3] = (color & 0x8000) ? 0xFF : 0x00;
+	}
+}
+
+static void convertDepth16(byte *dest, const byte *src, size_t count) {
+	for (size_t i = 0; i < count; i++, src += 2, dest += 4) {
+		const uint16_t depth = READ_LE_UINT16(src);
+
+		dest[0] = depth / 128;
+		dest[1] = depth / 128;
+		dest[2] = depth / 128;
+		dest[3] = (depth >= 0x7FFF) ? 0x00 : 0xFF;
+	}
+}
+
+/** Convert into R8G8B8A8, or with swapRB into B8G8R8A8. */
+static void convert(byte *dest, const byte *src, size_t count, PixelFormat format, bool swapRB) {
+	switch (format) {
+		case kPixelFormatR8G8B8:
+			if (swapRB)
+				convertBGRToRGBA(dest, src, count);
+			else
+				convertRGBToRGBA(dest, src, count);
+			break;
+
+		case kPixelFormatB8G8R8:
+			if (swapRB)
+				convertRGBToRGBA(dest, src, count);
+			else
+				convertBGRToRGBA(dest, src, count);
+			break;
+
+		case kPixelFormatR8G8B8A8:
+			if (swapRB)
+				convertBGRAToRGBA(dest, src, count);
+			else if (dest != src)
+				std::memcpy(dest, src, count * 4);
+			break;
+
+		case kPixelFormatB8G8R8A8:
+			if (!swapRB)
+				convertBGRAToRGBA(dest, src, count);
+			else if (dest != src)
+				std::memcpy(dest, src, count * 4);
+			break;
+
+		case kPixelFormatR5G6B5:
+			convertR5G6B5(dest, src, count);
+			break;
+
+		case kPixelFormatA1R5G5B5:
+			convertA1R5G5B5(dest, src, count);
+			break;
+
+		case kPixelFormatDepth16:
+			convertDepth16(dest, src, count);
+			break;
+
+		default:
+			throw Common::Exception("Unsupported pixel format: %d", (int) format);
+	}
+}
+
+void convertToRGBA(byte *dest, const byte *src, size_t count, PixelFormat format) {
+	convert(dest, src, count, format, false);
+}
+
+void convertToBGRA(byte *dest, const byte *src, size_t count, PixelFormat format) {
+	convert(dest, src, count, format, true);
+}
+
+} // End of namespace Images
@@ -0,0 +1,63 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Row-at-a-time pixel format conversion.
+ */
+
+#ifndef IMAGES_CONVERT_H
+#define IMAGES_CONVERT_H
+
+#include <cstddef>
+
+#include "src/common/types.h"
+
+#include "src/images/types.h"
+
+namespace Images {
+
+/* All kernels convert count pixels from src into dest. Unless they change
+ * the pixel size, dest may be the same as src. Where the hardware allows,
+ * they work on several pixels at once with SIMD instructions. */
+
+/** Convert R8G8B8 into R8G8B8A8, or B8G8R8 into B8G8R8A8. */
+void convertRGBToRGBA(byte *dest, const byte *src, size_t count);
+/** Convert B8G8R8 into R8G8B8A8, or R8G8B8 into B8G8R8A8. */
+void convertBGRToRGBA(byte *dest, const byte *src, size_t count);
+/** Convert B8G8R8A8 into R8G8B8A8, or the other way round. */
+void convertBGRAToRGBA(byte *dest, const byte *src, size_t count);
+
+/** Multiply the color components of R8G8B8A8 or B8G8R8A8 pixels with their alpha. */
+void premultiplyAlpha(byte *dest, const byte *src, size_t count);
+
+/** Scale the color components of R8G8B8A8 or B8G8R8A8 pixels, saturating at 255.
+ *
+ *  @param factor The scale, in units of 1/256. 256 leaves the colors unchanged.
+ */
+void adjustBrightness(byte *dest, const byte *src, size_t count, uint16_t factor);
+
+/** Convert a row of pixels in this format into R8G8B8A8. */
+void convertToRGBA(byte *dest, const byte *src, size_t count, PixelFormat format);
+/** Convert a row of pixels in this format into B8G8R8A8. */
+void convertToBGRA(byte *dest, const byte *src, size_t count, PixelFormat format);
+
+} // End of namespace Images
+
+#endif // IMAGES_CONVERT_H
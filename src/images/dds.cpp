@@ -45,8 +45,8 @@ static const uint32_t kPixelFlagsIsRGB     = 0x00000040;
 
 namespace Images {
 
-DDS::DDS(Common::SeekableReadStream &dds) {
-	load(dds);
+DDS::DDS(Common::SeekableReadStream &dds, bool lazyMipMaps) {
+	load(dds, lazyMipMaps);
 }
 
 DDS::~DDS() {
@@ -66,7 +66,7 @@ bool DDS::detect(Common::SeekableReadStream &dds) {
 	return fourCC == kDDSID;
 }
 
-void DDS::load(Common::SeekableReadStream &dds) {
+void DDS::load(Common::SeekableReadStream &dds, bool lazyMipMaps) {
 	try {
 
 		DataType dataType;
@@ -80,7 +80,10 @@ void DDS::load(Common::SeekableReadStream &dds) {
 	}
 
 	// In Phaethon, we always want decompressed images
-	decompress();
+	if (lazyMipMaps)
+		decompressLazily();
+	else
+		decompress();
 }
 
 void DDS::readHeader(Common::SeekableReadStream &dds, DataType &dataType) {
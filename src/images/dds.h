@@ -39,7 +39,13 @@ namespace Images {
  */
 class DDS : public Decoder {
 public:
-	DDS(Common::SeekableReadStream &dds);
+	/** Read a DDS image.
+	 *
+	 *  @param dds         The stream to read the DDS from.
+	 *  @param lazyMipMaps Only decompress the first mip map right away,
+	 *                     and the others when they're needed.
+	 */
+	DDS(Common::SeekableReadStream &dds, bool lazyMipMaps = false);
 	~DDS();
 
 	/** Return true if the data within this stream is a DDS image. */
@@ -64,7 +70,7 @@ private:
 	};
 
 	// Loading helpers
-	void load(Common::SeekableReadStream &dds);
+	void load(Common::SeekableReadStream &dds, bool lazyMipMaps);
 	void readHeader(Common::SeekableReadStream &dds, DataType &dataType);
 	void readStandardHeader(Common::SeekableReadStream &dds, DataType &dataType);
 	void readBioWareHeader(Common::SeekableReadStream &dds, DataType &dataType);
@@ -24,9 +24,11 @@
 
 #include <cassert>
 
+#include <vector>
+
 #include "src/common/util.h"
 #include "src/common/error.h"
-#include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 
 #include "src/images/decoder.h"
 #include "src/images/util.h"
@@ -69,7 +71,8 @@ void Decoder::MipMap::swap(MipMap &right) {
 }
 
 
-Decoder::Decoder() : _format(kPixelFormatR8G8B8A8), _layerCount(1), _isCubeMap(false) {
+Decoder::Decoder() : _format(kPixelFormatR8G8B8A8), _layerCount(1), _isCubeMap(false),
+	_lazyFormat(kPixelFormatR8G8B8A8) {
 }
 
 Decoder::Decoder(const Decoder &decoder) {
@@ -85,6 +88,11 @@ Decoder &Decoder::operator=(const Decoder &decoder) {
 	_layerCount = decoder._layerCount;
 	_isCubeMap  = decoder._isCubeMap;
 
+	std::lock_guard<std::mutex> lock(decoder._lazyMutex);
+
+	_lazyFormat  = decoder._lazyFormat;
+	_lazyMipMaps = decoder._lazyMipMaps;
+
 	_mipMaps.clear();
 	_mipMaps.reserve(decoder._mipMaps.size());
 
@@ -132,10 +140,29 @@ const Decoder::MipMap &Decoder::getMipMap(size_t mipMap, size_t layer) const {
 
 	assert(index < _mipMaps.size());
 
+	/* Decompressing a mip map doesn't change the image as seen from the
+	 * outside, it has been claiming to be decompressed all along. */
+	if (!_lazyMipMaps.empty())
+		const_cast<Decoder &>(*this).decompressLazyMipMap(mipMap);
+
 	return *_mipMaps[index];
 }
 
+/** The number of pixels from which on decompression is spread over the thread pool. */
+static const size_t kParallelPixels = 256 * 256;
+/** The number of pixels each parallel decompression task works on, roughly. */
+static const size_t kBandPixels = 64 * 1024;
+
+static size_t getBlockSize(PixelFormat format) {
+	return (format == kPixelFormatDXT1) ? 8 : 16;
+}
+
 void Decoder::decompress(MipMap &out, const MipMap &in, PixelFormat format) {
+	prepareDecompress(out, in, format);
+	decompressRows(out, in, format, 0, in.height);
+}
+
+void Decoder::prepareDecompress(MipMap &out, const MipMap &in, PixelFormat format) {
 	if ((format != kPixelFormatDXT1) &&
 	    (format != kPixelFormatDXT3) &&
 	    (format != kPixelFormatDXT5))
@@ -151,29 +178,151 @@ void Decoder::decompress(MipMap &out, const MipMap &in, PixelFormat format) {
 	out.size   = MAX(out.width * out.height * 4, 64);
 
 	out.data = std::make_unique<byte[]>(out.size);
+}
+
+void Decoder::decompressRows(MipMap &out, const MipMap &in, PixelFormat format, int y, int height) {
+	assert(((y % 4) == 0) && ((y + height) <= in.height));
 
-	std::unique_ptr<Common::MemoryReadStream> stream = std::make_unique<Common::MemoryReadStream>(in.data.get(), in.size);
+	// Skip the compressed block rows above the band
+	const size_t offset = (y / 4) * ((in.width + 3) / 4) * getBlockSize(format);
+
+	const byte  *src     = in.data.get() + MIN<size_t>(offset, in.size);
+	const size_t srcSize = in.size - MIN<size_t>(offset, in.size);
+
+	byte *dest = out.data.get() + y * out.width * 4;
 
 	if      (format == kPixelFormatDXT1)
-		decompressDXT1(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT1(dest, src, srcSize, out.width, height, out.width * 4);
 	else if (format == kPixelFormatDXT3)
-		decompressDXT3(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT3(dest, src, srcSize, out.width, height, out.width * 4);
 	else if (format == kPixelFormatDXT5)
-		decompressDXT5(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT5(dest, src, srcSize, out.width, height, out.width * 4);
 }
 
-void Decoder::decompress() {
-	if (!isCompressed())
+void Decoder::decompressMipMaps(const std::vector<size_t> &mipMaps, PixelFormat format) {
+	/* Split all mip maps of all layers into bands of whole block rows, which
+	 * can be decompressed independently of each other. Images smaller than a
+	 * block are handled a bit differently by the decompressor, so a band is
+	 * always at least 4 rows high: a partial last block row is attached to
+	 * the band before it. */
+
+	struct Band {
+		size_t mipMap;
+		int y;
+		int height;
+	};
+
+	std::vector<MipMap> decompressed(mipMaps.size());
+	std::vector<Band> bands;
+
+	size_t pixels = 0;
+	for (size_t i = 0; i < mipMaps.size(); i++) {
+		const MipMap &in = *_mipMaps[mipMaps[i]];
+
+		prepareDecompress(decompressed[i], in, format);
+		pixels += decompressed[i].size / 4;
+
+		const int fullRows = in.height / 4;
+		const int bandRows = MAX<int>(1, kBandPixels / (MAX<int>(in.width, 1) * 4));
+
+		if (fullRows <= bandRows) {
+			bands.push_back({ i, 0, in.height });
+			continue;
+		}
+
+		for (int row = 0; row < fullRows; row += bandRows) {
+			const int y      = row * 4;
+			const int height = ((row + bandRows) >= fullRows) ? (in.height - y) : (bandRows * 4);
+
+			bands.push_back({ i, y, height });
+		}
+	}
+
+	const auto decompressBand = [&](size_t i) {
+		const Band &band = bands[i];
+
+		decompressRows(decompressed[band.mipMap], *_mipMaps[mipMaps[band.mipMap]], format, band.y, band.height);
+	};
+
+	if (pixels >= kParallelPixels) {
+		ThreadPoolMan.getPool().parallelFor(0, bands.size(), decompressBand, Common::CancelToken(), 1);
+	} else {
+		for (size_t i = 0; i < bands.size(); i++)
+			decompressBand(i);
+	}
+
+	for (size_t i = 0; i < mipMaps.size(); i++)
+		decompressed[i].swap(*_mipMaps[mipMaps[i]]);
+}
+
+void Decoder::decompressLazily() {
+	if (!isCompressed() || (getMipMapCount() == 0))
+		return;
+
+	_lazyFormat = _format;
+	_format     = kPixelFormatR8G8B8A8;
+
+	_lazyMipMaps.assign(getMipMapCount(), true);
+
+	decompressLazyMipMap(0);
+}
+
+void Decoder::decompressLazyMipMap(size_t mipMap) {
+	std::lock_guard<std::mutex> lock(_lazyMutex);
+
+	if ((mipMap >= _lazyMipMaps.size()) || !_lazyMipMaps[mipMap])
 		return;
 
-	for (MipMaps::iterator m = _mipMaps.begin(); m != _mipMaps.end(); ++m) {
-		MipMap decompressed;
+	std::vector<size_t> mipMaps(_layerCount);
+	for (size_t i = 0; i < _layerCount; i++)
+		mipMaps[i] = i * getMipMapCount() + mipMap;
+
+	decompressMipMaps(mipMaps, _lazyFormat);
+
+	_lazyMipMaps[mipMap] = false;
+
+	fixupLazyMipMaps(mipMap);
+}
+
+void Decoder::fixupLazyMipMaps(size_t UNUSED(mipMap)) {
+}
+
+void Decoder::decompress(size_t mipMapCount) {
+	const size_t oldMipMapCount = getMipMapCount();
+	if (mipMapCount < oldMipMapCount) {
+		// Only keep the requested mip maps of each layer
+
+		MipMaps mipMaps;
+		mipMaps.reserve(mipMapCount * _layerCount);
+
+		for (size_t i = 0; i < _layerCount; i++)
+			for (size_t j = 0; j < mipMapCount; j++)
+				mipMaps.emplace_back(std::move(_mipMaps[i * oldMipMapCount + j]));
+
+		_mipMaps.swap(mipMaps);
+	}
+
+	if (!_lazyMipMaps.empty()) {
+		// Decompress all the mip maps that haven't been asked for yet
 
-		decompress(decompressed, **m, _format);
+		_lazyMipMaps.resize(getMipMapCount());
 
-		decompressed.swap(**m);
+		for (size_t j = 0; j < _lazyMipMaps.size(); j++)
+			decompressLazyMipMap(j);
+
+		_lazyMipMaps.clear();
+		return;
 	}
 
+	if (!isCompressed())
+		return;
+
+	std::vector<size_t> mipMaps(_mipMaps.size());
+	for (size_t i = 0; i < mipMaps.size(); i++)
+		mipMaps[i] = i;
+
+	decompressMipMaps(mipMaps, _format);
+
 	_format = kPixelFormatR8G8B8A8;
 }
 
@@ -186,8 +335,9 @@ void Decoder::dumpTGA(const Common::UString &fileName) const {
 		return;
 	}
 
+	// We only write the first mip map of each layer
 	Decoder decoder(*this);
-	decoder.decompress();
+	decoder.decompress(1);
 
 	Images::dumpTGA(fileName, decoder);
 }
@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
 
 #include <boost/noncopyable.hpp>
 
@@ -78,7 +79,11 @@ public:
 	/** Is this image a cube map? */
 	bool isCubeMap() const;
 
-	/** Return a mip map. */
+	/** Return a mip map.
+	 *
+	 *  If the image is decompressed lazily, this decompresses the mip map
+	 *  first, in all layers, if that hasn't happened yet.
+	 */
 	const MipMap &getMipMap(size_t mipMap, size_t layer = 0) const;
 
 	/** Return TXI data, if embedded in the image. */
@@ -107,10 +112,46 @@ protected:
 	/** Is the image data compressed? */
 	bool isCompressed() const;
 
-	/** Manually decompress the texture image data. */
-	void decompress();
+	/** Manually decompress the texture image data.
+	 *
+	 *  The mip maps of all layers are decompressed in parallel, on the
+	 *  shared thread pool.
+	 *
+	 *  @param mipMapCount Only keep and decompress this many mip maps
+	 *                     of each layer, discarding the rest.
+	 */
+	void decompress(size_t mipMapCount = SIZE_MAX);
 
 	static void decompress(MipMap &out, const MipMap &in, PixelFormat format);
+
+	/** Decompress the texture image data lazily.
+	 *
+	 *  The first mip map of each layer is decompressed right away, the other
+	 *  mip maps only once getMipMap() asks for them. The image format is
+	 *  R8G8B8A8 from now on, as if everything was decompressed.
+	 */
+	void decompressLazily();
+
+	/** Called after a mip map was decompressed lazily, in all layers. */
+	virtual void fixupLazyMipMaps(size_t mipMap);
+
+private:
+	/** The compressed format of the mip maps still to be decompressed lazily. */
+	PixelFormat _lazyFormat;
+	/** For each mip map, does it still need to be decompressed lazily? */
+	std::vector<bool> _lazyMipMaps;
+	/** Protects the lazy decompression. */
+	mutable std::mutex _lazyMutex;
+
+	/** Decompress these mip maps, in parallel. */
+	void decompressMipMaps(const std::vector<size_t> &mipMaps, PixelFormat format);
+	/** Decompress this mip map in all layers, if it still needs to be. */
+	void decompressLazyMipMap(size_t mipMap);
+
+	/** Check the compressed mip map and allocate its decompressed version. */
+	static void prepareDecompress(MipMap &out, const MipMap &in, PixelFormat format);
+	/** Decompress the rows [y, y + height) of a mip map, with y on a block boundary. */
+	static void decompressRows(MipMap &out, const MipMap &in, PixelFormat format, int y, int height);
 };
 
 } // End of namespace Images
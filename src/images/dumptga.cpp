@@ -24,6 +24,7 @@
 
 #include <cstdio>
 
+#include <vector>
 #include <memory>
 
 #include "src/common/error.h"
@@ -31,61 +32,11 @@
 #include "src/common/writefile.h"
 
 #include "src/images/decoder.h"
+#include "src/images/util.h"
+#include "src/images/convert.h"
 
 namespace Images {
 
-static void writePixel(Common::WriteStream &file, const byte *&data, PixelFormat format) {
-	if (format == kPixelFormatR8G8B8) {
-		file.writeByte(data[2]);
-		file.writeByte(data[1]);
-		file.writeByte(data[0]);
-		file.writeByte(0xFF);
-		data += 3;
-	} else if (format == kPixelFormatB8G8R8) {
-		file.writeByte(data[0]);
-		file.writeByte(data[1]);
-		file.writeByte(data[2]);
-		file.writeByte(0xFF);
-		data += 3;
-	} else if (format == kPixelFormatR8G8B8A8) {
-		file.writeByte(data[2]);
-		file.writeByte(data[1]);
-		file.writeByte(data[0]);
-		file.writeByte(data[3]);
-		data += 4;
-	} else if (format == kPixelFormatB8G8R8A8) {
-		file.writeByte(data[0]);
-		file.writeByte(data[1]);
-		file.writeByte(data[2]);
-		file.writeByte(data[3]);
-		data += 4;
-	} else if (format == kPixelFormatR5G6B5) {
-		uint16_t color = READ_LE_UINT16(data);
-		file.writeByte( color & 0x001F);
-		file.writeByte((color & 0x07E0) >>  5);
-		file.writeByte((color & 0xF800) >> 11);
-		file.writeByte(0xFF);
-		data += 2;
-	} else if (format == kPixelFormatA1R5G5B5) {
-		uint16_t color = READ_LE_UINT16(data);
-		file.writeByte( color & 0x001F);
-		file.writeByte((color & 0x03E0) >>  5);
-		file.writeByte((color & 0x7C00) >> 10);
-		file.writeByte((color & 0x8000) ? 0xFF : 0x00);
-		data += 2;
-	} else if (format == kPixelFormatDepth16) {
-		uint16_t color = READ_LE_UINT16(data);
-		file.writeByte(color / 128);
-		file.writeByte(color / 128);
-		file.writeByte(color / 128);
-		file.writeByte((color >= 0x7FFF) ? 0x00 : 0xFF);
-
-		data += 2;
-	} else
-		throw Common::Exception("Unsupported pixel format: %d", (int) format);
-
-}
-
 static Common::WriteStream *openTGA(const Common::UString &fileName, int width, int height) {
 	std::unique_ptr<Common::WriteFile> file = std::make_unique<Common::WriteFile>(fileName);
 
@@ -110,9 +61,16 @@ static Common::WriteStream *openTGA(const Common::UString &fileName, int width,
 static void writeMipMap(Common::WriteStream &stream, const Decoder::MipMap &mipMap, PixelFormat format) {
 	const byte *data = mipMap.data.get();
 
-	uint32_t count = mipMap.width * mipMap.height;
-	while (count-- > 0)
-		writePixel(stream, data, format);
+	const size_t rowSize = mipMap.width * getBPP(format);
+
+	// Convert into BGRA8888 and write the image one row at a time
+	std::vector<byte> row(mipMap.width * 4);
+
+	for (int y = 0; y < mipMap.height; y++, data += rowSize) {
+		convertToBGRA(row.data(), data, mipMap.width, format);
+
+		stream.write(row.data(), row.size());
+	}
 }
 
 void dumpTGA(const Common::UString &fileName, const Decoder &image) {
@@ -25,6 +25,7 @@ src_images_libimages_la_SOURCES =
 src_images_libimages_la_SOURCES += \
     src/images/types.h \
     src/images/util.h \
+    src/images/convert.h \
     src/images/s3tc.h \
     src/images/decoder.h \
     src/images/dumptga.h \
@@ -37,6 +38,7 @@ src_images_libimages_la_SOURCES += \
     $(EMPTY)
 
 src_images_libimages_la_SOURCES += \
+    src/images/convert.cpp \
     src/images/s3tc.cpp \
     src/images/decoder.cpp \
     src/images/dumptga.cpp \
@@ -22,11 +22,23 @@
  *  Manual S3TC DXTn decompression methods.
  */
 
+#include <cstring>
+
 #include "src/common/util.h"
+#include "src/common/endianness.h"
 #include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
 
 #include "src/images/s3tc.h"
 
+#if defined(__SSE2__) && defined(PHAETHON_LITTLE_ENDIAN)
+	#include <emmintrin.h>
+
+	#define PHAETHON_S3TC_SSE2 1
+#else
+	#define PHAETHON_S3TC_SSE2 0
+#endif
+
 namespace Images {
 
 static uint32_t convert565To8888(uint16_t color) {
@@ -216,4 +228,296 @@ void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32_t width,
 	}
 }
 
+/* Fast paths decoding out of a contiguous block buffer.
+ *
+ * The palette is calculated with integer math. interpolate32() above
+ * truncates (1 - w) * a + w * b with w being the float closest to 1/3 or
+ * 2/3, which is a hair off. Checked over all 256 * 256 channel pairs, the
+ * result is the exact third, minus one if it would otherwise round up to
+ * an integer, which happens exactly if a < b. */
+
+/** Integer version of interpolate32(0.333333f, ...) for one channel. */
+static inline uint32_t interpolateThird(uint32_t a, uint32_t b) {
+	return (2 * a + b - (a < b)) / 3;
+}
+
+/** Integer version of interpolate32(0.666666f, ...) for one channel. */
+static inline uint32_t interpolateTwoThirds(uint32_t a, uint32_t b) {
+	return (a + 2 * b - (a < b)) / 3;
+}
+
+/** Integer version of interpolate32(0.5f, ...) for one channel. */
+static inline uint32_t interpolateHalf(uint32_t a, uint32_t b) {
+	return (a + b) / 2;
+}
+
+static inline uint32_t makeColor(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+	return (r << 24) | (g << 16) | (b << 8) | a;
+}
+
+/** Calculate the 4 colors of a DXT color block, the same way the stream-based functions do. */
+static inline void decodeColors(uint32_t (&colors)[4], const byte *block, bool dxt1) {
+	const uint16_t color0 = READ_LE_UINT16(block);
+	const uint16_t color1 = READ_LE_UINT16(block + 2);
+
+	const uint32_t r0 = (color0 >> 11) << 3, g0 = ((color0 >> 5) & 0x3F) << 2, b0 = (color0 & 0x1F) << 3;
+	const uint32_t r1 = (color1 >> 11) << 3, g1 = ((color1 >> 5) & 0x3F) << 2, b1 = (color1 & 0x1F) << 3;
+
+	// DXT1 colors are opaque, DXT3 and DXT5 get their alpha values separately
+	const uint32_t a = dxt1 ? 0xFF : 0x00;
+
+	colors[0] = makeColor(r0, g0, b0, a);
+	colors[1] = makeColor(r1, g1, b1, a);
+
+	if (!dxt1 || (color0 > color1)) {
+		colors[2] = makeColor(interpolateThird(r0, r1), interpolateThird(g0, g1), interpolateThird(b0, b1), a);
+		colors[3] = makeColor(interpolateTwoThirds(r0, r1), interpolateTwoThirds(g0, g1), interpolateTwoThirds(b0, b1), a);
+	} else {
+		colors[2] = makeColor(interpolateHalf(r0, r1), interpolateHalf(g0, g1), interpolateHalf(b0, b1), a);
+		colors[3] = 0;
+	}
+}
+
+/** Decode the 16 pixels of a DXT color block, without alpha values for DXT3/DXT5. */
+static inline void decodeColorBlock(uint32_t (&pixels)[16], const byte *block, bool dxt1) {
+	uint32_t colors[4];
+	decodeColors(colors, block, dxt1);
+
+	// Row y of the block has its color indices in byte y, from the LSB
+	const uint32_t indices = READ_LE_UINT32(block + 4);
+
+	for (int i = 0; i < 16; i++)
+		pixels[i] = colors[(indices >> (2 * i)) & 3];
+}
+
+static inline void decodeDXT1Block(uint32_t (&pixels)[16], const byte *block) {
+	decodeColorBlock(pixels, block, true);
+}
+
+static inline void decodeDXT3Block(uint32_t (&pixels)[16], const byte *block) {
+	decodeColorBlock(pixels, block + 8, false);
+
+	/* Like decompressDXT3(), the rows of the explicit alpha values are
+	 * stored bottom to top, and only the upper 4 bits of alpha are set. */
+	for (int y = 0; y < 4; y++) {
+		const uint32_t alpha = READ_LE_UINT16(block + 2 * (3 - y));
+
+		for (int x = 0; x < 4; x++)
+			pixels[y * 4 + x] |= ((alpha >> (x * 4)) & 0xF) << 4;
+	}
+}
+
+/** Calculate the 8 alpha values of a DXT5 alpha block. */
+static inline void decodeDXT5Alphas(uint32_t (&alphas)[8], const byte *block) {
+	const uint32_t alpha0 = block[0];
+	const uint32_t alpha1 = block[1];
+
+	/* Integer division of integers is exactly what the double divisions in
+	 * decompressDXT5() end up as, since their results are never that close
+	 * to the next integer. */
+	alphas[0] = alpha0;
+	alphas[1] = alpha1;
+
+	if (alpha0 > alpha1) {
+		for (uint32_t i = 1; i < 7; i++)
+			alphas[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+	} else {
+		for (uint32_t i = 1; i < 5; i++)
+			alphas[i + 1] = ((5 - i) * alpha0 + i * alpha1 + 2) / 5;
+
+		alphas[6] = 0;
+		alphas[7] = 255;
+	}
+}
+
+static inline void decodeDXT5Block(uint32_t (&pixels)[16], const byte *block) {
+	decodeColorBlock(pixels, block + 8, false);
+
+	uint32_t alphas[8];
+	decodeDXT5Alphas(alphas, block);
+
+	const uint64_t indices = READ_LE_UINT32(block + 2) | ((uint64_t) READ_LE_UINT16(block + 6) << 32);
+
+	for (int i = 0; i < 16; i++)
+		pixels[i] |= alphas[(indices >> (3 * i)) & 7];
+}
+
+/** Decode all blocks of a DXT image, row by row, into RGBA8888 pixels. */
+template<size_t kBlockSize, void (*decodeBlock)(uint32_t (&)[16], const byte *)>
+static void decompressBlocks(byte *dest, const byte *src, uint32_t width, uint32_t height, uint32_t pitch) {
+	for (uint32_t by = 0; by < height; by += 4) {
+		const uint32_t blockHeight = MIN<uint32_t>(height - by, 4);
+
+		for (uint32_t bx = 0; bx < width; bx += 4, src += kBlockSize) {
+			const uint32_t blockWidth = MIN<uint32_t>(width - bx, 4);
+
+			uint32_t pixels[16];
+			decodeBlock(pixels, src);
+
+			byte *destRow = dest + by * pitch + bx * 4;
+			for (uint32_t y = 0; y < blockHeight; y++, destRow += pitch)
+				for (uint32_t x = 0; x < blockWidth; x++)
+					WRITE_BE_UINT32(destRow + x * 4, pixels[y * 4 + x]);
+		}
+	}
+}
+
+#if PHAETHON_S3TC_SSE2
+/* SSE2 versions, decoding a whole block into 4 rows of 4 pixels at once. They
+ * hold the pixels in memory order, which on little-endian x86 means that the
+ * alpha value is the most significant byte. */
+
+/** Decode the 4 rows of a DXT color block, without alpha values for DXT3/DXT5. */
+static inline void decodeColorBlockSSE2(__m128i (&rows)[4], const byte *block, bool dxt1) {
+	uint32_t colors[4];
+	decodeColors(colors, block, dxt1);
+
+	const __m128i color0 = _mm_set1_epi32(TO_BE_32(colors[0]));
+	const __m128i color1 = _mm_set1_epi32(TO_BE_32(colors[1]));
+	const __m128i color2 = _mm_set1_epi32(TO_BE_32(colors[2]));
+	const __m128i color3 = _mm_set1_epi32(TO_BE_32(colors[3]));
+
+	const __m128i color01 = _mm_xor_si128(color0, color1);
+	const __m128i color23 = _mm_xor_si128(color2, color3);
+
+	// The low and high bits of the 4 color indices within one byte
+	const __m128i bit0 = _mm_setr_epi32(0x01, 0x04, 0x10, 0x40);
+	const __m128i bit1 = _mm_setr_epi32(0x02, 0x08, 0x20, 0x80);
+
+	const uint32_t indices = READ_LE_UINT32(block + 4);
+
+	for (int y = 0; y < 4; y++) {
+		const __m128i row = _mm_set1_epi32(indices >> (8 * y));
+
+		const __m128i mask0 = _mm_cmpeq_epi32(_mm_and_si128(row, bit0), bit0);
+		const __m128i mask1 = _mm_cmpeq_epi32(_mm_and_si128(row, bit1), bit1);
+
+		// Select color 0 or 1 and 2 or 3 with the low bit, then between these with the high bit
+		const __m128i low  = _mm_xor_si128(color0, _mm_and_si128(mask0, color01));
+		const __m128i high = _mm_xor_si128(color2, _mm_and_si128(mask0, color23));
+
+		rows[y] = _mm_xor_si128(low, _mm_and_si128(mask1, _mm_xor_si128(low, high)));
+	}
+}
+
+static inline void decodeDXT1BlockSSE2(__m128i (&rows)[4], const byte *block) {
+	decodeColorBlockSSE2(rows, block, true);
+}
+
+static inline void decodeDXT3BlockSSE2(__m128i (&rows)[4], const byte *block) {
+	decodeColorBlockSSE2(rows, block + 8, false);
+
+	for (int y = 0; y < 4; y++) {
+		const uint32_t alpha = READ_LE_UINT16(block + 2 * (3 - y));
+
+		rows[y] = _mm_or_si128(rows[y], _mm_setr_epi32((alpha & 0x000F) << 28, (alpha & 0x00F0) << 24,
+		                                                (alpha & 0x0F00) << 20, (alpha & 0xF000) << 16));
+	}
+}
+
+static inline void decodeDXT5BlockSSE2(__m128i (&rows)[4], const byte *block) {
+	decodeColorBlockSSE2(rows, block + 8, false);
+
+	uint32_t alphas[8];
+	decodeDXT5Alphas(alphas, block);
+
+	const uint64_t indices = READ_LE_UINT32(block + 2) | ((uint64_t) READ_LE_UINT16(block + 6) << 32);
+
+	for (int y = 0; y < 4; y++) {
+		const uint32_t row = (uint32_t) (indices >> (12 * y));
+
+		rows[y] = _mm_or_si128(rows[y], _mm_setr_epi32(alphas[(row     ) & 7] << 24, alphas[(row >> 3) & 7] << 24,
+		                                                alphas[(row >> 6) & 7] << 24, alphas[(row >> 9) & 7] << 24));
+	}
+}
+
+/** Decode all blocks of a DXT image, row by row, into RGBA8888 pixels. */
+template<size_t kBlockSize, void (*decodeBlock)(__m128i (&)[4], const byte *)>
+static void decompressBlocksSSE2(byte *dest, const byte *src, uint32_t width, uint32_t height, uint32_t pitch) {
+	for (uint32_t by = 0; by < height; by += 4) {
+		const uint32_t blockHeight = MIN<uint32_t>(height - by, 4);
+
+		for (uint32_t bx = 0; bx < width; bx += 4, src += kBlockSize) {
+			const uint32_t blockWidth = MIN<uint32_t>(width - bx, 4);
+
+			__m128i rows[4];
+			decodeBlock(rows, src);
+
+			byte *destRow = dest + by * pitch + bx * 4;
+
+			if ((blockWidth == 4) && (blockHeight == 4)) {
+				for (uint32_t y = 0; y < 4; y++, destRow += pitch)
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(destRow), rows[y]);
+
+				continue;
+			}
+
+			// Partial block at the right or bottom edge
+			for (uint32_t y = 0; y < blockHeight; y++, destRow += pitch) {
+				byte row[16];
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(row), rows[y]);
+
+				std::memcpy(destRow, row, blockWidth * 4);
+			}
+		}
+	}
+}
+#endif // PHAETHON_S3TC_SSE2
+
+/** Can the fast path decode this image?
+ *
+ *  Images smaller than a block are walked through a bit differently in the
+ *  stream-based functions, and too little data needs to throw the same way.
+ */
+static bool canDecompressBlocks(size_t blockSize, size_t srcSize, uint32_t width, uint32_t height) {
+	if ((width < 4) || (height < 4))
+		return false;
+
+	const size_t blockCount = ((width + 3) / 4) * (size_t) ((height + 3) / 4);
+
+	return srcSize >= (blockCount * blockSize);
+}
+
+void decompressDXT1(byte *dest, const byte *src, size_t srcSize, uint32_t width, uint32_t height, uint32_t pitch) {
+	if (!canDecompressBlocks(8, srcSize, width, height)) {
+		Common::MemoryReadStream stream(src, srcSize);
+		decompressDXT1(dest, stream, width, height, pitch);
+		return;
+	}
+
+#if PHAETHON_S3TC_SSE2
+	decompressBlocksSSE2<8, decodeDXT1BlockSSE2>(dest, src, width, height, pitch);
+#else
+	decompressBlocks<8, decodeDXT1Block>(dest, src, width, height, pitch);
+#endif
+}
+
+void decompressDXT3(byte *dest, const byte *src, size_t srcSize, uint32_t width, uint32_t height, uint32_t pitch) {
+	if (!canDecompressBlocks(16, srcSize, width, height)) {
+		Common::MemoryReadStream stream(src, srcSize);
+		decompressDXT3(dest, stream, width, height, pitch);
+		return;
+	}
+
+#if PHAETHON_S3TC_SSE2
+	decompressBlocksSSE2<16, decodeDXT3BlockSSE2>(dest, src, width, height, pitch);
+#else
+	decompressBlocks<16, decodeDXT3Block>(dest, src, width, height, pitch);
+#endif
+}
+
+void decompressDXT5(byte *dest, const byte *src, size_t srcSize, uint32_t width, uint32_t height, uint32_t pitch) {
+	if (!canDecompressBlocks(16, srcSize, width, height)) {
+		Common::MemoryReadStream stream(src, srcSize);
+		decompressDXT5(dest, stream, width, height, pitch);
+		return;
+	}
+
+#if PHAETHON_S3TC_SSE2
+	decompressBlocksSSE2<16, decodeDXT5BlockSSE2>(dest, src, width, height, pitch);
+#else
+	decompressBlocks<16, decodeDXT5Block>(dest, src, width, height, pitch);
+#endif
+}
+
 } // End of namespace Images
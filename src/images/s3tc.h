@@ -37,6 +37,13 @@ void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32_t width,
 void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch);
 void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch);
 
+/* Faster versions decoding directly out of a buffer of srcSize bytes,
+ * with the same output. */
+
+void decompressDXT1(byte *dest, const byte *src, size_t srcSize, uint32_t width, uint32_t height, uint32_t pitch);
+void decompressDXT3(byte *dest, const byte *src, size_t srcSize, uint32_t width, uint32_t height, uint32_t pitch);
+void decompressDXT5(byte *dest, const byte *src, size_t srcSize, uint32_t width, uint32_t height, uint32_t pitch);
+
 } // End of namespace Images
 
 #endif // IMAGES_S3TC_H
@@ -40,14 +40,14 @@ static const byte kEncodingSwizzledBGRA = 0x0C;
 
 namespace Images {
 
-TPC::TPC(Common::SeekableReadStream &tpc) : _txiDataSize(0) {
-	load(tpc);
+TPC::TPC(Common::SeekableReadStream &tpc, bool lazyMipMaps) : _txiDataSize(0) {
+	load(tpc, lazyMipMaps);
 }
 
 TPC::~TPC() {
 }
 
-void TPC::load(Common::SeekableReadStream &tpc) {
+void TPC::load(Common::SeekableReadStream &tpc, bool lazyMipMaps) {
 	try {
 
 		byte encoding;
@@ -56,7 +56,7 @@ void TPC::load(Common::SeekableReadStream &tpc) {
 		readData   (tpc, encoding);
 		readTXIData(tpc);
 
-		fixupCubeMap();
+		fixupCubeMap(lazyMipMaps);
 
 	} catch (Common::Exception &e) {
 		e.add("Failed reading TPC file");
@@ -64,7 +64,10 @@ void TPC::load(Common::SeekableReadStream &tpc) {
 	}
 
 	// In Phaethon, we always want decompressed images
-	decompress();
+	if (lazyMipMaps)
+		decompressLazily();
+	else
+		decompress();
 }
 
 Common::SeekableReadStream *TPC::getTXI() const {
@@ -312,7 +315,7 @@ void TPC::readTXIData(Common::SeekableReadStream &tpc) {
 		throw Common::Exception(Common::kReadError);
 }
 
-void TPC::fixupCubeMap() {
+void TPC::fixupCubeMap(bool lazyMipMaps) {
 	/* Do various fixups to the cube maps. This includes rotating and swapping a
 	 * few sides around. This is done by the original games as well.
 	 */
@@ -342,33 +345,42 @@ void TPC::fixupCubeMap() {
 	}
 
 	// Since we need to rotate the individual cube sides, we need to decompress them all
+	if (lazyMipMaps && isCompressed()) {
+		// Or rather, each mip map once it's decompressed, see fixupLazyMipMaps()
+		decompressLazily();
+		return;
+	}
+
 	decompress();
 
+	for (size_t j = 0; j < getMipMapCount(); j++)
+		fixupCubeMapSides(j);
+}
+
+void TPC::fixupCubeMapSides(size_t mipMap) {
 	// Rotate the cube sides so that they're all oriented correctly
 	for (size_t i = 0; i < getLayerCount(); i++) {
-		for (size_t j = 0; j < getMipMapCount(); j++) {
-			const size_t index = i * getMipMapCount() + j;
-			assert(index < _mipMaps.size());
+		const size_t index = i * getMipMapCount() + mipMap;
+		assert(index < _mipMaps.size());
 
-			MipMap &mipMap = *_mipMaps[index];
+		MipMap &side = *_mipMaps[index];
 
-			static const int rotation[6] = { 3, 1, 0, 2, 2, 0 };
+		static const int rotation[6] = { 3, 1, 0, 2, 2, 0 };
 
-			rotate90(mipMap.data.get(), mipMap.width, mipMap.height, getBPP(_format), rotation[i]);
-		}
+		rotate90(side.data.get(), side.width, side.height, getBPP(_format), rotation[i]);
 	}
 
 	// Swap the first two sides of the cube maps
-	for (size_t j = 0; j < getMipMapCount(); j++) {
-		const size_t index0 = 0 * getMipMapCount() + j;
-		const size_t index1 = 1 * getMipMapCount() + j;
-		assert((index0 < _mipMaps.size()) && (index1 < _mipMaps.size()));
+	const size_t index0 = 0 * getMipMapCount() + mipMap;
+	const size_t index1 = 1 * getMipMapCount() + mipMap;
+	assert((index0 < _mipMaps.size()) && (index1 < _mipMaps.size()));
 
-		MipMap &mipMap0 = *_mipMaps[index0];
-		MipMap &mipMap1 = *_mipMaps[index1];
+	_mipMaps[index0]->data.swap(_mipMaps[index1]->data);
+}
 
-		mipMap0.data.swap(mipMap1.data);
-	}
+void TPC::fixupLazyMipMaps(size_t mipMap) {
+	if (isCubeMap())
+		fixupCubeMapSides(mipMap);
 }
 
 } // End of namespace Images
@@ -38,24 +38,34 @@ namespace Images {
 /** BioWare's own texture format, TPC. */
 class TPC : public Decoder {
 public:
-	TPC(Common::SeekableReadStream &tpc);
+	/** Read a TPC image.
+	 *
+	 *  @param tpc         The stream to read the TPC from.
+	 *  @param lazyMipMaps Only decompress the first mip map right away,
+	 *                     and the others when they're needed.
+	 */
+	TPC(Common::SeekableReadStream &tpc, bool lazyMipMaps = false);
 	~TPC();
 
 	/** Return the enclosed TXI data. */
 	Common::SeekableReadStream *getTXI() const;
 
+protected:
+	void fixupLazyMipMaps(size_t mipMap);
+
 private:
 	std::unique_ptr<byte[]> _txiData;
 	size_t _txiDataSize;
 
 	// Loading helpers
-	void load(Common::SeekableReadStream &tpc);
+	void load(Common::SeekableReadStream &tpc, bool lazyMipMaps);
 	void readHeader(Common::SeekableReadStream &tpc, byte &encoding);
 	void readData(Common::SeekableReadStream &tpc, byte encoding);
 	void readTXIData(Common::SeekableReadStream &tpc);
 
 	bool checkCubeMap(uint32_t &width, uint32_t &height);
-	void fixupCubeMap();
+	void fixupCubeMap(bool lazyMipMaps);
+	void fixupCubeMapSides(size_t mipMap);
 
 	static void deSwizzle(byte *dst, const byte *src, uint32_t width, uint32_t height);
 };
@@ -36,11 +36,14 @@ static const byte kEncodingDXT5 = 0x0C;
 
 namespace Images {
 
-TXB::TXB(Common::SeekableReadStream &txb) : _dataSize(0), _txiDataSize(0) {
+TXB::TXB(Common::SeekableReadStream &txb, bool lazyMipMaps) : _dataSize(0), _txiDataSize(0) {
 	load(txb);
 
 	// In Phaethon, we always want decompressed images
-	decompress();
+	if (lazyMipMaps)
+		decompressLazily();
+	else
+		decompress();
 }
 
 TXB::~TXB() {
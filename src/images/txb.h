@@ -38,7 +38,13 @@ namespace Images {
 /** Another one of BioWare's own texture formats, TXB. */
 class TXB : public Decoder {
 public:
-	TXB(Common::SeekableReadStream &txb);
+	/** Read a TXB image.
+	 *
+	 *  @param txb         The stream to read the TXB from.
+	 *  @param lazyMipMaps Only decompress the first mip map right away,
+	 *                     and the others when they're needed.
+	 */
+	TXB(Common::SeekableReadStream &txb, bool lazyMipMaps = false);
 	~TXB();
 
 	/** Return the enclosed TXI data. */
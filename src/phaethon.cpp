@@ -37,6 +37,7 @@
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/ustring.h"
+#include "src/common/threadpool.h"
 
 #include "src/gui/icons.h"
 #include "src/gui/mainwindow.h"
@@ -44,8 +45,10 @@
 #include "src/sound/sound.h"
 
 #include "src/cline.h"
+#include "src/extract.h"
 
 void initPlatform();
+void deinitThreadPool();
 
 void openGamePath(const Common::UString &path);
 
@@ -59,6 +62,9 @@ int main(int argc, char **argv) {
 		// Find out what we're supposed to do
 		Job job = parseCommandLine(args);
 
+		// Configure the shared thread pool, before anything uses it
+		ThreadPoolMan.init(job.jobs);
+
 		// Handle the job
 		switch (job.operation) {
 			case kOperationHelp:
@@ -73,21 +79,29 @@ int main(int argc, char **argv) {
 				openGamePath(job.path);
 				break;
 
+			case kOperationExtract:
+				extractArchive(job.path, job.outPath);
+				break;
+
 			case kOperationInvalid:
 			default:
 				std::printf("%s\n", createHelpText(args[0]).c_str());
+				deinitThreadPool();
 				return 1;
 		}
 	} catch (Common::Exception &e) {
 		Common::printException(e);
+		deinitThreadPool();
 		return 2;
 	} catch (std::exception &e) {
 		Common::Exception se(e);
 
 		Common::printException(se);
+		deinitThreadPool();
 		return 2;
 	}
 
+	deinitThreadPool();
 	return 0;
 }
 
@@ -103,6 +117,15 @@ void initPlatform() {
 }
 
 
+void deinitThreadPool() {
+	try {
+		Common::ThreadPoolManager::destroy();
+	} catch (Common::Exception &e) {
+		Common::printException(e, "WARNING: ");
+	}
+}
+
+
 class Phaethon {
 public:
 	Phaethon(const Common::UString &path = "");
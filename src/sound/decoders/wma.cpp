@@ -765,7 +765,16 @@ Common::SeekableReadStream *WMACodec::decodeSuperFrame(Common::SeekableReadStrea
 	if (_blockAlign)
 		size = _blockAlign;
 
-	Common::BitStream8MSB bits(data);
+	// Decode straight out of memory, we need the whole superframe anyway
+	const size_t dataSize = data.size();
+
+	std::unique_ptr<byte[]> superframe = std::make_unique<byte[]>(dataSize);
+
+	data.seek(0);
+	if (data.read(superframe.get(), dataSize) != dataSize)
+		throw Common::Exception(Common::kReadError);
+
+	Common::MemoryBitStream8MSB bits(superframe.get(), dataSize);
 
 	int outputDataSize = 0;
 	std::unique_ptr<int16_t[]> outputData;
@@ -824,8 +833,7 @@ Common::SeekableReadStream *WMACodec::decodeSuperFrame(Common::SeekableReadStrea
 				_lastSuperframeLen += 1;
 			}
 
-			Common::MemoryReadStream lastSuperframe(_lastSuperframe, _lastSuperframeLen);
-			Common::BitStream8MSB lastBits(lastSuperframe);
+			Common::MemoryBitStream8MSB lastBits(_lastSuperframe, _lastSuperframeLen);
 
 			lastBits.skip(_lastBitoffset);
 
@@ -856,8 +864,7 @@ Common::SeekableReadStream *WMACodec::decodeSuperFrame(Common::SeekableReadStrea
 			if (_lastBitoffset > 0)
 				_lastSuperframeLen++;
 
-			data.seek(data.size() - _lastSuperframeLen);
-			data.read(_lastSuperframe, _lastSuperframeLen);
+			std::memcpy(_lastSuperframe, superframe.get() + dataSize - _lastSuperframeLen, _lastSuperframeLen);
 		} else {
 			// We don't
 
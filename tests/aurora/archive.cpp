@@ -0,0 +1,93 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the archive base class and its resource list.
+ */
+
+#include "gtest/gtest.h"
+
+#include "src/common/ustring.h"
+#include "src/common/strutil.h"
+
+#include "src/aurora/archive.h"
+
+GTEST_TEST(ArchiveResourceList, add) {
+	Aurora::Archive::ResourceList resources;
+
+	resources.add("foo", Aurora::kFileTypeTXT, 0);
+	resources.add("bar", Aurora::kFileTypeBMP, 1, 23);
+
+	ASSERT_EQ(resources.size(), 2);
+
+	EXPECT_STREQ(resources[0].name, "foo");
+	EXPECT_EQ(resources[0].type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(resources[0].index, 0);
+	EXPECT_EQ(resources[0].hash, 0);
+
+	EXPECT_STREQ(resources[1].name, "bar");
+	EXPECT_EQ(resources[1].type, Aurora::kFileTypeBMP);
+	EXPECT_EQ(resources[1].index, 1);
+	EXPECT_EQ(resources[1].hash, 23);
+}
+
+GTEST_TEST(ArchiveResourceList, resize) {
+	Aurora::Archive::ResourceList resources;
+
+	resources.resize(2);
+	ASSERT_EQ(resources.size(), 2);
+
+	EXPECT_STREQ(resources[0].name, "");
+	EXPECT_EQ(resources[0].type, Aurora::kFileTypeNone);
+	EXPECT_EQ(resources[0].index, 0xFFFFFFFF);
+
+	resources.setName(resources[1], "foo");
+
+	EXPECT_STREQ(resources[0].name, "");
+	EXPECT_STREQ(resources[1].name, "foo");
+}
+
+GTEST_TEST(ArchiveResourceList, intern) {
+	Aurora::Archive::ResourceList resources;
+
+	resources.add("foo", Aurora::kFileTypeMDL, 0);
+	resources.add("foo", Aurora::kFileTypeMDX, 1);
+	resources.add("bar", Aurora::kFileTypeMDL, 2);
+
+	EXPECT_EQ(resources[0].name, resources[1].name);
+	EXPECT_NE(resources[0].name, resources[2].name);
+}
+
+GTEST_TEST(ArchiveResourceList, stableNames) {
+	Aurora::Archive::ResourceList resources;
+
+	resources.add("foo", Aurora::kFileTypeTXT, 0);
+	const char *name = resources[0].name;
+
+	// Enough names to need several blocks in the name table
+	for (uint32_t i = 1; i < 10000; i++)
+		resources.add(Common::composeString(i), Aurora::kFileTypeTXT, i);
+
+	resources.finish();
+
+	EXPECT_EQ(resources[0].name, name);
+	EXPECT_STREQ(resources[0].name, "foo");
+	EXPECT_STREQ(resources[9999].name, "9999");
+}
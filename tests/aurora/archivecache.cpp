@@ -0,0 +1,231 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our archive index cache.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/writefile.h"
+#include "src/common/readstream.h"
+
+#include "src/aurora/rimfile.h"
+#include "src/aurora/archivecache.h"
+
+static boost::filesystem::path kArchivePath;
+static boost::filesystem::path kCachePath;
+
+/** Write a RIM file with this many text resources. */
+static void writeRIM(const boost::filesystem::path &path, size_t count) {
+	static const size_t kHeaderSize   = 20;
+	static const size_t kResEntrySize = 32;
+	static const char  *kData         = "xoreos";
+
+	const size_t offData = kHeaderSize + count * kResEntrySize;
+
+	Common::WriteFile rim(path.generic_string());
+
+	rim.writeString("RIM V1.0");
+	rim.writeUint32LE(0);
+	rim.writeUint32LE(count);
+	rim.writeUint32LE(kHeaderSize);
+
+	for (size_t i = 0; i < count; i++) {
+		char name[16];
+		std::memset(name, 0, sizeof(name));
+		std::snprintf(name, sizeof(name), "file%u", (uint)i);
+
+		rim.write(name, sizeof(name));
+		rim.writeUint16LE(Aurora::kFileTypeTXT);
+		rim.writeUint32LE(i);
+		rim.writeUint16LE(0);
+		rim.writeUint32LE(offData + i * std::strlen(kData));
+		rim.writeUint32LE(std::strlen(kData));
+	}
+
+	for (size_t i = 0; i < count; i++)
+		rim.writeString(kData);
+
+	rim.flush();
+	rim.close();
+}
+
+class ArchiveCache : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		boost::filesystem::path tmpPath = boost::filesystem::temp_directory_path();
+
+		kArchivePath = tmpPath / boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.rim");
+		kCachePath   = tmpPath / boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.cache");
+	}
+
+	static void TearDownTestCase() {
+		boost::filesystem::remove(kArchivePath);
+		boost::filesystem::remove(kCachePath);
+	}
+
+	void SetUp() {
+		boost::filesystem::remove(kCachePath);
+
+		writeRIM(kArchivePath, 2);
+	}
+};
+
+GTEST_TEST_F(ArchiveCache, open) {
+	Aurora::ArchiveCache cache;
+	EXPECT_EQ(cache.size(), 0);
+
+	std::unique_ptr<Aurora::RIMFile> rim(cache.open<Aurora::RIMFile>(kArchivePath.generic_string()));
+	ASSERT_EQ(rim->getResources().size(), 2);
+	EXPECT_STREQ(rim->getResources()[1].name, "file1");
+
+	EXPECT_EQ(cache.size(), 1);
+	EXPECT_TRUE(cache.isModified());
+
+	std::unique_ptr<Common::SeekableReadStream> index(cache.getIndex(kArchivePath.generic_string()));
+	EXPECT_NE(index.get(), static_cast<Common::SeekableReadStream *>(0));
+}
+
+GTEST_TEST_F(ArchiveCache, saveLoad) {
+	{
+		Aurora::ArchiveCache cache;
+		delete cache.open<Aurora::RIMFile>(kArchivePath.generic_string());
+
+		cache.save(kCachePath.generic_string());
+		EXPECT_FALSE(cache.isModified());
+	}
+
+	Aurora::ArchiveCache cache;
+	ASSERT_TRUE(cache.load(kCachePath.generic_string()));
+
+	EXPECT_EQ(cache.size(), 1);
+	EXPECT_FALSE(cache.isModified());
+
+	std::unique_ptr<Common::SeekableReadStream> index(cache.getIndex(kArchivePath.generic_string()));
+	EXPECT_NE(index.get(), static_cast<Common::SeekableReadStream *>(0));
+}
+
+GTEST_TEST_F(ArchiveCache, openWithoutHeaders) {
+	Aurora::ArchiveCache cache;
+	delete cache.open<Aurora::RIMFile>(kArchivePath.generic_string());
+
+	// Break the RIM header, without changing the file's size or modification time
+	const std::time_t time = boost::filesystem::last_write_time(kArchivePath);
+	{
+		Common::WriteFile rim(kArchivePath.generic_string());
+
+		for (size_t i = 0; i < 20 + 2 * 32 + 2 * 6; i++)
+			rim.writeByte(0xFF);
+	}
+	boost::filesystem::last_write_time(kArchivePath, time);
+
+	std::unique_ptr<Aurora::RIMFile> rim(cache.open<Aurora::RIMFile>(kArchivePath.generic_string()));
+	ASSERT_EQ(rim->getResources().size(), 2);
+	EXPECT_STREQ(rim->getResources()[0].name, "file0");
+	EXPECT_EQ(rim->getResourceSize(0), 6);
+}
+
+GTEST_TEST_F(ArchiveCache, stale) {
+	Aurora::ArchiveCache cache;
+	delete cache.open<Aurora::RIMFile>(kArchivePath.generic_string());
+
+	writeRIM(kArchivePath, 3);
+
+	std::unique_ptr<Common::SeekableReadStream> staleIndex(cache.getIndex(kArchivePath.generic_string()));
+	EXPECT_EQ(staleIndex.get(), static_cast<Common::SeekableReadStream *>(0));
+
+	std::unique_ptr<Aurora::RIMFile> rim(cache.open<Aurora::RIMFile>(kArchivePath.generic_string()));
+	ASSERT_EQ(rim->getResources().size(), 3);
+	EXPECT_STREQ(rim->getResources()[2].name, "file2");
+
+	std::unique_ptr<Common::SeekableReadStream> index(cache.getIndex(kArchivePath.generic_string()));
+	EXPECT_NE(index.get(), static_cast<Common::SeekableReadStream *>(0));
+}
+
+GTEST_TEST_F(ArchiveCache, brokenIndex) {
+	static const byte kIndex[] = { 0x52, 0x49, 0x4D, 0x20, 0x56, 0x31, 0x2E, 0x30, 0xFF, 0xFF };
+
+	Aurora::ArchiveCache cache;
+	cache.setIndex(kArchivePath.generic_string(), kIndex, sizeof(kIndex));
+
+	std::unique_ptr<Aurora::RIMFile> rim(cache.open<Aurora::RIMFile>(kArchivePath.generic_string()));
+	ASSERT_EQ(rim->getResources().size(), 2);
+
+	std::unique_ptr<Common::SeekableReadStream> index(cache.getIndex(kArchivePath.generic_string()));
+	ASSERT_NE(index.get(), static_cast<Common::SeekableReadStream *>(0));
+	EXPECT_NE(index->size(), sizeof(kIndex));
+}
+
+GTEST_TEST_F(ArchiveCache, loadBroken) {
+	{
+		Common::WriteFile file(kCachePath.generic_string());
+		file.writeString("ARCC");
+		file.writeUint32LE(1);
+		file.writeUint32LE(0xFFFF);
+	}
+
+	Aurora::ArchiveCache cache;
+	EXPECT_FALSE(cache.load(kCachePath.generic_string()));
+	EXPECT_EQ(cache.size(), 0);
+
+	EXPECT_FALSE(cache.load(kCachePath.generic_string() + ".nope"));
+}
+
+GTEST_TEST_F(ArchiveCache, prune) {
+	Aurora::ArchiveCache cache;
+	delete cache.open<Aurora::RIMFile>(kArchivePath.generic_string());
+	ASSERT_EQ(cache.size(), 1);
+
+	cache.prune();
+	EXPECT_EQ(cache.size(), 1);
+
+	boost::filesystem::remove(kArchivePath);
+
+	cache.prune();
+	EXPECT_EQ(cache.size(), 0);
+}
+
+GTEST_TEST_F(ArchiveCache, savePrunes) {
+	{
+		Aurora::ArchiveCache cache;
+		delete cache.open<Aurora::RIMFile>(kArchivePath.generic_string());
+
+		boost::filesystem::remove(kArchivePath);
+
+		cache.save(kCachePath.generic_string());
+		EXPECT_EQ(cache.size(), 0);
+	}
+
+	Aurora::ArchiveCache cache;
+	ASSERT_TRUE(cache.load(kCachePath.generic_string()));
+	EXPECT_EQ(cache.size(), 0);
+}
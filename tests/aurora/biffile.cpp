@@ -22,10 +22,15 @@
  *  Unit tests for our BIF file archive class.
  */
 
+#include <atomic>
+#include <memory>
+
 #include "gtest/gtest.h"
 
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/biffile.h"
 #include "src/aurora/keyfile.h"
@@ -144,6 +149,54 @@ GTEST_TEST(BIFFile10, getResource) {
 	delete file;
 }
 
+GTEST_TEST(BIFFile10, getResourceNoCopy) {
+	Common::MemoryReadStream *stream =
+		new Common::MemoryReadStream(kBIF10File);
+
+	const Aurora::BIFFile bif(stream);
+
+	Common::SeekableReadStream *file = bif.getResource(0, true);
+	ASSERT_NE(file, static_cast<Common::SeekableReadStream *>(0));
+
+	ASSERT_EQ(file->size(), strlen(kFileData));
+	EXPECT_EQ(file->getData(), stream->getData() + stream->size() - strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	delete file;
+}
+
+GTEST_TEST(BIFFile10, readIndex) {
+	Common::MemoryWriteStreamDynamic index(true);
+	Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File)).writeIndex(index);
+
+	Common::MemoryReadStream indexStream(index.getData(), index.size());
+	const Aurora::BIFFile bif(new Common::MemoryReadStream(kBIF10File), indexStream);
+
+	EXPECT_EQ(bif.getResourceSize(0), strlen(kFileData));
+	EXPECT_EQ(bif.getResourceType(0), Aurora::kFileTypeTXT);
+
+	std::unique_ptr<Common::SeekableReadStream> file(bif.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+}
+
+GTEST_TEST(BIFFile10, readIndexBroken) {
+	Common::MemoryWriteStreamDynamic index(true);
+	Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File)).writeIndex(index);
+
+	// Too short to hold the resource table
+	Common::MemoryReadStream cutIndex(index.getData(), index.size() - 1);
+	EXPECT_THROW(Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File), cutIndex), Common::Exception);
+
+	// Not a BIF index at all
+	Common::MemoryReadStream keyIndex(kKEYFile);
+	EXPECT_THROW(Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File), keyIndex), Common::Exception);
+}
+
 GTEST_TEST(BIFFile10, mergeKEY) {
 	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
 
@@ -158,6 +211,120 @@ GTEST_TEST(BIFFile10, mergeKEY) {
 	delete bif;
 }
 
+GTEST_TEST(BIFFile10, mergeKEYDeferred) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	size_t opened = 0;
+	key.addDataFile(0, [&opened]() {
+		opened++;
+		return new Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File));
+	});
+
+	EXPECT_TRUE(key.haveDataFile(0));
+	EXPECT_FALSE(key.isDataFileOpen(0));
+	EXPECT_EQ(opened, 0);
+
+	std::unique_ptr<Common::SeekableReadStream> file(key.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	EXPECT_TRUE(key.isDataFileOpen(0));
+	EXPECT_EQ(key.getResourceSize(0), strlen(kFileData));
+	EXPECT_EQ(opened, 1);
+}
+
+GTEST_TEST(BIFFile10, mergeKEYDeferredBroken) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	size_t opened = 0;
+	key.addDataFile(0, [&opened]() -> Aurora::KEYDataFile * {
+		opened++;
+		throw Common::Exception("Broken");
+	});
+
+	EXPECT_TRUE(key.haveDataFile(0));
+
+	// Failing to open is remembered, the opener is never tried again
+	EXPECT_THROW(key.getResource(0), Common::Exception);
+	EXPECT_THROW(key.getResource(0), Common::Exception);
+	EXPECT_EQ(key.getResourceSize(0), 0xFFFFFFFF);
+
+	EXPECT_FALSE(key.isDataFileOpen(0));
+	EXPECT_EQ(opened, 1);
+}
+
+GTEST_TEST(BIFFile10, mergeKEYInvalidIndex) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	EXPECT_THROW(key.addDataFile(1, []() {
+		return new Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File));
+	}), Common::Exception);
+
+	Aurora::BIFFile bif(new Common::MemoryReadStream(kBIF10File));
+	EXPECT_THROW(key.addDataFile(1, &bif), Common::Exception);
+
+	EXPECT_FALSE(key.haveDataFile(0));
+}
+
+GTEST_TEST(BIFFile10, mergeKEYPrewarm) {
+	Common::ThreadPool pool(2);
+
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	key.addDataFile(0, []() {
+		return new Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File));
+	});
+
+	key.prewarmDataFiles(pool);
+
+	// Too late to add data files now
+	EXPECT_THROW(key.addDataFile(0, []() {
+		return new Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File));
+	}), Common::Exception);
+
+	std::unique_ptr<Common::SeekableReadStream> file(key.getResource(0));
+	EXPECT_EQ(file->size(), strlen(kFileData));
+
+	EXPECT_TRUE(key.isDataFileOpen(0));
+}
+
+GTEST_TEST(BIFFile10, mergeKEYPrewarmCancel) {
+	Common::ThreadPool pool(1);
+
+	// Keep the only worker busy, so that the pre-warm can't start
+	std::atomic<bool> started(false), release(false);
+
+	std::future<void> blocker = pool.submit([&started, &release]() {
+		started = true;
+		while (!release)
+			std::this_thread::yield();
+	});
+
+	while (!started)
+		std::this_thread::yield();
+
+	std::atomic<size_t> opened(0);
+
+	{
+		Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+		key.addDataFile(0, [&opened]() {
+			opened++;
+			return new Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File));
+		});
+
+		key.prewarmDataFiles(pool);
+
+		// Destroying the KEY cancels the pre-warm, without blocking on the busy worker
+	}
+
+	EXPECT_EQ(opened, 0);
+
+	release = true;
+	blocker.get();
+
+	EXPECT_EQ(opened, 0);
+}
+
 // --- BIF V1.1 ---
 
 // Percy Bysshe Shelley's "Ozymandias", within a BIF V1.1 file
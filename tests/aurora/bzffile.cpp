@@ -22,10 +22,13 @@
  *  Unit tests for our BZF file archive class.
  */
 
+#include <memory>
+
 #include "gtest/gtest.h"
 
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
 
 #include "src/aurora/bzffile.h"
 #include "src/aurora/keyfile.h"
@@ -130,6 +133,23 @@ GTEST_TEST(BZFFile, getResource) {
 	delete file;
 }
 
+GTEST_TEST(BZFFile, readIndex) {
+	Common::MemoryWriteStreamDynamic index(true);
+	Aurora::BZFFile(new Common::MemoryReadStream(kBZFFile)).writeIndex(index);
+
+	Common::MemoryReadStream indexStream(index.getData(), index.size());
+	const Aurora::BZFFile bzf(new Common::MemoryReadStream(kBZFFile), indexStream);
+
+	EXPECT_EQ(bzf.getResourceSize(0), strlen(kFileData));
+	EXPECT_EQ(bzf.getResourceType(0), Aurora::kFileTypeTXT);
+
+	std::unique_ptr<Common::SeekableReadStream> file(bzf.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+}
+
 GTEST_TEST(BZFFile, mergeKEY) {
 	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
 
@@ -22,11 +22,14 @@
  *  Unit tests for our ERF file archive class.
  */
 
+#include <memory>
+
 #include "gtest/gtest.h"
 
 #include "src/common/error.h"
 #include "src/common/hash.h"
 #include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
 
 #include "src/aurora/locstring.h"
 #include "src/aurora/language.h"
@@ -40,6 +43,14 @@ public:
 	}
 };
 
+/** Write the index of an ERF file, as used by the ArchiveCache. */
+static Common::SeekableReadStream *writeIndex(const Aurora::ERFFile &erf) {
+	Common::MemoryWriteStreamDynamic index(false);
+	erf.writeIndex(index);
+
+	return new Common::MemoryReadStream(index.getData(), index.size(), true);
+}
+
 // Percy Bysshe Shelley's "Ozymandias"
 static const char *kFileData =
 	"I met a traveller from an antique land\n"
@@ -168,7 +179,7 @@ GTEST_TEST(ERFFile10, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -212,6 +223,49 @@ GTEST_TEST(ERFFile10, getResource) {
 	delete file;
 }
 
+GTEST_TEST(ERFFile10, readIndex) {
+	LangMan.addLanguage(Aurora::kLanguageEnglish, 0, Common::kEncodingUTF8);
+
+	std::unique_ptr<Common::SeekableReadStream> index(writeIndex(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile10))));
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(kERFFile10), *index);
+
+	EXPECT_EQ(erf.getBuildYear(), 2000);
+	EXPECT_EQ(erf.getBuildDay(), 23);
+
+	EXPECT_EQ(erf.getDescription().getID(), 0);
+	EXPECT_STREQ(erf.getDescription().getString().c_str(), "xoreos unit test");
+
+	const Aurora::ERFFile::ResourceList &resources = erf.getResources();
+	ASSERT_EQ(resources.size(), 1);
+
+	EXPECT_STREQ(resources[0].name, "ozymandias");
+	EXPECT_EQ(resources[0].type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(resources[0].index, 0);
+
+	EXPECT_EQ(erf.getResourceSize(0), strlen(kFileData));
+
+	std::unique_ptr<Common::SeekableReadStream> file(erf.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	Aurora::LanguageManager::destroy();
+}
+
+GTEST_TEST(ERFFile10, readIndexBroken) {
+	static const byte kIndex[] = { 0x42, 0x49, 0x46, 0x46, 0x56, 0x31, 0x20, 0x20 };
+
+	Common::MemoryReadStream index(kIndex);
+	EXPECT_THROW(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile10), index), Common::Exception);
+
+	std::unique_ptr<Common::SeekableReadStream> fullIndex(writeIndex(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile10))));
+
+	Common::SeekableSubReadStream cutIndex(fullIndex.get(), 0, fullIndex->size() - 4);
+	EXPECT_THROW(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile10), cutIndex), Common::Exception);
+}
+
 GTEST_TEST(ERFFile10, typeMOD) {
 	static const byte kERF[] = {
 		0x4D,0x4F,0x44,0x20,0x56,0x31,0x2E,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
@@ -396,7 +450,7 @@ GTEST_TEST(ERFFile11NWN, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -444,6 +498,38 @@ GTEST_TEST(ERFFile11NWN, getResource) {
 	delete file;
 }
 
+GTEST_TEST(ERFFile11NWN, readIndex) {
+	PasswordStore password(kERF11NWNPassword);
+
+	std::unique_ptr<Common::SeekableReadStream>
+		index(writeIndex(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile11NWN), password)));
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(kERFFile11NWN), *index, password);
+
+	const Aurora::ERFFile::ResourceList &resources = erf.getResources();
+	ASSERT_EQ(resources.size(), 1);
+
+	EXPECT_STREQ(resources[0].name, "ozymandias");
+	EXPECT_EQ(resources[0].type, Aurora::kFileTypeTXT);
+
+	std::unique_ptr<Common::SeekableReadStream> file(erf.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+}
+
+GTEST_TEST(ERFFile11NWN, readIndexWrongPassword) {
+	PasswordStore password(kERF11NWNPassword);
+
+	std::unique_ptr<Common::SeekableReadStream>
+		index(writeIndex(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile11NWN), password)));
+
+	password[0] ^= 0xFF;
+
+	EXPECT_THROW(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile11NWN), *index, password), Common::Exception);
+}
+
 GTEST_TEST(ERFFile11NWN, typeMOD) {
 	static const byte kERF[] = {
 		0x4D,0x4F,0x44,0x20,0x56,0x31,0x2E,0x31,0xD5,0x8A,0x94,0xF2,0x3C,0x53,0x13,0xAA,
@@ -625,7 +711,7 @@ GTEST_TEST(ERFFile11NWN2, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -839,7 +925,7 @@ GTEST_TEST(ERFFile20, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -1031,7 +1117,7 @@ GTEST_TEST(ERFFile22Plain, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -1165,7 +1251,7 @@ GTEST_TEST(ERFFile22DeflateHeader, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -1299,7 +1385,7 @@ GTEST_TEST(ERFFile22DeflateRaw, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -1456,7 +1542,7 @@ GTEST_TEST(ERFFile22Blowfish, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -1504,6 +1590,30 @@ GTEST_TEST(ERFFile22Blowfish, getResource) {
 	delete file;
 }
 
+GTEST_TEST(ERFFile22Blowfish, readIndex) {
+	PasswordStore password(kERF22BPassword);
+
+	std::unique_ptr<Common::SeekableReadStream>
+		index(writeIndex(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile22B), password)));
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(kERFFile22B), *index, password);
+
+	const Aurora::ERFFile::ResourceList &resources = erf.getResources();
+	ASSERT_EQ(resources.size(), 1);
+
+	EXPECT_STREQ(resources[0].name, "ozymandias");
+	EXPECT_EQ(resources[0].type, Aurora::kFileTypeTXT);
+
+	std::unique_ptr<Common::SeekableReadStream> file(erf.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	index->seek(0);
+	EXPECT_THROW(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile22B), *index), Common::Exception);
+}
+
 // --- ERF V2.2 (Blowfish + raw DEFLATE) ---
 
 // Percy Bysshe Shelley's "Ozymandias", within an ERF V2.2 (Blowfish + raw DEFLATE) file
@@ -1601,7 +1711,7 @@ GTEST_TEST(ERFFile22BlowfishDeflateRaw, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -1752,7 +1862,7 @@ GTEST_TEST(ERFFile30Plain, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, Common::hashString("ozymandias.txt", Common::kHashFNV64));
 	EXPECT_EQ(resource.index, 0);
@@ -1774,6 +1884,19 @@ GTEST_TEST(ERFFile30Plain, findResourceHash) {
 	EXPECT_EQ(erf.findResource(0), 0xFFFFFFFF);
 }
 
+GTEST_TEST(ERFFile30Plain, findResourcesHash) {
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(kERFFile30Plain));
+
+	const std::vector<uint32_t> indices = erf.findResources({
+		Common::hashString("ozymandias.txt", Common::kHashFNV64), 0
+	});
+
+	ASSERT_EQ(indices.size(), 2);
+
+	EXPECT_EQ(indices[0], 0);
+	EXPECT_EQ(indices[1], 0xFFFFFFFF);
+}
+
 GTEST_TEST(ERFFile30Plain, findResourceName) {
 	const Aurora::ERFFile erf(new Common::MemoryReadStream(kERFFile30Plain));
 
@@ -1798,6 +1921,29 @@ GTEST_TEST(ERFFile30Plain, getResource) {
 	delete file;
 }
 
+GTEST_TEST(ERFFile30Plain, readIndex) {
+	std::unique_ptr<Common::SeekableReadStream> index(writeIndex(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile30Plain))));
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(kERFFile30Plain), *index);
+
+	EXPECT_EQ(erf.getNameHashAlgo(), Common::kHashFNV64);
+
+	const Aurora::ERFFile::ResourceList &resources = erf.getResources();
+	ASSERT_EQ(resources.size(), 1);
+
+	EXPECT_STREQ(resources[0].name, "ozymandias");
+	EXPECT_EQ(resources[0].type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(resources[0].hash, Common::hashString("ozymandias.txt", Common::kHashFNV64));
+
+	EXPECT_EQ(erf.findResource(Common::hashString("ozymandias.txt", Common::kHashFNV64)), 0);
+
+	std::unique_ptr<Common::SeekableReadStream> file(erf.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+}
+
 // --- ERF V3.0 (without filenames) ---
 
 // Percy Bysshe Shelley's "Ozymandias", within an ERF V3.0 (without filenames) file
@@ -1900,7 +2046,7 @@ GTEST_TEST(ERFFile30NoFilenames, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "");
+	EXPECT_STREQ(resource.name, "");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, Common::hashString("ozymandias.txt", Common::kHashFNV64));
 	EXPECT_EQ(resource.index, 0);
@@ -2033,7 +2179,7 @@ GTEST_TEST(ERFFile30DeflateHeader, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, Common::hashString("ozymandias.txt", Common::kHashFNV64));
 	EXPECT_EQ(resource.index, 0);
@@ -2167,7 +2313,7 @@ GTEST_TEST(ERFFile30DeflateRaw, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, Common::hashString("ozymandias.txt", Common::kHashFNV64));
 	EXPECT_EQ(resource.index, 0);
@@ -2323,7 +2469,7 @@ GTEST_TEST(ERFFile30Blowfish, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, Common::hashString("ozymandias.txt", Common::kHashFNV64));
 	EXPECT_EQ(resource.index, 0);
@@ -2468,7 +2614,7 @@ GTEST_TEST(ERFFile30BlowfishDeflateRaw, getResources) {
 
 	const Aurora::ERFFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, Common::hashString("ozymandias.txt", Common::kHashFNV64));
 	EXPECT_EQ(resource.index, 0);
@@ -22,12 +22,16 @@
  *  Unit tests for our KEY resource index reader.
  */
 
+#include <cstring>
+#include <memory>
 #include <vector>
 
 #include "gtest/gtest.h"
 
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
 
 #include "src/aurora/keyfile.h"
 
@@ -67,7 +71,7 @@ GTEST_TEST(KEYFile10, getResources) {
 	const Aurora::KEYFile::ResourceList &res = key.getResources();
 	ASSERT_EQ(res.size(), 1);
 
-	EXPECT_STREQ(res.begin()->name.c_str(), "ozymandias");
+	EXPECT_STREQ(res.begin()->name, "ozymandias");
 	EXPECT_EQ(res.begin()->type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(res.begin()->index, 0);
 	EXPECT_EQ(res.begin()->hash, 0);
@@ -110,6 +114,120 @@ GTEST_TEST(KEYFile10, findResourceName) {
 	EXPECT_EQ(key.findResource("nope"      , Aurora::kFileTypeBMP), 0xFFFFFFFF);
 }
 
+GTEST_TEST(KEYFile10, getDataFileResources) {
+	const Aurora::KEYFile key(new Common::MemoryReadStream(kKEY10File));
+
+	const Aurora::KEYFile::DataFileResources resources = key.getDataFileResources(0);
+	ASSERT_EQ(resources.size(), 1);
+	EXPECT_EQ(*resources.begin(), 0);
+
+	EXPECT_TRUE(key.getDataFileResources(1).empty());
+}
+
+GTEST_TEST(KEYFile10, getResourceListForDataFile) {
+	const Aurora::KEYFile key(new Common::MemoryReadStream(kKEY10File));
+
+	const std::vector<const Aurora::Archive::Resource *> resources = key.getResourceListForDataFile("data/xoreos.bif");
+	ASSERT_EQ(resources.size(), 1);
+	EXPECT_STREQ(resources[0]->name, "ozymandias");
+
+	EXPECT_TRUE(key.getResourceListForDataFile("data/nope.bif").empty());
+}
+
+/** Create a KEY V1 with several data files, whose resources are interleaved. */
+static Common::MemoryReadStream *createKEY10MultiFile() {
+	static const char *kDataFiles[] = { "a.bif", "b.bif", "c.bif" };
+	static const uint32_t kResDataFile[] = { 1, 0, 1, 1, 0, 1 };
+
+	const size_t dataFileCount = ARRAYSIZE(kDataFiles);
+	const size_t resCount      = ARRAYSIZE(kResDataFile);
+
+	const size_t offFileTable = 64;
+	const size_t offNames     = offFileTable + dataFileCount * 12;
+	const size_t offResTable  = offNames + dataFileCount * 5;
+	const size_t size         = offResTable + resCount * 22;
+
+	byte *data = new byte[size];
+	std::memset(data, 0, size);
+
+	std::memcpy(data, "KEY V1  ", 8);
+	WRITE_LE_UINT32(data +  8, dataFileCount);
+	WRITE_LE_UINT32(data + 12, resCount);
+	WRITE_LE_UINT32(data + 16, offFileTable);
+	WRITE_LE_UINT32(data + 20, offResTable);
+
+	for (size_t i = 0; i < dataFileCount; i++) {
+		WRITE_LE_UINT32(data + offFileTable + i * 12 + 4, offNames + i * 5);
+		WRITE_LE_UINT16(data + offFileTable + i * 12 + 8, 5);
+
+		std::memcpy(data + offNames + i * 5, kDataFiles[i], 5);
+	}
+
+	for (size_t i = 0; i < resCount; i++) {
+		byte *res = data + offResTable + i * 22;
+
+		res[0] = 'a' + i;
+		WRITE_LE_UINT16(res + 16, Aurora::kFileTypeTXT);
+		WRITE_LE_UINT32(res + 18, (kResDataFile[i] << 20) | i);
+	}
+
+	return new Common::MemoryReadStream(data, size, true);
+}
+
+GTEST_TEST(KEYFile10, getDataFileResourcesMultiFile) {
+	const Aurora::KEYFile key(createKEY10MultiFile());
+
+	ASSERT_EQ(key.getDataFileList().size(), 3);
+
+	const Aurora::KEYFile::DataFileResources resources0 = key.getDataFileResources(0);
+	ASSERT_EQ(resources0.size(), 2);
+	EXPECT_EQ(resources0.begin()[0], 1);
+	EXPECT_EQ(resources0.begin()[1], 4);
+
+	const Aurora::KEYFile::DataFileResources resources1 = key.getDataFileResources(1);
+	ASSERT_EQ(resources1.size(), 4);
+	EXPECT_EQ(resources1.begin()[0], 0);
+	EXPECT_EQ(resources1.begin()[1], 2);
+	EXPECT_EQ(resources1.begin()[2], 3);
+	EXPECT_EQ(resources1.begin()[3], 5);
+
+	EXPECT_TRUE(key.getDataFileResources(2).empty());
+	EXPECT_TRUE(key.getDataFileResources(3).empty());
+
+	const std::vector<const Aurora::Archive::Resource *> resources = key.getResourceListForDataFile("a.bif");
+	ASSERT_EQ(resources.size(), 2);
+	EXPECT_STREQ(resources[0]->name, "b");
+	EXPECT_STREQ(resources[1]->name, "e");
+}
+
+GTEST_TEST(KEYFile10, readIndex) {
+	Common::MemoryWriteStreamDynamic index(true);
+	Aurora::KEYFile(createKEY10MultiFile()).writeIndex(index);
+
+	Common::MemoryReadStream indexStream(index.getData(), index.size());
+	const Aurora::KEYFile key(new Common::MemoryReadStream(kKEY10File), indexStream);
+
+	ASSERT_EQ(key.getDataFileList().size(), 3);
+	EXPECT_STREQ(key.getDataFileList()[0].c_str(), "a.bif");
+	EXPECT_STREQ(key.getDataFileList()[2].c_str(), "c.bif");
+
+	const Aurora::KEYFile::ResourceList &resources = key.getResources();
+	ASSERT_EQ(resources.size(), 6);
+
+	EXPECT_STREQ(resources[3].name, "d");
+	EXPECT_EQ(resources[3].type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(resources[3].index, 3);
+
+	EXPECT_FALSE(key.haveDataFile(3));
+
+	const Aurora::KEYFile::DataFileResources resources0 = key.getDataFileResources(0);
+	ASSERT_EQ(resources0.size(), 2);
+	EXPECT_EQ(resources0.begin()[0], 1);
+	EXPECT_EQ(resources0.begin()[1], 4);
+
+	EXPECT_EQ(key.findResource("e", Aurora::kFileTypeTXT), 4);
+}
+
 // --- KEY V1.1 ---
 
 static const byte kKEY11File[] = {
@@ -146,7 +264,7 @@ GTEST_TEST(KEYFile11, getResources) {
 	const Aurora::KEYFile::ResourceList &res = key.getResources();
 	ASSERT_EQ(res.size(), 1);
 
-	EXPECT_STREQ(res.begin()->name.c_str(), "ozymandias");
+	EXPECT_STREQ(res.begin()->name, "ozymandias");
 	EXPECT_EQ(res.begin()->type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(res.begin()->index, 0);
 	EXPECT_EQ(res.begin()->hash, 0);
@@ -0,0 +1,124 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for opening archives of any supported type.
+ */
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
+
+#include "src/aurora/openarchive.h"
+#include "src/aurora/erffile.h"
+
+// Percy Bysshe Shelley's "Ozymandias", within an ERF V1.0 file
+static const byte kERFFile[] = {
+	0x45,0x52,0x46,0x20,0x56,0x31,0x2E,0x30,0x01,0x00,0x00,0x00,0x18,0x00,0x00,0x00,
+	0x01,0x00,0x00,0x00,0xA0,0x00,0x00,0x00,0xB8,0x00,0x00,0x00,0xD0,0x00,0x00,0x00,
+	0x64,0x00,0x00,0x00,0x17,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x78,0x6F,0x72,0x65,0x6F,0x73,0x20,0x75,
+	0x6E,0x69,0x74,0x20,0x74,0x65,0x73,0x74,0x6F,0x7A,0x79,0x6D,0x61,0x6E,0x64,0x69,
+	0x61,0x73,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x0A,0x00,0x00,0x00,
+	0xD8,0x00,0x00,0x00,0x6F,0x02,0x00,0x00,0x49,0x20,0x6D,0x65,0x74,0x20,0x61,0x20,
+	0x74,0x72,0x61,0x76,0x65,0x6C,0x6C,0x65,0x72,0x20,0x66,0x72,0x6F,0x6D,0x20,0x61,
+	0x6E,0x20,0x61,0x6E,0x74,0x69,0x71,0x75,0x65,0x20,0x6C,0x61,0x6E,0x64,0x0A,0x57,
+	0x68,0x6F,0x20,0x73,0x61,0x69,0x64,0x3A,0x20,0x54,0x77,0x6F,0x20,0x76,0x61,0x73,
+	0x74,0x20,0x61,0x6E,0x64,0x20,0x74,0x72,0x75,0x6E,0x6B,0x6C,0x65,0x73,0x73,0x20,
+	0x6C,0x65,0x67,0x73,0x20,0x6F,0x66,0x20,0x73,0x74,0x6F,0x6E,0x65,0x0A,0x53,0x74,
+	0x61,0x6E,0x64,0x20,0x69,0x6E,0x20,0x74,0x68,0x65,0x20,0x64,0x65,0x73,0x65,0x72,
+	0x74,0x2E,0x20,0x4E,0x65,0x61,0x72,0x20,0x74,0x68,0x65,0x6D,0x2C,0x20,0x6F,0x6E,
+	0x20,0x74,0x68,0x65,0x20,0x73,0x61,0x6E,0x64,0x2C,0x0A,0x48,0x61,0x6C,0x66,0x20,
+	0x73,0x75,0x6E,0x6B,0x2C,0x20,0x61,0x20,0x73,0x68,0x61,0x74,0x74,0x65,0x72,0x65,
+	0x64,0x20,0x76,0x69,0x73,0x61,0x67,0x65,0x20,0x6C,0x69,0x65,0x73,0x2C,0x20,0x77,
+	0x68,0x6F,0x73,0x65,0x20,0x66,0x72,0x6F,0x77,0x6E,0x2C,0x0A,0x41,0x6E,0x64,0x20,
+	0x77,0x72,0x69,0x6E,0x6B,0x6C,0x65,0x64,0x20,0x6C,0x69,0x70,0x2C,0x20,0x61,0x6E,
+	0x64,0x20,0x73,0x6E,0x65,0x65,0x72,0x20,0x6F,0x66,0x20,0x63,0x6F,0x6C,0x64,0x20,
+	0x63,0x6F,0x6D,0x6D,0x61,0x6E,0x64,0x2C,0x0A,0x54,0x65,0x6C,0x6C,0x20,0x74,0x68,
+	0x61,0x74,0x20,0x69,0x74,0x73,0x20,0x73,0x63,0x75,0x6C,0x70,0x74,0x6F,0x72,0x20,
+	0x77,0x65,0x6C,0x6C,0x20,0x74,0x68,0x6F,0x73,0x65,0x20,0x70,0x61,0x73,0x73,0x69,
+	0x6F,0x6E,0x73,0x20,0x72,0x65,0x61,0x64,0x0A,0x57,0x68,0x69,0x63,0x68,0x20,0x79,
+	0x65,0x74,0x20,0x73,0x75,0x72,0x76,0x69,0x76,0x65,0x2C,0x20,0x73,0x74,0x61,0x6D,
+	0x70,0x65,0x64,0x20,0x6F,0x6E,0x20,0x74,0x68,0x65,0x73,0x65,0x20,0x6C,0x69,0x66,
+	0x65,0x6C,0x65,0x73,0x73,0x20,0x74,0x68,0x69,0x6E,0x67,0x73,0x2C,0x0A,0x54,0x68,
+	0x65,0x20,0x68,0x61,0x6E,0x64,0x20,0x74,0x68,0x61,0x74,0x20,0x6D,0x6F,0x63,0x6B,
+	0x65,0x64,0x20,0x74,0x68,0x65,0x6D,0x20,0x61,0x6E,0x64,0x20,0x74,0x68,0x65,0x20,
+	0x68,0x65,0x61,0x72,0x74,0x20,0x74,0x68,0x61,0x74,0x20,0x66,0x65,0x64,0x3A,0x0A,
+	0x41,0x6E,0x64,0x20,0x6F,0x6E,0x20,0x74,0x68,0x65,0x20,0x70,0x65,0x64,0x65,0x73,
+	0x74,0x61,0x6C,0x20,0x74,0x68,0x65,0x73,0x65,0x20,0x77,0x6F,0x72,0x64,0x73,0x20,
+	0x61,0x70,0x70,0x65,0x61,0x72,0x3A,0x0A,0x27,0x4D,0x79,0x20,0x6E,0x61,0x6D,0x65,
+	0x20,0x69,0x73,0x20,0x4F,0x7A,0x79,0x6D,0x61,0x6E,0x64,0x69,0x61,0x73,0x2C,0x20,
+	0x6B,0x69,0x6E,0x67,0x20,0x6F,0x66,0x20,0x6B,0x69,0x6E,0x67,0x73,0x3A,0x0A,0x4C,
+	0x6F,0x6F,0x6B,0x20,0x6F,0x6E,0x20,0x6D,0x79,0x20,0x77,0x6F,0x72,0x6B,0x73,0x2C,
+	0x20,0x79,0x65,0x20,0x4D,0x69,0x67,0x68,0x74,0x79,0x2C,0x20,0x61,0x6E,0x64,0x20,
+	0x64,0x65,0x73,0x70,0x61,0x69,0x72,0x21,0x27,0x0A,0x4E,0x6F,0x74,0x68,0x69,0x6E,
+	0x67,0x20,0x62,0x65,0x73,0x69,0x64,0x65,0x20,0x72,0x65,0x6D,0x61,0x69,0x6E,0x73,
+	0x2E,0x20,0x52,0x6F,0x75,0x6E,0x64,0x20,0x74,0x68,0x65,0x20,0x64,0x65,0x63,0x61,
+	0x79,0x0A,0x4F,0x66,0x20,0x74,0x68,0x61,0x74,0x20,0x63,0x6F,0x6C,0x6F,0x73,0x73,
+	0x61,0x6C,0x20,0x77,0x72,0x65,0x63,0x6B,0x2C,0x20,0x62,0x6F,0x75,0x6E,0x64,0x6C,
+	0x65,0x73,0x73,0x20,0x61,0x6E,0x64,0x20,0x62,0x61,0x72,0x65,0x0A,0x54,0x68,0x65,
+	0x20,0x6C,0x6F,0x6E,0x65,0x20,0x61,0x6E,0x64,0x20,0x6C,0x65,0x76,0x65,0x6C,0x20,
+	0x73,0x61,0x6E,0x64,0x73,0x20,0x73,0x74,0x72,0x65,0x74,0x63,0x68,0x20,0x66,0x61,
+	0x72,0x20,0x61,0x77,0x61,0x79,0x2E
+};
+
+GTEST_TEST(openArchive, streamERF) {
+	std::unique_ptr<Aurora::Archive> archive(Aurora::openArchive(new Common::MemoryReadStream(kERFFile),
+	                                                             Aurora::kFileTypeERF));
+
+	ASSERT_NE(dynamic_cast<Aurora::ERFFile *>(archive.get()), static_cast<Aurora::ERFFile *>(0));
+	EXPECT_EQ(archive->getResources().size(), 1);
+}
+
+GTEST_TEST(openArchive, streamRIMIsERF) {
+	std::unique_ptr<Aurora::Archive> archive(Aurora::openArchive(new Common::MemoryReadStream(kERFFile),
+	                                                             Aurora::kFileTypeRIM));
+
+	ASSERT_NE(dynamic_cast<Aurora::ERFFile *>(archive.get()), static_cast<Aurora::ERFFile *>(0));
+	EXPECT_EQ(archive->getResources().size(), 1);
+}
+
+GTEST_TEST(openArchive, streamInvalidType) {
+	EXPECT_THROW(Aurora::openArchive(new Common::MemoryReadStream(kERFFile), Aurora::kFileTypeTXT),
+	             Common::Exception);
+}
+
+GTEST_TEST(openArchive, fileInvalidType) {
+	EXPECT_THROW(Aurora::openArchive("/this/file/does/not/exist.txt"), Common::Exception);
+}
+
+GTEST_TEST(openArchive, cancelled) {
+	Common::CancelToken cancel;
+	cancel.cancel();
+
+	EXPECT_EQ(Aurora::openArchive(new Common::MemoryReadStream(kERFFile), Aurora::kFileTypeERF,
+	                              0, "", &cancel), static_cast<Aurora::Archive *>(0));
+}
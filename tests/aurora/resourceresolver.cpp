@@ -0,0 +1,298 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our install-wide resource resolver.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/writefile.h"
+#include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/resourceresolver.h"
+
+static boost::filesystem::path kBasePath;
+
+/** Write a RIM file with this many text resources, all with the same contents. */
+static void writeRIM(const boost::filesystem::path &path, size_t count, const char *data) {
+	static const size_t kHeaderSize   = 20;
+	static const size_t kResEntrySize = 32;
+
+	const size_t offData = kHeaderSize + count * kResEntrySize;
+
+	Common::WriteFile rim(path.generic_string());
+
+	rim.writeString("RIM V1.0");
+	rim.writeUint32LE(0);
+	rim.writeUint32LE(count);
+	rim.writeUint32LE(kHeaderSize);
+
+	for (size_t i = 0; i < count; i++) {
+		char name[16];
+		std::memset(name, 0, sizeof(name));
+		std::snprintf(name, sizeof(name), "File%u", (uint)i);
+
+		rim.write(name, sizeof(name));
+		rim.writeUint16LE(Aurora::kFileTypeTXT);
+		rim.writeUint32LE(i);
+		rim.writeUint16LE(0);
+		rim.writeUint32LE(offData + i * std::strlen(data));
+		rim.writeUint32LE(std::strlen(data));
+	}
+
+	for (size_t i = 0; i < count; i++)
+		rim.writeString(data);
+
+	rim.flush();
+	rim.close();
+}
+
+static void writeFile(const boost::filesystem::path &path, const char *data) {
+	Common::WriteFile file(path.generic_string());
+
+	file.writeString(data);
+
+	file.flush();
+	file.close();
+}
+
+static Common::UString readResource(const Aurora::ResourceResolver &resolver,
+                                    const Common::UString &name, Aurora::FileType type) {
+
+	std::unique_ptr<Common::SeekableReadStream> stream(resolver.getResource(name, type));
+	if (!stream)
+		return "";
+
+	return Common::readStringFixed(*stream, Common::kEncodingASCII, stream->size());
+}
+
+/** An archive that only knows the hashes of its resource names. */
+class HashedArchive : public Aurora::Archive {
+public:
+	HashedArchive(const std::vector<Common::UString> &names) {
+		for (size_t i = 0; i < names.size(); i++)
+			_resources.add("", Aurora::kFileTypeTXT, i, Common::hashString(names[i], Common::kHashFNV64));
+
+		_resources.finish();
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	Common::SeekableReadStream *getResource(uint32_t UNUSED(index), bool UNUSED(tryNoCopy)) const {
+		static const byte kData[] = { 'h', 'a', 's', 'h' };
+
+		return new Common::MemoryReadStream(kData);
+	}
+
+	Common::HashAlgo getNameHashAlgo() const {
+		return Common::kHashFNV64;
+	}
+
+private:
+	ResourceList _resources;
+};
+
+class ResourceResolver : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kBasePath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%");
+
+		boost::filesystem::create_directories(kBasePath / "override" / "sub");
+		boost::filesystem::create_directories(kBasePath / "dlc" / "pack");
+
+		writeRIM(kBasePath / "base.rim", 4, "base");
+		writeRIM(kBasePath / "module.rim", 2, "module");
+
+		writeRIM(kBasePath / "dlc" / "a.rim", 3, "dlca");
+		writeRIM(kBasePath / "dlc" / "pack" / "b.rim", 4, "dlcb");
+
+		writeFile(kBasePath / "override" / "file0.txt", "override");
+		writeFile(kBasePath / "override" / "sub" / "FILE3.TXT", "overridesub");
+	}
+
+	static void TearDownTestCase() {
+		boost::filesystem::remove_all(kBasePath);
+	}
+
+	static Common::UString getPath(const char *path) {
+		return (kBasePath / path).generic_string();
+	}
+};
+
+GTEST_TEST_F(ResourceResolver, addArchive) {
+	Aurora::ResourceResolver resolver;
+
+	EXPECT_EQ(resolver.addArchive(getPath("base.rim"), Aurora::kPriorityBase), 0);
+	EXPECT_EQ(resolver.getLayerCount(), 1);
+	EXPECT_EQ(resolver.size(), 4);
+
+	EXPECT_TRUE(resolver.hasResource("file3", Aurora::kFileTypeTXT));
+	EXPECT_FALSE(resolver.hasResource("file4", Aurora::kFileTypeTXT));
+	EXPECT_FALSE(resolver.hasResource("file3", Aurora::kFileTypeNSS));
+
+	const Aurora::ResourceResolver::Location location = resolver.resolve("file2", Aurora::kFileTypeTXT);
+	ASSERT_TRUE(location.isValid());
+	EXPECT_EQ(location.layer, 0);
+	EXPECT_EQ(location.index, 2);
+	EXPECT_EQ(resolver.getResourceSize(location), 4);
+
+	EXPECT_EQ(readResource(resolver, "file2", Aurora::kFileTypeTXT), "base");
+	EXPECT_EQ(resolver.getResource("file4", Aurora::kFileTypeTXT), static_cast<Common::SeekableReadStream *>(0));
+}
+
+GTEST_TEST_F(ResourceResolver, caseInsensitive) {
+	Aurora::ResourceResolver resolver;
+	resolver.addArchive(getPath("base.rim"), Aurora::kPriorityBase);
+
+	EXPECT_TRUE(resolver.hasResource("file1", Aurora::kFileTypeTXT));
+	EXPECT_TRUE(resolver.hasResource("File1", Aurora::kFileTypeTXT));
+	EXPECT_TRUE(resolver.hasResource("FILE1", Aurora::kFileTypeTXT));
+}
+
+GTEST_TEST_F(ResourceResolver, priority) {
+	Aurora::ResourceResolver resolver;
+
+	// Add in the "wrong" order, to make sure only the priority matters
+	resolver.addArchive(getPath("module.rim"), Aurora::kPriorityModule);
+	resolver.addArchive(getPath("base.rim"), Aurora::kPriorityBase);
+
+	EXPECT_EQ(resolver.size(), 4);
+
+	EXPECT_EQ(readResource(resolver, "file0", Aurora::kFileTypeTXT), "module");
+	EXPECT_EQ(readResource(resolver, "file1", Aurora::kFileTypeTXT), "module");
+	EXPECT_EQ(readResource(resolver, "file2", Aurora::kFileTypeTXT), "base");
+	EXPECT_EQ(readResource(resolver, "file3", Aurora::kFileTypeTXT), "base");
+}
+
+GTEST_TEST_F(ResourceResolver, priorityTie) {
+	Aurora::ResourceResolver resolver;
+
+	resolver.addArchive(getPath("base.rim"), Aurora::kPriorityBase);
+	resolver.addArchive(getPath("module.rim"), Aurora::kPriorityBase);
+
+	EXPECT_EQ(readResource(resolver, "file0", Aurora::kFileTypeTXT), "module");
+	EXPECT_EQ(readResource(resolver, "file3", Aurora::kFileTypeTXT), "base");
+}
+
+GTEST_TEST_F(ResourceResolver, addDirectory) {
+	Aurora::ResourceResolver resolver;
+
+	resolver.addArchive(getPath("base.rim"), Aurora::kPriorityBase);
+	resolver.addDirectory(getPath("override"), Aurora::kPriorityOverride);
+
+	EXPECT_EQ(resolver.getLayerCount(), 2);
+	EXPECT_EQ(resolver.getLayer(1).files.size(), 2);
+
+	EXPECT_EQ(readResource(resolver, "file0", Aurora::kFileTypeTXT), "override");
+	EXPECT_EQ(readResource(resolver, "file1", Aurora::kFileTypeTXT), "base");
+	EXPECT_EQ(readResource(resolver, "file3", Aurora::kFileTypeTXT), "overridesub");
+
+	const Aurora::ResourceResolver::Location location = resolver.resolve("file0", Aurora::kFileTypeTXT);
+	EXPECT_EQ(resolver.getResourceSize(location), 8);
+	EXPECT_EQ(resolver.getPath(location), getPath("override/file0.txt"));
+}
+
+GTEST_TEST_F(ResourceResolver, addDirectoryNoRecurse) {
+	Aurora::ResourceResolver resolver;
+
+	resolver.addArchive(getPath("base.rim"), Aurora::kPriorityBase);
+	resolver.addDirectory(getPath("override"), Aurora::kPriorityOverride, 0);
+
+	EXPECT_EQ(readResource(resolver, "file0", Aurora::kFileTypeTXT), "override");
+	EXPECT_EQ(readResource(resolver, "file3", Aurora::kFileTypeTXT), "base");
+}
+
+GTEST_TEST_F(ResourceResolver, addArchives) {
+	Aurora::ResourceResolver resolver;
+
+	EXPECT_EQ(resolver.addArchives(getPath("dlc"), Aurora::kPriorityDLC), 1);
+	EXPECT_EQ(readResource(resolver, "file0", Aurora::kFileTypeTXT), "dlca");
+	EXPECT_FALSE(resolver.hasResource("file3", Aurora::kFileTypeTXT));
+
+	resolver.clear();
+	EXPECT_EQ(resolver.getLayerCount(), 0);
+	EXPECT_EQ(resolver.size(), 0);
+
+	// Sorted by path, so the archive in the subdirectory comes last and wins
+	EXPECT_EQ(resolver.addArchives(getPath("dlc"), Aurora::kPriorityDLC, -1), 2);
+	EXPECT_EQ(readResource(resolver, "file0", Aurora::kFileTypeTXT), "dlcb");
+	EXPECT_EQ(readResource(resolver, "file3", Aurora::kFileTypeTXT), "dlcb");
+}
+
+GTEST_TEST_F(ResourceResolver, addArchiveBroken) {
+	Aurora::ResourceResolver resolver;
+
+	EXPECT_THROW(resolver.addArchive(getPath("override/file0.txt"), Aurora::kPriorityBase), Common::Exception);
+	EXPECT_THROW(resolver.addArchive(getPath("nonexistent.rim"), Aurora::kPriorityBase), Common::Exception);
+	EXPECT_THROW(resolver.addDirectory(getPath("nonexistent"), Aurora::kPriorityBase), Common::Exception);
+
+	EXPECT_EQ(resolver.getLayerCount(), 0);
+}
+
+GTEST_TEST_F(ResourceResolver, hashedNames) {
+	Aurora::ResourceResolver resolver;
+
+	resolver.addArchive(getPath("base.rim"), Aurora::kPriorityBase);
+	resolver.addArchive(new HashedArchive({ "file1.txt", "hashed.txt" }), "hashed", Aurora::kPriorityPatch);
+
+	EXPECT_EQ(resolver.size(), 6);
+
+	EXPECT_EQ(readResource(resolver, "file0", Aurora::kFileTypeTXT), "base");
+	EXPECT_EQ(readResource(resolver, "FILE1", Aurora::kFileTypeTXT), "hash");
+	EXPECT_EQ(readResource(resolver, "hashed", Aurora::kFileTypeTXT), "hash");
+	EXPECT_FALSE(resolver.hasResource("hashed", Aurora::kFileTypeNSS));
+}
+
+GTEST_TEST_F(ResourceResolver, resolveMany) {
+	Aurora::ResourceResolver resolver;
+
+	resolver.addArchive(getPath("base.rim"), Aurora::kPriorityBase);
+	resolver.addArchive(getPath("module.rim"), Aurora::kPriorityModule);
+
+	const std::vector<Aurora::Archive::ResourceName> names = {
+		{ "file0", Aurora::kFileTypeTXT }, { "file3", Aurora::kFileTypeTXT }, { "file9", Aurora::kFileTypeTXT }
+	};
+
+	const std::vector<Aurora::ResourceResolver::Location> locations = resolver.resolve(names);
+	ASSERT_EQ(locations.size(), 3);
+
+	EXPECT_EQ(locations[0].layer, 1);
+	EXPECT_EQ(locations[0].index, 0);
+	EXPECT_EQ(locations[1].layer, 0);
+	EXPECT_EQ(locations[1].index, 3);
+	EXPECT_FALSE(locations[2].isValid());
+}
@@ -22,10 +22,17 @@
  *  Unit tests for our RIM file archive class.
  */
 
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
 
 #include "src/aurora/rimfile.h"
 
@@ -109,7 +116,7 @@ GTEST_TEST(RIMFile, getResources) {
 
 	const Aurora::RIMFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
@@ -142,6 +149,23 @@ GTEST_TEST(RIMFile, findResourceName) {
 	EXPECT_EQ(rim.findResource("nope"      , Aurora::kFileTypeBMP), 0xFFFFFFFF);
 }
 
+GTEST_TEST(RIMFile, findResourcesName) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kRIMFile);
+	const Aurora::RIMFile rim(stream);
+
+	const std::vector<uint32_t> indices = rim.findResources({
+		{ "ozymandias", Aurora::kFileTypeTXT },
+		{ "ozymandias", Aurora::kFileTypeBMP },
+		{ "nope"      , Aurora::kFileTypeTXT }
+	});
+
+	ASSERT_EQ(indices.size(), 3);
+
+	EXPECT_EQ(indices[0], 0);
+	EXPECT_EQ(indices[1], 0xFFFFFFFF);
+	EXPECT_EQ(indices[2], 0xFFFFFFFF);
+}
+
 GTEST_TEST(RIMFile, getResource) {
 	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kRIMFile);
 	const Aurora::RIMFile rim(stream);
@@ -156,3 +180,64 @@ GTEST_TEST(RIMFile, getResource) {
 
 	delete file;
 }
+
+GTEST_TEST(RIMFile, readIndex) {
+	Common::MemoryWriteStreamDynamic index(true);
+	Aurora::RIMFile(new Common::MemoryReadStream(kRIMFile)).writeIndex(index);
+
+	Common::MemoryReadStream indexStream(index.getData(), index.size());
+	const Aurora::RIMFile rim(new Common::MemoryReadStream(kRIMFile), indexStream);
+
+	const Aurora::RIMFile::ResourceList &resources = rim.getResources();
+	ASSERT_EQ(resources.size(), 1);
+
+	EXPECT_STREQ(resources[0].name, "ozymandias");
+	EXPECT_EQ(resources[0].type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(resources[0].index, 0);
+
+	EXPECT_EQ(rim.getResourceSize(0), strlen(kFileData));
+
+	std::unique_ptr<Common::SeekableReadStream> file(rim.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+}
+
+GTEST_TEST(RIMFile, getResourceConcurrent) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kRIMFile);
+	const Aurora::RIMFile rim(stream);
+
+	// Non-copying resource streams share the archive stream, reading them interleaved must work
+	std::unique_ptr<Common::SeekableReadStream> file1(rim.getResource(0, true));
+	std::unique_ptr<Common::SeekableReadStream> file2(rim.getResource(0, true));
+	ASSERT_EQ(file1->size(), strlen(kFileData));
+	ASSERT_EQ(file2->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++) {
+		EXPECT_EQ(file1->readByte(), kFileData[i]) << "At index " << i;
+		EXPECT_EQ(file2->readByte(), kFileData[i]) << "At index " << i;
+	}
+
+	std::atomic<size_t> mismatches(0);
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < 4; t++) {
+		threads.emplace_back([&rim, &mismatches]() {
+			for (size_t n = 0; n < 100; n++) {
+				std::unique_ptr<Common::SeekableReadStream> file(rim.getResource(0));
+
+				std::vector<char> data(file->size());
+				file->read(data.data(), data.size());
+
+				if ((data.size() != strlen(kFileData)) || std::memcmp(data.data(), kFileData, data.size()))
+					mismatches++;
+			}
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	EXPECT_EQ(mismatches, 0);
+}
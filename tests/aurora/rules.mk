@@ -26,6 +26,26 @@ aurora_LIBS = \
     tests/version/libversion.la \
     $(LDADD)
 
+check_PROGRAMS                    += tests/aurora/test_archive
+tests_aurora_test_archive_SOURCES  = tests/aurora/archive.cpp
+tests_aurora_test_archive_LDADD    = $(aurora_LIBS)
+tests_aurora_test_archive_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                         += tests/aurora/test_archivecache
+tests_aurora_test_archivecache_SOURCES  = tests/aurora/archivecache.cpp
+tests_aurora_test_archivecache_LDADD    = $(aurora_LIBS)
+tests_aurora_test_archivecache_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                         += tests/aurora/test_openarchive
+tests_aurora_test_openarchive_SOURCES  = tests/aurora/openarchive.cpp
+tests_aurora_test_openarchive_LDADD    = $(aurora_LIBS)
+tests_aurora_test_openarchive_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                              += tests/aurora/test_resourceresolver
+tests_aurora_test_resourceresolver_SOURCES  = tests/aurora/resourceresolver.cpp
+tests_aurora_test_resourceresolver_LDADD    = $(aurora_LIBS)
+tests_aurora_test_resourceresolver_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                 += tests/aurora/test_util
 tests_aurora_test_util_SOURCES  = tests/aurora/util.cpp
 tests_aurora_test_util_LDADD    = $(aurora_LIBS)
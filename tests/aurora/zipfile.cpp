@@ -101,7 +101,7 @@ GTEST_TEST(ZIPFile, getResources) {
 
 	const Aurora::ZIPFile::Resource &resource = *resources.begin();
 
-	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_STREQ(resource.name, "ozymandias");
 	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
 	EXPECT_EQ(resource.hash, 0);
 	EXPECT_EQ(resource.index, 0);
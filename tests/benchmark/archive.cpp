@@ -0,0 +1,94 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Benchmark of the archive resource list, against the std::list of
+ *  individual resources with their own strings it replaced.
+ */
+
+#include <cstdio>
+#include <list>
+#include <chrono>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/strutil.h"
+
+#include "src/aurora/archive.h"
+
+struct LegacyResource {
+	Common::UString name;
+	uint64_t hash;
+	Aurora::FileType type;
+	uint32_t index;
+};
+
+static const size_t kResourceCount = 60000;
+
+static Common::UString getName(size_t i) {
+	// Similar to a KEY file, names appear once per type of the same model
+	return "benchmark_model_" + Common::composeString(i / 2);
+}
+
+template<typename T>
+static double iterate(const T &resources, size_t &checksum) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int n = 0; n < 100; n++) {
+		for (typename T::const_iterator r = resources.begin(); r != resources.end(); ++r)
+			checksum += r->index + (size_t) r->type;
+	}
+
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	std::list<LegacyResource> legacy;
+	Aurora::Archive::ResourceList resources;
+
+	size_t legacyMemory = 0;
+	for (size_t i = 0; i < kResourceCount; i++) {
+		const Common::UString name = getName(i);
+		const Aurora::FileType type = (i & 1) ? Aurora::kFileTypeMDX : Aurora::kFileTypeMDL;
+
+		legacy.push_back(LegacyResource { name, 0, type, (uint32_t) i });
+		resources.add(name, type, i);
+
+		// List node with two pointers, plus the string's heap buffer, if it doesn't fit inline
+		legacyMemory += sizeof(LegacyResource) + 2 * sizeof(void *);
+		if (name.toString().capacity() > 15)
+			legacyMemory += name.toString().capacity() + 1;
+	}
+
+	resources.finish();
+
+	size_t legacyChecksum = 0, checksum = 0;
+	const double legacyTime = iterate(legacy, legacyChecksum);
+	const double time = iterate(resources, checksum);
+
+	if (checksum != legacyChecksum) {
+		std::fprintf(stderr, "Checksum mismatch: %u != %u\n", (uint)checksum, (uint)legacyChecksum);
+		return 1;
+	}
+
+	std::printf("std::list:    %8u bytes, 100 iterations in %8.3fms\n", (uint)legacyMemory, legacyTime);
+	std::printf("ResourceList: %8u bytes, 100 iterations in %8.3fms\n", (uint)resources.getMemoryUsage(), time);
+
+	return 0;
+}
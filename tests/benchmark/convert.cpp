@@ -0,0 +1,99 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Benchmark of the pixel format conversion kernels, against
+ *  converting one pixel at a time.
+ */
+
+#include <cstdio>
+#include <vector>
+#include <chrono>
+
+#include "src/common/types.h"
+
+#include "src/images/convert.h"
+
+static const size_t kCount = 2048 * 2048;
+static const size_t kRuns  = 50;
+
+static std::vector<byte> createPixels(size_t size) {
+	std::vector<byte> data(size);
+
+	uint32_t seed = 42;
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+
+		data[i] = (byte) (seed >> 16);
+	}
+
+	return data;
+}
+
+template<typename F>
+static void benchmarkKernel(const char *name, F kernel) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < kRuns; i++)
+		kernel();
+
+	const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+	std::printf("%-18s: %8.1f MPixels/s\n", name, (kCount * kRuns) / time.count() / 1000000.0);
+}
+
+int main() {
+	const std::vector<byte> rgb  = createPixels(kCount * 3);
+	const std::vector<byte> rgba = createPixels(kCount * 4);
+
+	std::vector<byte> dest(kCount * 4), reference(kCount * 4);
+
+	benchmarkKernel("RGB to RGBA", [&]() {
+		Images::convertRGBToRGBA(dest.data(), rgb.data(), kCount);
+	});
+	benchmarkKernel("BGR to RGBA", [&]() {
+		Images::convertBGRToRGBA(dest.data(), rgb.data(), kCount);
+	});
+	benchmarkKernel("Premultiply alpha", [&]() {
+		Images::premultiplyAlpha(dest.data(), rgba.data(), kCount);
+	});
+	benchmarkKernel("Brightness", [&]() {
+		Images::adjustBrightness(dest.data(), rgba.data(), kCount, 300);
+	});
+	benchmarkKernel("BGRA to RGBA", [&]() {
+		Images::convertBGRAToRGBA(dest.data(), rgba.data(), kCount);
+	});
+
+	// The same BGRA conversion, one pixel at a time, as the preview and TGA dumper used to do
+	benchmarkKernel("Per pixel BGRA", [&]() {
+		const byte *s = rgba.data();
+		byte *d = reference.data();
+
+		for (size_t i = 0; i < kCount; i++, s += 4) {
+			*d++ = s[2]; *d++ = s[1]; *d++ = s[0]; *d++ = s[3];
+		}
+	});
+
+	if (dest != reference) {
+		std::fprintf(stderr, "Converted pixels mismatch\n");
+		return 1;
+	}
+
+	return 0;
+}
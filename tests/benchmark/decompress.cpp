@@ -0,0 +1,186 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Benchmark of the per-thread decompression contexts, against
+ *  setting up a fresh decompressor for every resource.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <chrono>
+
+#include "src/common/types.h"
+#include "src/common/deflate.h"
+#include "src/common/lzma.h"
+
+// Percy Bysshe Shelley's "Ozymandias"
+static const char *kDataUncompressed =
+	"I met a traveller from an antique land\n"
+	"Who said: Two vast and trunkless legs of stone\n"
+	"Stand in the desert. Near them, on the sand,\n"
+	"Half sunk, a shattered visage lies, whose frown,\n"
+	"And wrinkled lip, and sneer of cold command,\n"
+	"Tell that its sculptor well those passions read\n"
+	"Which yet survive, stamped on these lifeless things,\n"
+	"The hand that mocked them and the heart that fed:\n"
+	"And on the pedestal these words appear:\n"
+	"'My name is Ozymandias, king of kings:\n"
+	"Look on my works, ye Mighty, and despair!'\n"
+	"Nothing beside remains. Round the decay\n"
+	"Of that colossal wreck, boundless and bare\n"
+	"The lone and level sands stretch far away.";
+
+// Percy Bysshe Shelley's "Ozymandias", compressed using DEFLATE
+static const byte kDataDEFLATE[] = {
+	0x2D,0x52,0xC9,0x6E,0xA4,0x30,0x10,0xBD,0xF3,0x15,0x95,0x53,0x2E,0xA8,0x3F,0xA0,
+	0x6F,0x73,0x9B,0x48,0x59,0xA4,0x24,0xD2,0x9C,0xAB,0x71,0xD1,0x58,0xD8,0x2E,0xC6,
+	0x65,0x40,0xE4,0xEB,0xF3,0x6C,0x5A,0x42,0x20,0xD5,0xF2,0xB6,0xE2,0x85,0xA2,0x14,
+	0x62,0x2A,0x99,0x37,0x09,0x41,0x32,0x8D,0x59,0x23,0x71,0xC2,0x53,0xFC,0xFF,0x55,
+	0x28,0x70,0x72,0xDD,0xBF,0x49,0xC9,0xD8,0xBB,0x2B,0x7D,0xEF,0x4A,0x1B,0x1B,0x76,
+	0x92,0xC3,0xD6,0x9A,0xE6,0x20,0x66,0x14,0xE4,0x6E,0xA4,0x23,0x59,0xD1,0x24,0xDD,
+	0x57,0xA9,0x5D,0x9F,0xA8,0x4C,0x42,0x4E,0x4C,0x72,0xB9,0xD0,0xBB,0x70,0xAE,0x85,
+	0xD8,0x93,0x9E,0x1D,0xC3,0x54,0xDF,0xFD,0xE5,0x80,0x3D,0x00,0xF5,0xD0,0x61,0x13,
+	0x97,0x22,0x59,0x1C,0x6D,0xDE,0xF8,0x0E,0x7A,0x2F,0xD6,0xD3,0x3E,0xA9,0x49,0x95,
+	0xB6,0xA7,0xBE,0xFB,0x03,0xEC,0x3D,0xFB,0xCA,0xEC,0xD0,0x5F,0xFA,0xA6,0xC5,0x92,
+	0x40,0x3D,0x24,0x0C,0x1A,0x1C,0x5E,0x31,0x36,0xF4,0x6F,0xB8,0x02,0x19,0x17,0xF2,
+	0xC5,0xC8,0x86,0x35,0x2C,0x45,0x33,0xED,0x67,0xB9,0xA2,0x2E,0x6C,0xE6,0x35,0x19,
+	0x65,0xE1,0xEA,0xD4,0x0F,0x13,0x1D,0x08,0xC5,0xD6,0xBC,0xF9,0x4D,0x7A,0x78,0xE2,
+	0xB8,0x80,0xEA,0x54,0x6D,0x55,0xD3,0x28,0xCD,0x75,0x99,0x7C,0xBA,0x1B,0x48,0x60,
+	0x66,0x6A,0x81,0x54,0xA2,0xA8,0xC3,0x2C,0xAE,0x59,0x3D,0x53,0xAA,0x5D,0x98,0x2F,
+	0x67,0x7B,0x14,0x77,0x6D,0x1E,0x1E,0x29,0x00,0x5A,0x40,0x11,0x1E,0xE0,0xBB,0x66,
+	0x67,0xC4,0xCB,0x82,0x8D,0x6B,0xF7,0xFC,0x76,0x50,0xE2,0x28,0xE4,0x8D,0x3E,0x7E,
+	0x8E,0xEA,0xC9,0x33,0x02,0x99,0x41,0x5C,0xCD,0xD6,0xAF,0x5D,0xBB,0x57,0xD5,0xB9,
+	0xE2,0xC5,0xA3,0xEE,0xCF,0x18,0x38,0x84,0xDE,0xFC,0x7D,0x2A,0xC7,0x99,0x0E,0x28,
+	0x16,0xF6,0xF9,0xE9,0xB9,0x7B,0xD7,0xA6,0x9A,0x6E,0x62,0xDE,0x09,0x4C,0x47,0xF6,
+	0xC9,0x2E,0xF4,0xA9,0xEB,0x43,0xAB,0x93,0x81,0x8F,0xEE,0x63,0x3C,0xE5,0x22,0x4E,
+	0x35,0x83,0xBC,0x3D,0xCB,0x80,0x1B,0xDD,0xEA,0x5C,0x73,0x5F,0x71,0x6F,0x9C,0xA5,
+	0xD9,0x0F,0xB8,0x7B,0xAB,0x04,0xC1,0x8F,0xD4,0x4E,0x8B,0xB8,0x4B,0x96,0x82,0x38,
+	0x47,0x5C,0x9E,0x77,0x3E,0x2E,0xBF
+};
+
+// Percy Bysshe Shelley's "Ozymandias", compressed using LZMA
+static const byte kDataLZMA[] = {
+	0x5D,0x00,0x00,0x00,0x01,0x00,0x24,0x88,0x09,0xA6,0x53,0xD8,0x61,0x0F,0xAE,0x55,
+	0xA9,0x63,0x39,0x41,0xFC,0x9F,0xD4,0xA8,0x78,0x14,0xAC,0xE4,0x2B,0xCC,0x0A,0x14,
+	0xAF,0x12,0x42,0x25,0xBC,0xEF,0xA4,0x3C,0x92,0x2C,0xC3,0x41,0x1E,0x0C,0x7E,0xAB,
+	0x97,0x95,0x4B,0xE0,0x18,0xFC,0x32,0xE0,0x7E,0xAC,0x35,0xED,0x0D,0xE8,0x9D,0xFA,
+	0xB0,0x7D,0xCD,0x26,0x2B,0x71,0xF2,0xC4,0xCF,0x31,0x2C,0xF9,0xD8,0xEC,0xFB,0xFC,
+	0xF5,0x7E,0x9E,0x1C,0x36,0xB0,0x30,0x72,0xE7,0x43,0xD8,0x64,0xA9,0x22,0x29,0xDD,
+	0x62,0xB2,0x19,0xB5,0x01,0xBD,0xC0,0x21,0xF2,0xEC,0x1C,0xF3,0x58,0xF0,0xBD,0x95,
+	0xBA,0xA0,0xBA,0xC4,0x6E,0xB2,0xDC,0x30,0x18,0x5E,0xA0,0x6F,0x72,0x03,0x57,0x1B,
+	0x8B,0xE6,0x63,0x39,0x72,0x58,0xE3,0xE8,0x70,0xE3,0x91,0xD1,0x0A,0x95,0x8E,0xC3,
+	0x34,0x79,0x10,0x27,0x5F,0x5A,0xFE,0xAA,0x27,0xCA,0xF2,0x15,0x1C,0x6C,0x72,0x86,
+	0xE1,0xE1,0x4A,0x57,0x1C,0xA3,0x76,0x66,0xF6,0x6A,0xC5,0xD8,0x7E,0xEE,0x04,0x0C,
+	0x98,0x6E,0x4D,0x70,0xBB,0x98,0xD9,0x59,0xD4,0xD0,0x25,0x34,0x7D,0x76,0xCF,0x02,
+	0x40,0xD7,0x78,0x47,0xC0,0xE0,0x4E,0xD2,0xF7,0x05,0x45,0x16,0x3F,0x2E,0xDD,0xAC,
+	0x68,0x60,0xE3,0x49,0x96,0x36,0xA7,0x52,0x22,0xEE,0x42,0xC8,0x6E,0x9A,0x14,0x20,
+	0xD7,0x03,0x35,0x25,0xF7,0xAB,0x8A,0x8B,0x38,0x9F,0xBF,0x79,0x81,0x0B,0x3A,0x7B,
+	0xA1,0x55,0xF2,0xF5,0xF6,0x7E,0xA5,0x47,0x34,0xAF,0x22,0x82,0x9A,0xFF,0xB1,0x93,
+	0xCF,0x47,0x98,0x63,0xF4,0x11,0xC8,0xD0,0x48,0x3F,0xC5,0xC9,0x1E,0xAD,0x4F,0x88,
+	0xBF,0x57,0x40,0xB0,0x7E,0xA2,0xB5,0xC8,0xA7,0x0B,0x64,0x83,0xD7,0xAB,0x8A,0x33,
+	0xA6,0x64,0xEA,0x2B,0xCF,0x41,0x96,0x92,0xF5,0x7B,0x66,0x48,0xA3,0x53,0x9D,0x01,
+	0x4F,0xC3,0xDF,0xA3,0x85,0x54,0x45,0x65,0xA9,0x3C,0x20,0x31,0x02,0x55,0xDB,0x64,
+	0x33,0x50,0x19,0x7A,0x58,0x64,0x87,0x72,0xF6,0x12,0x05,0xA3,0x83,0xFC,0xB4,0x0E,
+	0x28,0x5B,0x5C,0x17,0x57,0xB3,0xD8,0xF7,0xBE,0x1D,0xDF,0x96,0x32,0x36,0xA0,0xFE,
+	0x51,0x56,0x2D,0x84,0x2B,0xCA,0x2B,0x85,0x53,0x71,0xC1,0x33,0x3B,0xD2,0x77,0x2F,
+	0xB3,0x9E,0x87,0x71,0x8A,0x01,0x94,0x26,0x53,0x11,0x73,0x21,0xB5,0xD4,0x15,0xFB,
+	0xAC,0xC3,0xE7,0xA5,0x0A,0x09,0xF4,0x36,0x5B,0x88,0x25,0x51,0x0C,0x12,0xB5,0x09,
+	0x8A,0x78,0x57,0x5A,0xCC,0x20,0x13,0xC3,0xFD,0xC2,0x1E,0xF9,0xA6,0xF4,0xA1,0x77,
+	0xB2,0xAD,0xD3,0x6B,0xEF,0xB9,0xF7,0xA1,0x28,0x8A,0xB4,0x3D,0xCE,0x54,0xDA,0x78,
+	0xFF,0xF8,0x6E,0xCB,0x5F
+};
+
+static double getMicroseconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void printResult(const char *name, size_t count, double time) {
+	std::printf("%-20s %u resources in %10.3fms, %8.3fus per resource\n",
+	            name, (uint)count, time / 1000.0, time / count);
+}
+
+static void benchmarkDEFLATE(std::vector<byte> &decompressed) {
+	static const size_t kResourceCount = 100000;
+
+	// A fresh zlib stream for every resource, like we did before
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t n = 0; n < kResourceCount; n++) {
+		Common::InflateContext context;
+		context.decompress(kDataDEFLATE, sizeof(kDataDEFLATE), decompressed.data(), decompressed.size(),
+		                   Common::kWindowBitsMaxRaw);
+	}
+	printResult("Fresh zlib stream:", kResourceCount, getMicroseconds(start));
+
+	// Reusing the zlib stream of this thread
+	Common::InflateContext &threadContext = Common::InflateContext::getThreadContext();
+
+	start = std::chrono::steady_clock::now();
+	for (size_t n = 0; n < kResourceCount; n++)
+		threadContext.decompress(kDataDEFLATE, sizeof(kDataDEFLATE), decompressed.data(), decompressed.size(),
+		                         Common::kWindowBitsMaxRaw);
+	printResult("Reused zlib stream:", kResourceCount, getMicroseconds(start));
+}
+
+static void benchmarkLZMA(std::vector<byte> &decompressed) {
+	static const size_t kResourceCount = 2000;
+
+	const size_t propertiesSize = Common::LZMA1Context::getPropertiesSize();
+
+	const byte  *data     = kDataLZMA + propertiesSize;
+	const size_t dataSize = sizeof(kDataLZMA) - propertiesSize;
+
+	// A fresh decoder for every resource, like we did before
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t n = 0; n < kResourceCount; n++) {
+		Common::LZMA1Context context;
+		context.reset(kDataLZMA, propertiesSize);
+
+		size_t consumed = 0;
+		context.decompress(data, dataSize, decompressed.data(), decompressed.size(), consumed);
+	}
+	printResult("Fresh LZMA decoder:", kResourceCount, getMicroseconds(start));
+
+	// Reusing the decoder of this thread
+	Common::LZMA1Context &threadContext = Common::LZMA1Context::getThreadContext();
+
+	start = std::chrono::steady_clock::now();
+	for (size_t n = 0; n < kResourceCount; n++) {
+		threadContext.reset(kDataLZMA, propertiesSize);
+
+		size_t consumed = 0;
+		threadContext.decompress(data, dataSize, decompressed.data(), decompressed.size(), consumed);
+	}
+	printResult("Reused LZMA decoder:", kResourceCount, getMicroseconds(start));
+}
+
+int main() {
+	std::vector<byte> decompressed(std::strlen(kDataUncompressed));
+
+	benchmarkDEFLATE(decompressed);
+	benchmarkLZMA(decompressed);
+
+	if (std::memcmp(decompressed.data(), kDataUncompressed, decompressed.size()) != 0) {
+		std::fprintf(stderr, "Decompressed data mismatch\n");
+		return 1;
+	}
+
+	return 0;
+}
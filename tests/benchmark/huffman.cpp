@@ -0,0 +1,142 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Benchmark of the Huffman decoder's lookup tables, against decoding
+ *  one bit at a time.
+ */
+
+#include <cstdio>
+#include <vector>
+#include <chrono>
+
+#include "src/common/types.h"
+#include "src/common/huffman.h"
+#include "src/common/memreadstream.h"
+#include "src/common/bitstream.h"
+
+static const size_t kCodeCount   = 300;
+static const size_t kSymbolCount = 1000000;
+
+/** A canonical Huffman code with many long codes, similar to the WMA coefficient codes.
+ *
+ *  For LSB-first bit streams, the first bit of a code is its LSB, so the codes
+ *  are bit-reversed to still be prefix-free in that order.
+ */
+struct LongCode {
+	std::vector<uint32_t> codes;
+	std::vector<uint8_t>  lengths;
+	std::vector<uint32_t> symbols;
+
+	LongCode(size_t count, bool msbFirst) {
+		for (size_t i = 0; i < count; i++) {
+			lengths.push_back(6 + (i * 17) / count);
+			symbols.push_back(1000 + i);
+		}
+
+		uint32_t code = 0;
+		for (size_t i = 0; i < count; i++) {
+			if (i > 0)
+				code = (code + 1) << (lengths[i] - lengths[i - 1]);
+
+			codes.push_back(msbFirst ? code : reverse(code, lengths[i]));
+		}
+	}
+
+	static uint32_t reverse(uint32_t code, uint8_t length) {
+		uint32_t reversed = 0;
+		for (uint8_t i = 0; i < length; i++)
+			reversed |= ((code >> i) & 1) << (length - 1 - i);
+
+		return reversed;
+	}
+};
+
+/** Encode a list of code indices into a bit stream. */
+static std::vector<byte> encode(const LongCode &code, const std::vector<size_t> &indices, bool msbFirst) {
+	std::vector<byte> data;
+	size_t bitCount = 0;
+
+	for (size_t index : indices) {
+		for (size_t i = 0; i < code.lengths[index]; i++, bitCount++) {
+			const size_t bit = msbFirst ? (code.lengths[index] - 1 - i) : i;
+
+			if ((bitCount % 8) == 0)
+				data.push_back(0);
+
+			if (code.codes[index] & (1 << bit))
+				data.back() |= msbFirst ? (0x80 >> (bitCount % 8)) : (1 << (bitCount % 8));
+		}
+	}
+
+	return data;
+}
+
+static std::vector<size_t> createIndices(size_t codeCount, size_t count) {
+	std::vector<size_t> indices;
+
+	uint32_t seed = 1;
+	for (size_t i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		indices.push_back((seed >> 16) % codeCount);
+	}
+
+	return indices;
+}
+
+/** Decode all symbols, returning the time taken in seconds, or a negative value on a mismatch. */
+template<typename BitStream>
+static double decode(bool msbFirst, const std::vector<size_t> &indices) {
+	const LongCode code(kCodeCount, msbFirst);
+	const std::vector<byte> data = encode(code, indices, msbFirst);
+
+	Common::Huffman huffman(0, kCodeCount, code.codes.data(), code.lengths.data(), code.symbols.data());
+
+	Common::MemoryReadStream byteStream(data.data(), data.size());
+	BitStream                bitStream (byteStream);
+
+	bool mismatch = false;
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < indices.size(); i++)
+		mismatch |= huffman.getSymbol(bitStream) != code.symbols[indices[i]];
+	const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+	return mismatch ? -1.0 : time.count();
+}
+
+int main() {
+	const std::vector<size_t> indices = createIndices(kCodeCount, kSymbolCount);
+
+	// MSB-first streams are decoded with the lookup tables, LSB-first streams bit by bit
+	const double tableTime   = decode<Common::BitStream8MSB>(true , indices);
+	const double bitwiseTime = decode<Common::BitStream8LSB>(false, indices);
+
+	if ((tableTime < 0.0) || (bitwiseTime < 0.0)) {
+		std::fprintf(stderr, "Decoded symbol mismatch\n");
+		return 1;
+	}
+
+	std::printf("Lookup table: %u symbols in %10.3fms, %12.0f symbols/s\n",
+	            (uint)kSymbolCount, tableTime * 1000.0, kSymbolCount / tableTime);
+	std::printf("Bit-wise:     %u symbols in %10.3fms, %12.0f symbols/s\n",
+	            (uint)kSymbolCount, bitwiseTime * 1000.0, kSymbolCount / bitwiseTime);
+
+	return 0;
+}
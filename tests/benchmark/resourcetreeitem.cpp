@@ -0,0 +1,141 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Benchmark of the resource tree items of an expanded archive, as walked
+ *  by ResourceTree::index() and ResourceTree::parent().
+ */
+
+#include <cstdio>
+#include <vector>
+#include <chrono>
+
+#include <QString>
+
+#include "src/common/types.h"
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+
+#include "src/aurora/archive.h"
+
+#include "src/gui/resourcetreeitem.h"
+
+static const size_t kCount = 200000;
+
+/** An archive with lots of made-up resources and no actual data. */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive(size_t count) {
+		_resources.reserve(count);
+
+		for (size_t i = 0; i < count; i++)
+			_resources.add("resource" + Common::composeString(i), Aurora::kFileTypeTGA, i);
+
+		_resources.finish();
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	uint32_t getResourceSize(uint32_t UNUSED(index)) const {
+		return 0;
+	}
+
+	Common::SeekableReadStream *getResource(uint32_t UNUSED(index), bool UNUSED(tryNoCopy)) const {
+		throw Common::Exception("No resource data");
+	}
+
+private:
+	ResourceList _resources;
+};
+
+static double getSeconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Walk the children the way a QTreeView laying out the expanded archive does:
+ *  an index for every row, and the parent of every index. */
+static size_t walk(const GUI::ResourceTreeItem &item) {
+	size_t rowSum = 0;
+	for (int i = 0; i < item.childCount(); i++) {
+		const GUI::ResourceTreeItem *child  = item.childAt(i);
+		const GUI::ResourceTreeItem *parent = child->getParent();
+
+		rowSum += child->row() + parent->row();
+	}
+
+	return rowSum;
+}
+
+int main() {
+	TestArchive archive(kCount);
+
+	GUI::ResourceTreeItem root("Filename");
+
+	// Creating an item for every resource up front, as we did before
+	GUI::ResourceTreeItem *archiveItem = new GUI::ResourceTreeItem("archive.erf");
+	root.addChild(archiveItem);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (const Aurora::Archive::Resource &resource : archive.getResources())
+		archiveItem->addChild(new GUI::ResourceTreeItem(&archive, "archive.erf", resource));
+
+	const double timeBuild = getSeconds(start);
+
+	// The same archive again, this time with its items only created on demand
+	GUI::ResourceTreeItem *lazyItem = new GUI::ResourceTreeItem("lazy.erf");
+	root.addChild(lazyItem);
+
+	start = std::chrono::steady_clock::now();
+
+	std::vector<uint32_t> resources(kCount);
+	for (size_t i = 0; i < kCount; i++)
+		resources[i] = i;
+
+	lazyItem->addArchiveChildren(&archive, "lazy.erf", resources);
+
+	const double timeDefer = getSeconds(start);
+
+	start = std::chrono::steady_clock::now();
+	const size_t rowSum = walk(*archiveItem);
+	const double timeWalk = getSeconds(start);
+
+	// Walking the deferred items creates them, once
+	start = std::chrono::steady_clock::now();
+	const size_t lazyRowSum = walk(*lazyItem);
+	const double timeWalkLazy = getSeconds(start);
+
+	start = std::chrono::steady_clock::now();
+	walk(*lazyItem);
+	const double timeRewalkLazy = getSeconds(start);
+
+	if ((rowSum != (kCount * (kCount - 1)) / 2) || (lazyRowSum != rowSum + kCount)) {
+		std::fprintf(stderr, "Row mismatch\n");
+		return 1;
+	}
+
+	std::printf("Building  %u items:          %.3fs\n", (uint)kCount, timeBuild);
+	std::printf("Deferring %u items:          %.3fs\n", (uint)kCount, timeDefer);
+	std::printf("Walking   %u built items:    %.3fs\n", (uint)kCount, timeWalk);
+	std::printf("Walking   %u deferred items: %.3fs first, %.3fs again\n", (uint)kCount, timeWalkLazy, timeRewalkLazy);
+
+	return 0;
+}
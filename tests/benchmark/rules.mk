@@ -0,0 +1,63 @@
+# Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+#
+# Phaethon is the legal property of its developers, whose names
+# can be found in the AUTHORS file distributed with this source
+# distribution.
+#
+# Phaethon is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 3
+# of the License, or (at your option) any later version.
+#
+# Phaethon is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+# Benchmarks, timing performance-critical code against the way it was
+# done before. They are not unit tests: they are neither built nor run
+# by "make check", only by "make benchmark".
+
+benchmark_LIBS = \
+    src/aurora/libaurora.la \
+    src/common/libcommon.la \
+    src/version/libversion.la \
+    $(LDADD)
+
+benchmark_images_LIBS = \
+    src/images/libimages.la \
+    $(benchmark_LIBS)
+
+benchmark_gui_LIBS = \
+    src/gui/libgui.la \
+    src/sound/libsound.la \
+    $(benchmark_images_LIBS)
+
+EXTRA_PROGRAMS                        += tests/benchmark/bench_archive
+tests_benchmark_bench_archive_SOURCES  = tests/benchmark/archive.cpp
+tests_benchmark_bench_archive_LDADD    = $(benchmark_LIBS)
+
+EXTRA_PROGRAMS                           += tests/benchmark/bench_decompress
+tests_benchmark_bench_decompress_SOURCES  = tests/benchmark/decompress.cpp
+tests_benchmark_bench_decompress_LDADD    = $(benchmark_LIBS)
+
+EXTRA_PROGRAMS                        += tests/benchmark/bench_huffman
+tests_benchmark_bench_huffman_SOURCES  = tests/benchmark/huffman.cpp
+tests_benchmark_bench_huffman_LDADD    = $(benchmark_LIBS)
+
+EXTRA_PROGRAMS                        += tests/benchmark/bench_convert
+tests_benchmark_bench_convert_SOURCES  = tests/benchmark/convert.cpp
+tests_benchmark_bench_convert_LDADD    = $(benchmark_images_LIBS)
+
+EXTRA_PROGRAMS                                 += tests/benchmark/bench_resourcetreeitem
+tests_benchmark_bench_resourcetreeitem_SOURCES  = tests/benchmark/resourcetreeitem.cpp
+tests_benchmark_bench_resourcetreeitem_LDADD    = $(benchmark_gui_LIBS)
+
+CLEANFILES += $(EXTRA_PROGRAMS)
+
+benchmark: $(EXTRA_PROGRAMS)
+	@for bench in $(EXTRA_PROGRAMS); do echo "$$bench:"; ./$$bench || exit 1; done
+
+.PHONY: benchmark
@@ -192,3 +192,123 @@ GTEST_TEST(BitStream, BitStream64BELSB) {
 
 	testBitStream(bitStream, compValues);
 }
+
+/** Read through both bit streams in the same random-ish pattern and compare. */
+static void compareBitStreams(Common::BitStream &memStream, Common::BitStream &bitStream) {
+	ASSERT_EQ(memStream.size(), bitStream.size());
+
+	uint32_t seed = 23;
+	while (bitStream.pos() < bitStream.size()) {
+		seed = seed * 1103515245 + 12345;
+
+		const size_t left = bitStream.size() - bitStream.pos();
+		const size_t n    = MIN<size_t>(left, ((seed >> 16) % 32) + 1);
+
+		EXPECT_EQ(memStream.peekBits(32), bitStream.peekBits(32)) << "At bit " << bitStream.pos();
+
+		switch ((seed >> 8) % 3) {
+			case 0:
+				EXPECT_EQ(memStream.getBits(n), bitStream.getBits(n)) << "At bit " << bitStream.pos();
+				break;
+
+			case 1:
+				EXPECT_EQ(memStream.getBit(), bitStream.getBit()) << "At bit " << bitStream.pos();
+				break;
+
+			default:
+				memStream.skip(n);
+				bitStream.skip(n);
+				break;
+		}
+
+		ASSERT_EQ(memStream.pos(), bitStream.pos());
+	}
+
+	EXPECT_TRUE(memStream.eos());
+	EXPECT_EQ(memStream.peekBits(32), 0);
+	EXPECT_THROW(memStream.getBit(), Common::Exception);
+}
+
+template<int valueBits, bool isLE, bool isMSB2LSB>
+static void testMemoryBitStream() {
+	byte data[83];
+	for (size_t i = 0; i < ARRAYSIZE(data); i++)
+		data[i] = (byte) (i * 0x9D + 0x3B);
+
+	Common::MemoryReadStream stream(data);
+	Common::BitStreamImpl<valueBits, isLE, isMSB2LSB> bitStream(stream);
+	Common::MemoryBitStreamImpl<valueBits, isLE, isMSB2LSB> memStream(data);
+
+	compareBitStreams(memStream, bitStream);
+
+	// And again from the start, with large skips
+
+	memStream.rewind();
+	bitStream.rewind();
+	EXPECT_EQ(memStream.pos(), 0);
+
+	memStream.skip(3);
+	bitStream.skip(3);
+	memStream.skip(150);
+	bitStream.skip(150);
+	EXPECT_EQ(memStream.pos(), bitStream.pos());
+
+	compareBitStreams(memStream, bitStream);
+
+	// Reading the values from our fixed test data gives the same result, too
+
+	byte compValues[11], memValues[11];
+
+	Common::MemoryReadStream smallStream(data, 8);
+	Common::BitStreamImpl<valueBits, isLE, isMSB2LSB> smallBitStream(smallStream);
+	Common::MemoryBitStreamImpl<valueBits, isLE, isMSB2LSB> smallMemStream(data, 8);
+
+	readBitStream(smallBitStream, compValues);
+	readBitStream(smallMemStream, memValues);
+
+	for (size_t i = 0; i < ARRAYSIZE(compValues); i++)
+		EXPECT_EQ(memValues[i], compValues[i]) << "At index " << i;
+}
+
+GTEST_TEST(BitStream, MemoryBitStream8) {
+	testMemoryBitStream< 8, false, true >();
+	testMemoryBitStream< 8, false, false>();
+}
+
+GTEST_TEST(BitStream, MemoryBitStream16) {
+	testMemoryBitStream<16, true , true >();
+	testMemoryBitStream<16, true , false>();
+	testMemoryBitStream<16, false, true >();
+	testMemoryBitStream<16, false, false>();
+}
+
+GTEST_TEST(BitStream, MemoryBitStream32) {
+	testMemoryBitStream<32, true , true >();
+	testMemoryBitStream<32, true , false>();
+	testMemoryBitStream<32, false, true >();
+	testMemoryBitStream<32, false, false>();
+}
+
+GTEST_TEST(BitStream, MemoryBitStream64) {
+	testMemoryBitStream<64, true , true >();
+	testMemoryBitStream<64, true , false>();
+	testMemoryBitStream<64, false, true >();
+	testMemoryBitStream<64, false, false>();
+}
+
+GTEST_TEST(BitStream, MemoryBitStreamPeekSkip) {
+	static const byte data[3] = { 0x12, 0x34, 0x56 };
+	Common::MemoryBitStream8MSB bitStream(data);
+
+	EXPECT_EQ(bitStream.peekBits(12), 0x123);
+	EXPECT_EQ(bitStream.pos(), 0);
+
+	bitStream.skipBits(12);
+	EXPECT_EQ(bitStream.pos(), 12);
+
+	EXPECT_EQ(bitStream.peekBits(16), 0x4560);
+	EXPECT_EQ(bitStream.getBits(12), 0x456);
+	EXPECT_TRUE(bitStream.eos());
+
+	EXPECT_THROW(bitStream.skipBits(1), Common::Exception);
+}
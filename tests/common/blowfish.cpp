@@ -22,6 +22,7 @@
  *  Unit tests for our Blowfish implementation.
  */
 
+#include <cstring>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -29,6 +30,7 @@
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 #include "src/common/blowfish.h"
 
 static const byte kClearText[]  = { 'F', 'o', 'o', 'b', 'a', 'r', ' ', 'B', 'a', 'r', 'f', 'o', 'o' };
@@ -81,3 +83,84 @@ GTEST_TEST(Blowfish, misalign) {
 
 	EXPECT_THROW(Common::decryptBlowfishEBC(cipherText, key), Common::Exception);
 }
+
+GTEST_TEST(BlowfishContext, encryptInPlace) {
+	std::vector<byte> key;
+	createKey(key);
+
+	const Common::BlowfishContext context(key);
+
+	byte data[ARRAYSIZE(kCypherText)] = { 0 };
+	std::memcpy(data, kClearText, ARRAYSIZE(kClearText));
+
+	context.encryptECB(data, sizeof(data));
+
+	for (size_t i = 0; i < ARRAYSIZE(kCypherText); i++)
+		EXPECT_EQ(data[i], kCypherText[i]) << "At index " << i;
+
+	context.decryptECB(data, sizeof(data));
+
+	for (size_t i = 0; i < ARRAYSIZE(kClearText); i++)
+		EXPECT_EQ(data[i], kClearText[i]) << "At index " << i;
+}
+
+GTEST_TEST(BlowfishContext, misalign) {
+	std::vector<byte> key;
+	createKey(key);
+
+	const Common::BlowfishContext context(key);
+
+	byte data[7] = { 0 };
+	EXPECT_THROW(context.decryptECB(data, sizeof(data)), Common::Exception);
+}
+
+GTEST_TEST(BlowfishContext, invalidKey) {
+	EXPECT_THROW(Common::BlowfishContext(std::vector<byte>()), Common::Exception);
+	EXPECT_THROW(Common::BlowfishContext(std::vector<byte>(3)), Common::Exception);
+	EXPECT_THROW(Common::BlowfishContext(std::vector<byte>(57)), Common::Exception);
+}
+
+GTEST_TEST(BlowfishContext, parallel) {
+	std::vector<byte> key;
+	createKey(key);
+
+	const Common::BlowfishContext context(key);
+
+	// Big enough to be split across threads, and not a multiple of the split size
+	std::vector<byte> clearText(1024 * 1024 + 8);
+	for (size_t i = 0; i < clearText.size(); i++)
+		clearText[i] = (byte) (i * 7);
+
+	std::vector<byte> serial = clearText;
+	context.encryptECB(serial.data(), serial.size());
+
+	Common::ThreadPool pool(3);
+
+	std::vector<byte> parallel = clearText;
+	context.encryptECB(parallel.data(), parallel.size(), &pool);
+
+	EXPECT_EQ(parallel, serial);
+
+	context.decryptECB(parallel.data(), parallel.size(), &pool);
+
+	EXPECT_EQ(parallel, clearText);
+}
+
+GTEST_TEST(BlowfishContext, getContext) {
+	std::vector<byte> key1, key2;
+	createKey(key1);
+	createKey(key2);
+
+	key2.back() = '?';
+
+	std::shared_ptr<const Common::BlowfishContext> context1 = Common::BlowfishContext::getContext(key1);
+	std::shared_ptr<const Common::BlowfishContext> context2 = Common::BlowfishContext::getContext(key2);
+
+	ASSERT_TRUE(context1);
+	ASSERT_TRUE(context2);
+
+	EXPECT_NE(context1, context2);
+
+	EXPECT_EQ(Common::BlowfishContext::getContext(key1), context1);
+	EXPECT_EQ(Common::BlowfishContext::getContext(key2), context2);
+}
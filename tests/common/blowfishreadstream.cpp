@@ -0,0 +1,121 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our on-demand Blowfish decryption stream.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/blowfish.h"
+#include "src/common/blowfishreadstream.h"
+
+static const byte kKey[] = { 'T', 'h', 'i', 's', ' ', 'a', ' ', 'K', 'e', 'y', '!' };
+
+static const size_t kDataSize = 40000;
+
+static std::vector<byte> createKey() {
+	return std::vector<byte>(kKey, kKey + ARRAYSIZE(kKey));
+}
+
+static std::vector<byte> createClearText() {
+	std::vector<byte> data(kDataSize);
+	for (size_t i = 0; i < kDataSize; i++)
+		data[i] = (byte) ((i * 13) ^ (i >> 8));
+
+	return data;
+}
+
+static Common::MemoryReadStream *createCipherText(const std::vector<byte> &clearText) {
+	byte *data = new byte[clearText.size()];
+	std::memcpy(data, clearText.data(), clearText.size());
+
+	Common::BlowfishContext(createKey()).encryptECB(data, clearText.size());
+
+	return new Common::MemoryReadStream(data, clearText.size(), true);
+}
+
+GTEST_TEST(BlowfishReadStream, readAll) {
+	const std::vector<byte> clearText = createClearText();
+
+	Common::BlowfishReadStream stream(createCipherText(clearText), createKey());
+	ASSERT_EQ(stream.size(), kDataSize);
+
+	std::vector<byte> data(kDataSize + 1);
+	EXPECT_EQ(stream.read(data.data(), data.size()), kDataSize);
+	EXPECT_TRUE(stream.eos());
+
+	data.resize(kDataSize);
+	EXPECT_EQ(data, clearText);
+}
+
+GTEST_TEST(BlowfishReadStream, readSmall) {
+	const std::vector<byte> clearText = createClearText();
+
+	Common::BlowfishReadStream stream(createCipherText(clearText), createKey());
+
+	// Unaligned reads, crossing block and page boundaries
+	static const size_t kPositions[] = { 39990, 3, 4093, 8190, 20001, 12, 0, 39999 };
+
+	for (size_t i = 0; i < ARRAYSIZE(kPositions); i++) {
+		stream.seek(kPositions[i]);
+
+		byte data[7];
+		const size_t expectedSize = MIN<size_t>(sizeof(data), kDataSize - kPositions[i]);
+
+		ASSERT_EQ(stream.read(data, sizeof(data)), expectedSize);
+		EXPECT_EQ(stream.pos(), kPositions[i] + expectedSize);
+
+		for (size_t j = 0; j < expectedSize; j++)
+			EXPECT_EQ(data[j], clearText[kPositions[i] + j]) << "At position " << (kPositions[i] + j);
+	}
+}
+
+GTEST_TEST(BlowfishReadStream, readAt) {
+	const std::vector<byte> clearText = createClearText();
+
+	Common::BlowfishReadStream stream(createCipherText(clearText), createKey());
+
+	stream.seek(100);
+
+	// A big read starting unaligned, mixing cached pages and direct decryption
+	std::vector<byte> data(20000);
+	ASSERT_EQ(stream.readAt(5, data.data(), data.size()), data.size());
+
+	for (size_t i = 0; i < data.size(); i++)
+		ASSERT_EQ(data[i], clearText[5 + i]) << "At index " << i;
+
+	EXPECT_EQ(stream.pos(), 100);
+
+	EXPECT_EQ(stream.readAt(kDataSize, data.data(), 1), 0);
+}
+
+GTEST_TEST(BlowfishReadStream, misalign) {
+	static const byte kData[7] = { 0 };
+
+	EXPECT_THROW(Common::BlowfishReadStream(new Common::MemoryReadStream(kData), createKey()),
+	             Common::Exception);
+}
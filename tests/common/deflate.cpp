@@ -22,6 +22,9 @@
  *  Unit tests for our DEFLATE decompressor (which uses zlib).
  */
 
+#include <vector>
+#include <memory>
+
 #include "gtest/gtest.h"
 
 #include "src/common/deflate.h"
@@ -166,6 +169,48 @@ GTEST_TEST(DEFLATE, decompressFailInputCut) {
 	             Common::Exception);
 }
 
+GTEST_TEST(DEFLATE, decompressAfterFailure) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	// A failed decompression must not affect the next one using the same inflate context
+	EXPECT_THROW(Common::decompressDeflate(kDataCompressed, kSizeCompressed / 2,
+	                                       kSizeDecompressed, Common::kWindowBitsMaxRaw),
+	             Common::Exception);
+
+	std::unique_ptr<const byte[]> decompressed(Common::decompressDeflate(kDataCompressed, kSizeCompressed,
+	                                                                     kSizeDecompressed, Common::kWindowBitsMaxRaw));
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed[i], kDataUncompressed[i]) << "At index " << i;
+}
+
+GTEST_TEST(InflateContext, decompressReuse) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	// The same data, with a zlib header
+	size_t zlibSize = 0;
+	std::unique_ptr<const byte[]> zlibData(Common::compressDeflate(reinterpret_cast<const byte *>(kDataUncompressed),
+	                                                               kSizeDecompressed, zlibSize, Common::kWindowBitsMax));
+
+	Common::InflateContext context;
+
+	// Alternate between raw and zlib data, resetting the window size
+	for (size_t n = 0; n < 4; n++) {
+		std::vector<byte> decompressed(kSizeDecompressed);
+
+		if (n & 1)
+			context.decompress(zlibData.get(), zlibSize, decompressed.data(), kSizeDecompressed, Common::kWindowBitsMax);
+		else
+			context.decompress(kDataCompressed, kSizeCompressed, decompressed.data(), kSizeDecompressed,
+			                   Common::kWindowBitsMaxRaw);
+
+		for (size_t i = 0; i < kSizeDecompressed; i++)
+			EXPECT_EQ(decompressed[i], kDataUncompressed[i]) << "At index " << i << ", iteration " << n;
+	}
+}
+
 GTEST_TEST(DEFLATE, decompressChunked) {
 	static const byte kDataChunked[] = {
 		0x78,0x9C,0x25,0x8B,0x31,0x0E,0xC2,0x40,0x0C,0x04,0xFB,0xBC,0x62,0x1F,0x80,0xF2,
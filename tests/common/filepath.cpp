@@ -114,6 +114,12 @@ GTEST_TEST_F(FilePath, getFileSize) {
 	EXPECT_EQ(Common::FilePath::getFileSize(kDirectoryPath.generic_string()), Common::kFileInvalid);
 }
 
+GTEST_TEST_F(FilePath, getModificationTime) {
+	EXPECT_NE(Common::FilePath::getModificationTime(kFilePath.generic_string()), -1);
+	EXPECT_EQ(Common::FilePath::getModificationTime(kFilePathFake.generic_string()), -1);
+	EXPECT_EQ(Common::FilePath::getModificationTime(kDirectoryPath.generic_string()), -1);
+}
+
 GTEST_TEST_F(FilePath, getFile) {
 	EXPECT_STREQ(Common::FilePath::getFile("/path/to/file.ext").c_str(), "file.ext");
 	EXPECT_STREQ(Common::FilePath::getFile("path/to/file.ext" ).c_str(), "file.ext");
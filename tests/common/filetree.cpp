@@ -0,0 +1,332 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the FileTree class.
+ */
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/filepath.h"
+#include "src/common/filetree.h"
+
+static boost::filesystem::path kDirectoryPath;
+
+static void createFile(const boost::filesystem::path &path, size_t size) {
+	const std::string data(size, '\0');
+
+	boost::filesystem::ofstream file(path, std::ofstream::binary);
+
+	file.write(data.c_str(), size);
+	file.flush();
+	ASSERT_FALSE(file.fail());
+
+	file.close();
+}
+
+static const Common::FileTree::Entry *findChild(const Common::FileTree::Entry &entry, const char *name) {
+	for (const Common::FileTree::Entry &child : entry.children)
+		if (child.name == name)
+			return &child;
+
+	return nullptr;
+}
+
+class FileTree : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kDirectoryPath = boost::filesystem::temp_directory_path() /
+		                 boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		/* root/
+		 *   a.txt
+		 *   sub1/
+		 *     b.bin
+		 *     deep/
+		 *       c
+		 *   sub2/
+		 */
+
+		boost::filesystem::create_directories(kDirectoryPath / "sub1" / "deep");
+		boost::filesystem::create_directories(kDirectoryPath / "sub2");
+
+		createFile(kDirectoryPath / "a.txt", 23);
+		createFile(kDirectoryPath / "sub1" / "b.bin", 42);
+		createFile(kDirectoryPath / "sub1" / "deep" / "c", 0);
+	}
+
+	static void TearDownTestCase() {
+		if (!kDirectoryPath.empty())
+			boost::filesystem::remove_all(kDirectoryPath);
+	}
+};
+
+GTEST_TEST_F(FileTree, readPathRecursive) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	const Common::FileTree::Entry &root = tree.getRoot();
+
+	EXPECT_TRUE(root.isDirectory());
+	EXPECT_FALSE(root.isRegularFile());
+	ASSERT_EQ(root.children.size(), 3);
+
+	const Common::FileTree::Entry *a    = findChild(root, "a.txt");
+	const Common::FileTree::Entry *sub1 = findChild(root, "sub1");
+	const Common::FileTree::Entry *sub2 = findChild(root, "sub2");
+
+	ASSERT_NE(a, nullptr);
+	ASSERT_NE(sub1, nullptr);
+	ASSERT_NE(sub2, nullptr);
+
+	EXPECT_TRUE(a->isRegularFile());
+	EXPECT_FALSE(a->isDirectory());
+	EXPECT_EQ(a->size, 23);
+	EXPECT_TRUE(a->children.empty());
+
+	EXPECT_TRUE(sub1->isDirectory());
+	EXPECT_EQ(sub1->size, Common::kFileInvalid);
+	ASSERT_EQ(sub1->children.size(), 2);
+
+	EXPECT_TRUE(sub2->isDirectory());
+	EXPECT_TRUE(sub2->children.empty());
+
+	const Common::FileTree::Entry *b    = findChild(*sub1, "b.bin");
+	const Common::FileTree::Entry *deep = findChild(*sub1, "deep");
+
+	ASSERT_NE(b, nullptr);
+	ASSERT_NE(deep, nullptr);
+
+	EXPECT_TRUE(b->isRegularFile());
+	EXPECT_EQ(b->size, 42);
+	EXPECT_EQ(b->path, sub1->path / "b.bin");
+
+	EXPECT_TRUE(deep->isDirectory());
+	ASSERT_EQ(deep->children.size(), 1);
+
+	EXPECT_STREQ(deep->children.front().name.c_str(), "c");
+	EXPECT_TRUE(deep->children.front().isRegularFile());
+	EXPECT_EQ(deep->children.front().size, 0);
+}
+
+GTEST_TEST_F(FileTree, readPathDepth) {
+	Common::FileTree tree;
+
+	tree.readPath(kDirectoryPath, 0);
+	EXPECT_TRUE(tree.getRoot().isDirectory());
+	EXPECT_TRUE(tree.getRoot().children.empty());
+
+	tree.readPath(kDirectoryPath, 1);
+	ASSERT_EQ(tree.getRoot().children.size(), 3);
+
+	const Common::FileTree::Entry *sub1 = findChild(tree.getRoot(), "sub1");
+	ASSERT_NE(sub1, nullptr);
+
+	EXPECT_TRUE(sub1->isDirectory());
+	EXPECT_TRUE(sub1->children.empty());
+
+	tree.readPath(kDirectoryPath, 2);
+
+	sub1 = findChild(tree.getRoot(), "sub1");
+	ASSERT_NE(sub1, nullptr);
+	ASSERT_EQ(sub1->children.size(), 2);
+
+	const Common::FileTree::Entry *deep = findChild(*sub1, "deep");
+	ASSERT_NE(deep, nullptr);
+
+	EXPECT_TRUE(deep->children.empty());
+}
+
+GTEST_TEST_F(FileTree, readPathFile) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath / "a.txt", -1);
+
+	EXPECT_STREQ(tree.getRoot().name.c_str(), "a.txt");
+	EXPECT_TRUE(tree.getRoot().isRegularFile());
+	EXPECT_EQ(tree.getRoot().size, 23);
+	EXPECT_TRUE(tree.getRoot().children.empty());
+}
+
+GTEST_TEST_F(FileTree, readPathFail) {
+	Common::FileTree tree;
+
+	EXPECT_THROW(tree.readPath(kDirectoryPath / "nope", -1), Common::Exception);
+	EXPECT_TRUE(tree.isEmpty());
+}
+
+GTEST_TEST_F(FileTree, clear) {
+	Common::FileTree tree;
+
+	tree.readPath(kDirectoryPath, -1);
+	EXPECT_FALSE(tree.isEmpty());
+
+	tree.clear();
+	EXPECT_TRUE(tree.isEmpty());
+	EXPECT_TRUE(tree.getRoot().children.empty());
+}
+
+GTEST_TEST_F(FileTree, findEntry) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	const boost::filesystem::path &root = tree.getRoot().path;
+
+	EXPECT_EQ(tree.findEntry(root), &tree.getRoot());
+
+	const Common::FileTree::Entry *c = tree.findEntry(root / "sub1" / "deep" / "c");
+	ASSERT_NE(c, nullptr);
+	EXPECT_STREQ(c->name.c_str(), "c");
+
+	EXPECT_EQ(tree.findEntry(root / "sub1" / "nope"), nullptr);
+	EXPECT_EQ(tree.findEntry(root.parent_path()), nullptr);
+	EXPECT_EQ(tree.findEntry(root.parent_path() / "sub1"), nullptr);
+}
+
+GTEST_TEST_F(FileTree, updatePathFile) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	const boost::filesystem::path path = tree.getRoot().path / "sub2" / "new.txt";
+
+	createFile(path, 5);
+
+	const Common::FileTree::Entry *entry = tree.updatePath(path);
+	ASSERT_NE(entry, nullptr);
+	EXPECT_TRUE(entry->isRegularFile());
+	EXPECT_EQ(entry->size, 5);
+	EXPECT_EQ(tree.findEntry(path), entry);
+
+	createFile(path, 7);
+
+	entry = tree.updatePath(path);
+	ASSERT_NE(entry, nullptr);
+	EXPECT_EQ(entry->size, 7);
+	EXPECT_EQ(findChild(tree.getRoot(), "sub2")->children.size(), 1);
+
+	boost::filesystem::remove(path);
+
+	EXPECT_EQ(tree.updatePath(path), nullptr);
+	EXPECT_EQ(tree.findEntry(path), nullptr);
+	EXPECT_TRUE(findChild(tree.getRoot(), "sub2")->children.empty());
+}
+
+GTEST_TEST_F(FileTree, updatePathDirectory) {
+	const boost::filesystem::path path = kDirectoryPath / "sub3";
+
+	boost::filesystem::create_directories(path / "inner");
+	createFile(path / "inner" / "d", 3);
+
+	Common::FileTree treeFull, treeShallow;
+	treeFull.readPath(kDirectoryPath, -1);
+	treeShallow.readPath(kDirectoryPath, 2);
+
+	// Read the new directory completely
+	const Common::FileTree::Entry *full = treeFull.updatePath(treeFull.getRoot().path / "sub3");
+	ASSERT_NE(full, nullptr);
+	ASSERT_EQ(full->children.size(), 1);
+	EXPECT_EQ(full->children.front().children.size(), 1);
+
+	// Only read the new directory as deep as the rest of the tree
+	const Common::FileTree::Entry *shallow = treeShallow.updatePath(treeShallow.getRoot().path / "sub3");
+	ASSERT_NE(shallow, nullptr);
+	ASSERT_EQ(shallow->children.size(), 1);
+	EXPECT_TRUE(shallow->children.front().children.empty());
+
+	// The contents of this directory were never read
+	EXPECT_EQ(treeShallow.updatePath(treeShallow.getRoot().path / "sub3" / "inner" / "d"), nullptr);
+
+	boost::filesystem::remove_all(path);
+}
+
+GTEST_TEST_F(FileTree, updatePathStable) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	const boost::filesystem::path path1 = tree.getRoot().path / "sub2" / "first.txt";
+	const boost::filesystem::path path2 = tree.getRoot().path / "sub2" / "second.txt";
+
+	createFile(path1, 1);
+	createFile(path2, 2);
+
+	// Adding a sibling must not move the first entry
+	const Common::FileTree::Entry *entry1 = tree.updatePath(path1);
+	const Common::FileTree::Entry *entry2 = tree.updatePath(path2);
+	ASSERT_NE(entry1, nullptr);
+	ASSERT_NE(entry2, nullptr);
+
+	EXPECT_EQ(tree.findEntry(path1), entry1);
+	EXPECT_EQ(entry1->size, 1);
+	EXPECT_EQ(entry2->size, 2);
+
+	boost::filesystem::remove(path1);
+	boost::filesystem::remove(path2);
+}
+
+GTEST_TEST_F(FileTree, readPathDanglingSymlink) {
+	const boost::filesystem::path path = kDirectoryPath / "sub4";
+	boost::filesystem::create_directories(path);
+
+	// Not every platform or filesystem lets us create symlinks
+	boost::system::error_code error;
+	boost::filesystem::create_symlink(path / "nope", path / "dangling", error);
+	if (error) {
+		boost::filesystem::remove_all(path);
+		return;
+	}
+
+	createFile(path / "e", 4);
+
+	Common::FileTree tree;
+	ASSERT_NO_THROW(tree.readPath(kDirectoryPath, -1));
+
+	const Common::FileTree::Entry *sub4 = tree.findEntry(tree.getRoot().path / "sub4");
+	ASSERT_NE(sub4, nullptr);
+	ASSERT_EQ(sub4->children.size(), 1);
+	EXPECT_STREQ(sub4->children.front().name.c_str(), "e");
+
+	EXPECT_EQ(tree.updatePath(tree.getRoot().path / "sub4" / "dangling"), nullptr);
+
+	boost::filesystem::remove_all(path);
+}
+
+GTEST_TEST_F(FileTree, removePath) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	const boost::filesystem::path &root = tree.getRoot().path;
+
+	EXPECT_TRUE(tree.removePath(root / "sub1" / "deep"));
+	EXPECT_EQ(tree.findEntry(root / "sub1" / "deep"), nullptr);
+	EXPECT_EQ(tree.findEntry(root / "sub1" / "deep" / "c"), nullptr);
+	EXPECT_NE(tree.findEntry(root / "sub1" / "b.bin"), nullptr);
+
+	EXPECT_FALSE(tree.removePath(root / "sub1" / "deep"));
+	EXPECT_FALSE(tree.removePath(root / "nope" / "nope"));
+}
@@ -0,0 +1,204 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the FileWatcher class.
+ */
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/platform.h"
+#include "src/common/filetree.h"
+#include "src/common/filewatcher.h"
+
+static boost::filesystem::path kDirectoryPath;
+
+static void createFile(const boost::filesystem::path &path, const char *data) {
+	boost::filesystem::ofstream file(path, std::ofstream::binary);
+
+	file << data;
+	file.flush();
+	ASSERT_FALSE(file.fail());
+
+	file.close();
+}
+
+class FileWatcher : public ::testing::Test {
+protected:
+	Common::FileTree _tree;
+	Common::FileWatcher _watcher;
+
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kDirectoryPath = boost::filesystem::temp_directory_path() /
+		                 boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+	}
+
+	static void TearDownTestCase() {
+		if (!kDirectoryPath.empty())
+			boost::filesystem::remove_all(kDirectoryPath);
+	}
+
+	void SetUp() {
+		boost::filesystem::create_directories(kDirectoryPath / "sub");
+
+		_tree.readPath(kDirectoryPath, -1);
+		_watcher.watch(_tree.getRoot());
+	}
+
+	void TearDown() {
+		_watcher.clear();
+
+		boost::filesystem::remove_all(kDirectoryPath);
+	}
+
+	const boost::filesystem::path &root() const {
+		return _tree.getRoot().path;
+	}
+};
+
+GTEST_TEST_F(FileWatcher, isSupported) {
+#if defined(__linux__)
+	EXPECT_TRUE(_watcher.isSupported());
+	EXPECT_NE(_watcher.getDescriptor(), -1);
+#else
+	EXPECT_FALSE(_watcher.isSupported());
+	EXPECT_EQ(_watcher.getDescriptor(), -1);
+#endif
+}
+
+GTEST_TEST_F(FileWatcher, noChanges) {
+	EXPECT_TRUE(_watcher.readChanges().empty());
+}
+
+GTEST_TEST_F(FileWatcher, createDelete) {
+	if (!_watcher.isSupported())
+		return;
+
+	createFile(root() / "a.txt", "foo");
+
+	// Creating and writing the file is only reported once
+	std::vector<Common::FileWatcher::Change> changes = _watcher.readChanges();
+	ASSERT_EQ(changes.size(), 1);
+	EXPECT_EQ(changes[0].type, Common::FileWatcher::kChangeCreated);
+	EXPECT_EQ(changes[0].path, root() / "a.txt");
+
+	EXPECT_TRUE(_watcher.readChanges().empty());
+
+	createFile(root() / "a.txt", "foobar");
+
+	changes = _watcher.readChanges();
+	ASSERT_EQ(changes.size(), 1);
+	EXPECT_EQ(changes[0].type, Common::FileWatcher::kChangeModified);
+	EXPECT_EQ(changes[0].path, root() / "a.txt");
+
+	boost::filesystem::remove(root() / "a.txt");
+
+	changes = _watcher.readChanges();
+	ASSERT_EQ(changes.size(), 1);
+	EXPECT_EQ(changes[0].type, Common::FileWatcher::kChangeDeleted);
+	EXPECT_EQ(changes[0].path, root() / "a.txt");
+}
+
+GTEST_TEST_F(FileWatcher, deleteCreate) {
+	if (!_watcher.isSupported())
+		return;
+
+	createFile(root() / "a.txt", "foo");
+	boost::filesystem::remove(root() / "a.txt");
+	createFile(root() / "a.txt", "bar");
+
+	const std::vector<Common::FileWatcher::Change> changes = _watcher.readChanges();
+	ASSERT_EQ(changes.size(), 3);
+	EXPECT_EQ(changes[0].type, Common::FileWatcher::kChangeCreated);
+	EXPECT_EQ(changes[1].type, Common::FileWatcher::kChangeDeleted);
+	EXPECT_EQ(changes[2].type, Common::FileWatcher::kChangeCreated);
+}
+
+GTEST_TEST_F(FileWatcher, rename) {
+	if (!_watcher.isSupported())
+		return;
+
+	createFile(root() / "a.txt", "foo");
+	_watcher.readChanges();
+
+	boost::filesystem::rename(root() / "a.txt", root() / "sub" / "b.txt");
+
+	const std::vector<Common::FileWatcher::Change> changes = _watcher.readChanges();
+	ASSERT_EQ(changes.size(), 2);
+	EXPECT_EQ(changes[0].type, Common::FileWatcher::kChangeDeleted);
+	EXPECT_EQ(changes[0].path, root() / "a.txt");
+	EXPECT_EQ(changes[1].type, Common::FileWatcher::kChangeCreated);
+	EXPECT_EQ(changes[1].path, root() / "sub" / "b.txt");
+}
+
+GTEST_TEST_F(FileWatcher, newDirectory) {
+	if (!_watcher.isSupported())
+		return;
+
+	boost::filesystem::create_directory(root() / "new");
+
+	std::vector<Common::FileWatcher::Change> changes = _watcher.readChanges();
+	ASSERT_EQ(changes.size(), 1);
+	EXPECT_EQ(changes[0].type, Common::FileWatcher::kChangeCreated);
+
+	// Changes inside the new directory are only seen once it's watched
+	createFile(root() / "new" / "a.txt", "foo");
+	EXPECT_TRUE(_watcher.readChanges().empty());
+
+	const Common::FileTree::Entry *entry = _tree.updatePath(changes[0].path);
+	ASSERT_NE(entry, nullptr);
+	_watcher.watch(*entry);
+
+	createFile(root() / "new" / "b.txt", "foo");
+
+	changes = _watcher.readChanges();
+	ASSERT_EQ(changes.size(), 1);
+	EXPECT_EQ(changes[0].path, root() / "new" / "b.txt");
+}
+
+GTEST_TEST_F(FileWatcher, clear) {
+	if (!_watcher.isSupported())
+		return;
+
+	createFile(root() / "a.txt", "foo");
+	_watcher.clear();
+
+	EXPECT_TRUE(_watcher.readChanges().empty());
+
+	createFile(root() / "sub" / "b.txt", "foo");
+	EXPECT_TRUE(_watcher.readChanges().empty());
+}
+
+GTEST_TEST_F(FileWatcher, noRescan) {
+	if (!_watcher.isSupported())
+		return;
+
+	// All directories could be watched, so there's nothing to rescan
+	EXPECT_FALSE(_watcher.needsRescan());
+
+	createFile(root() / "sub" / "a.txt", "foo");
+	EXPECT_TRUE(_watcher.rescan().empty());
+}
@@ -22,6 +22,8 @@
  *  Unit tests for our Huffman decoder.
  */
 
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "src/common/huffman.h"
@@ -120,3 +122,97 @@ GTEST_TEST(Huffman, invalidSymbol) {
 
 	EXPECT_THROW(huffman.getSymbol(bitStream), Common::Exception);
 }
+
+/** A canonical Huffman code with many long codes, similar to the WMA coefficient codes.
+ *
+ *  For LSB-first bit streams, the first bit of a code is its LSB, so the codes
+ *  are bit-reversed to still be prefix-free in that order.
+ */
+struct LongCode {
+	std::vector<uint32_t> codes;
+	std::vector<uint8_t>  lengths;
+	std::vector<uint32_t> symbols;
+
+	LongCode(size_t count, bool msbFirst) {
+		for (size_t i = 0; i < count; i++) {
+			lengths.push_back(6 + (i * 17) / count);
+			symbols.push_back(1000 + i);
+		}
+
+		uint32_t code = 0;
+		for (size_t i = 0; i < count; i++) {
+			if (i > 0)
+				code = (code + 1) << (lengths[i] - lengths[i - 1]);
+
+			codes.push_back(msbFirst ? code : reverse(code, lengths[i]));
+		}
+	}
+
+	static uint32_t reverse(uint32_t code, uint8_t length) {
+		uint32_t reversed = 0;
+		for (uint8_t i = 0; i < length; i++)
+			reversed |= ((code >> i) & 1) << (length - 1 - i);
+
+		return reversed;
+	}
+};
+
+/** Encode a list of code indices into a bit stream. */
+static std::vector<byte> encode(const LongCode &code, const std::vector<size_t> &indices, bool msbFirst) {
+	std::vector<byte> data;
+	size_t bitCount = 0;
+
+	for (size_t index : indices) {
+		for (size_t i = 0; i < code.lengths[index]; i++, bitCount++) {
+			const size_t bit = msbFirst ? (code.lengths[index] - 1 - i) : i;
+
+			if ((bitCount % 8) == 0)
+				data.push_back(0);
+
+			if (code.codes[index] & (1 << bit))
+				data.back() |= msbFirst ? (0x80 >> (bitCount % 8)) : (1 << (bitCount % 8));
+		}
+	}
+
+	return data;
+}
+
+static std::vector<size_t> createIndices(size_t codeCount, size_t count) {
+	std::vector<size_t> indices;
+
+	uint32_t seed = 1;
+	for (size_t i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		indices.push_back((seed >> 16) % codeCount);
+	}
+
+	return indices;
+}
+
+GTEST_TEST(Huffman, getSymbolLongCodesMSB) {
+	const LongCode code(300, true);
+	const std::vector<size_t> indices = createIndices(300, 1000);
+	const std::vector<byte> data = encode(code, indices, true);
+
+	Common::MemoryReadStream byteStream(data.data(), data.size());
+	Common::BitStream8MSB    bitStream (byteStream);
+
+	Common::Huffman huffman(0, code.codes.size(), code.codes.data(), code.lengths.data(), code.symbols.data());
+
+	for (size_t i = 0; i < indices.size(); i++)
+		ASSERT_EQ(huffman.getSymbol(bitStream), code.symbols[indices[i]]) << "At index " << i;
+}
+
+GTEST_TEST(Huffman, getSymbolLongCodesLSB) {
+	const LongCode code(300, false);
+	const std::vector<size_t> indices = createIndices(300, 1000);
+	const std::vector<byte> data = encode(code, indices, false);
+
+	Common::MemoryReadStream byteStream(data.data(), data.size());
+	Common::BitStream8LSB    bitStream (byteStream);
+
+	Common::Huffman huffman(0, code.codes.size(), code.codes.data(), code.lengths.data(), code.symbols.data());
+
+	for (size_t i = 0; i < indices.size(); i++)
+		ASSERT_EQ(huffman.getSymbol(bitStream), code.symbols[indices[i]]) << "At index " << i;
+}
@@ -0,0 +1,151 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our on-demand DEFLATE decompression stream.
+ */
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/deflate.h"
+#include "src/common/inflatereadstream.h"
+#include "src/common/memreadstream.h"
+#include "src/common/error.h"
+
+static const size_t kDataSize = 300000;
+
+/** Create somewhat compressible test data. */
+static std::vector<byte> createData() {
+	std::vector<byte> data(kDataSize);
+
+	uint32_t seed = 0x12345678;
+	for (size_t i = 0; i < kDataSize; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (seed >> 24) & 0x1F;
+	}
+
+	return data;
+}
+
+static Common::MemoryReadStream *compressData(const std::vector<byte> &data, int windowBits) {
+	// Compress into a single frame, so that everything is flushed in one go
+	size_t compressedSize = 0;
+	byte *compressedData = Common::compressDeflate(data.data(), data.size(), compressedSize, windowBits,
+	                                               data.size() + 4096);
+
+	return new Common::MemoryReadStream(compressedData, compressedSize, true);
+}
+
+GTEST_TEST(InflateReadStream, readAll) {
+	const std::vector<byte> data = createData();
+
+	Common::InflateReadStream stream(compressData(data, Common::kWindowBitsMaxRaw), data.size(),
+	                                 Common::kWindowBitsMaxRaw);
+
+	ASSERT_EQ(stream.size(), data.size());
+
+	std::vector<byte> readData(data.size() + 1);
+	EXPECT_EQ(stream.read(readData.data(), readData.size()), data.size());
+	EXPECT_TRUE(stream.eos());
+
+	for (size_t i = 0; i < data.size(); i++)
+		ASSERT_EQ(readData[i], data[i]) << "At index " << i;
+}
+
+GTEST_TEST(InflateReadStream, zlibHeader) {
+	const std::vector<byte> data = createData();
+
+	Common::InflateReadStream stream(compressData(data, Common::kWindowBitsMax), data.size(),
+	                                 Common::kWindowBitsMax);
+
+	std::vector<byte> readData(data.size());
+	EXPECT_EQ(stream.read(readData.data(), readData.size()), data.size());
+
+	EXPECT_EQ(readData, data);
+}
+
+GTEST_TEST(InflateReadStream, readHeaderOnly) {
+	const std::vector<byte> data = createData();
+
+	Common::InflateReadStream stream(compressData(data, Common::kWindowBitsMaxRaw), data.size(),
+	                                 Common::kWindowBitsMaxRaw, true, 131072);
+
+	EXPECT_EQ(stream.readUint32BE(), READ_BE_UINT32(data.data()));
+
+	// Nothing beyond the first chunk was decompressed
+	EXPECT_EQ(stream.getCheckpointCount(), 0);
+}
+
+GTEST_TEST(InflateReadStream, seek) {
+	const std::vector<byte> data = createData();
+
+	Common::InflateReadStream stream(compressData(data, Common::kWindowBitsMaxRaw), data.size(),
+	                                 Common::kWindowBitsMaxRaw, true, 65536);
+
+	static const size_t kPositions[] = { 250000, 10, 200000, 131072, 131071, 65536, 299999, 0 };
+
+	for (size_t i = 0; i < ARRAYSIZE(kPositions); i++) {
+		stream.seek(kPositions[i]);
+
+		EXPECT_EQ(stream.readByte(), data[kPositions[i]]) << "At position " << kPositions[i];
+		EXPECT_EQ(stream.pos(), kPositions[i] + 1);
+	}
+
+	EXPECT_EQ(stream.getCheckpointCount(), 4);
+
+	stream.seek(0, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(stream.pos(), data.size());
+
+	EXPECT_THROW(stream.seek(1, Common::SeekableReadStream::kOriginEnd), Common::Exception);
+}
+
+GTEST_TEST(InflateReadStream, readAcrossCheckpoints) {
+	const std::vector<byte> data = createData();
+
+	Common::InflateReadStream stream(compressData(data, Common::kWindowBitsMaxRaw), data.size(),
+	                                 Common::kWindowBitsMaxRaw, true, 65536);
+
+	stream.seek(299000);
+	stream.readByte();
+
+	// Read a range spanning several checkpoints, starting before the furthest position
+	stream.seek(60000);
+
+	std::vector<byte> readData(100000);
+	ASSERT_EQ(stream.read(readData.data(), readData.size()), readData.size());
+
+	for (size_t i = 0; i < readData.size(); i++)
+		ASSERT_EQ(readData[i], data[60000 + i]) << "At index " << i;
+}
+
+GTEST_TEST(InflateReadStream, failInputCut) {
+	const std::vector<byte> data = createData();
+
+	std::unique_ptr<Common::MemoryReadStream> compressed(compressData(data, Common::kWindowBitsMaxRaw));
+
+	Common::InflateReadStream stream(new Common::MemoryReadStream(compressed->getData(), compressed->size() / 2),
+	                                 data.size(), Common::kWindowBitsMaxRaw);
+
+	std::vector<byte> readData(data.size());
+	EXPECT_THROW(stream.read(readData.data(), readData.size()), Common::Exception);
+}
@@ -22,6 +22,9 @@
  *  Unit tests for our LZMA decompressor (which uses lzma).
  */
 
+#include <vector>
+#include <memory>
+
 #include "gtest/gtest.h"
 
 #include "src/common/lzma.h"
@@ -132,3 +135,58 @@ GTEST_TEST(LZMA1, decompressFailInputCut) {
 	EXPECT_THROW(Common::decompressLZMA1(kDataCompressed, kSizeCompressed, kSizeDecompressed),
 	             Common::Exception);
 }
+
+GTEST_TEST(LZMA1, decompressAfterFailure) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	// A failed decompression must not affect the next one using the same decoder context
+	EXPECT_THROW(Common::decompressLZMA1(kDataCompressed, kSizeCompressed / 2, kSizeDecompressed),
+	             Common::Exception);
+
+	std::unique_ptr<const byte[]> decompressed(Common::decompressLZMA1(kDataCompressed, kSizeCompressed, kSizeDecompressed));
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed[i], kDataUncompressed[i]) << "At index " << i;
+}
+
+GTEST_TEST(LZMA1Context, decompressReuse) {
+	static const size_t kPropertiesSize   = Common::LZMA1Context::getPropertiesSize();
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed) - kPropertiesSize;
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMA1Context context;
+
+	for (size_t n = 0; n < 3; n++) {
+		context.reset(kDataCompressed, kPropertiesSize);
+
+		std::vector<byte> decompressed(kSizeDecompressed);
+
+		// Decompress in two halves
+		size_t consumed1 = 0, consumed2 = 0;
+		const size_t written1 = context.decompress(kDataCompressed + kPropertiesSize, kSizeCompressed,
+		                                           decompressed.data(), kSizeDecompressed / 2, consumed1);
+		EXPECT_FALSE(context.isFinished());
+
+		const size_t written2 = context.decompress(kDataCompressed + kPropertiesSize + consumed1,
+		                                           kSizeCompressed - consumed1, decompressed.data() + written1,
+		                                           kSizeDecompressed - written1, consumed2);
+		EXPECT_TRUE(context.isFinished());
+
+		EXPECT_EQ(written1 + written2, kSizeDecompressed);
+		EXPECT_EQ(consumed1 + consumed2, kSizeCompressed);
+
+		for (size_t i = 0; i < kSizeDecompressed; i++)
+			EXPECT_EQ(decompressed[i], kDataUncompressed[i]) << "At index " << i << ", iteration " << n;
+	}
+}
+
+GTEST_TEST(LZMA1Context, decompressUninitialized) {
+	Common::LZMA1Context context;
+
+	byte output[16];
+	size_t consumed = 0;
+
+	EXPECT_THROW(context.decompress(kDataCompressed, sizeof(kDataCompressed), output, sizeof(output), consumed),
+	             Common::Exception);
+}
@@ -22,6 +22,8 @@
  *  Unit tests for our memory read stream.
  */
 
+#include <memory>
+
 #include "gtest/gtest.h"
 
 #include "src/common/util.h"
@@ -88,6 +90,25 @@ GTEST_TEST(MemoryReadStream, read) {
 	EXPECT_TRUE(stream.eos());
 }
 
+GTEST_TEST(MemoryReadStream, readAt) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	stream.seek(1);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(stream.readAt(2, readData, 4), 3);
+
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+	EXPECT_EQ(readData[2], data[4]);
+
+	EXPECT_EQ(stream.readAt(5, readData, 1), 0);
+
+	EXPECT_EQ(stream.pos(), 1);
+	EXPECT_FALSE(stream.eos());
+}
+
 GTEST_TEST(MemoryReadStream, readStream) {
 	static const byte data[3] = { 0x12, 0x34, 0x56 };
 	Common::MemoryReadStream stream(data);
@@ -315,6 +336,65 @@ GTEST_TEST(SeekableSubReadStream, fromMem) {
 	EXPECT_FALSE(subStream.eos());
 }
 
+GTEST_TEST(SeekableSubReadStream, parentPos) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableSubReadStream subStream1(&stream, 1, 4);
+	Common::SeekableSubReadStream subStream2(&stream, 2, 5);
+
+	stream.seek(4);
+
+	EXPECT_EQ(subStream1.readByte(), data[1]);
+	EXPECT_EQ(subStream2.readByte(), data[2]);
+	EXPECT_EQ(subStream1.readByte(), data[2]);
+	EXPECT_EQ(subStream2.readByte(), data[3]);
+
+	EXPECT_EQ(stream.pos(), 4);
+	EXPECT_EQ(stream.readByte(), data[4]);
+}
+
+GTEST_TEST(SeekableSubReadStream, readAt) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableSubReadStream subStream(&stream, 1, 4);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(subStream.readAt(1, readData, 4), 2);
+
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+
+	EXPECT_EQ(subStream.readAt(3, readData, 1), 0);
+	EXPECT_EQ(subStream.pos(), 0);
+}
+
+GTEST_TEST(SeekableSubReadStream, getData) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableSubReadStream subStream(&stream, 1, 4);
+
+	EXPECT_EQ(subStream.getData(), data + 1);
+}
+
+GTEST_TEST(SeekableReadStream, createSubStream) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	std::unique_ptr<Common::SeekableReadStream> subStream(stream.createSubStream(1, 4));
+
+	EXPECT_EQ(subStream->size(), 3);
+	EXPECT_EQ(subStream->getData(), data + 1);
+
+	EXPECT_EQ(subStream->readByte(), data[1]);
+	EXPECT_EQ(subStream->readByte(), data[2]);
+	EXPECT_EQ(subStream->readByte(), data[3]);
+
+	EXPECT_THROW(stream.createSubStream(1, 6), Common::Exception);
+}
+
 GTEST_TEST(SeekableSubReadStreamEndian, streamEndianLE) {
 	static const byte data[4] = { 0x78, 0x56, 0x34, 0x12 };
 	Common::MemoryReadStream stream(data);
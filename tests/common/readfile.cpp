@@ -24,6 +24,7 @@
 
 #include <string>
 #include <iostream>
+#include <memory>
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -79,6 +80,18 @@ GTEST_TEST_F(ReadFile, write) {
 	const size_t readCount = file.read(readData, sizeof(readData));
 	EXPECT_EQ(readCount, ARRAYSIZE(readData));
 
+	// Positional reads leave the file position alone
+
+	file.seek(1);
+
+	byte readAtData[ARRAYSIZE(data)];
+	EXPECT_EQ(file.readAt(2, readAtData, sizeof(readAtData)), ARRAYSIZE(data) - 2);
+	EXPECT_EQ(file.pos(), 1);
+	EXPECT_EQ(file.readByte(), data[1]);
+
+	for (size_t i = 2; i < ARRAYSIZE(data); i++)
+		EXPECT_EQ(readAtData[i - 2], data[i]) << "At index " << i;
+
 	file.close();
 	ASSERT_FALSE(file.isOpen());
 
@@ -87,3 +100,61 @@ GTEST_TEST_F(ReadFile, write) {
 	for (size_t i = 0; i < ARRAYSIZE(data); i++)
 		EXPECT_EQ(readData[i], data[i]) << "At index " << i;
 }
+
+GTEST_TEST_F(ReadFile, mapped) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+
+	// Create the input file
+
+	boost::filesystem::ofstream testFile(kFilePath, std::ofstream::binary);
+
+	testFile.write(reinterpret_cast<const char *>(data), ARRAYSIZE(data));
+	testFile.flush();
+	ASSERT_FALSE(testFile.fail());
+
+	testFile.close();
+
+	// Map the file with our MappedReadFile class
+
+	Common::MappedReadFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+	ASSERT_NE(file.getData(), static_cast<const byte *>(0));
+
+	EXPECT_EQ(file.size(), ARRAYSIZE(data));
+
+	for (size_t i = 0; i < ARRAYSIZE(data); i++)
+		EXPECT_EQ(file.getData()[i], data[i]) << "At index " << i;
+
+	file.seek(1);
+	EXPECT_EQ(file.readUint16BE(), 0x3456);
+
+	file.seek(0);
+
+	byte readData[ARRAYSIZE(data) + 1];
+	const size_t readCount = file.read(readData, sizeof(readData));
+	EXPECT_EQ(readCount, ARRAYSIZE(data));
+	EXPECT_TRUE(file.eos());
+
+	for (size_t i = 0; i < ARRAYSIZE(data); i++)
+		EXPECT_EQ(readData[i], data[i]) << "At index " << i;
+
+	// A sub stream directly references the mapped data
+
+	std::unique_ptr<Common::SeekableReadStream> subStream(file.createSubStream(1, 4));
+	ASSERT_EQ(subStream->size(), 3);
+	EXPECT_EQ(subStream->getData(), file.getData() + 1);
+	EXPECT_EQ(subStream->readByte(), 0x34);
+
+	file.close();
+	ASSERT_FALSE(file.isOpen());
+}
+
+GTEST_TEST_F(ReadFile, mappedMissing) {
+	Common::MappedReadFile file;
+
+	EXPECT_FALSE(file.open((kFilePath.parent_path() / "xoreos-does-not-exist.nope").generic_string()));
+	EXPECT_FALSE(file.isOpen());
+	EXPECT_EQ(file.getData(), static_cast<const byte *>(0));
+}
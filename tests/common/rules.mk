@@ -80,6 +80,11 @@ tests_common_test_blowfish_SOURCES  = tests/common/blowfish.cpp
 tests_common_test_blowfish_LDADD    = $(common_LIBS)
 tests_common_test_blowfish_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                               += tests/common/test_blowfishreadstream
+tests_common_test_blowfishreadstream_SOURCES  = tests/common/blowfishreadstream.cpp
+tests_common_test_blowfishreadstream_LDADD    = $(common_LIBS)
+tests_common_test_blowfishreadstream_CXXFLAGS = $(test_CXXFLAGS)
+
 noinst_HEADERS += tests/common/encoding.h tests/common/encoding_tests.h
 
 check_PROGRAMS                           += tests/common/test_encoding_ascii
@@ -147,6 +152,16 @@ tests_common_test_filepath_SOURCES  = tests/common/filepath.cpp
 tests_common_test_filepath_LDADD    = $(common_LIBS)
 tests_common_test_filepath_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                     += tests/common/test_filetree
+tests_common_test_filetree_SOURCES  = tests/common/filetree.cpp
+tests_common_test_filetree_LDADD    = $(common_LIBS)
+tests_common_test_filetree_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                        += tests/common/test_filewatcher
+tests_common_test_filewatcher_SOURCES  = tests/common/filewatcher.cpp
+tests_common_test_filewatcher_LDADD    = $(common_LIBS)
+tests_common_test_filewatcher_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                     += tests/common/test_filelist
 tests_common_test_filelist_SOURCES  = tests/common/filelist.cpp
 tests_common_test_filelist_LDADD    = $(common_LIBS)
@@ -167,6 +182,11 @@ tests_common_test_deflate_SOURCES  = tests/common/deflate.cpp
 tests_common_test_deflate_LDADD    = $(common_LIBS)
 tests_common_test_deflate_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                              += tests/common/test_inflatereadstream
+tests_common_test_inflatereadstream_SOURCES  = tests/common/inflatereadstream.cpp
+tests_common_test_inflatereadstream_LDADD    = $(common_LIBS)
+tests_common_test_inflatereadstream_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                    += tests/common/test_zipfile
 tests_common_test_zipfile_SOURCES  = tests/common/zipfile.cpp
 tests_common_test_zipfile_LDADD    = $(common_LIBS)
@@ -186,3 +206,8 @@ check_PROGRAMS                   += tests/common/test_string
 tests_common_test_string_SOURCES  = tests/common/string.cpp
 tests_common_test_string_LDADD    = $(common_LIBS)
 tests_common_test_string_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                       += tests/common/test_threadpool
+tests_common_test_threadpool_SOURCES  = tests/common/threadpool.cpp
+tests_common_test_threadpool_LDADD    = $(common_LIBS)
+tests_common_test_threadpool_CXXFLAGS = $(test_CXXFLAGS)
@@ -0,0 +1,200 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our work-stealing thread pool.
+ */
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/threadpool.h"
+
+GTEST_TEST(ThreadPool, getThreadCount) {
+	Common::ThreadPool pool(3);
+
+	EXPECT_EQ(pool.getThreadCount(), 3);
+}
+
+GTEST_TEST(ThreadPool, submit) {
+	Common::ThreadPool pool(2);
+
+	std::vector<std::future<size_t>> futures;
+	for (size_t i = 0; i < 100; i++)
+		futures.push_back(pool.submit([i]() { return i * i; }));
+
+	for (size_t i = 0; i < futures.size(); i++)
+		EXPECT_EQ(futures[i].get(), i * i) << "At index " << i;
+}
+
+GTEST_TEST(ThreadPool, submitException) {
+	Common::ThreadPool pool(2);
+
+	std::future<void> future = pool.submit([]() { throw Common::Exception("Failed"); });
+
+	EXPECT_THROW(future.get(), Common::Exception);
+}
+
+GTEST_TEST(ThreadPool, submitCancel) {
+	Common::ThreadPool pool(1);
+	Common::CancelToken token;
+
+	// Keep the only worker busy until the token is cancelled
+	std::atomic<bool> started(false), release(false), ran(false);
+
+	std::future<void> blocker = pool.submit([&started, &release]() {
+		started = true;
+		while (!release)
+			std::this_thread::yield();
+	});
+
+	while (!started)
+		std::this_thread::yield();
+
+	std::future<void> future = pool.submit([&ran]() { ran = true; }, token);
+
+	token.cancel();
+	release = true;
+
+	blocker.get();
+	EXPECT_THROW(future.get(), Common::Exception);
+	EXPECT_FALSE(ran);
+}
+
+GTEST_TEST(ThreadPool, parallelFor) {
+	Common::ThreadPool pool(3);
+
+	std::vector<std::atomic<size_t>> counts(1000);
+	for (auto &count : counts)
+		count = 0;
+
+	EXPECT_TRUE(pool.parallelFor(0, counts.size(), [&counts](size_t i) { counts[i]++; }));
+
+	for (size_t i = 0; i < counts.size(); i++)
+		EXPECT_EQ(counts[i], 1) << "At index " << i;
+}
+
+GTEST_TEST(ThreadPool, parallelForGrainSize) {
+	Common::ThreadPool pool(2);
+
+	std::atomic<size_t> sum(0);
+	EXPECT_TRUE(pool.parallelFor(10, 20, [&sum](size_t i) { sum += i; }, Common::CancelToken(), 3));
+
+	EXPECT_EQ(sum, 145);
+}
+
+GTEST_TEST(ThreadPool, parallelForEmpty) {
+	Common::ThreadPool pool(2);
+
+	EXPECT_TRUE(pool.parallelFor(5, 5, [](size_t) { throw Common::Exception("Called"); }));
+}
+
+GTEST_TEST(ThreadPool, parallelForException) {
+	Common::ThreadPool pool(2);
+
+	EXPECT_THROW(pool.parallelFor(0, 100, [](size_t i) {
+		if (i == 50)
+			throw Common::Exception("Failed");
+	}), Common::Exception);
+}
+
+GTEST_TEST(ThreadPool, parallelForCancel) {
+	Common::ThreadPool pool(2);
+	Common::CancelToken token;
+
+	std::atomic<size_t> count(0);
+	EXPECT_FALSE(pool.parallelFor(0, 1000, [&count, &token](size_t) {
+		if (++count == 10)
+			token.cancel();
+	}, token, 1));
+
+	EXPECT_GE(count, 10);
+	EXPECT_LT(count, 1000);
+}
+
+GTEST_TEST(ThreadPool, parallelForNested) {
+	Common::ThreadPool pool(2);
+
+	// Nested loops run within the worker threads must not deadlock
+	std::atomic<size_t> count(0);
+	pool.parallelFor(0, 8, [&pool, &count](size_t) {
+		pool.parallelFor(0, 8, [&count](size_t) { count++; });
+	}, Common::CancelToken(), 1);
+
+	EXPECT_EQ(count, 64);
+}
+
+GTEST_TEST(ThreadPool, wait) {
+	Common::ThreadPool pool(1);
+
+	std::future<size_t> outer = pool.submit([&pool]() {
+		Common::TaskFuture<size_t> inner = pool.submit([]() { return (size_t) 23; });
+
+		// With only one worker, the inner task can only run while we wait for it
+		pool.wait(inner);
+		return inner.get();
+	});
+
+	EXPECT_EQ(outer.get(), 23);
+}
+
+GTEST_TEST(ThreadPool, waitOnlyRunsItsTask) {
+	Common::ThreadPool pool(1);
+
+	// Keep the only worker busy, so that all other tasks stay queued
+	std::atomic<bool> started(false), release(false), ranOther(false), ranTask(false);
+
+	std::future<void> blocker = pool.submit([&started, &release]() {
+		started = true;
+		while (!release)
+			std::this_thread::yield();
+	});
+
+	while (!started)
+		std::this_thread::yield();
+
+	std::future<void> other = pool.submit([&ranOther]() { ranOther = true; });
+	Common::TaskFuture<void> task = pool.submit([&ranTask]() { ranTask = true; });
+
+	// The task we wait for runs in our thread, the other one stays queued
+	pool.wait(task);
+
+	EXPECT_TRUE(ranTask);
+	EXPECT_FALSE(ranOther);
+
+	release = true;
+
+	blocker.get();
+	other.get();
+	EXPECT_TRUE(ranOther);
+}
+
+GTEST_TEST(ThreadPoolManager, getPool) {
+	ThreadPoolMan.init(2);
+	EXPECT_EQ(ThreadPoolMan.getPool().getThreadCount(), 2);
+
+	ThreadPoolMan.deinit();
+	EXPECT_GE(ThreadPoolMan.getPool().getThreadCount(), 1);
+
+	Common::ThreadPoolManager::destroy();
+}
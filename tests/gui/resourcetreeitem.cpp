@@ -0,0 +1,243 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the items that make up Phaethon's resource tree.
+ */
+
+#include <memory>
+
+#include <QString>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+
+#include "src/aurora/archive.h"
+
+#include "src/gui/resourcetreeitem.h"
+
+/** An archive with lots of made-up resources and no actual data. */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive(size_t count) {
+		_resources.reserve(count);
+
+		for (size_t i = 0; i < count; i++)
+			_resources.add("resource" + Common::composeString(i), Aurora::kFileTypeTGA, i);
+
+		_resources.finish();
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	uint32_t getResourceSize(uint32_t UNUSED(index)) const {
+		return 0;
+	}
+
+	Common::SeekableReadStream *getResource(uint32_t UNUSED(index), bool UNUSED(tryNoCopy)) const {
+		throw Common::Exception("No resource data");
+	}
+
+private:
+	ResourceList _resources;
+};
+
+GTEST_TEST(ResourceTreeItem, addChild) {
+	GUI::ResourceTreeItem root("Filename");
+
+	GUI::ResourceTreeItem *child1 = new GUI::ResourceTreeItem("foo");
+	GUI::ResourceTreeItem *child2 = new GUI::ResourceTreeItem("bar");
+
+	root.addChild(child1);
+	root.addChild(child2);
+
+	ASSERT_EQ(root.childCount(), 2);
+
+	EXPECT_EQ(root.childAt(0), child1);
+	EXPECT_EQ(root.childAt(1), child2);
+
+	EXPECT_EQ(child1->row(), 0);
+	EXPECT_EQ(child2->row(), 1);
+
+	EXPECT_EQ(child1->getParent(), &root);
+	EXPECT_EQ(child2->getParent(), &root);
+}
+
+GTEST_TEST(ResourceTreeItem, insertChild) {
+	GUI::ResourceTreeItem root("Filename");
+
+	GUI::ResourceTreeItem *child1 = new GUI::ResourceTreeItem("foo");
+	GUI::ResourceTreeItem *child2 = new GUI::ResourceTreeItem("bar");
+	GUI::ResourceTreeItem *child3 = new GUI::ResourceTreeItem("quux");
+
+	root.addChild(child1);
+	root.addChild(child2);
+
+	ASSERT_TRUE(root.insertChild(1, child3));
+	ASSERT_EQ(root.childCount(), 3);
+
+	EXPECT_EQ(root.childAt(0), child1);
+	EXPECT_EQ(root.childAt(1), child3);
+	EXPECT_EQ(root.childAt(2), child2);
+
+	for (int i = 0; i < root.childCount(); i++) {
+		EXPECT_EQ(root.childAt(i)->row(), i);
+		EXPECT_EQ(root.childAt(i)->getParent(), &root);
+	}
+
+	std::unique_ptr<GUI::ResourceTreeItem> child4 = std::make_unique<GUI::ResourceTreeItem>("foobar");
+	EXPECT_FALSE(root.insertChild(3, child4.get()));
+}
+
+GTEST_TEST(ResourceTreeItem, removeChild) {
+	GUI::ResourceTreeItem root("Filename");
+
+	GUI::ResourceTreeItem *child1 = new GUI::ResourceTreeItem("foo");
+	GUI::ResourceTreeItem *child2 = new GUI::ResourceTreeItem("bar");
+	GUI::ResourceTreeItem *child3 = new GUI::ResourceTreeItem("quux");
+
+	root.addChild(child1);
+	root.addChild(child2);
+	root.addChild(child3);
+
+	root.removeChild(1);
+	ASSERT_EQ(root.childCount(), 2);
+
+	EXPECT_EQ(root.childAt(0), child1);
+	EXPECT_EQ(root.childAt(1), child3);
+
+	EXPECT_EQ(child1->row(), 0);
+	EXPECT_EQ(child3->row(), 1);
+
+	root.removeChild(0);
+	ASSERT_EQ(root.childCount(), 1);
+
+	EXPECT_EQ(root.childAt(0), child3);
+	EXPECT_EQ(child3->row(), 0);
+}
+
+GTEST_TEST(ResourceTreeItem, clearChildren) {
+	TestArchive archive(10);
+
+	GUI::ResourceTreeItem root("Filename");
+	GUI::ResourceTreeItem *archiveItem = new GUI::ResourceTreeItem("archive.erf");
+
+	root.addChild(archiveItem);
+
+	archiveItem->addArchiveChildren(&archive, "archive.erf", { 1, 2, 3 });
+
+	// Only the items that were accessed are created
+	EXPECT_EQ(archiveItem->createdChildAt(1), nullptr);
+	GUI::ResourceTreeItem *child = archiveItem->childAt(1);
+	EXPECT_EQ(archiveItem->createdChildAt(1), child);
+
+	archiveItem->clearChildren();
+
+	EXPECT_FALSE(archiveItem->hasChildren());
+	EXPECT_FALSE(archiveItem->hasArchiveChildren());
+	EXPECT_EQ(archiveItem->childCount(), 0);
+
+	// Once cleared, the item can hold normal children again
+	archiveItem->addChild(new GUI::ResourceTreeItem("foo"));
+	EXPECT_EQ(archiveItem->childCount(), 1);
+}
+
+GTEST_TEST(ResourceTreeItem, archiveChildren) {
+	TestArchive archive(100);
+
+	GUI::ResourceTreeItem root("Filename");
+	GUI::ResourceTreeItem *archiveItem = new GUI::ResourceTreeItem("archive.erf");
+
+	root.addChild(archiveItem);
+
+	for (const Aurora::Archive::Resource &resource : archive.getResources())
+		archiveItem->addChild(new GUI::ResourceTreeItem(&archive, "archive.erf", resource));
+
+	ASSERT_EQ(archiveItem->childCount(), 100);
+
+	for (int i = 0; i < archiveItem->childCount(); i++) {
+		const GUI::ResourceTreeItem *child = archiveItem->childAt(i);
+
+		EXPECT_EQ(child->row(), i);
+		EXPECT_EQ(child->getParent(), archiveItem);
+		EXPECT_EQ(child->getName(), QString("resource%1.tga").arg(i));
+		EXPECT_EQ(child->getSource(), GUI::kSourceArchiveFile);
+	}
+}
+
+GTEST_TEST(ResourceTreeItem, addArchiveChildren) {
+	TestArchive archive(100);
+
+	GUI::ResourceTreeItem root("Filename");
+	GUI::ResourceTreeItem *archiveItem = new GUI::ResourceTreeItem("archive.erf");
+
+	root.addChild(archiveItem);
+
+	EXPECT_FALSE(archiveItem->hasArchiveChildren());
+
+	archiveItem->addArchiveChildren(&archive, "archive.erf", { 3, 1, 4 });
+	archiveItem->addArchiveChildren(&archive, "archive.erf", { 15, 9 });
+
+	EXPECT_TRUE(archiveItem->hasArchiveChildren());
+	EXPECT_TRUE(archiveItem->hasChildren());
+
+	ASSERT_EQ(archiveItem->childCount(), 5);
+
+	static const int kResources[] = { 3, 1, 4, 15, 9 };
+	for (int i = 0; i < archiveItem->childCount(); i++) {
+		const GUI::ResourceTreeItem *child = archiveItem->childAt(i);
+
+		ASSERT_NE(child, nullptr);
+
+		EXPECT_EQ(child->row(), i);
+		EXPECT_EQ(child->getParent(), archiveItem);
+		EXPECT_EQ(child->getName(), QString("resource%1.tga").arg(kResources[i]));
+		EXPECT_EQ(child->getPath(), QString("archive.erf/resource%1.tga").arg(kResources[i]));
+		EXPECT_EQ(child->getSource(), GUI::kSourceArchiveFile);
+		EXPECT_EQ(child->getFileType(), Aurora::kFileTypeTGA);
+
+		// Once created, the item stays the same
+		EXPECT_EQ(archiveItem->childAt(i), child);
+	}
+
+	// Members of a different archive go after the existing ones
+	TestArchive archive2(10);
+	archiveItem->addArchiveChildren(&archive2, "archive2.erf", { 7 });
+
+	ASSERT_EQ(archiveItem->childCount(), 6);
+
+	EXPECT_EQ(archiveItem->childAt(4)->getPath(), QString("archive.erf/resource9.tga"));
+	EXPECT_EQ(archiveItem->childAt(5)->getPath(), QString("archive2.erf/resource7.tga"));
+	EXPECT_EQ(archiveItem->childAt(5)->row(), 5);
+}
+
+GTEST_TEST(ResourceTreeItem, getResourceName) {
+	Aurora::Archive::ResourceList resources;
+
+	resources.add("foo", Aurora::kFileTypeTGA, 0);
+	resources.add("", Aurora::kFileTypeDDS, 1, 23);
+
+	EXPECT_STREQ(GUI::ResourceTreeItem::getResourceName(resources[0]).c_str(), "foo.tga");
+	EXPECT_STREQ(GUI::ResourceTreeItem::getResourceName(resources[1]).c_str(), "23.dds");
+}
@@ -0,0 +1,211 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our pixel format conversion kernels.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+#include "src/images/convert.h"
+#include "src/images/util.h"
+
+static std::vector<byte> createPixels(size_t size) {
+	std::vector<byte> data(size);
+
+	uint32_t seed = 42;
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+
+		data[i] = (byte) (seed >> 16);
+	}
+
+	// Make sure the extremes are in there
+	if (size >= 8) {
+		data[0] = data[1] = data[2] = data[3] = 0xFF;
+		data[4] = data[5] = data[6] = data[7] = 0x00;
+	}
+
+	return data;
+}
+
+/** The reference conversion, one pixel at a time, as the preview and TGA dumper used to do. */
+static void convertPixel(const byte *&src, byte *&dest, Images::PixelFormat format) {
+	switch (format) {
+		case Images::kPixelFormatR8G8B8:
+			*dest++ = src[0]; *dest++ = src[1]; *dest++ = src[2]; *dest++ = 0xFF;
+			src += 3;
+			break;
+
+		case Images::kPixelFormatB8G8R8:
+			*dest++ = src[2]; *dest++ = src[1]; *dest++ = src[0]; *dest++ = 0xFF;
+			src += 3;
+			break;
+
+		case Images::kPixelFormatR8G8B8A8:
+			*dest++ = src[0]; *dest++ = src[1]; *dest++ = src[2]; *dest++ = src[3];
+			src += 4;
+			break;
+
+		case Images::kPixelFormatB8G8R8A8:
+			*dest++ = src[2]; *dest++ = src[1]; *dest++ = src[0]; *dest++ = src[3];
+			src += 4;
+			break;
+
+		case Images::kPixelFormatR5G6B5:
+			{
+				const uint16_t color = READ_LE_UINT16(src);
+
+				*dest++ =  color & 0x001F;
+				*dest++ = (color & 0x07E0) >>  5;
+				*dest++ = (color & 0xF800) >> 11;
+				*dest++ = 0xFF;
+				src    += 2;
+			}
+			break;
+
+		case Images::kPixelFormatA1R5G5B5:
+			{
+				const uint16_t color = READ_LE_UINT16(src);
+
+				*dest++ =  color & 0x001F;
+				*dest++ = (color & 0x03E0) >>  5;
+				*dest++ = (color & 0x7C00) >> 10;
+				*dest++ = (color & 0x8000) ? 0xFF : 0x00;
+				src    += 2;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+static const Images::PixelFormat kFormats[] = {
+	Images::kPixelFormatR8G8B8  , Images::kPixelFormatB8G8R8  ,
+	Images::kPixelFormatR8G8B8A8, Images::kPixelFormatB8G8R8A8,
+	Images::kPixelFormatR5G6B5  , Images::kPixelFormatA1R5G5B5
+};
+
+GTEST_TEST(Convert, convertToRGBA) {
+	for (size_t f = 0; f < ARRAYSIZE(kFormats); f++) {
+		for (size_t count = 0; count < 40; count++) {
+			const std::vector<byte> src = createPixels(count * Images::getBPP(kFormats[f]));
+
+			std::vector<byte> dest(count * 4), reference(count * 4);
+
+			Images::convertToRGBA(dest.data(), src.data(), count, kFormats[f]);
+
+			const byte *s = src.data();
+			byte *d = reference.data();
+			for (size_t i = 0; i < count; i++)
+				convertPixel(s, d, kFormats[f]);
+
+			EXPECT_EQ(dest, reference) << "Format " << kFormats[f] << ", " << count << " pixels";
+		}
+	}
+}
+
+GTEST_TEST(Convert, convertToBGRA) {
+	for (size_t f = 0; f < ARRAYSIZE(kFormats); f++) {
+		for (size_t count = 0; count < 40; count++) {
+			const std::vector<byte> src = createPixels(count * Images::getBPP(kFormats[f]));
+
+			std::vector<byte> dest(count * 4), reference(count * 4);
+
+			Images::convertToBGRA(dest.data(), src.data(), count, kFormats[f]);
+
+			const byte *s = src.data();
+			byte *d = reference.data();
+			for (size_t i = 0; i < count; i++)
+				convertPixel(s, d, kFormats[f]);
+
+			// The 8-bit formats are swapped, the 16-bit formats aren't
+			if (Images::getBPP(kFormats[f]) > 2)
+				for (size_t i = 0; i < count; i++)
+					std::swap(reference[i * 4 + 0], reference[i * 4 + 2]);
+
+			EXPECT_EQ(dest, reference) << "Format " << kFormats[f] << ", " << count << " pixels";
+		}
+	}
+}
+
+GTEST_TEST(Convert, convertDepth16) {
+	static const byte kDepth[] = { 0x00, 0x00, 0xFF, 0x7F, 0x80, 0x3F };
+	static const byte kRGBA [] = { 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x7F, 0x7F, 0x7F, 0xFF };
+
+	byte rgba[ARRAYSIZE(kRGBA)];
+	Images::convertToRGBA(rgba, kDepth, 3, Images::kPixelFormatDepth16);
+
+	for (size_t i = 0; i < ARRAYSIZE(kRGBA); i++)
+		EXPECT_EQ(rgba[i], kRGBA[i]) << "At index " << i;
+}
+
+GTEST_TEST(Convert, convertInPlace) {
+	std::vector<byte> data = createPixels(37 * 4);
+	const std::vector<byte> original = data;
+
+	Images::convertToBGRA(data.data(), data.data(), 37, Images::kPixelFormatR8G8B8A8);
+	Images::convertToRGBA(data.data(), data.data(), 37, Images::kPixelFormatB8G8R8A8);
+
+	EXPECT_EQ(data, original);
+
+	EXPECT_THROW(Images::convertToRGBA(data.data(), data.data(), 1, Images::kPixelFormatDXT1), Common::Exception);
+}
+
+GTEST_TEST(Convert, premultiplyAlpha) {
+	for (size_t count = 0; count < 40; count++) {
+		const std::vector<byte> src = createPixels(count * 4);
+
+		std::vector<byte> dest(count * 4);
+		Images::premultiplyAlpha(dest.data(), src.data(), count);
+
+		for (size_t i = 0; i < count * 4; i++) {
+			const uint32_t alpha = src[(i & ~3) + 3];
+			const byte expected  = ((i & 3) == 3) ? alpha : (byte) ((src[i] * alpha + 127) / 255);
+
+			ASSERT_EQ(dest[i], expected) << "At index " << i << " of " << count << " pixels";
+		}
+	}
+}
+
+GTEST_TEST(Convert, adjustBrightness) {
+	static const uint16_t kFactors[] = { 0, 128, 256, 300, 1024, 0xFFFF };
+
+	for (size_t f = 0; f < ARRAYSIZE(kFactors); f++) {
+		for (size_t count = 0; count < 40; count++) {
+			const std::vector<byte> src = createPixels(count * 4);
+
+			std::vector<byte> dest(count * 4);
+			Images::adjustBrightness(dest.data(), src.data(), count, kFactors[f]);
+
+			for (size_t i = 0; i < count * 4; i++) {
+				const byte expected = ((i & 3) == 3) ? src[i] : MIN<uint32_t>((src[i] * kFactors[f]) / 256, 255);
+
+				ASSERT_EQ(dest[i], expected) << "At index " << i << " of " << count << " pixels, factor " << kFactors[f];
+			}
+		}
+	}
+}
@@ -0,0 +1,242 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our generic image decoder interface.
+ */
+
+#include <cstring>
+
+#include <vector>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/endianness.h"
+#include "src/common/memreadstream.h"
+
+#include "src/images/decoder.h"
+#include "src/images/util.h"
+#include "src/images/s3tc.h"
+#include "src/images/dds.h"
+
+/** A decoder holding random-ish DXT5 data, with a full mip map chain for every layer. */
+class TestDecoder : public Images::Decoder {
+public:
+	TestDecoder(int width, int height, size_t layerCount) {
+		_format     = Images::kPixelFormatDXT5;
+		_layerCount = layerCount;
+		_isCubeMap  = layerCount == 6;
+
+		uint32_t seed = 42;
+		for (size_t i = 0; i < layerCount; i++) {
+			for (int w = width, h = height; (w > 0) && (h > 0); w /= 2, h /= 2) {
+				std::unique_ptr<MipMap> mipMap = std::make_unique<MipMap>();
+
+				mipMap->width  = w;
+				mipMap->height = h;
+				mipMap->size   = Images::getDataSize(_format, w, h);
+				mipMap->data   = std::make_unique<byte[]>(mipMap->size);
+
+				for (uint32_t j = 0; j < mipMap->size; j++) {
+					seed = seed * 1103515245 + 12345;
+
+					mipMap->data[j] = (byte) (seed >> 16);
+				}
+
+				_mipMaps.emplace_back(std::move(mipMap));
+			}
+		}
+	}
+
+	using Images::Decoder::decompress;
+	using Images::Decoder::decompressLazily;
+
+	/** Return a mip map as it currently is, without lazily decompressing it. */
+	const MipMap &getCurrentMipMap(size_t mipMap, size_t layer) const {
+		return *_mipMaps[layer * getMipMapCount() + mipMap];
+	}
+
+	std::vector<size_t> fixedUp;
+
+protected:
+	void fixupLazyMipMaps(size_t mipMap) {
+		fixedUp.push_back(mipMap);
+	}
+};
+
+/** Decompress all mip maps of the decoder one by one, the old way. */
+static std::vector<std::vector<byte>> decompressSerially(const Images::Decoder &decoder) {
+	std::vector<std::vector<byte>> images;
+
+	for (size_t i = 0; i < decoder.getLayerCount(); i++) {
+		for (size_t j = 0; j < decoder.getMipMapCount(); j++) {
+			const Images::Decoder::MipMap &mipMap = decoder.getMipMap(j, i);
+
+			images.emplace_back(MAX<size_t>(mipMap.width * mipMap.height * 4, 64), 0);
+
+			Common::MemoryReadStream stream(mipMap.data.get(), mipMap.size);
+			Images::decompressDXT5(images.back().data(), stream, mipMap.width, mipMap.height, mipMap.width * 4);
+		}
+	}
+
+	return images;
+}
+
+static void compareDecompress(TestDecoder &decoder, size_t mipMapCount = SIZE_MAX) {
+	const std::vector<std::vector<byte>> images = decompressSerially(decoder);
+	const size_t oldMipMapCount = decoder.getMipMapCount();
+
+	decoder.decompress(mipMapCount);
+
+	ASSERT_EQ(decoder.getFormat(), Images::kPixelFormatR8G8B8A8);
+	ASSERT_EQ(decoder.getMipMapCount(), MIN(mipMapCount, oldMipMapCount));
+
+	for (size_t i = 0; i < decoder.getLayerCount(); i++) {
+		for (size_t j = 0; j < decoder.getMipMapCount(); j++) {
+			const Images::Decoder::MipMap &mipMap = decoder.getMipMap(j, i);
+			const std::vector<byte> &image = images[i * oldMipMapCount + j];
+
+			ASSERT_EQ(mipMap.size, image.size());
+			EXPECT_EQ(std::memcmp(mipMap.data.get(), image.data(), image.size()), 0) <<
+				"Layer " << i << ", mip map " << j;
+		}
+	}
+}
+
+GTEST_TEST(Decoder, decompress) {
+	TestDecoder decoder(512, 256, 1);
+
+	compareDecompress(decoder);
+}
+
+GTEST_TEST(Decoder, decompressCubeMap) {
+	TestDecoder decoder(256, 256, 6);
+
+	compareDecompress(decoder);
+}
+
+GTEST_TEST(Decoder, decompressOddSizes) {
+	// Partial block rows at the bottom, and a partial block column at the right
+	TestDecoder decoder(1030, 598, 2);
+
+	compareDecompress(decoder);
+}
+
+GTEST_TEST(Decoder, decompressMipMapCount) {
+	TestDecoder decoder(256, 128, 6);
+
+	compareDecompress(decoder, 2);
+}
+
+GTEST_TEST(Decoder, decompressLazily) {
+	TestDecoder decoder(256, 128, 6);
+
+	const std::vector<std::vector<byte>> images = decompressSerially(decoder);
+	const size_t mipMapCount = decoder.getMipMapCount();
+
+	decoder.decompressLazily();
+
+	ASSERT_EQ(decoder.getFormat(), Images::kPixelFormatR8G8B8A8);
+	ASSERT_EQ(decoder.getMipMapCount(), mipMapCount);
+
+	// Only the first mip map was decompressed yet
+	ASSERT_EQ(decoder.fixedUp.size(), 1);
+	EXPECT_EQ(decoder.fixedUp[0], 0);
+
+	EXPECT_EQ(decoder.getCurrentMipMap(0, 5).size, 256 * 128 * 4);
+	EXPECT_EQ(decoder.getCurrentMipMap(2, 5).size, (64 / 4) * (32 / 4) * 16);
+
+	// Asking for a mip map decompresses it in all layers, once
+	const Images::Decoder::MipMap &mipMap = decoder.getMipMap(2, 3);
+	ASSERT_EQ(mipMap.size, images[3 * mipMapCount + 2].size());
+	EXPECT_EQ(std::memcmp(mipMap.data.get(), images[3 * mipMapCount + 2].data(), mipMap.size), 0);
+
+	EXPECT_EQ(decoder.getCurrentMipMap(2, 5).size, 64 * 32 * 4);
+
+	decoder.getMipMap(2, 0);
+
+	ASSERT_EQ(decoder.fixedUp.size(), 2);
+	EXPECT_EQ(decoder.fixedUp[1], 2);
+
+	// Decompressing everything takes care of the rest
+
+	decoder.decompress();
+	EXPECT_EQ(decoder.fixedUp.size(), mipMapCount);
+
+	for (size_t i = 0; i < decoder.getLayerCount(); i++) {
+		for (size_t j = 0; j < mipMapCount; j++) {
+			const Images::Decoder::MipMap &current = decoder.getCurrentMipMap(j, i);
+			const std::vector<byte> &image = images[i * mipMapCount + j];
+
+			ASSERT_EQ(current.size, image.size());
+			EXPECT_EQ(std::memcmp(current.data.get(), image.data(), image.size()), 0) <<
+				"Layer " << i << ", mip map " << j;
+		}
+	}
+}
+
+GTEST_TEST(Decoder, decompressLazilyDDS) {
+	static const uint32_t kWidth = 64, kHeight = 32, kMipMaps = 4;
+
+	// A standard DXT1 DDS with a few mip maps
+	std::vector<byte> dds(128);
+
+	WRITE_BE_UINT32(&dds[  0], MKTAG('D', 'D', 'S', ' '));
+	WRITE_LE_UINT32(&dds[  4], 124);
+	WRITE_LE_UINT32(&dds[  8], 0x00020000);
+	WRITE_LE_UINT32(&dds[ 12], kHeight);
+	WRITE_LE_UINT32(&dds[ 16], kWidth);
+	WRITE_LE_UINT32(&dds[ 28], kMipMaps);
+	WRITE_LE_UINT32(&dds[ 76], 32);
+	WRITE_LE_UINT32(&dds[ 80], 0x00000004);
+	WRITE_BE_UINT32(&dds[ 84], MKTAG('D', 'X', 'T', '1'));
+
+	uint32_t seed = 23;
+	for (uint32_t i = 0, w = kWidth, h = kHeight; i < kMipMaps; i++, w /= 2, h /= 2) {
+		for (uint32_t j = 0; j < Images::getDataSize(Images::kPixelFormatDXT1, w, h); j++) {
+			seed = seed * 1103515245 + 12345;
+
+			dds.push_back((byte) (seed >> 16));
+		}
+	}
+
+	Common::MemoryReadStream stream1(dds.data(), dds.size());
+	Common::MemoryReadStream stream2(dds.data(), dds.size());
+
+	Images::DDS eager(stream1);
+	Images::DDS lazy(stream2, true);
+
+	ASSERT_EQ(lazy.getFormat(), eager.getFormat());
+	ASSERT_EQ(lazy.getMipMapCount(), kMipMaps);
+	ASSERT_EQ(eager.getMipMapCount(), kMipMaps);
+
+	for (size_t i = kMipMaps; i-- > 0; ) {
+		const Images::Decoder::MipMap &eagerMipMap = eager.getMipMap(i);
+		const Images::Decoder::MipMap &lazyMipMap  = lazy.getMipMap(i);
+
+		ASSERT_EQ(lazyMipMap.width , eagerMipMap.width);
+		ASSERT_EQ(lazyMipMap.height, eagerMipMap.height);
+		ASSERT_EQ(lazyMipMap.size  , eagerMipMap.size);
+
+		EXPECT_EQ(std::memcmp(lazyMipMap.data.get(), eagerMipMap.data.get(), lazyMipMap.size), 0) << "Mip map " << i;
+	}
+}
@@ -0,0 +1,102 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our S3TC DXTn decompression methods.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+
+#include "src/images/s3tc.h"
+
+typedef void (*DecompressStream)(byte *, Common::SeekableReadStream &, uint32_t, uint32_t, uint32_t);
+typedef void (*DecompressBuffer)(byte *, const byte *, size_t, uint32_t, uint32_t, uint32_t);
+
+/** Create random-ish compressed data, with all kinds of endpoint orders and equal endpoints. */
+static std::vector<byte> createData(size_t size) {
+	std::vector<byte> data(size);
+
+	uint32_t seed = 42;
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+
+		data[i] = (byte) (seed >> 16);
+	}
+
+	// Every 24 bytes, copy 2 bytes over the next 2, to also get blocks with equal endpoints
+	for (size_t i = 2; (i + 2) <= size; i += 24) {
+		data[i    ] = data[i - 2];
+		data[i + 1] = data[i - 1];
+	}
+
+	return data;
+}
+
+static void compareDecompress(DecompressStream decompressStream, DecompressBuffer decompressBuffer,
+                              size_t blockSize, uint32_t width, uint32_t height) {
+
+	const size_t size = ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+	const std::vector<byte> data = createData(size);
+
+	const uint32_t pitch = width * 4;
+
+	std::vector<byte> streamImage(MAX<size_t>(pitch * height, 64), 0);
+	std::vector<byte> bufferImage(MAX<size_t>(pitch * height, 64), 0);
+
+	Common::MemoryReadStream stream(data.data(), data.size());
+	decompressStream(streamImage.data(), stream, width, height, pitch);
+	decompressBuffer(bufferImage.data(), data.data(), data.size(), width, height, pitch);
+
+	for (size_t i = 0; i < streamImage.size(); i++)
+		ASSERT_EQ(bufferImage[i], streamImage[i]) << "At " << width << "x" << height << ", byte " << i;
+}
+
+static void compareDecompress(DecompressStream decompressStream, DecompressBuffer decompressBuffer, size_t blockSize) {
+	compareDecompress(decompressStream, decompressBuffer, blockSize,  64,  64);
+	compareDecompress(decompressStream, decompressBuffer, blockSize, 256,   4);
+	compareDecompress(decompressStream, decompressBuffer, blockSize,  18,  22);
+	compareDecompress(decompressStream, decompressBuffer, blockSize,   2,   2);
+	compareDecompress(decompressStream, decompressBuffer, blockSize,   1,  16);
+}
+
+GTEST_TEST(S3TC, decompressDXT1) {
+	compareDecompress(Images::decompressDXT1, Images::decompressDXT1, 8);
+}
+
+GTEST_TEST(S3TC, decompressDXT3) {
+	compareDecompress(Images::decompressDXT3, Images::decompressDXT3, 16);
+}
+
+GTEST_TEST(S3TC, decompressDXT5) {
+	compareDecompress(Images::decompressDXT5, Images::decompressDXT5, 16);
+}
+
+GTEST_TEST(S3TC, decompressTooSmall) {
+	const std::vector<byte> data = createData(8 * 15);
+
+	std::vector<byte> image(16 * 16 * 4);
+
+	EXPECT_THROW(Images::decompressDXT1(image.data(), data.data(), data.size(), 16, 16, 16 * 4), Common::Exception);
+}
@@ -39,5 +39,6 @@ include tests/version/rules.mk
 include tests/common/rules.mk
 include tests/aurora/rules.mk
 include tests/images/rules.mk
+include tests/gui/rules.mk
 
 TESTS += $(check_PROGRAMS)